@@ -15,10 +15,8 @@ Regblk:       equ    $0000
  INCLUDE sections.inc
  INCLUDE alarmSimul.inc
 
-; Dbug12 subroutines
-putchar        equ   $EE86
-getchar        equ   $EE84
-printf         equ   $EE88
+; Dbug12 subroutines (terminal I/O is done by the SCI Module)
+SetUserVector  equ   $EEA4
 writeEEByte    equ   $EEA6
 
         switch code_section
@@ -37,8 +35,8 @@ writeEEByte    equ   $EEA6
    			;do
 mainloop:  			; {
         ldd #MENU          ;   printf(MENU);
-        jsr [printf,PCr] 
-        jsr [getchar,PCr]  ;   select = getchar();  // getchar is debug 12 routine
+        jsr sciPuts 
+        jsr sciGetchar  ;   select = getchar();  // from the SCI0 receive ring
 	pshb ; save b
         pulb
         cmpb #'c'          ;   if(select == 'c') configCodes();
@@ -97,16 +95,14 @@ wait_b3:
         brclr Crgflg,x, %00001000 wait_b3  ; Wait until bit 3 = 1
         bset Clksel,x, %10000000
 
-        ; Setup Serial port
-        ldd #156
-        std Sc0bdh   ; Sets up the baud rate
-        ldaa #$0c
-        staa Sc0cr2  ; Enables serial interface
+        ; Setup Serial port (interrupt driven, see sci.asm)
+        jsr initSci
         
         ; Setup the data in the RAM
         ; For the Configuration Module
         movw #0,alarmCode
         movw #1000,mult
+        cli          ; enable interrupts (sci_isr)
         rts
 
    switch globalConst
@@ -131,6 +127,8 @@ NEWLINE  dc.b   NL,CR,$00
  INCLUDE	armed.asm
  INCLUDE	delay.asm
  INCLUDE	utilities.asm
+ INCLUDE	sci.asm
+ INCLUDE	format.asm
 
    switch code_section
 ENDCODE ;  used to define where the dataEEPROM section starts
@@ -42,12 +42,12 @@ enableAlarm:  pshd
                                 ;byte delayFlag;
    ;// Get a valid alarm code to arm the system
    ldd #CODEMSG                 ; printf(CODEMSG);
-   jsr [printf, PCr]
+   jsr sciPuts
    movb #FALSE,EAL_CODEVALID,SP ; codeValid = FALSE;
 eal_while1:
    tst EAL_CODEVALID,SP         ; while(!codeValid) 
    bne eal_endwhile1            ; {
-   jsr [getchar,PCr]              ;   input = getchar();
+   jsr sciGetchar              ;   input = getchar();
    stab EAL_INPUT,SP
    tba
    jsr checkCode                ;     codeValid = checkCode(input);
@@ -56,7 +56,7 @@ eal_while1:
 eal_endwhile1                   ; }
 
    ldd #ARMING                   ; printf(ARMING);
-   jsr [printf,PCr]
+   jsr sciPuts
    ; // Delay 1500 ms, i.e. 15 seconds
    ldd #ARMDELAY                 ; setDelay(ARMDELAY);
    jsr setDelay
@@ -96,7 +96,7 @@ eal_if3:			; if(!codeValid)
    tst EAL_CODEVALID,SP
    bne eal_endif3
    ldd #ARMED                   ;        printf(ARMED)
-   jsr [printf, PCr]
+   jsr sciPuts
 eal_endif3:
 eal_while3                      ;  while(!codeValid)
    tst EAL_CODEVALID,SP         ; {
@@ -121,7 +121,7 @@ eal_elseifA:
    cmpa #'a'
    bne eal_elseifB               ;   {
    ldd #DISARMING                ;      printf(DISARMING);
-   jsr [printf, PCr]
+   jsr sciPuts
    ldd #ARMDELAY                 ;      setDelay(ARMDELAY);
    jsr setDelay
 eal_while4:                      ;      while(!codeValid)
@@ -317,7 +317,7 @@ tra_while:                   ; while(!done)
    bne tra_endwhile
    ldab #BEL                 ;    putchar(BEL);
    clra
-   jsr [putchar, PCr]
+   jsr sciPutchar
    ldd #BEEPDELAY            ;    setDelay(BEEPDELAY);   //1 sec between beeps
    jsr setDelay
    movb #FALSE,TRA_DONEINPUT,SP ; doneInput = FALSE;
@@ -34,8 +34,8 @@ cfg_if1: jsr enterMstCode ; verify if master code is correct
       beq cfg_endif1
 cfg_loop:               ; repeat until valid input is given
       ldd #CONFIGMSG    ; display configuration message
-      jsr [printf,PCr]
-      jsr [getchar,PCr] ; read input from user
+      jsr sciPuts
+      jsr sciGetchar ; read input from user
       stab CFG_INPUT,SP ;
       movb #TRUE,CFG_FLAG,SP; set flag as true
 cfg_if2:
@@ -55,7 +55,7 @@ cfg_elseif2:
       bra cfg_endif2
 cfg_else2:              ; handle invalid input
       ldd #CERRMSG      ; display error message
-      jsr [printf,PCr]  ;
+      jsr sciPuts  ;
       movb #FALSE,CFG_FLAG,SP ; mark flag as false
 cfg_endif2:
       tst CFG_FLAG,SP   ; continue loop if flag is false
@@ -94,10 +94,10 @@ enterMstCode pshb
    movw #1000,EMC_MULT,SP     ; int mult = 1000;
    
    ldd #MSTCDMSG              ; printf(MSTCDMSG);
-   jsr [printf, PCr]
+   jsr sciPuts
    clr EMC_I,SP
 emc_for:                      ; for(i=0 ; i<4 ; i++)
-   jsr [getchar, PCr]         ; {
+   jsr sciGetchar         ; {
    stab EMC_INPUT,SP          ;    input = getchar();
 emc_if1:
    tba
@@ -181,10 +181,10 @@ setc_loop:                    ; do {
       movw #0,SETC_ALARMCODE,SP   ;  alarmCode=0;
       movw #1000,SETC_MULT,SP ;      mult=1000;
       ldd #GET_CODE_MSG       ;      printf(GET_CODE_MSG);
-      jsr [printf, PCr]
+      jsr sciPuts
       clr SETC_I,SP           ;      for(i=0 ; i< 4 ; i++)
 setc_for:                     ;      {
-      jsr [getchar, PCr]      ;         input = getchar();
+      jsr sciGetchar      ;         input = getchar();
       stab SETC_INPUT,SP
 setc_if cmpb #'d'             ;         if(input == 'd')
       bne setc_elseif         ;         { 
@@ -192,7 +192,7 @@ setc_if2 ldaa SETC_IX,SP      ;            if(ix == 0)
       cmpa #0
       bne setc_else2
       ldd #ERR_MST_MSG        ;               printf(ERR_MST_MSG);
-      jsr [printf,PCr]
+      jsr sciPuts
       bra setc_endif2
 setc_else2                    ;            else {
       movw #$ffff,SETC_ALARMCODE,SP ;            alarmCode = 0xffff;
@@ -223,7 +223,7 @@ setc_elseif:
       bra setc_endif          ;         }
 setc_else:                    ;         else {
       ldd #CERRMSG            ;                printf(CERRMSG);
-      jsr [printf, PCr]
+      jsr sciPuts
       bra setc_endfor         ;                break;
                               ;         }
 setc_endif:
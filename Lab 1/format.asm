@@ -0,0 +1,88 @@
+;------------------------------------------------------
+; Alarm System Simulation Assembler Program
+; File: format.asm
+; Description: The Format Module
+;    Emitters for terminal output that take no format
+;    string, in place of the DBug12 printf:
+;       sciPuts  - string (SCI Module)
+;       putDec   - unsigned decimal
+;       putHex   - 4 hex digits, putHexB - 2 hex digits
+;    All go to the transmit ring of the SCI Module: the
+;    caller does not wait for each character at 9600
+;    baud as with the DBug12 printf.
+;------------------------------------------------------
+
+	SWITCH code_section
+
+;------------------------------------------------------
+; Subroutine: putDec
+; Parameters: num - accumulator D (unsigned)
+; Returns: nothing
+; Variables: digits - on the stack
+;            cnt - Y register
+; Description: Prints num in decimal without leading
+;              zeros.  The digits are found from the
+;              last with IDIV and pushed, then printed.
+;------------------------------------------------------
+putDec: pshd
+   pshx
+   pshy
+   ldy #0                   ; cnt = 0;
+pdc_div:                    ; do {
+   ldx #10
+   idiv                     ;    num = num/10 (in X), remainder in B
+   addb #ASCII_CONV_NUM     ;    push(remainder + '0');
+   pshb
+   iny                      ;    cnt++;
+   tfr x,d
+   tbne d,pdc_div           ; } while(num != 0);
+pdc_out:                    ; do {
+   pulb                     ;    sciPutchar(pop());
+   jsr sciPutchar
+   dbne y,pdc_out           ; } while(--cnt != 0);
+   puly
+   pulx
+   puld
+   rts
+
+;------------------------------------------------------
+; Subroutine: putHex
+; Parameters: num - accumulator D
+; Returns: nothing
+; Description: Prints num as 4 hex digits.
+;------------------------------------------------------
+putHex: pshd
+   tab                      ; putHexB(high byte);
+   bsr putHexB
+   ldab 1,SP                ; putHexB(low byte);
+   bsr putHexB
+   puld
+   rts
+
+;------------------------------------------------------
+; Subroutine: putHexB
+; Parameters: num - accumulator B
+; Returns: nothing
+; Description: Prints num as 2 hex digits.
+;------------------------------------------------------
+putHexB: pshd
+   pshb
+   lsrb                     ; phx_digit(num >> 4);
+   lsrb
+   lsrb
+   lsrb
+   bsr phx_digit
+   pulb                     ; phx_digit(num & 0x0F);
+   andb #$0F
+   bsr phx_digit
+   puld
+   rts
+
+; Prints the hex digit in B (0 to 15)
+phx_digit:
+   cmpb #10                 ; if(dig >= 10) dig += 'A'-'0'-10;
+   blo phx_num
+   addb #'A'-'0'-10
+phx_num:
+   addb #'0'                ; sciPutchar(dig + '0');
+   jmp sciPutchar           ; returns to the caller of phx_digit
@@ -0,0 +1,173 @@
+;------------------------------------------------------
+; Alarm System Simulation Assembler Program
+; File: sci.asm
+; Description: The SCI Module
+;    Interrupt driven terminal I/O on SCI0 in place of
+;    the DBug12 printf, getchar and putchar, which wait
+;    for every character (1.04 ms at 9600 baud).
+;    sciPuts and sciPutchar copy into the transmit ring
+;    and return; sci_isr sends from the ring on TDRE and
+;    puts received characters in the receive ring on
+;    RDRF.  Only a full transmit ring makes sciPutchar
+;    wait.
+;------------------------------------------------------
+
+; Some definitions
+SCI_TIE      equ %10000000  ; Sc0cr2: transmit interrupt enable
+SCI_RIE      equ %00100000  ; Sc0cr2: receive interrupt enable
+SCI_TE_RE    equ %00001100  ; Sc0cr2: transmitter and receiver enabled
+SCI_TDRE     equ %10000000  ; Sc0sr1: transmit data register empty
+SCI_RDRF     equ %00100000  ; Sc0sr1: receive data register full
+SCI_BAUD     equ 156        ; 9600 baud with the 24 MHz bus
+UserSCI0     equ 43         ; SetUserVector number of SCI0 ($FFD6)
+TXSIZE       equ 128        ; ring sizes, powers of 2 up to 256
+RXSIZE       equ 16
+
+	SWITCH code_section
+
+;------------------------------------------------------
+; Subroutine: initSci
+; Parameters: none
+; Returns: nothing
+; Global Variables: txHead, txTail, rxHead, rxTail
+; Description: Installs sci_isr in the DBug12 user vector
+;              table, sets 9600 baud and enables the
+;              transmitter, the receiver and its interrupt.
+;              The caller clears the I bit.
+;------------------------------------------------------
+initSci: pshd
+   clr txHead               ; empty rings
+   clr txTail
+   clr rxHead
+   clr rxTail
+   ldd #sci_isr             ; SetUserVector(UserSCI0, sci_isr);
+   pshd                     ; second argument on the stack
+   ldd #UserSCI0            ; first argument passed in D
+   jsr [SetUserVector,PCr]
+   leas 2,SP                ; remove argument
+   ldd #SCI_BAUD
+   std Sc0bdh               ; Sets up the baud rate
+   movb #SCI_TE_RE|SCI_RIE,Sc0cr2
+   puld
+   rts
+
+;------------------------------------------------------
+; Subroutine: sciPutchar
+; Parameters: chr - accumulator B
+; Returns: nothing
+; Global Variables: txBuf, txHead, txTail
+; Description: Adds chr to the transmit ring and enables
+;              the transmit interrupt.  Waits only while
+;              the ring is full.
+;------------------------------------------------------
+sciPutchar: pshd
+   pshx
+   ldx #txBuf
+   ldaa txHead
+   stab a,x                 ; txBuf[txHead] = chr;  (always a free slot)
+   inca                     ; next = (txHead+1) % TXSIZE;
+   anda #TXSIZE-1
+spc_wait:
+   cmpa txTail              ; while(next == txTail) /*wait*/;
+   beq spc_wait
+   staa txHead              ; txHead = next;
+   bset Sc0cr2,SCI_TIE      ; sci_isr sends it
+   pulx
+   puld
+   rts
+
+;------------------------------------------------------
+; Subroutine: sciPuts
+; Parameters: str - address in accumulator D
+; Returns: nothing
+; Variables: ptr - X register
+; Description: Adds the NUL terminated string to the
+;              transmit ring (see sciPutchar).
+;------------------------------------------------------
+sciPuts: pshd
+   pshx
+   tfr d,x                  ; ptr = str;
+sps_loop:
+   ldab 1,x+                ; while(*ptr != 0) sciPutchar(*ptr++);
+   beq sps_end
+   bsr sciPutchar
+   bra sps_loop
+sps_end:
+   pulx
+   puld
+   rts
+
+;------------------------------------------------------
+; Subroutine: sciGetchar
+; Parameters: none
+; Returns: chr - in accumulator B (A is 0)
+; Global Variables: rxBuf, rxHead, rxTail
+; Description: Waits for a character in the receive
+;              ring and removes it.
+;------------------------------------------------------
+sciGetchar: pshx
+   ldaa rxTail
+sgc_wait:
+   cmpa rxHead              ; while(rxTail == rxHead) /*wait*/;
+   beq sgc_wait
+   ldx #rxBuf
+   ldab a,x                 ; chr = rxBuf[rxTail];
+   inca                     ; rxTail = (rxTail+1) % RXSIZE;
+   anda #RXSIZE-1
+   staa rxTail
+   clra
+   pulx
+   rts                      ; return(chr);
+
+;------------------------------------------------------
+; Interrupt: sci_isr
+; Global Variables: txBuf, txHead, txTail,
+;                   rxBuf, rxHead, rxTail
+; Description: SCI0 interrupt (installed by initSci).
+;              A received character goes into the receive
+;              ring (dropped if it is full).  When the
+;              transmitter is free the next character of
+;              the transmit ring is sent; the transmit
+;              interrupt is disabled once the ring is
+;              empty.  Reading Sc0sr1 then Sc0drl clears
+;              RDRF, writing Sc0drl clears TDRE.
+;------------------------------------------------------
+sci_isr:
+   brclr Sc0sr1,SCI_RDRF,sisr_tx  ; if(RDRF)
+   ldab Sc0drl              ; {  chr = SCI0DRL;
+   ldx #rxBuf
+   ldaa rxHead
+   stab a,x                 ;    rxBuf[rxHead] = chr;
+   inca                     ;    next = (rxHead+1) % RXSIZE;
+   anda #RXSIZE-1
+   cmpa rxTail              ;    if(next != rxTail) rxHead = next;
+   beq sisr_tx
+   staa rxHead              ; }
+sisr_tx:
+   brclr Sc0cr2,SCI_TIE,sisr_end  ; if(TIE && TDRE)
+   brclr Sc0sr1,SCI_TDRE,sisr_end ; {
+   ldaa txTail              ;    if(txTail == txHead) TIE = 0;
+   cmpa txHead
+   beq sisr_off
+   ldx #txBuf               ;    else
+   ldab a,x                 ;    {  SCI0DRL = txBuf[txTail];
+   stab Sc0drl
+   inca                     ;       txTail = (txTail+1) % TXSIZE;
+   anda #TXSIZE-1
+   staa txTail              ;    }
+   rti                      ; }
+sisr_off:
+   bclr Sc0cr2,SCI_TIE
+sisr_end:
+   rti
+
+;------------------------------------------------------
+; Global variables
+;------------------------------------------------------
+   switch globalVar
+txBuf  ds.b TXSIZE   ; transmit ring, sent by sci_isr
+rxBuf  ds.b RXSIZE   ; receive ring, filled by sci_isr
+txHead ds.b 1        ; next free slot of txBuf
+txTail ds.b 1        ; next character to send
+rxHead ds.b 1        ; next free slot of rxBuf
+rxTail ds.b 1        ; next character to read
@@ -14,10 +14,8 @@ Regblk:       equ    $0000
  INCLUDE sections.inc
  INCLUDE alarm.inc
 
-; Dbug12 subroutines
-putchar        equ   $EE86
-getchar        equ   $EE84
-printf         equ   $EE88
+; Dbug12 subroutines (terminal I/O is done by the SCI Module)
+SetUserVector  equ   $EEA4
 writeEEByte    equ   $EEA6
 
         switch code_section
@@ -38,7 +36,7 @@ writeEEByte    equ   $EEA6
    			;do
 mainloop:  			; {
         ldd #MENU          ;   printf(MENU);
-        jsr [printf,PCr] 
+        jsr sciPuts 
         jsr initKeyPad	   ;   select = readKey();
 	jsr readKey
         cmpb #'c'          ;   if(select == 'c') configCodes();
@@ -96,16 +94,14 @@ wait_b3:
         brclr Crgflg,x, %00001000 wait_b3  ; Wait until bit 3 = 1
         bset Clksel,x, %10000000
 
-        ; Setup Serial port
-        ldd #156
-        std Sc0bdh   ; Sets up the baud rate
-        ldaa #$0c
-        staa Sc0cr2  ; Enables serial interface
+        ; Setup Serial port (interrupt driven, see sci.asm)
+        jsr initSci
         
         ; Setup the data in the RAM
         ; For the Configuration Module
         movw #0,alarmCode
         movw #1000,mult
+        cli          ; enable interrupts (sci_isr)
         rts
 
    switch globalConst
@@ -131,6 +127,8 @@ NEWLINE  dc.b   NL,CR,$00
  INCLUDE 	keyPad.asm
  INCLUDE	delay.asm
  INCLUDE	utilities.asm
+ INCLUDE	sci.asm
+ INCLUDE	format.asm
  INCLUDE 	switches.asm
 	
    switch code_section
@@ -40,7 +40,7 @@ enableAlarm:  pshd
    leas  -EAL_VARSIZE,SP        ; Reserve space for input, code validity, and delay flag
    ;// Prompt user for a valid alarm code to arm the system
    ldd #CODEMSG                 ; Show message to prompt for code entry
-   jsr [printf, PCr]
+   jsr sciPuts
    movb #FALSE,EAL_CODEVALID,SP ; Set code validity to false
 eal_while1:
    tst EAL_CODEVALID,SP         ; Keep checking until a valid code is entered
@@ -54,7 +54,7 @@ eal_while1:
 eal_endwhile1:                   ; End of loop when valid code is entered
 
    ldd #ARMING                   ; Show message: "System is arming"
-   jsr [printf,PCr]
+   jsr sciPuts
    ; // Delay for 1500 ms, i.e., 15 seconds
    ldd #ARMDELAY                 ; Set delay duration to 15 seconds
    jsr setDelay
@@ -94,7 +94,7 @@ eal_if3:			; If code is not valid
    tst EAL_CODEVALID,SP
    bne eal_endif3
    ldd #ARMED                   ; Show message: "System is armed"
-   jsr [printf, PCr]
+   jsr sciPuts
 eal_endif3:
 eal_while3:                      ; Keep checking until a valid code is entered
    tst EAL_CODEVALID,SP         ; Check if code is valid
@@ -119,7 +119,7 @@ eal_elseifA:
    anda #%00000001
    beq eal_elseifB               ; If not opened, check other conditions
    ldd #DISARMING                ; Show message: "System is disarming"
-   jsr [printf, PCr]
+   jsr sciPuts
    ldd #ARMDELAY                 ; Set delay for disarming
    jsr setDelay
 eal_while4:                      ; Wait for valid code to disarm
@@ -318,7 +318,7 @@ tra_while:                   ; while(!done)
    bne tra_endwhile
    ldb #BEL                  ;    putchar(BEL);
    clra
-   jsr [putchar, PCr]
+   jsr sciPutchar
    ldd #BEEPDELAY            ;    setDelay(BEEPDELAY);   // 1 sec between beeps
    jsr setDelay
    movb #FALSE,TRA_DONEINPUT,SP ; doneInput = FALSE;
@@ -33,7 +33,7 @@ cfg_if1: jsr enterMstCode ; if(enterMstCode())
       beq cfg_endif1
 cfg_loop:               ;     do {
       ldd #CONFIGMSG    ;          printf(CONFIGMSG);
-      jsr [printf,PCr]
+      jsr sciPuts
       jsr readKey ;          input = readKey();
       stab CFG_INPUT,SP ;
       movb #TRUE,CFG_FLAG,SP;      flag = TRUE;
@@ -54,7 +54,7 @@ cfg_elseif2:
       bra cfg_endif2
 cfg_else2:              ;           else      
       ldd #CERRMSG      ;           { printf(CERRMSG);
-      jsr [printf,PCr]  ;
+      jsr sciPuts  ;
       movb #FALSE,CFG_FLAG,SP ;       flag = FALSE; }
 cfg_endif2:
       tst CFG_FLAG,SP   ;       } while(!flag);
@@ -94,7 +94,7 @@ enterMstCode pshb
    movw #1000,EMC_MULT,SP     ; int mult = 1000;
    
    ldd #MSTCDMSG              ; printf(MSTCDMSG);
-   jsr [printf, PCr]
+   jsr sciPuts
    clr EMC_I,SP
 emc_for:                      ; for(i=0 ; i<4 ; i++)
    jsr readKey                ; {
@@ -178,7 +178,7 @@ setcode: pshy       ; {
       staa SETC_IX,SP         ; save parameter value
 setc_loop:                    ; do {
       ldd #GET_CODE_MSG       ;      printf(GET_CODE_MSG);
-      jsr [printf, PCr]
+      jsr sciPuts
       clr SETC_I,SP           ;      for(i=0 ; i< 4 ; i++)
 setc_for:                     ;      {
       jsr readKey             ;         input = readKey();
@@ -189,7 +189,7 @@ setc_if2 ldaa SETC_IX,SP      ;            if(ix == 0)
       cmpa #0
       bne setc_else2
       ldd #ERR_MST_MSG        ;               printf(ERR_MST_MSG);
-      jsr [printf,PCr]
+      jsr sciPuts
       bra setc_endif2
 setc_else2                    ;            else {
       movw #$ffff,SETC_ALARMCODE,SP ;            alarmCode = 0xffff;
@@ -220,7 +220,7 @@ setc_elseif:
       bra setc_endif          ;         }
 setc_else:                    ;         else {
       ldd #CERRMSG            ;                printf(CERRMSG);
-      jsr [printf, PCr]
+      jsr sciPuts
       bra setc_endfor         ;                break;
                               ;         }
 setc_endif:
@@ -34,19 +34,21 @@ ISD_endif:
 ; Subroutine: pollgetchar
 ; Parameters:  none
 ; Returns: char read from SC0 or NOCHAR if none available
-;          Returned in Acc A
+;          Returned in Acc B
 ; Variables:
-;      ptr in X register
-;      sum in Accumulator B       
-; Description: Checks the RDRF bit to see if a character
-;              is available before reading a character using getchar.
+;      chr in Accumulator B
+; Description: Checks the receive ring of the SCI Module
+;              to see if a character is available before
+;              reading it with sciGetchar.
 ;------------------------------------------------------
 
-polgetchar: psha     ; gechar destroys contents of acc A
+polgetchar: psha     ; sciGetchar destroys contents of acc A
   ldab #NOCHAR        ;  char chr = NOCHAR;
   
-  brclr sc0sr1,%00100000,PGC_endif ; if(SCI0SR1_RDRF==1) 
-  jsr [getchar, PCr]  ;                    chr = getchar();
+  ldaa rxTail         ; if(rxTail != rxHead)
+  cmpa rxHead
+  beq PGC_endif
+  jsr sciGetchar      ;                    chr = sciGetchar();
 PGC_endif
    pula            ; restore registers
    rts             ; return(chr);  in ACC B
@@ -6,17 +6,22 @@ Description:  Segment Display Module
 
 #include "mc9s12dg256.h"
 #include "SegDisp.h"
+#include "clock.h"
+#include "diag.h"
+#include "trace.h"
 
 #define NUMDISPS 4  // number of displays
 #define SPACE ' '   // The space character
 #define BLANK 0xFF  // disables displays
 #define NUMFLASH 10 // Number of flashes
-#define DISP_TIMEOUT 3750	// For 50 ms delay (1 1/3 microSec/tick).
+#define DISP_TIMEOUT TICKS(50)	// For 5 ms delay (see clock.h).
 #define HALFSEC 500  // 500 ms = 1/2 sec
 
 
 // Global Variables
+#include "hot_data_begin.h"
 byte codes[NUMDISPS];  // ASCII codes for each display
+#pragma DATA_SEG DEFAULT
 
 struct ascii_to_code 
 {
@@ -72,11 +77,13 @@ void initDisp(void)
   clearDisp();   // clear the displays at the start
   
   // set up timer to generate interrupts for display control
-  // assume timer is already enabled elsewhere with 1 1/3 microsecond ticks
+  // assume timer is already enabled elsewhere (tick set by clock module)
+#ifndef UNIFIED_TIMER  // otherwise dispTask is run from tco_isr (see delay.c)
   TIOS |= 0b00000010; // set output compare on timer channel 1
   TIE |= 0b00000010;  // enable interrupt on timer channel 1
   
   TC1 = TCNT + DISP_TIMEOUT;  // set timer channel 1 to trigger after a timeout
+#endif
 }
 
 
@@ -159,12 +166,20 @@ void turnOffDP(int dNum)
 /*-------------------------------------------------
 Interrupt: disp_isr
 Description: Display interrupt service routine that
-             to update displays every 50 ms.
+             to update displays every 5 ms.  With
+             UNIFIED_TIMER it is the function dispTask
+             called from tco_isr.
 ---------------------------------------------------*/
+#ifdef UNIFIED_TIMER
+void dispTask(void)
+#else
 void interrupt VectorNumber_Vtimch1 disp_isr(void)
+#endif
 {
   static byte dNum = 0;  // preserve between invocations
   byte enable;
+  DIAG_ENTER();
+  TRACE_BEGIN(TR_DISP_ISR);
   
   PORTB = codes[dNum];
   enable = PTP;  // get current values
@@ -172,8 +187,12 @@ void interrupt VectorNumber_Vtimch1 disp_isr(void)
   PTP = enable | enableCodes[dNum]; // set lower for bits
   dNum++;
   dNum = dNum%NUMDISPS;
+#ifndef UNIFIED_TIMER
 	// Set up next interrupt (also clears the interrupt)
 	TC1 = TC1 + DISP_TIMEOUT;
+#endif
+  TRACE_END(TR_DISP_ISR);
+  DIAG_LEAVE(DIAG_DISP);
 }
 
 
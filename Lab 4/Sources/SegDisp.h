@@ -8,4 +8,7 @@ void initDisp(void);
 void clearDisp(void);
 void setCharDisplay(char, byte );
 void turnOnDP(int);
-void turnOffDP(int);
\ No newline at end of file
+void turnOffDP(int);
+#ifdef UNIFIED_TIMER
+void dispTask(void);  // run every 5 ms by tco_isr
+#endif
\ No newline at end of file
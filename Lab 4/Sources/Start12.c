@@ -23,6 +23,7 @@ Note: C++ destructors of global objects are NOT yet supported in the HIWARE Obje
 
 #include "hidef.h"
 #include "start12.h"
+#include "diag.h"
 
 /***************************************************************************/
 /* Macros to control how the startup code handles the COP:                 */
@@ -414,6 +415,17 @@ __EXTERN_C void _Startup(void) {
    ___INITEE = 0x09;  /* lock EEPROM block to end at 0x0fff */
 #endif
 
+#ifdef DIAG
+   /* paint the stack for the high-water mark (see diag.c) - nothing is on it yet */
+   __asm {
+             LDX   #__SEG_START_SSTACK
+             LDAA  #DIAG_PAINT
+   paint:    STAA  1,X+
+             CPX   #__SEG_END_SSTACK
+             BLO   paint
+   }
+#endif
+
    /* Here user defined code could be inserted, the stack could be used */
 #if defined(_DO_DISABLE_COP_)
    _DISABLE_COP();
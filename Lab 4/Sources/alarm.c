@@ -44,20 +44,35 @@ void displayTemp(int);
 void main()
 {
    byte select;
-   PLL_init();  // initialize phase-locked loop (PLL) for clock
+   byte menu = FALSE;  // the menu is up (disarmed and idle)
    initMain();  // initialize main settings
 
    // main loop
    for(;;)  // loop forever
    {
+      if(!menu)  // back to the menu
+      {
+         setClockProfile(CLK_LOW_POWER);  // disarmed and idle - run slower (see clock.h)
+         TELEM_STATE(TS_IDLE);
+         menu = TRUE;
+      }
       printLCDStr(MENU1, 0);  // display first menu on LCD
       printLCDStr(MENU2, 1);  // display second menu on LCD
       select = pollReadKey(); // read user input from the keypad
 
       if(select == 'c') 
+      {
+         menu = FALSE;
+         setClockProfile(CLK_FULL_SPEED);  // EEPROM clock divider assumes the full speed bus
+         TELEM_STATE(TS_CONFIG);
          configCodes();  // if 'c' pressed, configure alarm codes
+      }
       else if(select == 'a') 
+      {
+         menu = FALSE;
+         setClockProfile(CLK_FULL_SPEED);
          enableAlarm();  // if 'a' pressed, enable alarm
+      }
       else 
          ;  // do nothing if no valid key is pressed
    }
@@ -73,6 +88,10 @@ void main()
 void initMain()
 {
    // initialisation of various components
+   initClock(CLK_FULL_SPEED);  // initialize phase-locked loop (PLL) and timer prescaler
+#ifdef DIAG
+   initDiag();  // diagnostic command on SCI1 (baud rate set by initClock)
+#endif
    initCodes();  // initialize alarm codes
    initKeyPad();  // initialize keypad
    initSwitches();  // initialize switches
@@ -80,11 +99,15 @@ void initMain()
 
    // setup the timer
    TSCR1 = 0b10010000;  // enable the timer and enable fast clear
-   TSCR2 = 0b00000101;  // setup prescaler to 32, for 1 1/3 micro-sec tick
+                        // prescaler is set by the clock module (see clock.c)
 
    initSiren();  // initialize siren
    initDelay();  // initialize delay module
+   HPRIO = HPRIO_VECTOR;  // siren first when interrupts are pending (see intPrio.h)
    asm cli;  // clear interrupt flag
+#ifdef TELEM
+   initTelem();  // event frames on SCI1 (needs interrupts)
+#endif
    initLCD();   // need to initialize with interrupts running since delay module is used
 }
 
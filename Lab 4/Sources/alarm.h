@@ -42,3 +42,8 @@
 #include "lcdDisp.h"  // LCD Display Module
 #include "SegDisp.h"  // Segment Display Module
 #include "siren.h"    // Siren Module
+#include "clock.h"    // Clock Module
+#include "intPrio.h"  // Interrupt priorities
+#include "diag.h"     // Diagnostics Module
+#include "trace.h"    // Trace points
+#include "telem.h"    // Telemetry Module
@@ -54,6 +54,7 @@ void enableAlarm(void)
      codeValid = checkCode(input);  // check if input code is valid
    }
    printLCDStr(ARMING,1);
+   TELEM_STATE(TS_ARMING);
    // stop displaying temperature
    displayTempFlag = FALSE;
    clearDisp();
@@ -103,6 +104,7 @@ void systemArmed()
    // loop to monitor triggers and alarm code to disable alarm
    // codeValid is TRUE if valid alarm code entered
    if(!codeValid) printLCDStr(ARMED,1);   
+   TELEM_STATE(TS_ARMED);
    while(!codeValid)
    {
        input = pollReadKey();  // read user input
@@ -112,6 +114,7 @@ void systemArmed()
        {
            triggerAlarm();   // trigger alarm
            printLCDStr(DISARMING,1);
+           TELEM_STATE(TS_ENTRY);
            // stop displaying temperature
            displayTempFlag = FALSE;
            clearDisp();
@@ -169,6 +172,7 @@ byte checkCode(byte input)
    static int mult = 1000; // multiplier for the digit's place value
    static int alarmCode = 0;   // stores the current alarm code value
    byte retval = FALSE;  // return value indicating if code is valid
+   TRACE_BEGIN(TR_CHECK_CODE);
 
    // check if the input is a digit
    if(isdigit(input))
@@ -188,6 +192,7 @@ byte checkCode(byte input)
       mult = 1000;  // reset the multiplier
    }
    
+   TRACE_END(TR_CHECK_CODE);
    return(retval);  // return if the code is valid or not
 }
 
@@ -234,6 +239,7 @@ void triggerAlarm()
    byte done = FALSE; // flag to indicate if the alarm code is entered
    byte input;
    turnOnSiren();  // activate the siren
+   TELEM_STATE(TS_ALARM);
 
    // loop until a valid code is entered
    while(!done)
@@ -0,0 +1,106 @@
+/*------------------------------------------------------
+File: clock.c
+Description:  Clock Module
+              Selects the bus clock (PLL) and the timer
+              prescaler for a clock profile.  All timer
+              periods in the other modules are given with
+              TICKS() so they follow the current profile.
+-------------------------------------------------------*/
+
+#include "mc9s12dg256.h"
+#include "main_asm.h"
+#include "clock.h"
+
+#ifdef CLOCK_PROFILES
+
+#define NUMPROFILES 2
+
+struct clk_profile
+{
+   byte usePLL;     // 1 - PLLCLK (24 MHz bus), 0 - OSCCLK (4 MHz bus)
+   byte prescale;   // value for TSCR2 (timer prescaler)
+   word ticks;      // timer ticks in 0.1 ms
+   word sbr;        // SCI baud divisor for 9600 baud (bus clock / (16 * 9600))
+};
+
+struct clk_profile profiles[NUMPROFILES] =
+{
+   { 1, 0b00000101, 75, 156 },  // full speed: 24 MHz/32, 75 * 1 1/3 micro-sec = 0.1 ms
+#ifdef NO_MONITOR
+   { 0, 0b00000011, 50, 26 }    // low power: 4 MHz/8, 50 * 2 micro-sec = 0.1 ms
+#else
+   { 1, 0b00000101, 75, 156 }   // low power: no-op, the bus is kept for SCI0 of the serial monitor
+#endif
+};
+
+// Global Variables
+#include "hot_data_begin.h"
+volatile word ticksPerTenthMs = 75;  // timer ticks in 0.1 ms for current profile
+#pragma DATA_SEG DEFAULT
+static byte curProfile = CLK_FULL_SPEED;
+
+// Prototypes of local functions
+void applyProfile(byte);
+
+/*----------------------------------------------------
+Function: initClock
+Description: Sets up the clock for the given profile at
+             startup.  Must be called before the timer
+             is used and before interrupts are enabled.
+------------------------------------------------------*/
+void initClock(byte profile)
+{
+   if(profile >= NUMPROFILES) return;
+   if(profiles[profile].usePLL) PLL_start();
+   applyProfile(profile);
+}
+
+/*----------------------------------------------------
+Function: setClockProfile
+Description: Switches to another clock profile while
+             the system is running.  The PLL is started and
+             locks with the interrupts as they were; only the
+             switch of the bus clock, prescaler and tick is
+             done with interrupts masked.  Compare events
+             already scheduled with the old tick run once
+             with the old period; the ISRs use the new tick
+             when they reschedule.
+------------------------------------------------------*/
+void setClockProfile(byte profile)
+{
+   byte ccr;
+
+   if(profile >= NUMPROFILES || profile == curProfile) return;
+   if(profiles[profile].usePLL && !profiles[curProfile].usePLL)
+      PLL_start();  // lock wait, bus still on OSCCLK
+   ccr = maskInts();  // no timer interrupts while the tick changes
+   applyProfile(profile);
+   restoreInts(ccr);
+}
+
+/*----------------------------------------------------
+Function: getClockProfile
+Description: Returns the current clock profile.
+------------------------------------------------------*/
+byte getClockProfile(void)
+{
+   return(curProfile);
+}
+
+/*----------------------------------------------------
+Function: applyProfile
+Description: Selects the bus clock and timer prescaler
+             of a profile.  The PLL of a profile using it
+             is on and locked (PLL_start).
+------------------------------------------------------*/
+void applyProfile(byte profile)
+{
+   if(profiles[profile].usePLL) PLL_select();  // select PLLCLK
+   else PLL_off();  // select OSCCLK and turn off the PLL
+   TSCR2 = profiles[profile].prescale;
+   ticksPerTenthMs = profiles[profile].ticks;
+   setSci1Baud(profiles[profile].sbr);
+   curProfile = profile;
+}
+
+#endif /* CLOCK_PROFILES */
@@ -0,0 +1,71 @@
+/*----------------
+File: clock.h
+Description: Header file for Clock Module
+--------------------*/
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "mc9s12dg256.h"
+#include "diag.h"  // DIAG, TELEM (telem.h): SCI1 in use
+
+// Timer layout: define UNIFIED_TIMER (here or with -DUNIFIED_TIMER) to
+// run the delay, display and keypad work from the single TC0 interrupt
+// with a phase table (see delay.c) instead of TC0, TC1 and TC4.
+//#define UNIFIED_TIMER
+
+// Clock profiles: define CLOCK_PROFILES (here or with -DCLOCK_PROFILES)
+// once clock.c is in the Sources group of Lab4.mcp.  Without it the
+// bus stays at 24 MHz with the 1 1/3 micro-sec timer tick.
+//#define CLOCK_PROFILES
+
+// Serial monitor: SCI0 of the serial monitor (and the debugger on it)
+// runs from the bus clock, so under the monitor CLK_LOW_POWER is the
+// same as CLK_FULL_SPEED: a no-op, the bus stays at 24 MHz.  Only an
+// image built with NO_MONITOR (here or with -DNO_MONITOR), which runs
+// without it (Full Chip Simulation, or flashed on its own), turns the
+// PLL off for a 4 MHz bus in the low power profile.
+//#define NO_MONITOR
+
+#define CLK_FULL_SPEED 0  // PLL on, 24 MHz bus, 1 1/3 micro-sec timer tick
+#define CLK_LOW_POWER  1  // NO_MONITOR: PLL off, 4 MHz bus, 2 micro-sec timer tick
+
+// SCI1 baud divisor, written only when SCI1 is used (DIAG or TELEM):
+// the baud rate follows the bus clock
+#if defined(DIAG) || defined(TELEM)
+#define setSci1Baud(sbr) (SCI1BD = (sbr))
+#else
+#define setSci1Baud(sbr)
+#endif
+
+#ifdef CLOCK_PROFILES
+// Number of timer ticks in tenthMs tenths of a millisecond
+// for the current clock profile
+#define TICKS(tenthMs) ((tenthMs)*ticksPerTenthMs)
+
+// Read by every timer ISR - allocated in HOT_DATA (see clock.c)
+#include "hot_data_begin.h"
+extern volatile word ticksPerTenthMs;
+#pragma DATA_SEG DEFAULT
+
+// Function Prototypes
+void initClock(byte);
+void setClockProfile(byte);
+byte getClockProfile(void);
+#else
+#include "main_asm.h"  // PLL_init
+
+#define TICKS(tenthMs) ((tenthMs)*75)  // 75 * 1 1/3 micro-sec = 0.1 ms
+
+// PLL, timer prescaler (/32) and SCI1 (9600 baud) of the full speed bus
+#define initClock(profile) \
+   do \
+   { \
+      PLL_init(); \
+      TSCR2 = 0b00000101; \
+      setSci1Baud(156); \
+   } while(0)
+#define setClockProfile(profile)
+#define getClockProfile() CLK_FULL_SPEED
+#endif
+
+#endif /* _CLOCK_H */
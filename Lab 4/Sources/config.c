@@ -193,7 +193,7 @@ int initEE(int ix, int code)
       *eepromAddr = code;    // Write data word aligned address
       ECMD = PROG;              // Write program command
       ESTAT = CBEIF;            // Write 1 to CBEIF to lauch command
-      if(ESTAT & (ACCERR|PVIOL) != 0) retVal = FALSE; // Flag the error
+      if((ESTAT & (ACCERR|PVIOL)) != 0) retVal = FALSE; // Flag the error
       else while(!(ESTAT & CCIF)) ;  // wait until command complete      
    } 
    else retVal = FALSE; // Flag error - command buffer not empty
@@ -214,6 +214,7 @@ int writeToEE(int ix, int code)
    int retVal = TRUE;  // assume that write is successful
    int *eepromAddr;
    int newcodes[2];
+   TRACE_BEGIN(TR_WRITE_EE);
    // Detemine which four bytes need modifying
    if(ix < 2) // ix is 0 or 1
    {
@@ -243,18 +244,19 @@ int writeToEE(int ix, int code)
       *eepromAddr = newcodes[0];    // Write data word aligned address
       ECMD = SECTOR_MODIFY;     // Erases 2 words, write one word
       ESTAT = CBEIF;            // Write 1 to CBEIF to lauch command
-      if(ESTAT & (ACCERR|PVIOL) != 0) retVal = FALSE; // Flag the error
+      if((ESTAT & (ACCERR|PVIOL)) != 0) retVal = FALSE; // Flag the error
       else 
       {
          while(!(ESTAT & CCIF)) ;  // wait until command complete      
          *(eepromAddr+1) = newcodes[1];    // Write data word aligned address
          ECMD = PROG;              // Write program command
          ESTAT = CBEIF;            // Write 1 to CBEIF to lauch command
-         if(ESTAT & (ACCERR|PVIOL) != 0) retVal = FALSE; // Flag the error
+         if((ESTAT & (ACCERR|PVIOL)) != 0) retVal = FALSE; // Flag the error
          else while(!(ESTAT & CCIF)) ;  // wait until command complete      
       }
    } 
    else retVal = FALSE; // Flag error - command buffer not empty
+   TRACE_END(TR_WRITE_EE);
    return(retVal);
 }
 
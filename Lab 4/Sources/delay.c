@@ -2,17 +2,50 @@
 File: Delay.c
 Description:  Delay module
               Uses Timer Channel 0
+              With UNIFIED_TIMER, TC0 interrupts every 1 ms
+              and also runs the display and keypad work
+              from the phase table tasks[].
 -------------------------------------------------------*/
 
 #include "mc9s12dg256.h"
 #include <stddef.h>
-#include "Delay.h"
+#include "delay.h"
+#include "clock.h"
+#include "intPrio.h"
+#include "diag.h"
+#include "telem.h"
+#ifdef UNIFIED_TIMER
+#include "SegDisp.h"
+#include "keyPad.h"
+#endif
 // Some definitions
-#define ONETENTH_MS 75	// number for timer to increment in 0.1 ms (75*1 1/3 micro-sec)
+#define ONETENTH_MS TICKS(1)	// number for timer to increment in 0.1 ms (see clock.h)
+#define ONE_MS TICKS(10)	// number for timer to increment in 1 ms
 // Global Variables
+#include "hot_data_begin.h"
 static volatile int timeCounter; // Module global variable for blocking delay
 static volatile int *countPtr = NULL;  // Pointer to counter in other module 
 static volatile int isrCounter; 
+#pragma DATA_SEG DEFAULT
+
+#ifdef UNIFIED_TIMER
+// Phase table for the work run from tco_isr.  The display
+// runs at 2, 7, 12 ... ms and the keypad at 4, 14, 24 ... ms
+// so they never run in the same interrupt.
+struct timer_task
+{
+   void (*task)(void);
+   byte period;  // in ms
+   byte count;   // ms until the next run (initially the phase + 1)
+};
+
+#define NUMTASKS 2
+struct timer_task tasks[NUMTASKS] =
+{
+   { dispTask,  5, 3 },  // 5 ms, phase 2
+   { keyTask,  10, 5 }   // 10 ms, phase 4
+};
+#endif
 
 /*----------------------------------------------------
 Function: initDelay
@@ -23,7 +56,11 @@ void initDelay(void)
 {
 	TIOS_IOS0 = 1; // set TC0 to output-compare
 	TIE_C0I = 0x01; // enable interrupt channel 0
-	TC0 = TCNT + ONETENTH_MS; // Set TC0 for one ms delay
+#ifdef UNIFIED_TIMER
+	TC0 = TCNT + ONE_MS; // Set TC0 for one ms delay
+#else
+	TC0 = TCNT + ONETENTH_MS; // Set TC0 for one tenth of a ms delay
+#endif
 	isrCounter = 10;  // to count 1 ms in the ISR
 }
 
@@ -47,7 +84,8 @@ Description: Delays num millisecond (blocks until delay
 void delayms(int num) 
 {
     timeCounter = num;  // count num millisecond
-    while(timeCounter) /*wait*/;
+    while(timeCounter) DIAG_IDLE();  // wait (idle time for the CPU load, see diag.c)
+    DIAG_IDLE_END();
 }
 
 /*----------------------------------------------------
@@ -55,17 +93,50 @@ Interrupt: tc0_isr
 Description: This service routine decrements the counter
              variable timeCounter and the counter 
              referenced by countPtr every 1ms. It resets
-             the timer channel.
+             the timer channel. With UNIFIED_TIMER it also
+             runs the tasks in tasks[] when they are due.
 -------------------------------------------------------*/
+#ifdef UNIFIED_TIMER
+void interrupt VectorNumber_Vtimch0 tco_isr(void) 
+{    
+    byte i;
+    DIAG_ENTER();
+#ifdef NEST_TCO_ISR
+    TC0 = TC0 + ONE_MS;  // set up next interrupt first (this also resets the interrupt)
+    ISR_NEST();  // tasks can be interrupted by the siren
+#endif
+    timeCounter--;  // decrement the time counter
+    if(countPtr != NULL) (*countPtr)--;  // decrement the value pointed to by countPtr, if it's not NULL
+    DIAG_MS();
+    TELEM_MS();
+    for(i = 0; i < NUMTASKS; i++)  // run the tasks due in this ms
+    {
+       if(--tasks[i].count == 0)
+       {
+          tasks[i].count = tasks[i].period;
+          tasks[i].task();
+       }
+    }
+#ifndef NEST_TCO_ISR
+    TC0 = TC0 + ONE_MS;  // increment TC0 by one millisecond (this also resets the interrupt)
+#endif
+    DIAG_LEAVE(DIAG_TCO);
+}
+#else
 void interrupt VectorNumber_Vtimch0 tco_isr(void) 
 {    
+    DIAG_ENTER();
     isrCounter--;  // decrement the ISR counter
     if(isrCounter == 0)  // check if ISR counter reached zero
     {
        isrCounter = 10;  // reset ISR counter to 10
        timeCounter--;  // decrement the time counter
        if(countPtr != NULL) (*countPtr)--;  // decrement the value pointed to by countPtr, if it's not NULL
+       DIAG_MS();
+       TELEM_MS();
     }
     TC0 = TC0 + ONETENTH_MS;  // increment TC0 by one-tenth of a millisecond (this also resets the interrupt)
+    DIAG_LEAVE(DIAG_TCO);
 }
+#endif
 
@@ -0,0 +1,241 @@
+/*------------------------------------------------------
+File: diag.c
+Description:  Diagnostics Module
+              Measures the system on the target and
+              reports it on SCI1 (9600 baud, 8N1) when 'd'
+              or '?' is received:
+              - stack high-water mark: the stack is painted
+                with DIAG_PAINT at startup (Start12.c), the
+                bytes still painted were never used;
+              - CPU load: time spent in the wait loops
+                (delayms, readKey, pollReadKey), less the ISRs that ran
+                meanwhile, over the time since the last
+                report (ms from tco_isr);
+              - for each ISR the number of entries and the
+                bus cycles from TCNT (DIAG_ENTER to
+                DIAG_LEAVE, without the 9 cycles of entry
+                and the RTI).  The resolution is one timer
+                tick (32 cycles at full speed, 8 at low
+                power).  A nested ISR is also counted in
+                the ISR it interrupted.
+              SCI0 is left to the serial monitor.  The
+              report is sent one character per pass of a
+              wait loop so nothing blocks on the SCI.  With
+              TELEM (telem.h) it is sent as TM_COUNTERS and
+              TM_ISR frames instead.
+-------------------------------------------------------*/
+
+#include "mc9s12dg256.h"
+#include "main_asm.h"
+#include "diag.h"
+#include "clock.h"
+#include "format.h"
+#include "telem.h"
+
+#ifdef DIAG
+
+#define SCI_TE_RE 0b00001100  // SCI1CR2: transmitter and receiver enabled
+#define PRESCALE 0b00000111   // TSCR2: timer prescaler bits (ticks are 2^n cycles)
+#define REPORT_SIZE 240  // the longest report (10 digit counts) is about 210
+
+struct diag_isr
+{
+   unsigned long count;   // entries
+   unsigned long cycles;  // bus cycles in total
+   word maxCycles;        // longest entry
+};
+
+// Global Variables
+#include "hot_data_begin.h"
+volatile unsigned long diagMs;  // ms since reset, counted by tco_isr
+static struct diag_isr isrs[DIAG_ISRS];
+static volatile word isrTicks;  // timer ticks in the ISRs (wraps)
+#pragma DATA_SEG DEFAULT
+
+#ifndef TELEM
+static const char *isrNames[DIAG_ISRS] = { "tco", "disp", "key", "siren" };
+#endif
+
+static byte inIdle;          // lastIdle is the previous pass of a wait loop
+static word lastIdle;        // TCNT at that pass
+static word lastIsrTicks;    // isrTicks at that pass
+static word idleTicks;       // idle less than 0.1 ms
+static unsigned long idleTenths;  // idle time in 0.1 ms since the last report
+static unsigned long startMs;     // diagMs at the last report
+
+static char report[REPORT_SIZE];
+static byte outPos, outLen;  // next character to send, end of the report
+
+// Prototypes of local functions
+void serial(void);
+void makeReport(void);
+
+/*----------------------------------------------------
+Function: initDiag
+Description: Enables SCI1 for the diagnostic command.
+             The baud rate is set with the clock profile
+             (see clock.c), so initClock comes first.
+------------------------------------------------------*/
+void initDiag(void)
+{
+   SCI1CR2 = SCI_TE_RE;
+}
+
+/*----------------------------------------------------
+Function: diagLeave
+Description: Counts one entry of ISR id that started at
+             TCNT value start (see DIAG_ENTER).  An ISR
+             that reenables interrupts (intPrio.h) gets here
+             with I clear, so the counters are updated with
+             interrupts masked.
+------------------------------------------------------*/
+void diagLeave(byte id, word start)
+{
+   word ticks = TCNT - start;
+   word cycles = ticks << (TSCR2 & PRESCALE);
+   byte ccr = maskInts();
+
+   isrs[id].count++;
+   isrs[id].cycles += cycles;
+   if(cycles > isrs[id].maxCycles) isrs[id].maxCycles = cycles;
+   isrTicks += ticks;
+   restoreInts(ccr);
+}
+
+/*----------------------------------------------------
+Function: diagIdle
+Description: Called on every pass of a wait loop.  The
+             time since the previous pass, less the ISRs,
+             is idle.  Also serves the SCI1 command.
+------------------------------------------------------*/
+void diagIdle(void)
+{
+   word now = TCNT;
+   word isr = isrTicks;
+   word delta = now - lastIdle;
+
+   if(inIdle && delta > (word)(isr - lastIsrTicks))
+   {
+      idleTicks += delta - (word)(isr - lastIsrTicks);
+      while(idleTicks >= TICKS(1))
+      {
+         idleTicks -= TICKS(1);
+         idleTenths++;
+      }
+   }
+   lastIdle = now;
+   lastIsrTicks = isr;
+   inIdle = 1;
+   serial();
+}
+
+/*----------------------------------------------------
+Function: diagIdleEnd
+Description: Called when a wait loop ends: the time up
+             to the next wait loop is not idle.
+------------------------------------------------------*/
+void diagIdleEnd(void)
+{
+   inIdle = 0;
+}
+
+/*----------------------------------------------------
+Function: serial
+Description: Sends the next character of the report or,
+             when there is none, checks for a command.
+------------------------------------------------------*/
+void serial(void)
+{
+   char cmd;
+
+   if(outPos < outLen)
+   {
+      if(SCI1SR1 & SCI1SR1_TDRE_MASK) SCI1DRL = report[outPos++];
+   }
+   else if(SCI1SR1 & SCI1SR1_RDRF_MASK)
+   {
+      cmd = SCI1DRL;  // reading SR1 then the data clears RDRF
+      if(cmd == 'd' || cmd == '?') makeReport();
+   }
+}
+
+/*----------------------------------------------------
+Function: makeReport
+Description: Builds the report and starts a new period
+             for the CPU load:
+                stack 63/256 load 12% (5000 ms)
+                isr count cycles max
+                tco 50000 1600000 64
+                ...
+             or queues it as telemetry frames.
+------------------------------------------------------*/
+void makeReport(void)
+{
+   char *sp = __SEG_START_SSTACK;
+   unsigned long ms, busy, load;
+   struct diag_isr isr;
+   byte i, ccr;
+#ifdef TELEM
+   unsigned long vals[4];
+#else
+   char *end;
+#endif
+
+   while(sp < __SEG_END_SSTACK && *sp == (char)DIAG_PAINT) sp++;
+
+   ccr = maskInts();  // diagMs is changed by tco_isr
+   ms = diagMs;
+   restoreInts(ccr);
+   ms -= startMs;
+   busy = ms * 10 > idleTenths ? ms * 10 - idleTenths : 0;
+   load = ms ? busy * 10 / ms : 0;
+
+#ifdef TELEM
+   vals[0] = __SEG_END_SSTACK - sp;
+   vals[1] = __SEG_END_SSTACK - __SEG_START_SSTACK;
+   vals[2] = load;
+   telemSend(TM_COUNTERS, vals, 3);
+   for(i = 0; i < DIAG_ISRS; i++)
+   {
+      ccr = maskInts();  // changed by diagLeave
+      isr = isrs[i];
+      restoreInts(ccr);
+      vals[0] = i;
+      vals[1] = isr.count;
+      vals[2] = isr.cycles;
+      vals[3] = isr.maxCycles;
+      telemSend(TM_ISR, vals, 4);
+   }
+#else
+   end = fmtStr(report, "stack ");
+   end = fmtDec(end, __SEG_END_SSTACK - sp);
+   end = fmtStr(end, "/");
+   end = fmtDec(end, __SEG_END_SSTACK - __SEG_START_SSTACK);
+   end = fmtStr(end, " load ");
+   end = fmtDec(end, load);
+   end = fmtStr(end, "% (");
+   end = fmtDec(end, ms);
+   end = fmtStr(end, " ms)\r\nisr count cycles max\r\n");
+   for(i = 0; i < DIAG_ISRS; i++)
+   {
+      ccr = maskInts();  // changed by diagLeave
+      isr = isrs[i];
+      restoreInts(ccr);
+      end = fmtStr(end, isrNames[i]);
+      end = fmtStr(end, " ");
+      end = fmtDec(end, isr.count);
+      end = fmtStr(end, " ");
+      end = fmtDec(end, isr.cycles);
+      end = fmtStr(end, " ");
+      end = fmtDec(end, isr.maxCycles);
+      end = fmtStr(end, "\r\n");
+   }
+   outPos = 0;
+   outLen = (byte)(end - report);
+#endif
+
+   startMs += ms;
+   idleTenths = 0;
+}
+
+#endif /* DIAG */
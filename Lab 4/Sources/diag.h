@@ -0,0 +1,81 @@
+/*----------------
+File: diag.h
+Description: Header file for the Diagnostics Module
+             (stack high-water mark, CPU load and ISR
+             counters, reported on SCI1 - see diag.c)
+--------------------*/
+#ifndef _DIAG_H
+#define _DIAG_H
+
+#include "mc9s12dg256.h"
+#include "telem.h"  // TELEM_IDLE
+
+// Diagnostics: define DIAG (here or with -DDIAG) for the stack
+// painting, the ISR counters and the SCI1 command, once diag.c and
+// format.c (which builds its report) are in the Sources group of
+// Lab4.mcp.
+//#define DIAG
+
+// ISRs counted by DIAG_ENTER/DIAG_LEAVE (with UNIFIED_TIMER the
+// display and keypad are the tasks run inside tco_isr)
+#define DIAG_TCO   0  // tco_isr (delay.c)
+#define DIAG_DISP  1  // disp_isr or dispTask (SegDisp.c)
+#define DIAG_KEY   2  // key_isr or keyTask (keyPad.c)
+#define DIAG_SIREN 3  // sirenISR (siren.c)
+#define DIAG_ISRS  4
+
+#define DIAG_PAINT 0xA5  // value of the stack bytes never written
+
+// Stack segment (linker symbols, see the .prm)
+#ifndef __SEG_START_SSTACK
+extern char __SEG_START_SSTACK[], __SEG_END_SSTACK[];
+#endif
+
+// IDLE_HOOK() runs on every pass of a wait loop (DIAG_IDLE), with
+// or without DIAG, after TELEM_IDLE() (telem.h).  The host build
+// (Tools/host) defines it in its mc9s12dg256.h to skip the idle
+// time of the loop.
+#ifndef IDLE_HOOK
+#define IDLE_HOOK()
+#endif
+
+#ifdef DIAG
+// DIAG_ENTER() goes last in the declarations of an ISR and
+// DIAG_LEAVE(id) at its end, DIAG_IDLE() in a wait loop and
+// DIAG_IDLE_END() after it.
+#define DIAG_ENTER() word diagStart = TCNT
+#define DIAG_LEAVE(id) diagLeave(id, diagStart)
+#define DIAG_MS() diagMs++
+#define DIAG_IDLE() \
+   do \
+   { \
+      diagIdle(); \
+      TELEM_IDLE(); \
+      IDLE_HOOK(); \
+   } while(0)
+#define DIAG_IDLE_END() diagIdleEnd()
+
+// Counted by tco_isr - allocated in HOT_DATA (see diag.c)
+#include "hot_data_begin.h"
+extern volatile unsigned long diagMs;
+#pragma DATA_SEG DEFAULT
+
+// Function Prototypes
+void initDiag(void);
+void diagLeave(byte, word);
+void diagIdle(void);
+void diagIdleEnd(void);
+#else
+#define DIAG_ENTER()
+#define DIAG_LEAVE(id)
+#define DIAG_MS()
+#define DIAG_IDLE() \
+   do \
+   { \
+      TELEM_IDLE(); \
+      IDLE_HOOK(); \
+   } while(0)
+#define DIAG_IDLE_END()
+#endif
+
+#endif /* _DIAG_H */
@@ -0,0 +1,73 @@
+/*------------------------------------------------------
+File: format.c
+Description:  Format Module
+              Builds messages from a string, decimal and
+              hex emitters instead of a printf that parses
+              a format string at run time:
+                 end = fmtStr(buf, "load ");
+                 end = fmtDec(end, load);
+              The caller's buffer must hold the message and
+              its NUL (no length is checked).
+-------------------------------------------------------*/
+
+#include "format.h"
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+/*----------------------------------------------------
+Function: fmtStr
+Description: Copies str.
+------------------------------------------------------*/
+char *fmtStr(char *dst, const char *str)
+{
+   while(*str) *dst++ = *str++;
+   *dst = '\0';
+   return(dst);
+}
+
+/*----------------------------------------------------
+Function: fmtDec
+Description: num in decimal without leading zeros (1
+             to 10 digits).  The digits are found from
+             the last, with a word division once num fits
+             in 16 bits (the long division is a library
+             call).
+------------------------------------------------------*/
+char *fmtDec(char *dst, unsigned long num)
+{
+   char digits[10];
+   byte i = 0;
+   word w;
+
+   while(num > 0xFFFF)
+   {
+      digits[i++] = '0' + (char)(num % 10);
+      num /= 10;
+   }
+   w = (word)num;
+   do
+   {
+      digits[i++] = '0' + (char)(w % 10);
+      w /= 10;
+   } while(w != 0);
+   while(i > 0) *dst++ = digits[--i];
+   *dst = '\0';
+   return(dst);
+}
+
+/*----------------------------------------------------
+Function: fmtHex
+Description: The low n digits (1 to 4) of num in hex.
+------------------------------------------------------*/
+char *fmtHex(char *dst, word num, byte n)
+{
+   byte i;
+
+   for(i = n; i > 0; i--)
+   {
+      dst[i-1] = hexDigits[num & 0x0F];
+      num >>= 4;
+   }
+   dst[n] = '\0';
+   return(dst + n);
+}
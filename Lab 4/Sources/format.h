@@ -0,0 +1,18 @@
+/*----------------
+File: format.h
+Description: Header file for the Format Module
+             (string, decimal and hex emitters without a
+             format string - see format.c)
+--------------------*/
+#ifndef _FORMAT_H
+#define _FORMAT_H
+
+#include "mc9s12dg256.h"
+
+// Function Prototypes - each writes at dst, adds the NUL and
+// returns the end (the NUL) so calls can be chained.
+char *fmtStr(char *, const char *);
+char *fmtDec(char *, unsigned long);
+char *fmtHex(char *, word, byte);
+
+#endif /* _FORMAT_H */
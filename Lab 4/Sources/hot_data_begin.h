@@ -0,0 +1,17 @@
+/*----------------
+File: hot_data_begin.h
+Description: Opens the HOT_DATA segment for the variables
+             used by the timer ISRs (see the linker .prm).
+             Include it before their definitions or extern
+             declarations and close the segment after them
+             with #pragma DATA_SEG DEFAULT.  With
+             HOT_DATA_SHORT the segment is in the direct page
+             (__SHORT_SEG, direct addressing).  There is no
+             include guard: it is included once per group.
+--------------------*/
+
+#ifdef HOT_DATA_SHORT
+#pragma DATA_SEG __SHORT_SEG HOT_DATA
+#else
+#pragma DATA_SEG HOT_DATA
+#endif
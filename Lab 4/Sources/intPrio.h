@@ -0,0 +1,34 @@
+/*----------------
+File: intPrio.h
+Description: Interrupt priority configuration.
+             Sets which interrupt is raised to the highest
+             priority with HPRIO and which ISRs allow other
+             interrupts to nest.
+--------------------*/
+
+// Low byte of the vector address of the interrupt promoted to the
+// highest I-bit priority (written to HPRIO in initMain).
+// Default order of the timer channels is TC0 ($FFEE) down to TC7 ($FFE0),
+// so the siren (TC5, $FFE4) would otherwise wait for TC0, TC1 and TC4.
+// -DHPRIO_VECTOR=0xF2 keeps the reset value (no timer channel promoted).
+#ifndef HPRIO_VECTOR
+#define HPRIO_VECTOR 0xE4
+#endif
+
+// Long ISRs that re-enable interrupts once their own flag is cleared,
+// so that the short latency-critical ISRs (siren) can nest.  Define
+// NEST_KEY_ISR (here or with -DNEST_KEY_ISR) to nest key_isr (calls
+// getKCode, drives PORTA rows): off, the siren latency measured on the
+// host is the same with it (see Tools/readme.txt).  Define NO_ISR_NEST
+// (here or with -DNO_ISR_NEST) to run every ISR masked.
+//#define NEST_KEY_ISR
+//#define NO_ISR_NEST
+#ifdef NO_ISR_NEST
+#undef NEST_KEY_ISR
+#else
+#define NEST_TCO_ISR   // tco_isr - only with UNIFIED_TIMER (runs the tasks)
+#endif
+
+// Re-enable interrupts inside an ISR; the ISR's flag must be cleared
+// first or it interrupts itself.
+#define ISR_NEST() asm cli
@@ -6,12 +6,19 @@
 
 #include "mc9s12dg256.h"
 #include "keyPad.h"
+#include "clock.h"
+#include "intPrio.h"
+#include "diag.h"
+#include "trace.h"
+#include "telem.h"
 #define BIT4 0b00010000;
 
-#define TENMSEC 7500  // 10 ms = 7500 x 1 1/3 micro-second
+#define TENMSEC TICKS(100)  // 10 ms in timer ticks (see clock.h)
 
 // Global variables
+#include "hot_data_begin.h"
 volatile byte keyCode;
+#pragma DATA_SEG DEFAULT
 
 // Local Function Prototypes
 char getAscii(byte);
@@ -30,13 +37,16 @@ void initKeyPad(void)
   PUCR |= 0x01;  // enable pull-up resistors on port a
   
   // set up timer channel for interrupt generation
-  // assume timer is already enabled elsewhere with 1 1/3 microsec ticks
+  // assume timer is already enabled elsewhere (tick set by clock module)
   // used for controlling displays
+#ifndef UNIFIED_TIMER  // otherwise keyTask is run from tco_isr (see delay.c)
   TIOS |= BIT4;  // set output compare mode for timer channel 4 (TC4)
   TIE |= BIT4;   // enable interrupt for TC4
   
   TC4 = TCNT + TENMSEC;  // set TC4 to trigger timeout after 10 ms
+#endif
   keyCode = NOKEY;  // initialize keyCode as no key pressed
+}
 
 /*-------------------------------------------------
 Interrupt: readKey
@@ -46,9 +56,11 @@ Description: Waits for a key and returns its ASCII
 char readKey() 
 {
     char ch;
-    while(keyCode == NOKEY) /* wait until a key is pressed */;  
+    while(keyCode == NOKEY) DIAG_IDLE();  // wait until a key is pressed
+    DIAG_IDLE_END();
     ch = getAscii(keyCode);  // convert keyCode to ASCII character
     keyCode = NOKEY;  // reset keyCode to no key pressed
+    TELEM_KEY(ch);
     return(ch);  // return the ASCII character of the pressed key
 }
 
@@ -60,11 +72,17 @@ Description: Checks for a key and if present returns its ASCII
 char pollReadKey() 
 {
     char ch;
-    if(keyCode == NOKEY) ch = NOKEY;  // return no key if no key is pressed
+    if(keyCode == NOKEY)
+    {
+        ch = NOKEY;  // return no key if no key is pressed
+        DIAG_IDLE();  // the callers poll in a wait loop
+    }
     else
     {  
+        DIAG_IDLE_END();
         ch = getAscii(keyCode);  // convert keyCode to ASCII character
         keyCode = NOKEY;  // reset keyCode to no key pressed
+        TELEM_KEY(ch);
     }
     return(ch);  // return the ASCII character of the pressed key or NOKEY
 }
@@ -73,7 +91,9 @@ char pollReadKey()
 /*-------------------------------------------------
 Interrupt: key_isr
 Description: Display interrupt service routine
-             that checks keypad every 10 ms.
+             that checks keypad every 10 ms.  With
+             UNIFIED_TIMER it is the function keyTask
+             called from tco_isr.
 ---------------------------------------------------*/
 // State values
 #define WAITING_FOR_KEY 0
@@ -81,11 +101,23 @@ Description: Display interrupt service routine
 #define WAITING_FOR_REL 2
 #define DEB_REL         3 
 
+#ifdef UNIFIED_TIMER
+void keyTask(void)
+#else
 void interrupt VectorNumber_Vtimch4 key_isr(void)
+#endif
 {
   static byte state = WAITING_FOR_KEY;  // state of keypad check
   static byte code;
+  DIAG_ENTER();
+  TRACE_BEGIN(TR_KEY_ISR);
   
+#if !defined(UNIFIED_TIMER) && defined(NEST_KEY_ISR)
+	// Set up next interrupt first (clears the interrupt) and let
+	// the siren and other ISRs interrupt the keypad scan
+	TC4 = TC4 + TENMSEC;
+	ISR_NEST();
+#endif
   switch(state) 
   {
     case WAITING_FOR_KEY:
@@ -112,8 +144,12 @@ void interrupt VectorNumber_Vtimch4 key_isr(void)
       }
       break;
   }
+#if !defined(UNIFIED_TIMER) && !defined(NEST_KEY_ISR)
 	// Set up next interrupt (also clears the interrupt)
 	TC4 = TC4 + TENMSEC;
+#endif
+  TRACE_END(TR_KEY_ISR);
+  DIAG_LEAVE(DIAG_KEY);
 }
 
 /*-------------------------------------------------
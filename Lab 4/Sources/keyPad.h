@@ -9,6 +9,9 @@
 void initKeyPad(void);
 char pollReadKey(void);
 char readKey(void);
+#ifdef UNIFIED_TIMER
+void keyTask(void);  // run every 10 ms by tco_isr
+#endif
 
 // Some Definitions
 #define NOKEY 0  // See KeyPad.c - to indicate no key pressed
@@ -11,6 +11,7 @@ Description: C Module that provides
    1) the type "byte" is defined as "unsigned char"
 */
 #include "lcd_asm.h"
+#include "trace.h"
 
 // Some Definitions
 #define NUM_LINES 2
@@ -49,6 +50,7 @@ Description: Prints a string on the display on one of the
 void printLCDStr(char *str, byte lineno)
 {
     char newstr[LINE_SIZE+1];  // create a new string with space for null terminator
+    TRACE_BEGIN(TR_PRINT_LCD);
     if(lineno < 2)  // check if the line number is valid (0 or 1)
     {
        set_lcd_addr(lineno*LINE_OFFSET);  // set address for line 1 or 2 (40 for line 1)
@@ -56,6 +58,7 @@ void printLCDStr(char *str, byte lineno)
        type_lcd(newstr);  // send the padded string to the LCD
     }
     // no action if lineno is invalid
+    TRACE_END(TR_PRINT_LCD);
 }
 
 
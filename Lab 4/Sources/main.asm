@@ -9,7 +9,8 @@
 
 
 ; export symbols
-            XDEF asm_main, PLL_init
+            XDEF asm_main, PLL_init, PLL_off, PLL_start, PLL_select
+            XDEF maskInts, restoreInts
 
 ; include derivative specific macros
             INCLUDE 'mc9s12dg256.inc'
@@ -20,11 +21,32 @@ MyCode:     SECTION
 asm_main:
 
 PLL_init:
+          bsr     PLL_start
+PLL_select:
+          movb    #$80,CLKSEL       ;select PLLCLK, bus = 24 MHz
+          rts
+
+PLL_off:
+          bclr    CLKSEL,#$80       ;select OSCCLK, bus = 4 MHz
+          bclr    PLLCTL,#$40       ;turn off PLL to save power
+          rts
+
+PLL_start:
+          clr     CLKSEL            ;bus on OSCCLK while the PLL locks
           movb    #$02,SYNR         ;PLLOSC = 48 MHz
           movb    #$00,REFDV
-          clr     CLKSEL
           movb    #$F1,PLLCTL
 pll1:     brclr   CRGFLG,#$08,pll1  ;wait for PLL to lock
-          movb    #$80,CLKSEL       ;select PLLCLK
+          rts
+
+maskInts:
+          tpa                       ;A = CCR
+          sei
+          tab                       ;return the old CCR in B
+          rts
+
+restoreInts:
+          tba                       ;B = CCR from maskInts
+          tap                       ;I bit as it was
           rts
 
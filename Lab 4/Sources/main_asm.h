@@ -8,6 +8,14 @@
 void asm_main(void);
   /* interface to my assembly main function */
 void PLL_init(void);
+void PLL_off(void);
+void PLL_start(void);
+  /* turn on the PLL and wait for lock, bus stays on OSCCLK */
+void PLL_select(void);
+unsigned char maskInts(void);
+  /* sei, returns the CCR as it was */
+void restoreInts(unsigned char);
+  /* restores the I bit from the CCR returned by maskInts */
 
 #ifdef __cplusplus
     }
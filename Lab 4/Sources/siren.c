@@ -4,10 +4,12 @@ File: siren.c
 Description: The siren module.
 -------------------------------------------------*/
 #include "mc9s12dg256.h"  // include the header for the microcontroller
+#include "clock.h"        // timer ticks for the current clock profile
+#include "diag.h"         // ISR counters
 
 // definitions for the high and low durations of the siren signal
-#define HIGH_MS 300   // 300 * 1 1/3 micro-sec = 0.400 ms 
-#define LOW_MS 600    // 600 * 1 1/3 micro-sec = 0.800 ms
+#define HIGH_MS TICKS(4)   // 0.400 ms
+#define LOW_MS TICKS(8)    // 0.800 ms
 
 // prototypes of local functions
 void interrupt VectorNumber_Vtimch5 sirenISR(void);
@@ -29,7 +31,9 @@ Description: Turns on the siren by setting pin 5 high at an output-compare event
 -------------------------------------------------*/
 #define HIGH 1
 #define LOW 0
+#include "hot_data_begin.h"
 int levelTC5;  // stores the current level on TC5
+#pragma DATA_SEG DEFAULT
 void turnOnSiren()
 {
    TCTL1 |= 0b00001100;  // set pin 5 to high on output-compare event 
@@ -60,6 +64,7 @@ Description: Interrupt service routine for TC5. Toggles the siren state between
 -------------------------------------------------*/
 void interrupt VectorNumber_Vtimch5 sirenISR()
 {
+   DIAG_ENTER();
    if(levelTC5 == HIGH)  // if the current level is high
    {
       TC5 += LOW_MS;    // set the next event for LOW_MS
@@ -70,4 +75,5 @@ void interrupt VectorNumber_Vtimch5 sirenISR()
       TC5 += HIGH_MS;   // set the next event for HIGH_MS
       levelTC5 = HIGH;   // change state to high
    }
+   DIAG_LEAVE(DIAG_SIREN);
 }
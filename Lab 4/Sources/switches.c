@@ -4,6 +4,7 @@
  *              Alarm System Simulation project.
 -----------------------------------------------------------------*/
 #include "switches.h"  // Definitions file
+#include "telem.h"     // zone events
 
 /*----------------------------------------
  * Function: initSwitches
@@ -25,9 +26,12 @@ void initSwitches()
  *          switches are opened (bit set to 1).
  * Description: Checks status of switches and 
  *              returns bytes that shows their
- *              status.      
+ *              status.  A change is sent as a
+ *              zone event (telem.h).
  *---------------------------*/
 byte getSwStatus()
 {
-    return(PTH);
+    byte sw = PTH;
+    TELEM_ZONE(sw);
+    return(sw);
 }
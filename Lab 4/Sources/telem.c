@@ -0,0 +1,167 @@
+/*------------------------------------------------------
+File: telem.c
+Description:  Telemetry Module
+              Sends the state changes, zone (switch)
+              changes, keys and counters as binary frames
+              on SCI1 (9600 baud, 8N1; frame format in
+              telem.h).  A frame is built on the caller's
+              stack and copied into the transmit ring with
+              interrupts masked; telem_isr sends the ring.
+              Nothing waits for the SCI: a frame that does
+              not fit in the ring is dropped and shows as a
+              SEQ gap.  A frame queued by an ISR while a
+              telemSend is building its frame can be sent
+              before it (SEQ out of order).
+-------------------------------------------------------*/
+
+#include "mc9s12dg256.h"
+#include "main_asm.h"
+#include "telem.h"
+
+#ifdef TELEM
+
+#define SCI_TE  0b00001000   // SCI1CR2: transmitter enabled
+#define SCI_TIE 0b10000000   // SCI1CR2: transmit interrupt enabled
+#define RING_SIZE 256        // byte indices wrap by themselves
+#define FRAME_MAX (4 + TM_MAX_PAYLOAD + 2)
+#define VARINT_MAX 5         // bytes of an unsigned long
+
+// Global Variables
+volatile unsigned long telemMs;
+static byte ring[RING_SIZE];
+static volatile byte head, tail;  // next byte written, next byte sent
+static byte seq;
+static byte lastState = 0xFF;     // none sent yet
+static byte lastZone;
+static byte zoneSent;
+
+// CRC-16/CCITT of each nibble value
+static const word crcTable[16] =
+{
+   0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+   0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+// Prototypes of local functions
+byte putVarint(byte *, unsigned long);
+void interrupt VectorNumber_Vsci1 telem_isr(void);
+
+/*----------------------------------------------------
+Function: initTelem
+Description: Enables the SCI1 transmitter and sends the
+             TM_BOOT frame.  Called with interrupts
+             enabled; the baud rate is set with the clock
+             profile (see clock.c).
+------------------------------------------------------*/
+void initTelem(void)
+{
+   unsigned long version = TM_VERSION;
+
+   SCI1CR2 |= SCI_TE;
+   telemSend(TM_BOOT, &version, 1);
+}
+
+/*----------------------------------------------------
+Function: putVarint
+Description: Writes num as a varint, returns its bytes.
+------------------------------------------------------*/
+byte putVarint(byte *dst, unsigned long num)
+{
+   byte n = 0;
+
+   while(num > 0x7F)
+   {
+      dst[n++] = (byte)num | 0x80;
+      num >>= 7;
+   }
+   dst[n++] = (byte)num;
+   return(n);
+}
+
+/*----------------------------------------------------
+Function: telemSend
+Description: Queues a frame of the given type with the
+             ms time and the n values as payload.
+------------------------------------------------------*/
+void telemSend(byte type, const unsigned long *vals, byte n)
+{
+   byte frame[FRAME_MAX];
+   byte len = 4;
+   byte i;
+   word crc = 0xFFFF;
+   unsigned long ms;
+   byte ccr;
+
+   ccr = maskInts();  // telemMs is changed by tco_isr
+   ms = telemMs;
+   frame[3] = seq++;
+   restoreInts(ccr);
+   frame[0] = TM_SOF;
+   frame[2] = type;
+   len += putVarint(&frame[len], ms);
+   for(i = 0; i < n && len <= 4 + TM_MAX_PAYLOAD - VARINT_MAX; i++)
+      len += putVarint(&frame[len], vals[i]);
+   frame[1] = len - 4;
+   for(i = 1; i < len; i++)
+   {
+      crc = (crc << 4) ^ crcTable[(crc >> 12) ^ (frame[i] >> 4)];
+      crc = (crc << 4) ^ crcTable[(crc >> 12) ^ (frame[i] & 0x0F)];
+   }
+   frame[len++] = (byte)(crc >> 8);
+   frame[len++] = (byte)crc;
+
+   ccr = maskInts();
+   if((byte)(tail - head - 1) >= len)  // free bytes (one is kept empty)
+   {
+      for(i = 0; i < len; i++) ring[head++] = frame[i];
+      SCI1CR2 |= SCI_TIE;
+   }
+   restoreInts(ccr);
+}
+
+/*----------------------------------------------------
+Function: telemState, telemZone, telemKey
+Description: Event frames.  State and zone frames are
+             sent only when the value changes; digits are
+             sent as TM_DIGIT.
+------------------------------------------------------*/
+void telemState(byte state)
+{
+   unsigned long v = state;
+
+   if(state == lastState) return;
+   lastState = state;
+   telemSend(TM_STATE, &v, 1);
+}
+
+void telemZone(byte zone)
+{
+   unsigned long v = zone;
+
+   if(zoneSent && zone == lastZone) return;
+   lastZone = zone;
+   zoneSent = 1;
+   telemSend(TM_ZONE, &v, 1);
+}
+
+void telemKey(byte key)
+{
+   unsigned long v = (key >= '0' && key <= '9') ? TM_DIGIT : key;
+
+   telemSend(TM_KEY, &v, 1);
+}
+
+/*-------------------------------------------------
+Interrupt: telem_isr
+Description: SCI1 transmit interrupt.  Sends the next
+             byte of the ring; reading SCI1SR1 then
+             writing SCI1DRL clears TDRE.  Disables the
+             interrupt once the ring is empty.
+---------------------------------------------------*/
+void interrupt VectorNumber_Vsci1 telem_isr(void)
+{
+   if(head == tail) SCI1CR2 &= ~SCI_TIE;
+   else if(SCI1SR1 & SCI1SR1_TDRE_MASK) SCI1DRL = ring[tail++];
+}
+
+#endif /* TELEM */
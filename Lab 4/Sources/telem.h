@@ -0,0 +1,88 @@
+/*----------------
+File: telem.h
+Description: Header file for the Telemetry Module
+             (binary event frames on SCI1 - see telem.c).
+
+Frame:  SOF  LEN  TYPE  SEQ  payload (LEN bytes)  CRC (2)
+             SOF   TM_SOF
+             LEN   payload bytes (up to TM_MAX_PAYLOAD)
+             TYPE  TM_BOOT ... TM_ISR
+             SEQ   frame count (mod 256), a gap is a lost frame
+             payload  unsigned varints (7 bits per byte, low
+                   first, bit 7 set when more follow); the
+                   first is the ms since reset
+             CRC   CRC-16/CCITT (0x1021, from 0xFFFF) of LEN to
+                   the end of the payload, high byte first
+Payload after the ms:
+             TM_BOOT      TM_VERSION
+             TM_STATE     state (TS_IDLE ...)
+             TM_ZONE      switches (bit set = open)
+             TM_KEY       key, TM_DIGIT for any digit
+             TM_COUNTERS  stack used, stack size, load % (diag.c)
+             TM_ISR       ISR (DIAG_TCO ...), count, cycles, max
+Tools/telem/telemdec decodes a stream.
+--------------------*/
+#ifndef _TELEM_H
+#define _TELEM_H
+
+#include "mc9s12dg256.h"
+
+// Telemetry: define TELEM (here or with -DTELEM) to send the
+// frames, once telem.c is in the Sources group of Lab4.mcp.  SCI1
+// then carries frames only: the diagnostic report (diag.c, with
+// DIAG) is sent as TM_COUNTERS and TM_ISR frames.
+//#define TELEM
+
+#define TM_SOF 0x7E
+#define TM_VERSION 1
+#define TM_MAX_PAYLOAD 24  // the frame is built on the stack
+
+// Frame types
+#define TM_BOOT     1
+#define TM_STATE    2
+#define TM_ZONE     3
+#define TM_KEY      4
+#define TM_COUNTERS 5
+#define TM_ISR      6
+
+// States of TM_STATE
+#define TS_IDLE    0  // menu (disarmed)
+#define TS_CONFIG  1  // configuring the codes
+#define TS_ARMING  2  // exit delay
+#define TS_ARMED   3
+#define TS_ENTRY   4  // front door opened, entry delay
+#define TS_ALARM   5  // siren on
+
+#define TM_DIGIT 'x'  // sent for the digits (codes are not reported)
+
+#ifdef TELEM
+// The event macros send a frame when the value changes (keys:
+// every key taken by readKey or pollReadKey).  Frames are
+// queued, never waited for, and dropped when the queue is full.
+// TELEM_IDLE() samples the switches from the wait loops (DIAG_IDLE,
+// also called by pollReadKey), so a zone change is sent within a pass of
+// the loop whatever the main line is waiting for.
+#define TELEM_STATE(s) telemState(s)
+#define TELEM_ZONE(z) telemZone(z)
+#define TELEM_KEY(k) telemKey(k)
+#define TELEM_MS() telemMs++
+#define TELEM_IDLE() telemZone(PTH)
+
+extern volatile unsigned long telemMs;  // counted by tco_isr
+
+// Function Prototypes - telemSend masks interrupts around its
+// critical sections and restores the I bit as it found it.
+void initTelem(void);
+void telemSend(byte, const unsigned long *, byte);
+void telemState(byte);
+void telemZone(byte);
+void telemKey(byte);
+#else
+#define TELEM_STATE(s)
+#define TELEM_ZONE(z)
+#define TELEM_KEY(k)
+#define TELEM_MS()
+#define TELEM_IDLE()
+#endif
+
+#endif /* _TELEM_H */
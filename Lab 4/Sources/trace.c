@@ -0,0 +1,15 @@
+/*------------------------------------------------------
+File: trace.c
+Description:  Trace Module
+              The ring written by the trace points of
+              trace.h.  To read it, dump traceBuf
+              (TRACE_SIZE * 3 + 1 bytes, address from the
+              .map) with the debugger or DBug12 MD and
+              run Tools/trace/tracedec on the dump.
+-------------------------------------------------------*/
+
+#include "trace.h"
+
+#ifdef TRACING
+struct trace_buf traceBuf;
+#endif
@@ -0,0 +1,66 @@
+/*----------------
+File: trace.h
+Description: Trace points for on-target profiling.
+             Each TRACE_BEGIN/TRACE_END writes an (id, TCNT)
+             record into the RAM ring traceBuf; a dump of
+             traceBuf is turned into a timeline on the host
+             with Tools/trace/tracedec.  Without TRACING the
+             trace points compile to nothing.
+--------------------*/
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "mc9s12dg256.h"
+
+// Tracing: define TRACING (here or with -DTRACING) to compile the
+// trace points in, once trace.c (traceBuf) is in the Sources group
+// of Lab4.mcp.
+//#define TRACING
+
+#define TRACE_SIZE 64    // records in the ring, a power of 2 up to 256
+#define TRACE_END_BIT 0x80
+
+// Trace point ids (1 to 127; tracedec reads the names from here)
+#define TR_KEY_ISR    1  // key_isr or keyTask (keyPad.c)
+#define TR_DISP_ISR   2  // disp_isr or dispTask (SegDisp.c)
+#define TR_CHECK_CODE 3  // checkCode (armed.c)
+#define TR_PRINT_LCD  4  // printLCDStr (lcdDisp.c)
+#define TR_WRITE_EE   5  // writeToEE (config.c)
+
+#ifdef TRACING
+struct trace_rec
+{
+   byte id;    // trace point id, TRACE_END_BIT set at the end; 0 - not written
+   word tcnt;  // TCNT when written
+};
+
+struct trace_buf
+{
+   volatile byte head;  // records written (mod 256), the next is ring[head % TRACE_SIZE]
+   struct trace_rec ring[TRACE_SIZE];
+};
+
+extern struct trace_buf traceBuf;
+
+// The slot is taken by storing head + 1 before the record is
+// written, so an ISR tracing in the middle of a record takes the
+// next slot.  Only an ISR that traces between the read and the
+// store of head loses its record (it is overwritten); interrupts
+// are never disabled.
+#define TRACE_REC(code) \
+   do \
+   { \
+      byte traceI = traceBuf.head; \
+      traceBuf.head = traceI + 1; \
+      traceI &= TRACE_SIZE - 1; \
+      traceBuf.ring[traceI].id = (code); \
+      traceBuf.ring[traceI].tcnt = TCNT; \
+   } while(0)
+#define TRACE_BEGIN(id) TRACE_REC(id)
+#define TRACE_END(id) TRACE_REC((id) | TRACE_END_BIT)
+#else
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+#endif
+
+#endif /* _TRACE_H */
@@ -0,0 +1,322 @@
+/*------------------------------------------------
+ * File: alarmHost.c
+ * Description: Host driver for the Lab 4 modules.
+ *
+ *   alarmhost bench [seconds]
+ *      Runs the timer interrupts (delay, display,
+ *      keypad and siren) for the given simulated time
+ *      and reports the simulated events per second.
+ *
+ *   alarmhost run [-t seconds] [-k keys] [-s switches@sec] [-r dump]
+ *                 [-o telemetry] [-c chars@sec]
+ *      Runs the firmware main with keys pressed every
+ *      0.5 s from 1 s (each held 100 ms) and the switches
+ *      (hex, bit set = open) changed at the given time,
+ *      then prints the LCD, the displays, the siren edges
+ *      and the alarm codes.  -r writes traceBuf (built
+ *      with -DTRACING) as a hex dump in the target layout
+ *      for trace/tracedec.  -o writes the bytes sent on
+ *      SCI1 (the frames of a -DTELEM build, for
+ *      telem/telemdec).  -c sends characters to SCI1
+ *      from the given time, one every 2 ms (e.g. d@20
+ *      asks a -DDIAG build for its report).
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "alarmExtern.h"
+#include "main_asm.h"
+
+#define KEY_START_US 1000000.0
+#define KEY_PERIOD_US 500000.0
+#define KEY_HOLD_US 100000.0
+#define CHAR_PERIOD_US 2000.0  // more than a character time at 9600 baud
+
+// Firmware entry points (the firmware main is compiled as alarmMain)
+void alarmMain(void);
+void tco_isr(void);
+void sirenISR(void);
+void disp_isr(void) __attribute__((weak));  // absent with UNIFIED_TIMER
+void key_isr(void) __attribute__((weak));
+void telem_isr(void) __attribute__((weak));  // only with TELEM
+
+/*----------------------------------------------------
+Function: setup
+Description: Reset and connect the firmware to the
+             simulated vectors and EEPROM.
+------------------------------------------------------*/
+static void setup(void)
+{
+   hostReset();
+   hostSetVector(VEC_TC0, tco_isr);
+   if(disp_isr) hostSetVector(VEC_TC1, disp_isr);
+   if(key_isr) hostSetVector(VEC_TC4, key_isr);
+   hostSetVector(VEC_TC5, sirenISR);
+   if(telem_isr) hostSetVector(VEC_SCI1, telem_isr);
+   hostEeprom(alarmCodes, sizeof(alarmCodes[0]), NUMCODES);
+}
+
+static double cpuSeconds(void)
+{
+   return((double)clock() / CLOCKS_PER_SEC);
+}
+
+/*----------------------------------------------------
+Function: printLatency
+Description: Latency of the timer ISRs in bus cycles:
+             min, average, max and jitter (max - min),
+             and their histograms.
+------------------------------------------------------*/
+static void printLatency(void)
+{
+   static const byte vectors[4] = { VEC_TC0, VEC_TC1, VEC_TC4, VEC_TC5 };
+   static const char *names[4] = { "tco_isr", "disp_isr", "key_isr", "sirenISR" };
+   struct host_latency lat[4];
+   int have[4];
+   int i, b, lo = HOST_LAT_BINS - 1, hi = 0;
+   char range[48];
+
+   printf("latency (cycles)     min      avg      max   jitter\n");
+   for(i = 0; i < 4; i++)
+   {
+      have[i] = hostLatency(vectors[i], &lat[i]);
+      if(!have[i]) continue;
+      printf("%-16s %8lu %8.1f %8lu %8lu\n", names[i], lat[i].min,
+             lat[i].sum / lat[i].count, lat[i].max, lat[i].max - lat[i].min);
+      for(b = 0; b < HOST_LAT_BINS; b++)
+      {
+         if(lat[i].hist[b] && b < lo) lo = b;
+         if(lat[i].hist[b] && b > hi) hi = b;
+      }
+   }
+   printf("%-16s", "cycles");
+   for(i = 0; i < 4; i++)
+      if(have[i]) printf(" %9s", names[i]);
+   printf("\n");
+   for(b = lo; b <= hi; b++)
+   {
+      if(b == 0) snprintf(range, sizeof(range), "0");
+      else snprintf(range, sizeof(range), "%lu-%lu", 1UL << (b - 1), (1UL << b) - 1);
+      printf("%-16s", range);
+      for(i = 0; i < 4; i++)
+         if(have[i]) printf(" %9lu", lat[i].hist[b]);
+      printf("\n");
+   }
+}
+
+/*----------------------------------------------------
+Function: bench
+Description: Interrupt load of the armed system with the
+             siren on, and the latency of each ISR
+             (compare match to its start).
+------------------------------------------------------*/
+static int bench(double seconds)
+{
+   double t0, t1;
+   unsigned long long ev;
+
+   setup();
+   initClock(CLK_FULL_SPEED);
+   initKeyPad();
+   initDisp();
+   TSCR1 = 0b10010000;
+   initSiren();
+   initDelay();
+   HPRIO = HPRIO_VECTOR;
+   setCharDisplay('8', 0);
+   turnOnSiren();
+
+   t0 = cpuSeconds();
+   hostRunUs(seconds * 1e6);
+   t1 = cpuSeconds();
+   ev = hostEvents();
+
+   printf("simulated %.3f s in %.3f s cpu\n", hostTimeUs() / 1e6, t1 - t0);
+   printf("events %llu (%.2f M/s)\n", ev, t1 > t0 ? ev / (t1 - t0) / 1e6 : 0.0);
+   printf("tco_isr %lu  disp_isr %lu  key_isr %lu  sirenISR %lu\n",
+          hostIsrCount(VEC_TC0), hostIsrCount(VEC_TC1),
+          hostIsrCount(VEC_TC4), hostIsrCount(VEC_TC5));
+   printf("entries %.0f/s\n", (hostIsrCount(VEC_TC0) + hostIsrCount(VEC_TC1) +
+          hostIsrCount(VEC_TC4) + hostIsrCount(VEC_TC5)) / (hostTimeUs() / 1e6));
+   printf("worst latency (us) tco_isr %.2f  disp_isr %.2f  key_isr %.2f  sirenISR %.2f\n",
+          hostMaxLatencyUs(VEC_TC0), hostMaxLatencyUs(VEC_TC1),
+          hostMaxLatencyUs(VEC_TC4), hostMaxLatencyUs(VEC_TC5));
+   printLatency();
+   printf("siren edges %lu (%.1f Hz)\n", hostSirenEdges(),
+          hostSirenEdges() / 2.0 / (hostTimeUs() / 1e6));
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: pressKey, releaseKey, setSwitches, sciReceive
+Description: Scripted inputs (see hostAt).
+------------------------------------------------------*/
+static void pressKey(int key)
+{
+   hostPressKey((char)key);
+}
+
+static void releaseKey(int arg)
+{
+   (void)arg;
+   hostReleaseKey();
+}
+
+static void setSwitches(int sw)
+{
+   hostSetSwitches((byte)sw);
+}
+
+static void sciReceive(int ch)
+{
+   hostSciReceive((byte)ch);
+}
+
+/*----------------------------------------------------
+Function: writeTrace
+Description: Writes traceBuf as the target would hold it
+             (byte head, then 3-byte records with TCNT
+             high byte first), 16 bytes per line from
+             address 0000.  Returns -1 on an error.
+------------------------------------------------------*/
+static int writeTrace(const char *path)
+{
+#ifdef TRACING
+   byte bytes[1 + 3 * TRACE_SIZE];
+   FILE *out;
+   int i, n = 0;
+
+   bytes[n++] = traceBuf.head;
+   for(i = 0; i < TRACE_SIZE; i++)
+   {
+      bytes[n++] = traceBuf.ring[i].id;
+      bytes[n++] = traceBuf.ring[i].tcnt >> 8;
+      bytes[n++] = traceBuf.ring[i].tcnt & 0xFF;
+   }
+   if((out = fopen(path, "w")) == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   for(i = 0; i < n; i++)
+   {
+      if(i % 16 == 0) fprintf(out, "%s%04X", i ? "\n" : "", i);
+      fprintf(out, " %02X", bytes[i]);
+   }
+   fprintf(out, "\n");
+   return(fclose(out) == 0 ? 0 : -1);
+#else
+   (void)path;
+   fprintf(stderr, "-r: built without TRACING (make clean; make HOSTDEFS=-DTRACING)\n");
+   return(-1);
+#endif
+}
+
+/*----------------------------------------------------
+Function: run
+Description: Runs the firmware main with scripted input.
+------------------------------------------------------*/
+static int run(double seconds, const char *keys, int sw, double swAt, const char *dump,
+               const char *telem, const char *chars, double charsAt)
+{
+   char line[17];
+   double t0, t1, t;
+   FILE *out = NULL;
+   int i;
+
+   setup();
+   if(telem != NULL)
+   {
+      if((out = fopen(telem, "wb")) == NULL)
+      {
+         perror(telem);
+         return(1);
+      }
+      hostSciOutput(out);
+   }
+   for(i = 0, t = KEY_START_US; keys[i] != '\0'; i++, t += KEY_PERIOD_US)
+   {
+      if(sw >= 0 && swAt * 1e6 <= t)
+      {
+         hostAt(swAt * 1e6, setSwitches, sw);
+         sw = -1;
+      }
+      hostAt(t, pressKey, keys[i]);
+      hostAt(t + KEY_HOLD_US, releaseKey, 0);
+   }
+   if(sw >= 0) hostAt(swAt * 1e6, setSwitches, sw);
+   for(i = 0; chars != NULL && chars[i] != '\0'; i++)
+      hostAt(charsAt * 1e6 + i * CHAR_PERIOD_US, sciReceive, (byte)chars[i]);
+
+   t0 = cpuSeconds();
+   hostRunMain(alarmMain, seconds * 1e6);
+   t1 = cpuSeconds();
+
+   printf("simulated %.3f s in %.3f s cpu\n", hostTimeUs() / 1e6, t1 - t0);
+   hostLcdLine(0, line);
+   printf("LCD |%s|\n", line);
+   hostLcdLine(1, line);
+   printf("    |%s|\n", line);
+   printf("7-segment %02x %02x %02x %02x\n", hostSegment(0), hostSegment(1),
+          hostSegment(2), hostSegment(3));
+   printf("siren edges %lu\n", hostSirenEdges());
+   printf("alarm codes");
+   for(i = 0; i < NUMCODES; i++) printf(" %04x", alarmCodes[i] & 0xFFFF);
+   printf("  (sector erases %lu %lu %lu)\n", hostEraseCount(0), hostEraseCount(2),
+          hostEraseCount(4));
+   if(out != NULL)
+   {
+      printf("SCI1 %lu bytes\n", hostSciBytes());
+      hostSciOutput(NULL);
+      if(fclose(out) != 0)
+      {
+         perror(telem);
+         return(1);
+      }
+   }
+   return(dump != NULL && writeTrace(dump) != 0 ? 1 : 0);
+}
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: alarmhost bench [seconds]\n"
+                   "       alarmhost run [-t seconds] [-k keys] [-s switches@sec] [-r dump]\n"
+                   "                     [-o telemetry] [-c chars@sec]\n");
+   exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+   double seconds = 10.0;
+   const char *keys = "", *dump = NULL, *telem = NULL;
+   char chars[64];
+   int sw = -1;
+   double swAt = 0.0, charsAt = -1.0;
+   int i;
+
+   if(argc < 2) usage();
+   if(strcmp(argv[1], "bench") == 0)
+   {
+      if(argc > 2) seconds = atof(argv[2]);
+      return(bench(seconds));
+   }
+   if(strcmp(argv[1], "run") != 0) usage();
+   for(i = 2; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+      else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) keys = argv[++i];
+      else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      {
+         if(sscanf(argv[++i], "%x@%lf", (unsigned *)&sw, &swAt) != 2) usage();
+      }
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) dump = argv[++i];
+      else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) telem = argv[++i];
+      else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+      {
+         if(sscanf(argv[++i], "%63[^@]@%lf", chars, &charsAt) != 2) usage();
+      }
+      else usage();
+   }
+   return(run(seconds, keys, sw, swAt, dump, telem, charsAt >= 0.0 ? chars : NULL, charsAt));
+}
@@ -0,0 +1,921 @@
+/*------------------------------------------------
+ * File: hostSim.c
+ * Description: Simulated peripheral block for the host
+ *              build of the Lab 4 modules.
+ *
+ *              Every register access made by the modules
+ *              goes through hostReg8/hostReg16, which
+ *              charge the access to the virtual clock,
+ *              advance the timer, deliver interrupts and
+ *              apply the side effects of the previous
+ *              access (a write is seen as a change of the
+ *              register value).  Time is kept in units of
+ *              1/48 micro-sec so both bus clocks (24 MHz
+ *              with the PLL, 4 MHz from the oscillator) are
+ *              whole numbers of units.
+ *
+ *              SCI1: a byte written to SCI1DRL goes to the
+ *              output file (hostSciOutput) and TDRE is set
+ *              again one character time (10 bits) later.
+ *              Its transmit interrupt comes after the timer
+ *              channels.  A scripted character received
+ *              (hostSciReceive) sets RDRF until SCI1DRL is
+ *              read; the receiver is polled (no RIE).
+ *
+ *              Busy-wait loops on RAM variables (delayms,
+ *              readKey) make no register access.  They call
+ *              the idle hook of diag.h on every pass, which
+ *              jumps the virtual clock to the next event
+ *              (hostIdle), so idle time costs nothing.
+--------------------------------------------------*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "hostSim.h"
+
+// Time base
+#define UNITS_PER_US 48
+#define PLL_BUS 2      // units per bus cycle, 24 MHz
+#define OSC_BUS 12     // units per bus cycle, 4 MHz
+#define ACCESS_CYCLES 4  // bus cycles charged for each register access
+#define ENTRY_CYCLES 9   // interrupt entry (stack registers, fetch vector)
+#define RTI_CYCLES 8
+
+// EEPROM timing (micro-sec)
+#define EE_PROG_US 46
+#define EE_ERASE_US 20000
+
+// Register addresses (see mc9s12dg256.h)
+#define REGSIZE 0x400
+#define R_PORTA  0x000
+#define R_PORTB  0x001
+#define R_DDRA   0x002
+#define R_HPRIO  0x01F
+#define R_CRGFLG 0x037
+#define R_CLKSEL 0x039
+#define R_PLLCTL 0x03A
+#define R_TIOS   0x040
+#define R_CFORC  0x041
+#define R_TCNT   0x044
+#define R_TSCR1  0x046
+#define R_TCTL1  0x048
+#define R_TCTL2  0x049
+#define R_TIE    0x04C
+#define R_TSCR2  0x04D
+#define R_TFLG1  0x04E
+#define R_TC0    0x050
+#define R_SC1BD  0x0D0
+#define R_SC1CR2 0x0D3
+#define R_SC1SR1 0x0D4
+#define R_SC1DRL 0x0D7
+#define R_ESTAT  0x115
+#define R_ECMD   0x116
+#define R_PTT    0x240
+#define R_PTP    0x258
+#define R_PTH    0x260
+
+// Register bits
+#define TEN   0x80
+#define TFFCA 0x10
+#define LOCK  0x08
+#define PLLON 0x40
+#define PLLSEL 0x80
+#define CBEIF 0x80
+#define CCIF  0x40
+#define PVIOL 0x20
+#define ACCERR 0x10
+#define SCI_TIE 0x80
+#define SCI_TE  0x08
+#define SCI_RE  0x04
+#define TDRE  0x80
+#define TC    0x40
+#define RDRF  0x20
+#define NO_DATA 0xFFFF   // SCI1DRL before a write
+#define RX_MARK 0x8000   // high byte of a received character in SCI1DRL, so a write is still seen
+#define SCI_CHAR_BITS 10
+#define SECTOR_MODIFY 0x60
+#define PROG 0x20
+#define ERASED 0xFFFF
+
+#define MAXEE 64
+#define MAXSCRIPT 256
+
+struct script_entry
+{
+   unsigned long long at;  // time in units
+   void (*fn)(int);
+   int arg;
+};
+
+// Peripheral block
+static byte regs8[REGSIZE];
+static word regs16[REGSIZE];
+static int pendAddr = -1;  // previous access, committed on the next one
+static int pendWide;
+static word pendValue;
+
+// Virtual clock and CPU state
+static unsigned long long now;
+static unsigned long long tickFrac;  // units since the last timer tick
+static word tcnt;
+static int ibit = 1;
+
+// Interrupts
+static void (*vectors[8])(void);
+static unsigned long isrCount[8];
+static unsigned long long matchAt[8];     // compare match of the pending flag
+static unsigned long long maxLatency[8];  // longest match to ISR start
+static struct host_latency latency[8];
+static unsigned long long events;
+static void (*sciVector)(void);
+static unsigned long sciIsrCount;
+
+// SCI1 transmitter
+static FILE *sciOut;
+static unsigned long long sciFree;  // time TDRE is set again
+static unsigned long sciBytes;
+
+// SCI1 receiver
+static int rxFull;  // RDRF
+static byte rxData;
+
+// Ports
+static byte portaLatch;
+static byte segs[4];
+static unsigned long edges;
+static char keyDown;
+static byte switches;  // bit set = open: all closed at reset
+
+// EEPROM
+static void *eeRegion;
+static int eeSize;
+static int eeCount;
+static word eeImage[MAXEE];
+static unsigned long eeErases[MAXEE/2];
+static int eeBusy;
+static unsigned long long eeDoneAt;
+
+// Scripted input changes
+static struct script_entry script[MAXSCRIPT];
+static int scriptLen;
+static int scriptNext;
+
+// Running the firmware main
+static jmp_buf stopJmp;
+static int running;
+static unsigned long long stopAt;
+
+// Prototypes of local functions
+static void commit(void);
+static void beforeAccess(int, int);
+static void advance(unsigned long long);
+static void timerTicks(unsigned long, unsigned long long, unsigned long long);
+static void outputAction(int);
+static void dispatch(void);
+static int sciPending(void);
+static void sciWrite(byte);
+static int pickChannel(byte);
+static void countLatency(int, unsigned long long);
+static byte portaPins(void);
+static void eeStatusWrite(byte, byte);
+static void eeLaunch(byte);
+static word eeRead(int);
+static void runScript(void);
+static void checkStop(void);
+
+/*----------------------------------------------------
+Function: busUnits
+Description: Units per bus cycle for the selected clock.
+------------------------------------------------------*/
+static unsigned busUnits(void)
+{
+   return((regs8[R_CLKSEL] & PLLSEL) ? PLL_BUS : OSC_BUS);
+}
+
+/*----------------------------------------------------
+Function: tickUnits
+Description: Units per timer tick (bus clock divided
+             by the TSCR2 prescaler).
+------------------------------------------------------*/
+static unsigned long long tickUnits(void)
+{
+   return((unsigned long long)busUnits() << (regs8[R_TSCR2] & 0x07));
+}
+
+/*----------------------------------------------------
+Function: hostReset
+Description: Puts the peripheral block and the virtual
+             clock in their reset state.
+------------------------------------------------------*/
+void hostReset(void)
+{
+   memset(regs8, 0, sizeof(regs8));
+   memset(regs16, 0, sizeof(regs16));
+   regs8[R_ESTAT] = CBEIF | CCIF;
+   regs8[R_HPRIO] = 0xF2;
+   pendAddr = -1;
+   now = tickFrac = 0;
+   tcnt = 0;
+   ibit = 1;
+   memset(vectors, 0, sizeof(vectors));
+   memset(isrCount, 0, sizeof(isrCount));
+   memset(maxLatency, 0, sizeof(maxLatency));
+   memset(latency, 0, sizeof(latency));
+   events = 0;
+   sciVector = NULL;
+   sciIsrCount = 0;
+   sciOut = NULL;
+   sciFree = 0;
+   sciBytes = 0;
+   rxFull = 0;
+   rxData = 0;
+   portaLatch = 0;
+   memset(segs, 0, sizeof(segs));
+   edges = 0;
+   keyDown = 0;
+   switches = 0;
+   eeRegion = NULL;
+   eeCount = 0;
+   eeBusy = 0;
+   memset(eeErases, 0, sizeof(eeErases));
+   scriptLen = scriptNext = 0;
+}
+
+/*----------------------------------------------------
+Function: hostSetVector
+Description: Registers the service routine for a timer
+             channel vector (VEC_TC0 ... VEC_TC7) or SCI1
+             (VEC_SCI1).
+------------------------------------------------------*/
+void hostSetVector(byte vector, void (*isr)(void))
+{
+   if(vector >= VEC_TC7 && vector <= VEC_TC0 && !(vector & 1))
+      vectors[(VEC_TC0 - vector)/2] = isr;
+   else if(vector == VEC_SCI1) sciVector = isr;
+}
+
+/*----------------------------------------------------
+Function: hostEeprom
+Description: Declares the array that lives in EEPROM
+             (n elements of size bytes).  Its current
+             contents become the programmed image.
+------------------------------------------------------*/
+void hostEeprom(void *region, int size, int n)
+{
+   int i;
+   if(n > MAXEE) n = MAXEE;
+   eeRegion = region;
+   eeSize = size;
+   eeCount = n;
+   for(i = 0; i < n; i++) eeImage[i] = eeRead(i);
+}
+
+/*----------------------------------------------------
+Function: hostReg8, hostReg16
+Description: Return the simulated register for an
+             access by the modules.  Interrupts that
+             became due are taken before the access.
+------------------------------------------------------*/
+static volatile byte *regAccess(word addr, int wide)
+{
+   addr &= REGSIZE - 1;
+   commit();
+   advance(ACCESS_CYCLES * busUnits());
+   checkStop();
+   dispatch();
+   beforeAccess(addr, wide);
+   pendAddr = addr;
+   pendWide = wide;
+   pendValue = wide ? regs16[addr] : regs8[addr];
+   return(wide ? (volatile byte *)&regs16[addr] : &regs8[addr]);
+}
+
+volatile byte *hostReg8(word addr)
+{
+   return(regAccess(addr, 0));
+}
+
+volatile word *hostReg16(word addr)
+{
+   return((volatile word *)regAccess(addr, 1));
+}
+
+/*----------------------------------------------------
+Function: hostCli, hostSei, hostIMasked
+Description: asm cli and asm sei, and the I bit.
+------------------------------------------------------*/
+void hostCli(void)
+{
+   commit();
+   ibit = 0;
+   dispatch();
+}
+
+void hostSei(void)
+{
+   ibit = 1;
+}
+
+int hostIMasked(void)
+{
+   return(ibit);
+}
+
+/*----------------------------------------------------
+Function: beforeAccess
+Description: Read side of the registers: values that
+             come from the pins or the timer, and the
+             timer fast flag clear.
+------------------------------------------------------*/
+static void beforeAccess(int addr, int wide)
+{
+   int ch;
+   if(wide)
+   {
+      if(addr == R_TCNT) regs16[R_TCNT] = tcnt;
+      else if(addr == R_SC1DRL)
+      {
+         regs16[R_SC1DRL] = rxFull ? RX_MARK | rxData : NO_DATA;
+         rxFull = 0;  // RDRF is cleared by reading the data
+      }
+      else if(addr >= R_TC0 && addr < R_TC0 + 16 && (regs8[R_TSCR1] & TFFCA))
+      {
+         ch = (addr - R_TC0)/2;
+         regs8[R_TFLG1] &= ~(1 << ch);
+      }
+      return;
+   }
+   switch(addr)
+   {
+      case R_PORTA:
+         regs8[R_PORTA] = portaPins();
+         break;
+      case R_PTH:
+         regs8[R_PTH] = switches;
+         break;
+      case R_CRGFLG:
+         if(regs8[R_PLLCTL] & PLLON) regs8[R_CRGFLG] |= LOCK;
+         else regs8[R_CRGFLG] &= ~LOCK;
+         break;
+      case R_SC1SR1:
+         regs8[R_SC1SR1] = (now >= sciFree ? TDRE | TC : 0) | (rxFull ? RDRF : 0);
+         break;
+   }
+}
+
+/*----------------------------------------------------
+Function: commit
+Description: Write side of the previous access.  The
+             register was written if its value changed.
+------------------------------------------------------*/
+static void commit(void)
+{
+   int addr = pendAddr;
+   word value;
+   int ch;
+
+   if(addr < 0) return;
+   pendAddr = -1;
+   value = pendWide ? regs16[addr] : regs8[addr];
+   if(value == pendValue) return;
+   if(pendWide)
+   {
+      if(addr == R_TCNT) regs16[addr] = pendValue;  // read only
+      else if(addr == R_SC1DRL) sciWrite((byte)value);
+      return;
+   }
+   switch(addr)
+   {
+      case R_PORTA:
+         portaLatch = (byte)value;
+         break;
+      case R_TFLG1:  // write 1 to clear
+         regs8[R_TFLG1] = (byte)pendValue & ~(byte)value;
+         break;
+      case R_CFORC:
+         for(ch = 0; ch < 8; ch++)
+            if(value & (1 << ch)) outputAction(ch);
+         regs8[R_CFORC] = 0;
+         break;
+      case R_PTP:  // enabled digits (low) show PORTB
+         for(ch = 0; ch < 4; ch++)
+            if(!(value & (1 << ch))) segs[ch] = regs8[R_PORTB];
+         break;
+      case R_ESTAT:
+         eeStatusWrite((byte)pendValue, (byte)value);
+         break;
+   }
+}
+
+/*----------------------------------------------------
+Function: portaPins
+Description: Keypad matrix on port A.  Rows are the
+             outputs PA4-PA7, columns the inputs PA0-PA3
+             with pull-ups.  A pressed key pulls its
+             column low when its row is driven low.
+------------------------------------------------------*/
+static const char keyMap[] = "123a456b789c*0#d";
+
+static byte portaPins(void)
+{
+   byte ddr = regs8[R_DDRA];
+   byte pins = (portaLatch & ddr) | (~ddr & 0x0F);
+   const char *k;
+   int row, col;
+
+   if(keyDown && (k = strchr(keyMap, keyDown)) != NULL)
+   {
+      row = (k - keyMap)/4;
+      col = (k - keyMap)%4;
+      if(!(pins & (0x10 << row))) pins &= ~(1 << col);
+   }
+   return(pins);
+}
+
+/*----------------------------------------------------
+Function: advance
+Description: Moves the virtual clock forward.
+------------------------------------------------------*/
+static void advance(unsigned long long units)
+{
+   unsigned long long tick;
+   unsigned long n;
+
+   now += units;
+   if(regs8[R_TSCR1] & TEN)
+   {
+      tick = tickUnits();
+      tickFrac += units;
+      n = tickFrac / tick;
+      tickFrac -= n * tick;
+      if(n) timerTicks(n, now - tickFrac, tick);
+   }
+   if(eeBusy && now >= eeDoneAt)
+   {
+      eeBusy = 0;
+      regs8[R_ESTAT] |= CCIF;
+   }
+   if(scriptNext < scriptLen && now >= script[scriptNext].at) runScript();
+}
+
+/*----------------------------------------------------
+Function: timerTicks
+Description: Counts n timer ticks, the last at time last
+             and each tick units apart, and sets the flags
+             of the output compares that matched.
+------------------------------------------------------*/
+static void timerTicks(unsigned long n, unsigned long long last, unsigned long long tick)
+{
+   int ch;
+   unsigned long dist;
+
+   for(ch = 0; ch < 8; ch++)
+   {
+      if(!(regs8[R_TIOS] & (1 << ch))) continue;
+      dist = (word)(regs16[R_TC0 + 2*ch] - tcnt);
+      if(dist == 0) dist = 0x10000;
+      if(dist <= n)
+      {
+         if(!(regs8[R_TFLG1] & (1 << ch))) matchAt[ch] = last - (n - dist) * tick;
+         regs8[R_TFLG1] |= 1 << ch;
+         outputAction(ch);
+         events++;
+      }
+   }
+   tcnt += n;
+}
+
+/*----------------------------------------------------
+Function: outputAction
+Description: Output compare pin action of TCTL1/TCTL2.
+------------------------------------------------------*/
+static void outputAction(int ch)
+{
+   byte action;
+   byte old = regs8[R_PTT];
+
+   if(ch >= 4) action = (regs8[R_TCTL1] >> 2*(ch-4)) & 3;
+   else action = (regs8[R_TCTL2] >> 2*ch) & 3;
+   switch(action)
+   {
+      case 1: regs8[R_PTT] ^= 1 << ch; break;
+      case 2: regs8[R_PTT] &= ~(1 << ch); break;
+      case 3: regs8[R_PTT] |= 1 << ch; break;
+   }
+   if(ch == 5 && regs8[R_PTT] != old) edges++;
+}
+
+/*----------------------------------------------------
+Function: sciWrite
+Description: A byte written to SCI1DRL.  It is sent if
+             the transmitter is enabled, whether or not
+             TDRE was set.
+------------------------------------------------------*/
+static void sciWrite(byte data)
+{
+   unsigned sbr = regs16[R_SC1BD] & 0x1FFF;
+
+   if(!(regs8[R_SC1CR2] & SCI_TE)) return;
+   if(sciOut != NULL) putc(data, sciOut);
+   sciBytes++;
+   if(sciFree < now) sciFree = now;
+   sciFree += (unsigned long long)SCI_CHAR_BITS * 16 * (sbr ? sbr : 1) * busUnits();
+}
+
+/*----------------------------------------------------
+Function: sciPending
+Description: SCI1 transmit interrupt requested (TIE and
+             TDRE) with a service routine.
+------------------------------------------------------*/
+static int sciPending(void)
+{
+   return((regs8[R_SC1CR2] & SCI_TIE) && now >= sciFree && sciVector != NULL);
+}
+
+/*----------------------------------------------------
+Function: dispatch
+Description: Runs the service routines of the pending
+             and enabled interrupts while the I bit is
+             clear, highest priority first (the timer
+             channels, then SCI1).
+------------------------------------------------------*/
+static void dispatch(void)
+{
+   byte pending;
+   int ch;
+   void (*isr)(void);
+   unsigned long *count;
+   int timer;
+
+   while(!ibit && ((pending = regs8[R_TFLG1] & regs8[R_TIE]) != 0 || sciPending()))
+   {
+      if(pending)
+      {
+         ch = pickChannel(pending);
+         if(vectors[ch] == NULL)
+         {
+            fprintf(stderr, "hostSim: no service routine for TC%d, interrupt disabled\n", ch);
+            regs8[R_TIE] &= ~(1 << ch);
+            continue;
+         }
+         isr = vectors[ch];
+         count = &isrCount[ch];
+         timer = 1;
+      }
+      else
+      {
+         isr = sciVector;
+         count = &sciIsrCount;
+         timer = 0;
+      }
+      advance(ENTRY_CYCLES * busUnits());
+      if(timer) countLatency(ch, now - matchAt[ch]);
+      ibit = 1;
+      (*count)++;
+      isr();
+      commit();
+      advance(RTI_CYCLES * busUnits());
+      ibit = 0;
+   }
+}
+
+/*----------------------------------------------------
+Function: countLatency
+Description: Latency of an entry of the timer ISR of
+             channel ch (units).
+------------------------------------------------------*/
+static void countLatency(int ch, unsigned long long units)
+{
+   struct host_latency *l = &latency[ch];
+   unsigned long cycles = units / busUnits();
+   unsigned long v = cycles;
+   int b = 0;
+
+   if(units > maxLatency[ch]) maxLatency[ch] = units;
+   if(l->count == 0 || cycles < l->min) l->min = cycles;
+   if(cycles > l->max) l->max = cycles;
+   l->count++;
+   l->sum += cycles;
+   while(v && b < HOST_LAT_BINS - 1)
+   {
+      v >>= 1;
+      b++;
+   }
+   l->hist[b]++;
+}
+
+/*----------------------------------------------------
+Function: pickChannel
+Description: TC0 has the highest priority of the timer
+             vectors unless HPRIO promotes another one.
+------------------------------------------------------*/
+static int pickChannel(byte pending)
+{
+   byte hprio = regs8[R_HPRIO];
+   int ch;
+
+   if(hprio >= VEC_TC7 && hprio <= VEC_TC0 && !(hprio & 1))
+   {
+      ch = (VEC_TC0 - hprio)/2;
+      if(pending & (1 << ch)) return(ch);
+   }
+   for(ch = 0; !(pending & (1 << ch)); ch++) ;
+   return(ch);
+}
+
+/*----------------------------------------------------
+Function: eeRead, eeWrite
+Description: Element i of the EEPROM array.
+------------------------------------------------------*/
+static word eeRead(int i)
+{
+   char *p = (char *)eeRegion + i*eeSize;
+   if(eeSize == 1) return(*(byte *)p);
+   if(eeSize == 2) return(*(word *)p);
+   return((word)*(int *)p);
+}
+
+static void eeWrite(int i, word value)
+{
+   char *p = (char *)eeRegion + i*eeSize;
+   if(eeSize == 1) *(byte *)p = (byte)value;
+   else if(eeSize == 2) *(word *)p = value;
+   else *(int *)p = value;
+}
+
+/*----------------------------------------------------
+Function: eeStatusWrite
+Description: ESTAT write: errors are cleared by writing
+             1, writing 1 to CBEIF launches ECMD.
+------------------------------------------------------*/
+static void eeStatusWrite(byte old, byte written)
+{
+   regs8[R_ESTAT] = old & ~(written & (ACCERR|PVIOL));
+   if((written & CBEIF) && (old & CBEIF)) eeLaunch(regs8[R_ECMD]);
+}
+
+/*----------------------------------------------------
+Function: eeLaunch
+Description: Runs an EEPROM command on the word the
+             firmware wrote before the launch (the array
+             element that differs from the image).  A
+             write of the value already stored cannot be
+             seen; the command then only takes its time.
+------------------------------------------------------*/
+static void eeLaunch(byte cmd)
+{
+   int i, sect;
+   int latched = -1;
+
+   for(i = 0; i < eeCount; i++)
+      if(eeRead(i) != eeImage[i]) { latched = i; break; }
+   if(cmd == SECTOR_MODIFY)
+   {
+      if(latched >= 0)
+      {
+         sect = latched & ~1;  // a sector is two words
+         for(i = sect; i < sect + 2 && i < eeCount; i++)
+         {
+            if(i != latched) eeWrite(i, ERASED);
+            eeImage[i] = eeRead(i);
+         }
+         eeErases[sect/2]++;
+      }
+      eeDoneAt = now + (unsigned long long)(EE_ERASE_US + EE_PROG_US) * UNITS_PER_US;
+   }
+   else if(cmd == PROG)
+   {
+      if(latched >= 0) eeImage[latched] = eeRead(latched);
+      eeDoneAt = now + (unsigned long long)EE_PROG_US * UNITS_PER_US;
+   }
+   else
+   {
+      regs8[R_ESTAT] |= ACCERR;
+      return;
+   }
+   regs8[R_ESTAT] &= ~CCIF;
+   eeBusy = 1;
+}
+
+/*----------------------------------------------------
+Function: hostEraseCount
+Description: Number of erases of the sector holding
+             element i of the EEPROM array.
+------------------------------------------------------*/
+unsigned long hostEraseCount(int i)
+{
+   return((i >= 0 && i < eeCount) ? eeErases[i/2] : 0);
+}
+
+/*----------------------------------------------------
+Function: hostAt
+Description: Schedules fn(arg) at virtual time us, after
+             the entries already given for that time.
+------------------------------------------------------*/
+void hostAt(double us, void (*fn)(int), int arg)
+{
+   unsigned long long at = (unsigned long long)(us * UNITS_PER_US);
+   int i;
+
+   if(scriptLen == MAXSCRIPT) return;
+   for(i = scriptLen; i > scriptNext && script[i-1].at > at; i--) script[i] = script[i-1];
+   script[i].at = at;
+   script[i].fn = fn;
+   script[i].arg = arg;
+   scriptLen++;
+}
+
+static void runScript(void)
+{
+   while(scriptNext < scriptLen && now >= script[scriptNext].at)
+   {
+      script[scriptNext].fn(script[scriptNext].arg);
+      scriptNext++;
+   }
+}
+
+/*----------------------------------------------------
+Function: inputs
+Description: Keypad, switches and SCI1 input seen by the
+             modules.
+------------------------------------------------------*/
+void hostPressKey(char key)
+{
+   keyDown = key;
+}
+
+void hostReleaseKey(void)
+{
+   keyDown = 0;
+}
+
+void hostSetSwitches(byte sw)
+{
+   switches = sw;
+}
+
+void hostSciReceive(byte ch)
+{
+   if(!(regs8[R_SC1CR2] & SCI_RE)) return;  // receiver off: lost
+   rxData = ch;
+   rxFull = 1;
+}
+
+/*----------------------------------------------------
+Function: outputs and counters
+------------------------------------------------------*/
+void hostSciOutput(FILE *out)
+{
+   sciOut = out;
+}
+
+unsigned long hostSciBytes(void)
+{
+   return(sciBytes);
+}
+
+byte hostSegment(int digit)
+{
+   return((digit >= 0 && digit < 4) ? segs[digit] : 0);
+}
+
+unsigned long hostSirenEdges(void)
+{
+   return(edges);
+}
+
+unsigned long hostIsrCount(byte vector)
+{
+   if(vector == VEC_SCI1) return(sciIsrCount);
+   if(vector < VEC_TC7 || vector > VEC_TC0 || (vector & 1)) return(0);
+   return(isrCount[(VEC_TC0 - vector)/2]);
+}
+
+double hostMaxLatencyUs(byte vector)
+{
+   if(vector < VEC_TC7 || vector > VEC_TC0 || (vector & 1)) return(0.0);
+   return((double)maxLatency[(VEC_TC0 - vector)/2] / UNITS_PER_US);
+}
+
+int hostLatency(byte vector, struct host_latency *l)
+{
+   if(vector < VEC_TC7 || vector > VEC_TC0 || (vector & 1)) return(0);
+   *l = latency[(VEC_TC0 - vector)/2];
+   return(l->count != 0);
+}
+
+unsigned long long hostEvents(void)
+{
+   return(events);
+}
+
+double hostTimeUs(void)
+{
+   return((double)now / UNITS_PER_US);
+}
+
+/*----------------------------------------------------
+Function: nextEvent
+Description: Units until the next thing that can end
+             an idle wait: a compare match with its
+             interrupt enabled, TDRE with the SCI1
+             interrupt enabled, the end of an EEPROM
+             command, a scripted input or the stop time.
+------------------------------------------------------*/
+static unsigned long long nextEvent(unsigned long long limit)
+{
+   unsigned long long u = limit;
+   unsigned long long t;
+   unsigned long dist;
+   int ch;
+
+   if(regs8[R_TSCR1] & TEN)
+   {
+      for(ch = 0; ch < 8; ch++)
+      {
+         if(!(regs8[R_TIOS] & regs8[R_TIE] & (1 << ch))) continue;
+         dist = (word)(regs16[R_TC0 + 2*ch] - tcnt);
+         if(dist == 0) dist = 0x10000;
+         t = dist * tickUnits() - tickFrac;
+         if(t < u) u = t;
+      }
+   }
+   if((regs8[R_SC1CR2] & SCI_TIE) && sciFree > now && sciFree - now < u) u = sciFree - now;
+   if(eeBusy && eeDoneAt - now < u) u = eeDoneAt > now ? eeDoneAt - now : 1;
+   if(scriptNext < scriptLen && script[scriptNext].at - now < u)
+      u = script[scriptNext].at > now ? script[scriptNext].at - now : 1;
+   if(running && stopAt - now < u) u = stopAt > now ? stopAt - now : 1;
+   return(u ? u : 1);
+}
+
+/*----------------------------------------------------
+Function: hostRunUs
+Description: Runs the interrupt driven part of the
+             modules for us micro-sec with the main line
+             idle (I bit clear).
+------------------------------------------------------*/
+void hostRunUs(double us)
+{
+   unsigned long long end = now + (unsigned long long)(us * UNITS_PER_US);
+
+   commit();
+   ibit = 0;
+   dispatch();
+   while(now < end)
+   {
+      advance(nextEvent(end - now));
+      dispatch();
+   }
+}
+
+/*----------------------------------------------------
+Function: hostIdle
+Description: Idle hook of the wait loops (diag.h): the
+             firmware waits for a RAM variable changed by
+             an ISR, so the clock jumps to the next event
+             and the due interrupts are taken.
+------------------------------------------------------*/
+void hostIdle(void)
+{
+   if(!running || ibit) return;
+   commit();
+   advance(nextEvent((unsigned long long)1000 * UNITS_PER_US));
+   checkStop();
+   dispatch();
+}
+
+/*----------------------------------------------------
+Function: checkStop
+Description: Leaves the firmware main when the stop time
+             is reached.
+------------------------------------------------------*/
+static void checkStop(void)
+{
+   if(running && now >= stopAt)
+   {
+      running = 0;
+      longjmp(stopJmp, 1);
+   }
+}
+
+/*----------------------------------------------------
+Function: hostRunMain
+Description: Runs the firmware main (which never
+             returns) for us micro-sec of virtual time.
+             Returns 1 when the time was reached.
+------------------------------------------------------*/
+int hostRunMain(void (*fwMain)(void), double us)
+{
+   stopAt = now + (unsigned long long)(us * UNITS_PER_US);
+   if(setjmp(stopJmp) == 0)
+   {
+      running = 1;
+      fwMain();
+   }
+   running = 0;
+   pendAddr = -1;
+   ibit = 1;
+   return(1);
+}
@@ -0,0 +1,75 @@
+/*------------------------------------------------
+ * File: hostSim.h
+ * Description: Simulated peripheral block and virtual
+ *              clock for the host build of the Lab 4
+ *              modules.
+--------------------------------------------------*/
+#ifndef _HOSTSIM_H
+#define _HOSTSIM_H
+
+#include <stdio.h>
+
+typedef unsigned char byte;
+typedef unsigned short word;
+
+// Timer channel vectors (low byte of the vector address)
+#define VEC_TC0 0xEE
+#define VEC_TC1 0xEC
+#define VEC_TC2 0xEA
+#define VEC_TC3 0xE8
+#define VEC_TC4 0xE6
+#define VEC_TC5 0xE4
+#define VEC_TC6 0xE2
+#define VEC_TC7 0xE0
+#define VEC_SCI1 0xD4
+
+// Latency of a timer ISR, from the compare match to its start
+#define HOST_LAT_BINS 12  // histogram bins: 0, 1, 2-3, 4-7 ... bus cycles
+struct host_latency
+{
+   unsigned long count;
+   unsigned long min, max;  // bus cycles
+   double sum;
+   unsigned long hist[HOST_LAT_BINS];
+};
+
+// Register access (used by mc9s12dg256.h)
+volatile byte *hostReg8(word);
+volatile word *hostReg16(word);
+void hostCli(void);
+void hostSei(void);
+int hostIMasked(void);
+void hostIdle(void);
+
+// Set up
+void hostReset(void);
+void hostSetVector(byte, void (*)(void));
+void hostEeprom(void *, int, int);
+
+// Virtual clock
+double hostTimeUs(void);
+void hostRunUs(double);
+int hostRunMain(void (*)(void), double);
+void hostAt(double, void (*)(int), int);
+
+// Inputs
+void hostPressKey(char);
+void hostReleaseKey(void);
+void hostSetSwitches(byte);
+void hostSciReceive(byte);
+
+// Outputs and counters
+void hostSciOutput(FILE *);
+unsigned long hostSciBytes(void);
+byte hostSegment(int);
+unsigned long hostSirenEdges(void);
+unsigned long hostIsrCount(byte);
+double hostMaxLatencyUs(byte);
+int hostLatency(byte, struct host_latency *);
+unsigned long long hostEvents(void);
+unsigned long hostEraseCount(int);
+
+// LCD contents (lcdHost.c)
+void hostLcdLine(int, char *);
+
+#endif /* _HOSTSIM_H */
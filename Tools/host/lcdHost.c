@@ -0,0 +1,114 @@
+/*------------------------------------------------
+ * File: lcdHost.c
+ * Description: C version of lcd.asm for the host build.
+ *              The same PORTK writes and delayms calls
+ *              are made, and the characters are kept in
+ *              a display memory that hostLcdLine reads.
+ *              The display memory is 80 characters, the
+ *              second line starts at 40 (address 0x28 as
+ *              used by lcdDisp.c, or 0x40).
+--------------------------------------------------*/
+#include <string.h>
+#include "mc9s12dg256.h"
+#include "lcd_asm.h"
+#include "delay.h"
+
+#define DDRAM_SIZE 80
+#define LINE_START 40
+#define LINE_SIZE 16
+
+static char ddram[DDRAM_SIZE];
+static int addr;  // address counter (index in ddram)
+
+static const byte initCodes[] =
+{ 0x30, 0x30, 0x30, 0x20, 0x20, 0x80, 0x00, 0x60, 0x00, 0xC0, 0x00, 0x10 };
+
+/*----------------------------------------------------
+Function: writeNibble
+Description: Upper nibble of ch on PK2-PK5 with an E
+             pulse on PK1, RS on PK0.
+------------------------------------------------------*/
+static void writeNibble(byte ch, byte rs)
+{
+   byte val = ((ch & 0xF0) >> 2) | rs;
+   PORTK = val | 0x02;  // E = 1
+   PORTK = val;         // E = 0
+}
+
+static void writeByte(byte ch, byte rs)
+{
+   writeNibble(ch, rs);
+   writeNibble(ch << 4, rs);
+   if(rs)  // data
+   {
+      if(addr >= 0 && addr < DDRAM_SIZE) ddram[addr] = ch;
+      addr = (addr + 1) % DDRAM_SIZE;
+   }
+   else if(ch & 0x80)  // set DDRAM address
+   {
+      ch &= 0x7F;
+      addr = ch < 0x40 ? ch : ch - 0x40 + LINE_START;
+   }
+   else if(ch == 0x01)  // clear
+   {
+      memset(ddram, ' ', sizeof(ddram));
+      addr = 0;
+   }
+}
+
+void lcd_init(void)
+{
+   unsigned i;
+   DDRK = 0xFF;
+   for(i = 0; i < sizeof(initCodes); i++)
+   {
+      writeNibble(initCodes[i], 0);
+      delayms(5);
+   }
+   memset(ddram, ' ', sizeof(ddram));
+   addr = 0;
+}
+
+void instr8(char ch)
+{
+   writeByte(ch, 0);
+   delayms(10);
+}
+
+void data8(char ch)
+{
+   writeByte(ch, 1);
+   delayms(10);
+}
+
+void set_lcd_addr(char adr)
+{
+   writeByte(adr | 0x80, 0);
+   delayms(10);
+}
+
+void clear_lcd(void)
+{
+   writeByte(0x01, 0);
+   delayms(10);
+}
+
+void type_lcd(char *str)
+{
+   while(*str)
+   {
+      writeByte(*str++, 1);
+      delayms(10);
+   }
+}
+
+/*----------------------------------------------------
+Function: hostLcdLine
+Description: Copies the 16 visible characters of a line
+             (0 or 1) to buf (17 chars).
+------------------------------------------------------*/
+void hostLcdLine(int line, char *buf)
+{
+   memcpy(buf, &ddram[line ? LINE_START : 0], LINE_SIZE);
+   buf[LINE_SIZE] = '\0';
+}
@@ -0,0 +1,71 @@
+/*------------------------------------------------
+ * File: mainHost.c
+ * Description: C version of the main.asm routines used
+ *              by the Lab 4 modules (host build).
+--------------------------------------------------*/
+#include "mc9s12dg256.h"
+#include "main_asm.h"
+#include "diag.h"
+
+// SSTACK as painted by Start12.c (see diag.c)
+char hostStack[HOST_STACKSIZE] = { [0 ... HOST_STACKSIZE - 1] = DIAG_PAINT };
+
+/*----------------------------------------------------
+Function: PLL_init
+Description: 24 MHz bus from the 8 MHz crystal
+             (SYNR = 2, REFDV = 0), waits for lock.
+------------------------------------------------------*/
+void PLL_init(void)
+{
+   PLL_start();
+   PLL_select();
+}
+
+/*----------------------------------------------------
+Function: PLL_start, PLL_select
+Description: PLL_init in two steps: turn on the PLL and
+             wait for lock with the bus on OSCCLK, then
+             select PLLCLK.
+------------------------------------------------------*/
+void PLL_start(void)
+{
+   CLKSEL = 0;
+   SYNR = 2;
+   REFDV = 0;
+   PLLCTL = 0xF1;
+   while(!(CRGFLG & 0x08)) ;  // wait for lock
+}
+
+void PLL_select(void)
+{
+   CLKSEL = 0x80;
+}
+
+/*----------------------------------------------------
+Function: PLL_off
+Description: Selects OSCCLK and turns off the PLL.
+------------------------------------------------------*/
+void PLL_off(void)
+{
+   CLKSEL &= ~0x80;
+   PLLCTL &= ~0x40;
+}
+
+/*----------------------------------------------------
+Function: maskInts, restoreInts
+Description: sei returning the CCR (I bit only) as it
+             was, and its restore.
+------------------------------------------------------*/
+unsigned char maskInts(void)
+{
+   unsigned char ccr = hostIMasked() ? 0x10 : 0;
+
+   hostSei();
+   return(ccr);
+}
+
+void restoreInts(unsigned char ccr)
+{
+   if(ccr & 0x10) hostSei();
+   else hostCli();
+}
@@ -0,0 +1,124 @@
+/*------------------------------------------------
+ * File: mc9s12dg256.h  (host build)
+ * Description: Stand-in for the CodeWarrior derivative
+ *              header when the Lab 4 modules are compiled
+ *              on the host.  Every register is an lvalue in
+ *              the simulated peripheral block of hostSim.c,
+ *              the interrupt keyword is dropped so the ISRs
+ *              are plain functions, asm cli/sei set the
+ *              simulated I bit and the wait loops skip their
+ *              idle time.
+--------------------------------------------------*/
+#ifndef _MC9S12DG256_H
+#define _MC9S12DG256_H
+
+#include "hostSim.h"
+
+// CodeWarrior extensions
+#define interrupt
+#define asm
+#define cli hostCli()
+#define sei hostSei()
+
+// Idle hook of the wait loops (see diag.h)
+#define IDLE_HOOK() hostIdle()
+
+// Interrupt vector numbers (the ISRs are registered with hostSetVector)
+#define VectorNumber_Vtimch7
+#define VectorNumber_Vtimch6
+#define VectorNumber_Vtimch5
+#define VectorNumber_Vtimch4
+#define VectorNumber_Vtimch3
+#define VectorNumber_Vtimch2
+#define VectorNumber_Vtimch1
+#define VectorNumber_Vtimch0
+#define VectorNumber_Vsci0
+#define VectorNumber_Vsci1
+
+// Byte register with bit access
+typedef union
+{
+   byte Byte;
+   struct
+   {
+      byte BIT0:1;
+      byte BIT1:1;
+      byte BIT2:1;
+      byte BIT3:1;
+      byte BIT4:1;
+      byte BIT5:1;
+      byte BIT6:1;
+      byte BIT7:1;
+   } Bits;
+} REG8BITS;
+
+#define _REG8(addr)  (*hostReg8(addr))
+#define _REG16(addr) (*hostReg16(addr))
+#define _BITS8(addr) (*(volatile REG8BITS *)hostReg8(addr))
+
+// Ports
+#define PORTA   _REG8(0x0000)
+#define PORTB   _REG8(0x0001)
+#define DDRA    _REG8(0x0002)
+#define DDRB    _REG8(0x0003)
+#define PUCR    _REG8(0x000C)
+#define HPRIO   _REG8(0x001F)
+#define PORTK   _REG8(0x0032)
+#define DDRK    _REG8(0x0033)
+#define PTT     _REG8(0x0240)
+#define PTP     _REG8(0x0258)
+#define DDRP    _REG8(0x025A)
+#define PTH     _REG8(0x0260)
+#define DDRH    _REG8(0x0262)
+#define PERH    _REG8(0x0264)
+#define PPSH    _REG8(0x0265)
+
+// Clocks and Reset Generator
+#define SYNR    _REG8(0x0034)
+#define REFDV   _REG8(0x0035)
+#define CRGFLG  _REG8(0x0037)
+#define CLKSEL  _REG8(0x0039)
+#define PLLCTL  _REG8(0x003A)
+
+// Enhanced Capture Timer
+#define TIOS    _REG8(0x0040)
+#define TIOS_IOS0 _BITS8(0x0040).Bits.BIT0
+#define CFORC   _REG8(0x0041)
+#define TCNT    _REG16(0x0044)
+#define TSCR1   _REG8(0x0046)
+#define TCTL1   _REG8(0x0048)
+#define TCTL2   _REG8(0x0049)
+#define TIE     _REG8(0x004C)
+#define TIE_C0I _BITS8(0x004C).Bits.BIT0
+#define TSCR2   _REG8(0x004D)
+#define TFLG1   _REG8(0x004E)
+#define TC0     _REG16(0x0050)
+#define TC1     _REG16(0x0052)
+#define TC2     _REG16(0x0054)
+#define TC3     _REG16(0x0056)
+#define TC4     _REG16(0x0058)
+#define TC5     _REG16(0x005A)
+#define TC6     _REG16(0x005C)
+#define TC7     _REG16(0x005E)
+
+// Serial Communication Interface 1
+#define SCI1BD  _REG16(0x00D0)
+#define SCI1CR2 _REG8(0x00D3)
+#define SCI1SR1 _REG8(0x00D4)
+#define SCI1SR1_RDRF_MASK 0x20
+#define SCI1SR1_TDRE_MASK 0x80
+#define SCI1DRL _REG16(0x00D7)  // word so every write is seen (see hostSim.c)
+
+// EEPROM
+#define ECLKDIV _REG8(0x0110)
+#define ESTAT   _REG8(0x0115)
+#define ECMD    _REG8(0x0116)
+
+// Linker symbols of the stack segment (stack of the host thread
+// is not this array, so it stays as painted - see mainHost.c)
+#define HOST_STACKSIZE 0x100
+extern char hostStack[HOST_STACKSIZE];
+#define __SEG_START_SSTACK hostStack
+#define __SEG_END_SSTACK (hostStack + HOST_STACKSIZE)
+
+#endif /* _MC9S12DG256_H */
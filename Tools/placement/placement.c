@@ -0,0 +1,443 @@
+/*-------------------------------------------------------------
+ * File:  placement.c
+ * Description: Code placement tool.  Reads the linker map
+ *              (PROCEDURES of the OBJECT-ALLOCATION SECTION and
+ *              the OBJECT-DEPENDENCIES SECTION) and a profile of
+ *              call and cycle counts, pins the ISRs, the functions
+ *              they call, the functions called from assembler
+ *              and the hot functions in non-banked flash
+ *              (ROM_C000) and moves the cold C functions to the
+ *              banked pages PAGE_30 to PAGE_3D.  Prints the
+ *              PLACEMENT block for the linker .prm file, the
+ *              functions to put in each code segment and the
+ *              CALL/RTC overhead added by the banked functions.
+ *
+ *  Usage: placement [-h pct] [-n calls] [-p isr,...] map profile
+ *
+ *  Profile format (one function per line, # starts a comment):
+ *      name calls cycles
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXFUNCS 512
+#define MAXUSES 16
+#define NAMESIZE 64
+#define LINESIZE 256
+#define PAGESIZE 0x4000   // size of a PPAGE window (0x8000 - 0xBFFF)
+#define FIRSTPAGE 0x30
+#define LASTPAGE 0x3D
+
+// Cycles for calling and returning (CPU12 reference manual)
+#define JSR_CYCLES 4      // JSR opr16a
+#define RTS_CYCLES 5
+#define CALL_CYCLES 7     // CALL opr16a,page
+#define RTC_CYCLES 6
+
+// Placement of a function
+#define PL_PINNED 0       // ISR, startup, runtime or assembler - must stay non-banked
+#define PL_HOT 1          // hot path from the profile - non-banked
+#define PL_COLD 2         // banked
+
+struct function
+{
+   char name[NAMESIZE];
+   char module[NAMESIZE];
+   unsigned addr;
+   unsigned size;
+   unsigned long calls;
+   unsigned long long cycles;
+   int placement;
+   int page;
+   int numUses;
+   int uses[MAXUSES];    // indices of the functions it calls
+};
+
+struct function funcs[MAXFUNCS];
+int numFuncs = 0;
+
+// Default ISRs (Lab 4)
+char *defIsrs = "key_isr,disp_isr,tco_isr,sirenISR";
+
+// Prototypes
+int readMap(char *);
+int readProfile(char *);
+struct function *findFunc(char *);
+int isPinnedModule(char *);
+int isInList(char *, char *);
+void readUses(char *, struct function **);
+void pinCallees(struct function *, int);
+void classify(char *, double, unsigned long);
+void assignPages(void);
+void printPlacement(void);
+void printSegments(void);
+void printOverhead(void);
+
+/*------------------------------------
+ * Function: main
+ * Description: Reads the map and profile and prints
+ *              the placement report.
+ * --------------------------------*/
+int main(int argc, char **argv)
+{
+   double hotPct = 1.0;          // % of total cycles that makes a function hot
+   unsigned long hotCalls = 1000; // number of calls that makes a function hot
+   char *isrs = defIsrs;
+   int i;
+
+   for(i = 1; i < argc - 2; i++)
+   {
+      if(strcmp(argv[i], "-h") == 0 && i+1 < argc-2) hotPct = atof(argv[++i]);
+      else if(strcmp(argv[i], "-n") == 0 && i+1 < argc-2) hotCalls = strtoul(argv[++i], NULL, 0);
+      else if(strcmp(argv[i], "-p") == 0 && i+1 < argc-2) isrs = argv[++i];
+      else break;
+   }
+   if(argc < 3 || i != argc - 2)
+   {
+      fprintf(stderr, "usage: placement [-h pct] [-n calls] [-p isr,...] map profile\n");
+      return(2);
+   }
+   if(!readMap(argv[argc-2]) || !readProfile(argv[argc-1])) return(1);
+
+   classify(isrs, hotPct, hotCalls);
+   assignPages();
+   printPlacement();
+   printSegments();
+   printOverhead();
+   return(0);
+}
+
+/*------------------------------------
+ * Function: readMap
+ * Description: Reads the procedures of every module
+ *              from the OBJECT-ALLOCATION SECTION
+ *              of a CodeWarrior linker map.
+ * --------------------------------*/
+int readMap(char *fileName)
+{
+   FILE *fp;
+   char line[LINESIZE];
+   char module[NAMESIZE] = "";
+   int inObjects = 0;
+   int inProcs = 0;
+   int inDeps = 0;
+   struct function *f;
+   struct function *user = NULL;
+   char *p;
+
+   if((fp = fopen(fileName, "r")) == NULL)
+   {
+      perror(fileName);
+      return(0);
+   }
+   while(fgets(line, sizeof(line), fp) != NULL)
+   {
+      if(strstr(line, "OBJECT-ALLOCATION SECTION")) inObjects = 1;
+      else if(strstr(line, "OBJECT-DEPENDENCIES SECTION")) inDeps = 1;
+      else if(inDeps && strstr(line, "DEPENDENCY TREE")) break;
+      else if(inDeps) readUses(line, &user);
+      else if(!inObjects) continue;
+      else if(strstr(line, "MODULE STATISTIC")) inObjects = 0;
+      else if(strncmp(line, "MODULE:", 7) == 0)
+      {
+         // module name is between "-- " and " --", e.g. CTYPE.C.o (ansis.lib)
+         module[0] = '\0';
+         if((p = strstr(line, "-- ")) != NULL)
+         {
+            strncpy(module, p + 3, NAMESIZE - 1);
+            module[NAMESIZE - 1] = '\0';
+            if((p = strstr(module, " --")) != NULL) *p = '\0';
+         }
+         inProcs = 0;
+      }
+      else if(strncmp(line, "- PROCEDURES:", 13) == 0) inProcs = 1;
+      else if(strncmp(line, "- ", 2) == 0) inProcs = 0;
+      else if(inProcs && numFuncs < MAXFUNCS)
+      {
+         f = &funcs[numFuncs];
+         memset(f, 0, sizeof(*f));
+         if(sscanf(line, "%63s %x %x", f->name, &f->addr, &f->size) == 3)
+         {
+            strcpy(f->module, module);
+            numFuncs++;
+         }
+      }
+   }
+   fclose(fp);
+   if(numFuncs == 0)
+   {
+      fprintf(stderr, "%s: no procedures found\n", fileName);
+      return(0);
+   }
+   return(1);
+}
+
+/*------------------------------------
+ * Function: readUses
+ * Description: Reads one line of the OBJECT-DEPENDENCIES
+ *              SECTION ("name USES a b c", continued on
+ *              lines starting with spaces) and records the
+ *              functions called.  Variables are skipped.
+ * --------------------------------*/
+void readUses(char *line, struct function **user)
+{
+   char name[NAMESIZE];
+   char *p = line;
+   int n;
+   struct function *f;
+
+   if(line[0] != ' ')
+   {
+      if(sscanf(line, "%63s%n", name, &n) != 1)
+      {
+         *user = NULL;
+         return;
+      }
+      *user = findFunc(name);
+      p += n;
+      if((p = strstr(p, "USES")) == NULL) return;
+      p += 4;
+   }
+   if(*user == NULL) return;
+   while(sscanf(p, "%63s%n", name, &n) == 1)
+   {
+      p += n;
+      if((f = findFunc(name)) != NULL && (*user)->numUses < MAXUSES)
+         (*user)->uses[(*user)->numUses++] = f - funcs;
+   }
+}
+
+/*------------------------------------
+ * Function: readProfile
+ * Description: Reads call and cycle counts for each
+ *              function. Unknown names are ignored.
+ * --------------------------------*/
+int readProfile(char *fileName)
+{
+   FILE *fp;
+   char line[LINESIZE];
+   char name[NAMESIZE];
+   unsigned long calls;
+   unsigned long long cycles;
+   struct function *f;
+
+   if((fp = fopen(fileName, "r")) == NULL)
+   {
+      perror(fileName);
+      return(0);
+   }
+   while(fgets(line, sizeof(line), fp) != NULL)
+   {
+      if(line[0] == '#') continue;
+      if(sscanf(line, "%63s %lu %llu", name, &calls, &cycles) != 3) continue;
+      if((f = findFunc(name)) != NULL)
+      {
+         f->calls += calls;
+         f->cycles += cycles;
+      }
+   }
+   fclose(fp);
+   return(1);
+}
+
+/*------------------------------------
+ * Function: findFunc
+ * Description: Returns the function with the given name
+ *              or NULL.
+ * --------------------------------*/
+struct function *findFunc(char *name)
+{
+   int i;
+   for(i = 0; i < numFuncs; i++)
+      if(strcmp(funcs[i].name, name) == 0) return(&funcs[i]);
+   return(NULL);
+}
+
+/*------------------------------------
+ * Function: isPinnedModule
+ * Description: Assembler modules return with RTS and the
+ *              startup and library code is not compiled
+ *              for banking, so they stay non-banked.
+ * --------------------------------*/
+int isPinnedModule(char *module)
+{
+   return(strstr(module, ".asm") != NULL || strstr(module, "Start12") != NULL ||
+          strstr(module, ".lib") != NULL || strstr(module, "(") != NULL ||
+          strstr(module, "mc9s12") != NULL);
+}
+
+/*------------------------------------
+ * Function: isInList
+ * Description: TRUE if name is in the comma separated list.
+ * --------------------------------*/
+int isInList(char *name, char *list)
+{
+   size_t len = strlen(name);
+   char *p = list;
+
+   while((p = strstr(p, name)) != NULL)
+   {
+      if((p == list || p[-1] == ',') && (p[len] == ',' || p[len] == '\0')) return(1);
+      p += len;
+   }
+   return(0);
+}
+
+/*------------------------------------
+ * Function: pinCallees
+ * Description: Marks every function called (directly or
+ *              not) by f with at least placement pl.
+ * --------------------------------*/
+void pinCallees(struct function *f, int pl)
+{
+   int i;
+   for(i = 0; i < f->numUses; i++)
+   {
+      struct function *callee = &funcs[f->uses[i]];
+      if(callee->placement > pl)
+      {
+         callee->placement = pl;
+         pinCallees(callee, pl);
+      }
+   }
+}
+
+/*------------------------------------
+ * Function: classify
+ * Description: Pins ISRs and non-C code, marks functions
+ *              with hotPct % of the cycles or hotCalls calls
+ *              as hot and all others as cold.  main is kept
+ *              non-banked since it never returns.  Functions
+ *              called from assembler (JSR) are pinned and
+ *              functions called from ISRs are hot.
+ * --------------------------------*/
+void classify(char *isrs, double hotPct, unsigned long hotCalls)
+{
+   unsigned long long total = 0;
+   int i;
+
+   for(i = 0; i < numFuncs; i++) total += funcs[i].cycles;
+   for(i = 0; i < numFuncs; i++)
+   {
+      struct function *f = &funcs[i];
+      if(isInList(f->name, isrs) || isPinnedModule(f->module) || strcmp(f->name, "main") == 0)
+         f->placement = PL_PINNED;
+      else if(f->calls >= hotCalls || (total && 100.0 * f->cycles / total >= hotPct))
+         f->placement = PL_HOT;
+      else
+         f->placement = PL_COLD;
+   }
+   for(i = 0; i < numFuncs; i++)
+   {
+      if(strstr(funcs[i].module, ".asm") != NULL) pinCallees(&funcs[i], PL_PINNED);
+      else if(isInList(funcs[i].name, isrs)) pinCallees(&funcs[i], PL_HOT);
+   }
+}
+
+/*------------------------------------
+ * Function: assignPages
+ * Description: Fills the banked pages with the cold
+ *              functions, keeping the functions of a
+ *              module together where possible.
+ * --------------------------------*/
+void assignPages(void)
+{
+   int page = FIRSTPAGE;
+   unsigned used = 0;
+   int i;
+
+   for(i = 0; i < numFuncs; i++)
+   {
+      if(funcs[i].placement != PL_COLD) continue;
+      if(used + funcs[i].size > PAGESIZE && page < LASTPAGE)
+      {
+         page++;
+         used = 0;
+      }
+      funcs[i].page = page;
+      used += funcs[i].size;
+   }
+}
+
+/*------------------------------------
+ * Function: printPlacement
+ * Description: Prints the PLACEMENT block.  HOT_CODE holds
+ *              the hot C functions, COLD_CODE the banked ones.
+ * --------------------------------*/
+void printPlacement(void)
+{
+   int page;
+   int last = FIRSTPAGE;
+   int i;
+
+   for(i = 0; i < numFuncs; i++)
+      if(funcs[i].placement == PL_COLD && funcs[i].page > last) last = funcs[i].page;
+
+   printf("PLACEMENT /* generated by placement */\n");
+   printf("    _PRESTART,\n    STARTUP,\n    ROM_VAR,\n    STRINGS,\n    VIRTUAL_TABLE_SEGMENT,\n");
+   printf("    HOT_CODE,                    /* ISRs and hot paths: JSR/RTS */\n");
+   printf("    DEFAULT_ROM, NON_BANKED,\n    COPY                         INTO  ROM_C000;\n");
+   printf("    COLD_CODE,                   /* banked: CALL/RTC */\n");
+   printf("    OTHER_ROM                    INTO  ");
+   for(page = FIRSTPAGE; page <= last; page++)
+      printf("PAGE_%02X%s", page, page < last ? "," : ";\n");
+   printf("    SSTACK,\n    HOT_DATA,\n    DEFAULT_RAM                  INTO  RAM;\n");
+   printf("    EEPROM_DATA                  INTO  EEPROM;\nEND\n\n");
+}
+
+/*------------------------------------
+ * Function: printSegments
+ * Description: Lists the functions for each code segment
+ *              (#pragma CODE_SEG HOT_CODE and
+ *               #pragma CODE_SEG __FAR_SEG COLD_CODE).
+ * --------------------------------*/
+void printSegments(void)
+{
+   char *titles[] = { "Pinned (DEFAULT_ROM/NON_BANKED)", "HOT_CODE", "COLD_CODE" };
+   int pl;
+   int i;
+
+   for(pl = PL_PINNED; pl <= PL_COLD; pl++)
+   {
+      printf("/* %s */\n", titles[pl]);
+      for(i = 0; i < numFuncs; i++)
+      {
+         struct function *f = &funcs[i];
+         if(f->placement != pl) continue;
+         printf("/*   %-24s %-20s %5u bytes %10lu calls %12llu cycles", f->name, f->module,
+                f->size, f->calls, f->cycles);
+         if(pl == PL_COLD) printf("  PAGE_%02X", f->page);
+         printf(" */\n");
+      }
+   }
+   printf("\n");
+}
+
+/*------------------------------------
+ * Function: printOverhead
+ * Description: Reports the cycles added by calling the
+ *              banked functions with CALL/RTC instead of
+ *              JSR/RTS.
+ * --------------------------------*/
+void printOverhead(void)
+{
+   unsigned long long total = 0;
+   unsigned long long added = 0;
+   unsigned coldSize = 0;
+   int i;
+
+   for(i = 0; i < numFuncs; i++)
+   {
+      total += funcs[i].cycles;
+      if(funcs[i].placement == PL_COLD)
+      {
+         added += (unsigned long long)funcs[i].calls *
+                  (CALL_CYCLES + RTC_CYCLES - JSR_CYCLES - RTS_CYCLES);
+         coldSize += funcs[i].size;
+      }
+   }
+   printf("/* Banked code: %u bytes moved out of ROM_C000 */\n", coldSize);
+   printf("/* CALL/RTC overhead: %llu cycles added to %llu profiled cycles (%.3f%%) */\n",
+          added, total, total ? 100.0 * added / total : 0.0);
+}
@@ -0,0 +1,91 @@
+/*------------------------------------------------
+ * File: atd.c
+ * Description: ATD0 with the LM35 temperature sensor
+ *              of the Dragon12-Plus on AN05 (10 mV per
+ *              deg C, VRH = 5 V).  The other channels read
+ *              0 V.
+ *
+ *              A write of ATD0CTL5 converts the whole
+ *              sequence at once: the results, CCF and SCF
+ *              are there for the first read of the status.
+ *              The temperatures are given in advance with
+ *              their times, as the key presses are.
+--------------------------------------------------*/
+#include "hcs12.h"
+
+#define R_ATDCTL3 0x083
+#define R_ATDCTL4 0x084
+#define R_ATDCTL5 0x085
+#define R_ATDSTAT0 0x086
+#define R_ATDSTAT1 0x08B
+#define R_ATDDR0  0x090
+
+// ATD bits
+#define SRES8 0x80
+#define DJM   0x80
+#define MULT  0x10
+#define SCF   0x80
+
+#define TEMP_CH   5
+#define ROOM_TEMP 22.0   // deg C before the first reading
+#define VRH       5.0
+
+/*----------------------------------------------------
+Function: tempSet
+Description: The temperature becomes degC at atMs.
+             Returns -1 if the list is full.
+------------------------------------------------------*/
+int tempSet(struct hcs12 *s, double atMs, double degC)
+{
+   struct inputs *in = &s->inputs;
+   int i;
+
+   if(in->numTemps == MAXTEMPS) return(-1);
+   for(i = in->numTemps++; i > 0 && in->temps[i-1].at > atMs * 1000.0; i--)
+      in->temps[i] = in->temps[i-1];
+   in->temps[i].at = atMs * 1000.0;
+   in->temps[i].value = degC;
+   return(0);
+}
+
+// Input of channel ch (volts)
+static double volts(struct hcs12 *s, int ch)
+{
+   struct inputs *in = &s->inputs;
+   double now = simTimeUs(s), t = ROOM_TEMP;
+   int i;
+
+   if(ch != TEMP_CH) return(0.0);
+   for(i = 0; i < in->numTemps && in->temps[i].at <= now; i++) t = in->temps[i].value;
+   return(t * 0.01);
+}
+
+/*----------------------------------------------------
+Function: atdConvert
+Description: Called on a write of ATD0CTL5: converts the
+             sequence (length from S8C-S1C of ATD0CTL3,
+             8 or 10 bits, left or right justified).
+------------------------------------------------------*/
+void atdConvert(struct hcs12 *s)
+{
+   byte ctl5 = s->regs[R_ATDCTL5];
+   int len = (s->regs[R_ATDCTL3] >> 3) & 0x0F;
+   int bits = (s->regs[R_ATDCTL4] & SRES8) ? 8 : 10;
+   int i;
+
+   if(len == 0 || len > 8) len = 8;
+   s->regs[R_ATDSTAT1] = 0;
+   for(i = 0; i < len; i++)
+   {
+      int ch = (ctl5 & MULT) ? ((ctl5 + i) & 0x07) : (ctl5 & 0x07);
+      long code = (long)(volts(s, ch) / VRH * (1 << bits) + 0.5);
+      word dr;
+      if(code < 0) code = 0;
+      if(code >= (1 << bits)) code = (1 << bits) - 1;
+      dr = (ctl5 & DJM) ? (word)code : (word)(code << (16 - bits));
+      s->regs[R_ATDDR0 + 2*i] = (byte)(dr >> 8);
+      s->regs[R_ATDDR0 + 2*i + 1] = (byte)dr;
+      s->regs[R_ATDSTAT1] |= 1 << i;
+   }
+   s->regs[R_ATDSTAT0] |= SCF;
+}
@@ -0,0 +1,1388 @@
+/*------------------------------------------------
+ * File: cpu.c
+ * Description: HCS12 CPU - memory access, instruction
+ *              decode and execution with the HCS12 cycle
+ *              counts, interrupts and the shadow call
+ *              stack used to measure routines.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define D(s) ((word)((s)->a << 8 | (s)->b))
+
+// Indexed addressing classes (columns of the cycle tables)
+#define IDX   0  // 5-bit offset, auto inc/dec, accumulator offset
+#define IDX1  1  // 9-bit offset
+#define IDX2  2  // 16-bit offset
+#define INDD  3  // [D,xysp]
+#define IND16 4  // [n16,xysp]
+
+// Cycles for each indexed class
+static const byte cycLoad[5]  = { 3, 3, 4, 6, 6 };  // LDAA, ADDA, LDD, ADDD ...
+static const byte cycStore[5] = { 2, 3, 3, 5, 5 };  // STAA, STD, CLR
+static const byte cycRmw[5]   = { 3, 4, 5, 6, 6 };  // INC, NEG, ASL ...
+static const byte cycJmp[5]   = { 3, 3, 4, 6, 6 };
+static const byte cycJsr[5]   = { 4, 4, 5, 7, 7 };
+static const byte cycCall[5]  = { 7, 7, 8, 10, 10 };
+static const byte cycBset[5]  = { 4, 4, 6, 5, 5 };
+static const byte cycBrset[5] = { 4, 5, 6, 6, 6 };
+static const byte cycMax[5]   = { 4, 4, 5, 7, 7 };  // MAXA, EMAXD ...
+static const byte cycMaxm[5]  = { 4, 5, 6, 7, 7 };  // MAXM, EMAXM ...
+
+/*----------------------------------------------------
+Function: hcs12Read8, hcs12Read16
+Description: Memory reads (registers go to periph.c).
+------------------------------------------------------*/
+byte hcs12Read8(struct hcs12 *s, word a)
+{
+   if(a >= FLASH_START)
+   {
+      if(a >= WIN_END) return(s->img->flash[0x0F][a - WIN_END]);
+      if(a >= WIN_START) return(s->img->flash[s->ppage & 0x0F][a - WIN_START]);
+      return(s->img->flash[0x0E][a - FLASH_START]);
+   }
+   if(a >= RAM_START) return(s->ram[a - RAM_START]);
+   if(a >= EE_START) return(s->eeprom[a - EE_START]);
+   s->loop.taint = 1;  // not an idle loop (see idle.c)
+   return(ioRead(s, a));
+}
+
+word hcs12Read16(struct hcs12 *s, word a)
+{
+   return((word)(hcs12Read8(s, a) << 8 | hcs12Read8(s, a + 1)));
+}
+
+/*----------------------------------------------------
+Function: hcs12Write8, hcs12Write16
+Description: Memory writes.  Writes to flash are ignored,
+             writes to EEPROM go to its controller.
+------------------------------------------------------*/
+void hcs12Write8(struct hcs12 *s, word a, byte v)
+{
+   s->loop.taint = 1;
+   if(a >= FLASH_START) return;
+   if(a >= RAM_START)
+   {
+      s->ram[a - RAM_START] = v;
+      if(s->snap) snapMark(s, a);
+   }
+   else if(a >= EE_START) eepromWrite(s, a, v, 0);
+   else ioWrite(s, a, v);
+}
+
+void hcs12Write16(struct hcs12 *s, word a, word v)
+{
+   if(a >= EE_START && a < RAM_START)
+   {
+      s->loop.taint = 1;
+      eepromWrite(s, a, v, 1);
+      return;
+   }
+   hcs12Write8(s, a, v >> 8);
+   hcs12Write8(s, a + 1, (byte)v);
+}
+
+/*----------------------------------------------------
+Function: hcs12Linear
+Description: Address of a code byte that does not depend
+             on PPAGE: $0000-$FFFF outside the window,
+             $10000 + page x $4000 + offset inside it.
+------------------------------------------------------*/
+unsigned long hcs12Linear(struct hcs12 *s, word a)
+{
+   if(a >= WIN_START && a < WIN_END)
+      return(0x10000UL + (unsigned long)(s->ppage & 0x0F) * PAGE_SIZE + (a - WIN_START));
+   return(a);
+}
+
+#define rd8(a)     hcs12Read8(s, (a))
+#define rd16(a)    hcs12Read16(s, (a))
+#define wr8(a, v)  hcs12Write8(s, (a), (v))
+#define wr16(a, v) hcs12Write16(s, (a), (v))
+
+static byte fetch8(struct hcs12 *s)
+{
+   return(rd8(s->pc++));
+}
+
+static word fetch16(struct hcs12 *s)
+{
+   word v = rd16(s->pc);
+   s->pc += 2;
+   return(v);
+}
+
+static void push8(struct hcs12 *s, byte v)
+{
+   s->sp--;
+   wr8(s->sp, v);
+}
+
+void hcs12Push16(struct hcs12 *s, word v)
+{
+   s->sp -= 2;
+   wr16(s->sp, v);
+}
+
+static byte pull8(struct hcs12 *s)
+{
+   return(rd8(s->sp++));
+}
+
+word hcs12Pull16(struct hcs12 *s)
+{
+   word v = rd16(s->sp);
+   s->sp += 2;
+   return(v);
+}
+
+/*----------------------------------------------------
+Function: enter, leave
+Description: Shadow call stack.  A frame is left when
+             the stack pointer is back at (or above) the
+             value it had before the call or interrupt.
+------------------------------------------------------*/
+static void enter(struct hcs12 *s, word sp, byte kind)
+{
+   struct frame *f;
+   if(s->depth == MAXFRAMES) return;
+   f = &s->frames[s->depth++];
+   f->func = hcs12Linear(s, s->pc);
+   f->site = f->func;
+   if(kind == FR_CALL && s->depth > 1)
+   {
+      byte page = s->ppage;
+      if(s->farCall) s->ppage = rd8(s->sp);  // page of the CALL
+      f->site = hcs12Linear(s, s->lastPC);
+      s->ppage = page;
+   }
+   f->sp = sp;
+   f->kind = kind;
+   f->start = s->cycles;
+   f->irq = 0;
+   if(s->timeline) timelineEnter(s);
+}
+
+static void leave(struct hcs12 *s)
+{
+   struct frame *f;
+   while(s->depth > 1 && s->frames[s->depth-1].sp <= s->sp)
+   {
+      f = &s->frames[--s->depth];
+      if(f->kind == FR_IRQ) s->frames[s->depth-1].irq += s->cycles - f->start;
+      else s->frames[s->depth-1].irq += f->irq;
+      if(s->onLeave) s->onLeave(s, f);
+      if(s->irqs && f->kind == FR_IRQ) irqLeave(s, s->depth);
+      if(s->timeline) timelineLeave(s, f);
+   }
+}
+
+/*----------------------------------------------------
+Function: hcs12Reset
+Description: Reset: RAM and EEPROM get the loaded image,
+             the CPU starts at the reset vector with the
+             I and X bits set.
+------------------------------------------------------*/
+void hcs12Reset(struct hcs12 *s, const struct image *img)
+{
+   void (*onLeave)(struct hcs12 *, struct frame *) = s->onLeave;
+   void *user = s->user;
+   void (*onOutput)(struct hcs12 *, int) = s->onOutput;
+   void *observer = s->observer;
+   unsigned long long *pcCycles = s->pcCycles;
+   struct irqs *irqs = s->irqs;
+   struct direct *direct = s->direct;
+   struct timeline *timeline = s->timeline;
+   int dbug12 = s->dbug12;
+   int skipIdle = s->skipIdle;
+   int lcdTrace = s->lcd.trace;
+   int quiet = s->quiet;
+
+   memset(s, 0, sizeof(*s));
+   s->img = img;
+   s->onLeave = onLeave;
+   s->user = user;
+   s->onOutput = onOutput;
+   s->observer = observer;
+   s->pcCycles = pcCycles;
+   s->irqs = irqs;
+   s->direct = direct;
+   s->timeline = timeline;
+   s->dbug12 = dbug12;
+   s->skipIdle = skipIdle;
+   s->lcd.trace = lcdTrace;
+   s->quiet = quiet;
+   memcpy(s->eeprom, &img->low[EE_START], sizeof(s->eeprom));
+   memcpy(s->ram, &img->low[RAM_START], sizeof(s->ram));
+   s->ccr = CC_S | CC_X | CC_I;
+   s->ppage = 0x3D;  // $8000-$BFFF as in the non-banked memory model
+   periphReset(s);
+   s->pc = rd16(VEC_RESET);
+   s->state = ST_RUN;
+   s->depth = 0;
+   enter(s, 0xFFFF, FR_CALL);  // root frame, never left
+}
+
+/*----------------------------------------------------
+Function: flags helpers
+------------------------------------------------------*/
+static void nz8(struct hcs12 *s, byte v)
+{
+   s->ccr &= ~(CC_N|CC_Z);
+   if(v & 0x80) s->ccr |= CC_N;
+   if(v == 0) s->ccr |= CC_Z;
+}
+
+static void nz16(struct hcs12 *s, word v)
+{
+   s->ccr &= ~(CC_N|CC_Z);
+   if(v & 0x8000) s->ccr |= CC_N;
+   if(v == 0) s->ccr |= CC_Z;
+}
+
+static byte logic8(struct hcs12 *s, byte v)  // loads, AND, ORA, EOR ...
+{
+   nz8(s, v);
+   s->ccr &= ~CC_V;
+   return(v);
+}
+
+static word logic16(struct hcs12 *s, word v)
+{
+   nz16(s, v);
+   s->ccr &= ~CC_V;
+   return(v);
+}
+
+static byte add8(struct hcs12 *s, byte x, byte y, int c)
+{
+   unsigned r = x + y + c;
+   s->ccr &= ~(CC_H|CC_V|CC_C);
+   if((x ^ y ^ r) & 0x10) s->ccr |= CC_H;
+   if(r & 0x100) s->ccr |= CC_C;
+   if(~(x ^ y) & (x ^ r) & 0x80) s->ccr |= CC_V;
+   nz8(s, (byte)r);
+   return((byte)r);
+}
+
+static byte sub8(struct hcs12 *s, byte x, byte y, int c)
+{
+   unsigned r = x - y - c;
+   s->ccr &= ~(CC_V|CC_C);
+   if(r & 0x100) s->ccr |= CC_C;
+   if((x ^ y) & (x ^ r) & 0x80) s->ccr |= CC_V;
+   nz8(s, (byte)r);
+   return((byte)r);
+}
+
+static word add16(struct hcs12 *s, word x, word y)
+{
+   unsigned long r = (unsigned long)x + y;
+   s->ccr &= ~(CC_V|CC_C);
+   if(r & 0x10000) s->ccr |= CC_C;
+   if(~(x ^ y) & (x ^ r) & 0x8000) s->ccr |= CC_V;
+   nz16(s, (word)r);
+   return((word)r);
+}
+
+static word sub16(struct hcs12 *s, word x, word y)
+{
+   unsigned long r = (unsigned long)x - y;
+   s->ccr &= ~(CC_V|CC_C);
+   if(r & 0x10000) s->ccr |= CC_C;
+   if((x ^ y) & (x ^ r) & 0x8000) s->ccr |= CC_V;
+   nz16(s, (word)r);
+   return((word)r);
+}
+
+/*----------------------------------------------------
+Function: rmw
+Description: NEG, COM, INC, DEC, LSR, ROL, ROR, ASR,
+             ASL and CLR (low nibble of the opcode).
+------------------------------------------------------*/
+static byte rmw(struct hcs12 *s, int op, byte v)
+{
+   int c = s->ccr & CC_C;
+   byte r;
+
+   switch(op)
+   {
+      case 0x0:  // NEG
+         r = sub8(s, 0, v, 0);
+         return(r);
+      case 0x1:  // COM
+         r = logic8(s, ~v);
+         s->ccr |= CC_C;
+         return(r);
+      case 0x2:  // INC
+         r = v + 1;
+         nz8(s, r);
+         s->ccr &= ~CC_V;
+         if(r == 0x80) s->ccr |= CC_V;
+         return(r);
+      case 0x3:  // DEC
+         r = v - 1;
+         nz8(s, r);
+         s->ccr &= ~CC_V;
+         if(r == 0x7F) s->ccr |= CC_V;
+         return(r);
+      case 0x4:  // LSR
+         r = v >> 1;
+         c = v & 1;
+         break;
+      case 0x5:  // ROL
+         r = (v << 1) | c;
+         c = v >> 7;
+         break;
+      case 0x6:  // ROR
+         r = (v >> 1) | (c << 7);
+         c = v & 1;
+         break;
+      case 0x7:  // ASR
+         r = (v >> 1) | (v & 0x80);
+         c = v & 1;
+         break;
+      case 0x8:  // ASL
+         r = v << 1;
+         c = v >> 7;
+         break;
+      default:   // CLR
+         s->ccr = (s->ccr & ~(CC_N|CC_V|CC_C)) | CC_Z;
+         return(0);
+   }
+   nz8(s, r);
+   s->ccr &= ~(CC_V|CC_C);
+   if(c) s->ccr |= CC_C;
+   if(!!(s->ccr & CC_N) != !!c) s->ccr |= CC_V;
+   return(r);
+}
+
+/*----------------------------------------------------
+Function: indexed
+Description: Decodes an indexed postbyte and its offset
+             and returns the effective address.  trail is
+             the number of instruction bytes after the
+             offset (PC relative addresses are from the
+             next instruction).
+------------------------------------------------------*/
+static word *indexReg(struct hcs12 *s, int rr)
+{
+   switch(rr)
+   {
+      case 0: return(&s->x);
+      case 1: return(&s->y);
+      case 2: return(&s->sp);
+      default: return(&s->pc);
+   }
+}
+
+static word effAddr(struct hcs12 *s, int *cls, int trail)
+{
+   byte xb = fetch8(s);
+   int rr;
+   word base, off;
+   word *r;
+   int n;
+
+   if((xb & 0xE0) == 0xE0)  // 111rrxxx
+   {
+      rr = (xb >> 3) & 3;
+      switch(xb & 7)
+      {
+         case 0:
+         case 1:  // 9-bit offset
+            off = fetch8(s);
+            if(xb & 1) off |= 0xFF00;
+            *cls = IDX1;
+            break;
+         case 2:  // 16-bit offset
+            off = fetch16(s);
+            *cls = IDX2;
+            break;
+         case 3:  // [n16,r]
+            off = fetch16(s);
+            base = (rr == 3) ? s->pc + trail : *indexReg(s, rr);
+            *cls = IND16;
+            return((word)(base + off));
+         case 4:  // A,r
+            off = s->a;
+            *cls = IDX;
+            break;
+         case 5:  // B,r
+            off = s->b;
+            *cls = IDX;
+            break;
+         case 6:  // D,r
+            off = D(s);
+            *cls = IDX;
+            break;
+         default:  // [D,r]
+            base = (rr == 3) ? s->pc + trail : *indexReg(s, rr);
+            *cls = INDD;
+            return((word)(base + D(s)));
+      }
+      base = (rr == 3) ? s->pc + trail : *indexReg(s, rr);
+      return((word)(base + off));
+   }
+   rr = (xb >> 6) & 3;
+   *cls = IDX;
+   if(!(xb & 0x20))  // 5-bit offset
+   {
+      off = xb & 0x1F;
+      if(off & 0x10) off |= 0xFFE0;
+      base = (rr == 3) ? s->pc + trail : *indexReg(s, rr);
+      return((word)(base + off));
+   }
+   // auto pre/post increment/decrement
+   r = indexReg(s, rr);
+   n = xb & 0x0F;
+   n = (n & 0x08) ? n - 16 : n + 1;
+   if(xb & 0x10)  // post
+   {
+      base = *r;
+      *r += n;
+      return(base);
+   }
+   *r += n;
+   return(*r);
+}
+
+// Effective address (for [D,r] and [n16,r] the pointer is followed)
+static word indexed(struct hcs12 *s, int *cls, int trail)
+{
+   word a = effAddr(s, cls, trail);
+   if(*cls >= INDD) return(rd16(a));
+   return(a);
+}
+
+/*----------------------------------------------------
+Function: condition
+Description: Branch condition (low nibble of Bcc).
+------------------------------------------------------*/
+static int condition(struct hcs12 *s, int cc)
+{
+   byte c = s->ccr;
+   int n = !!(c & CC_N), z = !!(c & CC_Z), v = !!(c & CC_V), k = !!(c & CC_C);
+   switch(cc & 0x0F)
+   {
+      case 0x0: return(1);             // BRA
+      case 0x1: return(0);             // BRN
+      case 0x2: return(!(k | z));      // BHI
+      case 0x3: return(k | z);         // BLS
+      case 0x4: return(!k);            // BCC
+      case 0x5: return(k);             // BCS
+      case 0x6: return(!z);            // BNE
+      case 0x7: return(z);             // BEQ
+      case 0x8: return(!v);            // BVC
+      case 0x9: return(v);             // BVS
+      case 0xA: return(!n);            // BPL
+      case 0xB: return(n);             // BMI
+      case 0xC: return(!(n ^ v));      // BGE
+      case 0xD: return(n ^ v);         // BLT
+      case 0xE: return(!(z | (n ^ v)));// BGT
+      default:  return(z | (n ^ v));   // BLE
+   }
+}
+
+/*----------------------------------------------------
+Function: getReg, setReg
+Description: Register numbers of TFR/EXG and the loop
+             primitives (A B CCR TMP3 D X Y SP).
+------------------------------------------------------*/
+static word getReg(struct hcs12 *s, int r)
+{
+   switch(r & 7)
+   {
+      case 0: return(s->a);
+      case 1: return(s->b);
+      case 2: return(s->ccr);
+      case 3: return(0);
+      case 4: return(D(s));
+      case 5: return(s->x);
+      case 6: return(s->y);
+      default: return(s->sp);
+   }
+}
+
+static void setCCR(struct hcs12 *s, byte v)
+{
+   if(!(s->ccr & CC_X)) v &= ~CC_X;  // X can only be cleared
+   s->ccr = v;
+}
+
+static void setReg(struct hcs12 *s, int r, word v)
+{
+   switch(r & 7)
+   {
+      case 0: s->a = (byte)v; break;
+      case 1: s->b = (byte)v; break;
+      case 2: setCCR(s, (byte)v); break;
+      case 3: break;
+      case 4: s->a = v >> 8; s->b = (byte)v; break;
+      case 5: s->x = v; break;
+      case 6: s->y = v; break;
+      default: s->sp = v; break;
+   }
+}
+
+static void tfrExg(struct hcs12 *s, byte pb)
+{
+   int r1 = (pb >> 4) & 7, r2 = pb & 7;
+   word v1 = getReg(s, r1), v2 = getReg(s, r2);
+
+   if(!(pb & 0x80))  // TFR (8 to 16 bit sign extends - SEX)
+   {
+      if(r1 < 4 && r2 >= 4 && (v1 & 0x80)) v1 |= 0xFF00;
+      setReg(s, r2, v1);
+   }
+   else  // EXG (8 and 16 bit: the 16-bit register gets $00:r8)
+   {
+      if(r1 < 4 && r2 >= 4) { setReg(s, r2, v1 & 0xFF); setReg(s, r1, v2); }
+      else if(r1 >= 4 && r2 < 4) { setReg(s, r1, v2 & 0xFF); setReg(s, r2, v1); }
+      else { setReg(s, r1, v2); setReg(s, r2, v1); }
+   }
+}
+
+/*----------------------------------------------------
+Function: interrupt
+Description: Stacks the registers, sets I and fetches
+             the vector (9 cycles).
+------------------------------------------------------*/
+static void stackAll(struct hcs12 *s)
+{
+   hcs12Push16(s, s->pc);
+   hcs12Push16(s, s->y);
+   hcs12Push16(s, s->x);
+   push8(s, s->a);
+   push8(s, s->b);
+   push8(s, s->ccr);
+}
+
+static word vectorAddr(struct hcs12 *s, word vec)
+{
+   if(s->dbug12) return(dbug12Vector(s, vec));
+   return(rd16(vec));
+}
+
+static void interrupt(struct hcs12 *s, word vec)
+{
+   word sp = s->sp;
+   stackAll(s);
+   s->ccr |= CC_I;
+   s->pc = vectorAddr(s, vec);
+   s->cycles += 9;
+   enter(s, sp, FR_IRQ);
+   s->frames[s->depth-1].start -= 9;
+   if(s->irqs) irqEnter(s, vec);
+}
+
+/*----------------------------------------------------
+Function: hcs12Return
+Description: Return from a routine run by the simulator
+             (monitor traps): RTC after a CALL, RTS
+             otherwise.
+------------------------------------------------------*/
+void hcs12Return(struct hcs12 *s)
+{
+   if(s->farCall) s->ppage = pull8(s);
+   s->pc = hcs12Pull16(s);
+   leave(s);
+}
+
+/*----------------------------------------------------
+Function: divide helpers
+------------------------------------------------------*/
+static void idiv(struct hcs12 *s, int fractional, int sign)
+{
+   word d = D(s), x = s->x;
+   unsigned long n = fractional ? (unsigned long)d << 16 : d;
+   word q, r;
+
+   s->ccr &= ~(CC_N|CC_Z|CC_V|CC_C);
+   if(x == 0)
+   {
+      s->ccr |= CC_C;
+      s->x = 0xFFFF;
+      return;
+   }
+   if(fractional)
+   {
+      if(x <= d) { s->ccr |= CC_V; s->x = 0xFFFF; return; }
+      q = (word)(n / x);
+      r = (word)(n % x);
+   }
+   else if(sign)
+   {
+      long sn = (short)d, sx = (short)x, sq;
+      sq = sn / sx;
+      if(sq > 32767 || sq < -32768) s->ccr |= CC_V;
+      q = (word)sq;
+      r = (word)(sn % sx);
+      if(q & 0x8000) s->ccr |= CC_N;
+   }
+   else
+   {
+      q = d / x;
+      r = d % x;
+   }
+   if(q == 0) s->ccr |= CC_Z;
+   s->x = q;
+   s->a = r >> 8;
+   s->b = (byte)r;
+}
+
+static void ediv(struct hcs12 *s, int sign)
+{
+   unsigned long n = (unsigned long)s->y << 16 | D(s);
+   word x = s->x;
+   unsigned long q;
+   long sq;
+   word r;
+
+   s->ccr &= ~(CC_N|CC_Z|CC_V|CC_C);
+   if(x == 0) { s->ccr |= CC_C; return; }
+   if(sign)
+   {
+      long sn = (long)(int)(unsigned)n;
+      sq = sn / (short)x;
+      r = (word)(sn % (short)x);
+      if(sq > 32767 || sq < -32768) { s->ccr |= CC_V; return; }
+      q = (word)sq;
+   }
+   else
+   {
+      q = n / x;
+      r = (word)(n % x);
+      if(q > 0xFFFF) { s->ccr |= CC_V; return; }
+   }
+   nz16(s, (word)q);
+   s->y = (word)q;
+   s->a = r >> 8;
+   s->b = (byte)r;
+}
+
+/*----------------------------------------------------
+Function: daa
+Description: Decimal adjust A after a BCD add.
+------------------------------------------------------*/
+static void daa(struct hcs12 *s)
+{
+   byte a = s->a, lo = a & 0x0F, hi = a >> 4;
+   byte corr = 0;
+   int c = s->ccr & CC_C;
+
+   if((s->ccr & CC_H) || lo > 9) corr |= 0x06;
+   if(c || hi > 9 || (hi >= 9 && lo > 9)) { corr |= 0x60; c = 1; }
+   s->a = a + corr;
+   nz8(s, s->a);
+   s->ccr &= ~CC_C;
+   if(c) s->ccr |= CC_C;
+}
+
+/*----------------------------------------------------
+Function: minMax
+Description: MAXA/MINA/EMAXD/EMIND (result in the
+             register) and MAXM/MINM/EMAXM/EMINM (result
+             in memory).  Flags are those of the compare.
+------------------------------------------------------*/
+static void minMax(struct hcs12 *s, byte op, word ea)
+{
+   int wide = op & 0x02;
+   int isMax = !(op & 0x01);
+   int toMem = op & 0x04;
+   word m = wide ? rd16(ea) : rd8(ea);
+   word r = wide ? D(s) : s->a;
+   int mBigger;
+
+   if(wide) sub16(s, r, m);
+   else sub8(s, (byte)r, (byte)m, 0);
+   mBigger = (s->ccr & CC_C) != 0;  // r < m (unsigned)
+   if(isMax ? mBigger : !mBigger && r != m)
+   {
+      if(toMem) return;  // memory already holds the result
+      if(wide) { s->a = m >> 8; s->b = (byte)m; } else s->a = (byte)m;
+   }
+   else if(toMem)
+   {
+      if(wide) wr16(ea, r); else wr8(ea, (byte)r);
+   }
+}
+
+/*----------------------------------------------------
+Function: page2
+Description: Instructions with the $18 prefix.  Returns
+             the cycles.
+------------------------------------------------------*/
+static int page2(struct hcs12 *s)
+{
+   byte op = fetch8(s);
+   int cls, cls2;
+   word ea, src, v;
+   byte b;
+   unsigned long prod;
+
+   switch(op)
+   {
+      case 0x00:  // MOVW #,idx
+         ea = indexed(s, &cls, 2);
+         v = fetch16(s);
+         wr16(ea, v);
+         return(4);
+      case 0x01:  // MOVW ext,idx
+         ea = indexed(s, &cls, 2);
+         v = rd16(fetch16(s));
+         wr16(ea, v);
+         return(5);
+      case 0x02:  // MOVW idx,idx
+         src = indexed(s, &cls, 1);
+         v = rd16(src);
+         ea = indexed(s, &cls2, 0);
+         wr16(ea, v);
+         return(5);
+      case 0x03:  // MOVW #,ext
+         v = fetch16(s);
+         ea = fetch16(s);
+         wr16(ea, v);
+         return(5);
+      case 0x04:  // MOVW ext,ext
+         src = fetch16(s);
+         ea = fetch16(s);
+         wr16(ea, rd16(src));
+         return(6);
+      case 0x05:  // MOVW idx,ext
+         src = indexed(s, &cls, 2);
+         v = rd16(src);
+         ea = fetch16(s);
+         wr16(ea, v);
+         return(5);
+      case 0x06:  // ABA
+         s->a = add8(s, s->a, s->b, 0);
+         return(2);
+      case 0x07:
+         daa(s);
+         return(3);
+      case 0x08:  // MOVB #,idx
+         ea = indexed(s, &cls, 1);
+         b = fetch8(s);
+         wr8(ea, b);
+         return(4);
+      case 0x09:  // MOVB ext,idx
+         ea = indexed(s, &cls, 2);
+         b = rd8(fetch16(s));
+         wr8(ea, b);
+         return(5);
+      case 0x0A:  // MOVB idx,idx
+         src = indexed(s, &cls, 1);
+         b = rd8(src);
+         ea = indexed(s, &cls2, 0);
+         wr8(ea, b);
+         return(5);
+      case 0x0B:  // MOVB #,ext
+         b = fetch8(s);
+         ea = fetch16(s);
+         wr8(ea, b);
+         return(4);
+      case 0x0C:  // MOVB ext,ext
+         src = fetch16(s);
+         ea = fetch16(s);
+         wr8(ea, rd8(src));
+         return(6);
+      case 0x0D:  // MOVB idx,ext
+         src = indexed(s, &cls, 2);
+         b = rd8(src);
+         ea = fetch16(s);
+         wr8(ea, b);
+         return(5);
+      case 0x0E:  // TAB
+         s->b = logic8(s, s->a);
+         return(2);
+      case 0x0F:  // TBA
+         s->a = logic8(s, s->b);
+         return(2);
+      case 0x10:
+         idiv(s, 0, 0);
+         return(12);
+      case 0x11:  // FDIV
+         idiv(s, 1, 0);
+         return(12);
+      case 0x12:  // EMACS (X)*(Y) + (ea) -> (ea)
+      {
+         long m;
+         ea = fetch16(s);
+         m = (long)(short)rd16(s->x) * (short)rd16(s->y);
+         m += (long)(int)((unsigned)rd16(ea) << 16 | rd16(ea + 2));
+         wr16(ea, (word)((unsigned long)m >> 16));
+         wr16(ea + 2, (word)m);
+         nz16(s, (word)((unsigned long)m >> 16));
+         return(13);
+      }
+      case 0x13:  // EMULS
+         prod = (unsigned long)((long)(short)D(s) * (short)s->y);
+         s->y = (word)(prod >> 16);
+         s->a = (byte)(prod >> 8);
+         s->b = (byte)prod;
+         s->ccr &= ~(CC_N|CC_Z|CC_C);
+         if(prod & 0x80000000UL) s->ccr |= CC_N;
+         if((prod & 0xFFFFFFFFUL) == 0) s->ccr |= CC_Z;
+         if(prod & 0x8000) s->ccr |= CC_C;
+         return(3);
+      case 0x14:
+         ediv(s, 1);
+         return(12);
+      case 0x15:  // IDIVS
+         idiv(s, 0, 1);
+         return(12);
+      case 0x16:  // SBA
+         s->a = sub8(s, s->a, s->b, 0);
+         return(2);
+      case 0x17:  // CBA
+         sub8(s, s->a, s->b, 0);
+         return(2);
+      case 0x18: case 0x19: case 0x1A: case 0x1B:  // MAXA MINA EMAXD EMIND
+         ea = indexed(s, &cls, 0);
+         minMax(s, op & 0x03, ea);
+         return(cycMax[cls]);
+      case 0x1C: case 0x1D: case 0x1E: case 0x1F:  // MAXM MINM EMAXM EMINM
+         ea = indexed(s, &cls, 0);
+         minMax(s, (op & 0x03) | 0x04, ea);
+         return(cycMaxm[cls]);
+      case 0x3A: case 0x3B: case 0x3C:  // REV REVW WAV (fuzzy logic) not simulated
+         fprintf(stderr, "hcs12sim: fuzzy logic instruction at %04X\n", s->lastPC);
+         s->state = ST_HALT;
+         return(1);
+      case 0x3D:  // TBL
+         ea = indexed(s, &cls, 0);
+         {
+            byte y1 = rd8(ea), y2 = rd8(ea + 1);
+            int r = y1 + (((int)y2 - y1) * s->b) / 256;
+            s->a = (byte)r;
+            nz8(s, s->a);
+         }
+         return(8);
+      case 0x3E:  // STOP (stop disabled by S) treated as the end of the program
+         s->state = ST_HALT;
+         return(2);
+      case 0x3F:  // ETBL
+         ea = indexed(s, &cls, 0);
+         {
+            word y1 = rd16(ea), y2 = rd16(ea + 2);
+            long r = y1 + (((long)y2 - y1) * s->b) / 256;
+            s->a = (byte)(r >> 8);
+            s->b = (byte)r;
+            nz16(s, (word)r);
+         }
+         return(10);
+      default:
+         if(op >= 0x20 && op <= 0x2F)  // long branches
+         {
+            v = fetch16(s);
+            if(condition(s, op))
+            {
+               s->pc += v;
+               return(4);
+            }
+            return(3);
+         }
+         // TRAP and unimplemented opcodes
+         if(s->dbug12 && dbug12Trap(s)) return(0);
+         s->pc = s->lastPC + 2;
+         {
+            word sp = s->sp;
+            stackAll(s);
+            s->ccr |= CC_I;
+            s->pc = vectorAddr(s, VEC_TRAP);
+            enter(s, sp, FR_IRQ);
+         }
+         return(10);
+   }
+}
+
+/*----------------------------------------------------
+Function: operand helpers for the $80-$FF columns
+Description: mode 0 IMM, 1 DIR, 2 IDX, 3 EXT.
+------------------------------------------------------*/
+static word eaOf(struct hcs12 *s, int mode, int *cyc, const byte *tab, int dirCyc, int extCyc)
+{
+   int cls;
+   word ea;
+   switch(mode)
+   {
+      case 1:
+         *cyc = dirCyc;
+         return(fetch8(s));
+      case 2:
+         ea = indexed(s, &cls, 0);
+         *cyc = tab[cls];
+         return(ea);
+      default:
+         *cyc = extCyc;
+         ea = fetch16(s);
+         if(s->direct && dirCyc) directAccess(s, ea, extCyc - dirCyc);
+         return(ea);
+   }
+}
+
+/*----------------------------------------------------
+Function: hcs12Step
+Description: Executes one instruction.
+------------------------------------------------------*/
+void hcs12Step(struct hcs12 *s)
+{
+   byte op, pb, m, v8;
+   word ea, v16, sp;
+   int cyc = 1, cls, mode, lo;
+   unsigned long prod;
+
+   s->lastPC = s->pc;
+   op = fetch8(s);
+   s->insts++;
+
+   if(op >= 0x80)  // ALU and loads: A/D (8x-Bx), B/D/X/Y/SP (Cx-Fx)
+   {
+      mode = (op >> 4) & 3;
+      lo = op & 0x0F;
+      if(lo == 0x07)  // column 7: CLRA TSTA NOP TFR CLRB TSTB TST TST
+      {
+         switch(op)
+         {
+            case 0x87: s->a = rmw(s, 0x9, s->a); break;
+            case 0xC7: s->b = rmw(s, 0x9, s->b); break;
+            case 0x97: logic8(s, s->a); s->ccr &= ~CC_C; break;
+            case 0xD7: logic8(s, s->b); s->ccr &= ~CC_C; break;
+            case 0xA7: break;  // NOP
+            case 0xB7: tfrExg(s, fetch8(s)); break;
+            case 0xE7:
+            case 0xF7:  // TST: no direct form
+               ea = eaOf(s, mode, &cyc, cycLoad, 0, 3);
+               logic8(s, rd8(ea));
+               s->ccr &= ~CC_C;
+               break;
+         }
+         s->cycles += cyc;
+         return;
+      }
+      if(lo == 0x03 || lo >= 0x0C)  // 16-bit operand
+      {
+         if(mode == 0) { v16 = fetch16(s); cyc = 2; }
+         else v16 = rd16(eaOf(s, mode, &cyc, cycLoad, 3, 3));
+         if(op < 0xC0)
+         {
+            switch(lo)
+            {
+               case 0x3: v16 = sub16(s, D(s), v16); s->a = v16 >> 8; s->b = (byte)v16; break; // SUBD
+               case 0xC: sub16(s, D(s), v16); break;   // CPD
+               case 0xD: sub16(s, s->y, v16); break;   // CPY
+               case 0xE: sub16(s, s->x, v16); break;   // CPX
+               case 0xF: sub16(s, s->sp, v16); break;  // CPS
+            }
+         }
+         else
+         {
+            switch(lo)
+            {
+               case 0x3: v16 = add16(s, D(s), v16); s->a = v16 >> 8; s->b = (byte)v16; break; // ADDD
+               case 0xC: logic16(s, v16); s->a = v16 >> 8; s->b = (byte)v16; break; // LDD
+               case 0xD: s->y = logic16(s, v16); break;
+               case 0xE: s->x = logic16(s, v16); break;
+               case 0xF: s->sp = logic16(s, v16); break;
+            }
+         }
+         s->cycles += cyc;
+         return;
+      }
+      // 8-bit operand
+      if(mode == 0) { v8 = fetch8(s); cyc = 1; }
+      else v8 = rd8(eaOf(s, mode, &cyc, cycLoad, 3, 3));
+      {
+         byte *r = (op < 0xC0) ? &s->a : &s->b;
+         switch(lo)
+         {
+            case 0x0: *r = sub8(s, *r, v8, 0); break;                   // SUB
+            case 0x1: sub8(s, *r, v8, 0); break;                        // CMP
+            case 0x2: *r = sub8(s, *r, v8, s->ccr & CC_C); break;       // SBC
+            case 0x4: *r = logic8(s, *r & v8); break;                   // AND
+            case 0x5: logic8(s, *r & v8); break;                        // BIT
+            case 0x6: *r = logic8(s, v8); break;                        // LDA
+            case 0x8: *r = logic8(s, *r ^ v8); break;                   // EOR
+            case 0x9: *r = add8(s, *r, v8, s->ccr & CC_C); break;       // ADC
+            case 0xA: *r = logic8(s, *r | v8); break;                   // ORA
+            case 0xB: *r = add8(s, *r, v8, 0); break;                   // ADD
+         }
+      }
+      s->cycles += cyc;
+      return;
+   }
+
+   if(op >= 0x5A && op <= 0x7F && (op & 0x0F) >= 0x0A)  // stores
+   {
+      mode = (op >> 4) == 5 ? 1 : (op >> 4) == 6 ? 2 : 3;
+      ea = eaOf(s, mode, &cyc, cycStore, 2, 3);
+      switch(op & 0x0F)
+      {
+         case 0xA: wr8(ea, logic8(s, s->a)); break;
+         case 0xB: wr8(ea, logic8(s, s->b)); break;
+         case 0xC: wr16(ea, logic16(s, D(s))); break;
+         case 0xD: wr16(ea, logic16(s, s->y)); break;
+         case 0xE: wr16(ea, logic16(s, s->x)); break;
+         case 0xF: wr16(ea, logic16(s, s->sp)); break;
+      }
+      s->cycles += cyc;
+      return;
+   }
+
+   if(op >= 0x60 && op <= 0x79)  // memory read-modify-write and CLR
+   {
+      lo = op & 0x0F;
+      if(op < 0x70) { ea = indexed(s, &cls, 0); cyc = (lo == 9) ? cycStore[cls] : cycRmw[cls]; }
+      else { ea = fetch16(s); cyc = (lo == 9) ? 3 : 4; }
+      if(lo == 9) { rmw(s, 9, 0); wr8(ea, 0); }
+      else wr8(ea, rmw(s, lo, rd8(ea)));
+      s->cycles += cyc;
+      return;
+   }
+
+   if(op >= 0x40 && op <= 0x58 && op != 0x49 && op != 0x4A && op != 0x4B  // inherent A/B
+      && (op & 0x0F) <= 0x08)
+   {
+      if(op < 0x50) s->a = rmw(s, op & 0x0F, s->a);
+      else s->b = rmw(s, op & 0x0F, s->b);
+      s->cycles += 1;
+      return;
+   }
+
+   if(op >= 0x20 && op <= 0x2F)  // short branches
+   {
+      v16 = fetch8(s);
+      if(v16 & 0x80) v16 |= 0xFF00;
+      if(condition(s, op))
+      {
+         s->pc += v16;
+         cyc = 3;
+      }
+      s->cycles += cyc;
+      return;
+   }
+
+   switch(op)
+   {
+      case 0x00:  // BGND - end of the program
+         s->state = ST_HALT;
+         cyc = 5;
+         break;
+      case 0x02: s->y++; s->ccr = (s->ccr & ~CC_Z) | (s->y ? 0 : CC_Z); break;  // INY
+      case 0x03: s->y--; s->ccr = (s->ccr & ~CC_Z) | (s->y ? 0 : CC_Z); break;  // DEY
+      case 0x08: s->x++; s->ccr = (s->ccr & ~CC_Z) | (s->x ? 0 : CC_Z); break;  // INX
+      case 0x09: s->x--; s->ccr = (s->ccr & ~CC_Z) | (s->x ? 0 : CC_Z); break;  // DEX
+      case 0x04:  // DBEQ DBNE TBEQ TBNE IBEQ IBNE
+      {
+         int kind, r, taken;
+         word val;
+         pb = fetch8(s);
+         v16 = fetch8(s);
+         if(pb & 0x10) v16 |= 0xFF00;
+         kind = (pb >> 5) & 7;
+         r = pb & 7;
+         val = getReg(s, r);
+         if(kind <= 1) val--;
+         else if(kind >= 4) val++;
+         if(r < 4) val &= 0xFF;
+         if(kind <= 1 || kind >= 4) setReg(s, r, val);
+         taken = (val == 0);
+         if(kind & 1) taken = !taken;
+         if(taken) s->pc += v16;
+         cyc = 3;
+         break;
+      }
+      case 0x05:  // JMP idx
+         ea = indexed(s, &cls, 0);
+         s->pc = ea;
+         cyc = cycJmp[cls];
+         break;
+      case 0x06:  // JMP ext
+         s->pc = fetch16(s);
+         cyc = 3;
+         break;
+      case 0x07:  // BSR
+         v16 = fetch8(s);
+         if(v16 & 0x80) v16 |= 0xFF00;
+         sp = s->sp;
+         hcs12Push16(s, s->pc);
+         s->pc += v16;
+         s->cycles += 4;
+         s->farCall = 0;
+         enter(s, sp, FR_CALL);
+         return;
+      case 0x15:  // JSR idx
+      case 0x16:  // JSR ext
+      case 0x17:  // JSR dir
+         if(op == 0x15) { ea = indexed(s, &cls, 0); cyc = cycJsr[cls]; }
+         else if(op == 0x16) { ea = fetch16(s); cyc = 4; }
+         else { ea = fetch8(s); cyc = 4; }
+         sp = s->sp;
+         hcs12Push16(s, s->pc);
+         s->pc = ea;
+         s->cycles += cyc;
+         s->farCall = 0;
+         enter(s, sp, FR_CALL);
+         return;
+      case 0x4A:  // CALL ext,page
+      case 0x4B:  // CALL idx,page or [idx]
+         sp = s->sp;
+         if(op == 0x4A) { ea = fetch16(s); pb = fetch8(s); cyc = 7; }
+         else
+         {
+            byte xb = rd8(s->pc);
+            int indirect = (xb & 0xE7) == 0xE3 || (xb & 0xE7) == 0xE7;
+            ea = effAddr(s, &cls, indirect ? 0 : 1);
+            if(indirect)  // the pointer holds the routine and its page
+            {
+               pb = rd8(ea + 2);
+               ea = rd16(ea);
+            }
+            else pb = fetch8(s);
+            cyc = cycCall[cls];
+         }
+         hcs12Push16(s, s->pc);
+         push8(s, s->ppage);
+         s->ppage = pb;
+         s->pc = ea;
+         s->cycles += cyc;
+         s->farCall = 1;
+         enter(s, sp, FR_CALL);
+         return;
+      case 0x0A:  // RTC
+         s->ppage = pull8(s);
+         s->pc = hcs12Pull16(s);
+         s->cycles += 6;
+         leave(s);
+         return;
+      case 0x3D:  // RTS
+         s->pc = hcs12Pull16(s);
+         s->cycles += 5;
+         leave(s);
+         return;
+      case 0x0B:  // RTI
+         setCCR(s, pull8(s));
+         s->b = pull8(s);
+         s->a = pull8(s);
+         s->x = hcs12Pull16(s);
+         s->y = hcs12Pull16(s);
+         s->pc = hcs12Pull16(s);
+         s->cycles += 8;
+         leave(s);
+         if(s->irq && !(s->ccr & CC_I))
+         {
+            // another interrupt pending: the frame is reused (RTI takes 10)
+            word vec = periphVector(s);
+            if(vec)
+            {
+               sp = s->sp;
+               s->sp -= 9;
+               s->ccr |= CC_I;
+               s->pc = vectorAddr(s, vec);
+               s->cycles += 2;
+               enter(s, sp, FR_IRQ);
+               s->frames[s->depth-1].start -= 2;
+               if(s->irqs) irqEnter(s, vec);
+            }
+         }
+         return;
+      case 0x0C:  // BSET idx
+      case 0x0D:  // BCLR idx
+         ea = indexed(s, &cls, 1);
+         m = fetch8(s);
+         v8 = rd8(ea);
+         v8 = (op == 0x0C) ? (v8 | m) : (v8 & ~m);
+         logic8(s, v8);
+         wr8(ea, v8);
+         cyc = cycBset[cls];
+         break;
+      case 0x1C:  // BSET ext
+      case 0x1D:  // BCLR ext
+      case 0x4C:  // BSET dir
+      case 0x4D:  // BCLR dir
+         ea = (op & 0x40) ? fetch8(s) : fetch16(s);
+         if(s->direct && !(op & 0x40)) directAccess(s, ea, 0);
+         m = fetch8(s);
+         v8 = rd8(ea);
+         v8 = (op & 1) ? (v8 & ~m) : (v8 | m);
+         logic8(s, v8);
+         wr8(ea, v8);
+         cyc = 4;
+         break;
+      case 0x0E:  // BRSET idx
+      case 0x0F:  // BRCLR idx
+      case 0x1E:  // BRSET ext
+      case 0x1F:  // BRCLR ext
+      case 0x4E:  // BRSET dir
+      case 0x4F:  // BRCLR dir
+      {
+         int set = !(op & 1);
+         if(op < 0x10) { ea = indexed(s, &cls, 2); cyc = cycBrset[cls]; }
+         else if(op < 0x40)
+         {
+            ea = fetch16(s);
+            cyc = 5;
+            if(s->direct) directAccess(s, ea, 1);
+         }
+         else { ea = fetch8(s); cyc = 4; }
+         m = fetch8(s);
+         v16 = fetch8(s);
+         if(v16 & 0x80) v16 |= 0xFF00;
+         v8 = rd8(ea);
+         if(set ? ((v8 & m) == m) : ((v8 & m) == 0)) s->pc += v16;
+         break;
+      }
+      case 0x10:  // ANDCC
+         setCCR(s, s->ccr & fetch8(s));
+         break;
+      case 0x14:  // ORCC
+         s->ccr |= fetch8(s);
+         break;
+      case 0x11:  // EDIV
+         ediv(s, 0);
+         cyc = 11;
+         break;
+      case 0x12:  // MUL
+         v16 = s->a * s->b;
+         s->a = v16 >> 8;
+         s->b = (byte)v16;
+         s->ccr = (s->ccr & ~CC_C) | ((v16 & 0x80) ? CC_C : 0);
+         cyc = 3;
+         break;
+      case 0x13:  // EMUL
+         prod = (unsigned long)D(s) * s->y;
+         s->y = (word)(prod >> 16);
+         s->a = (byte)(prod >> 8);
+         s->b = (byte)prod;
+         s->ccr &= ~(CC_N|CC_Z|CC_C);
+         if(prod & 0x80000000UL) s->ccr |= CC_N;
+         if((prod & 0xFFFFFFFFUL) == 0) s->ccr |= CC_Z;
+         if(prod & 0x8000) s->ccr |= CC_C;
+         cyc = 3;
+         break;
+      case 0x18:
+         cyc = page2(s);
+         break;
+      case 0x19:  // LEAY
+      case 0x1A:  // LEAX
+      case 0x1B:  // LEAS
+         ea = indexed(s, &cls, 0);
+         if(op == 0x19) s->y = ea;
+         else if(op == 0x1A) s->x = ea;
+         else s->sp = ea;
+         cyc = 2;
+         break;
+      case 0x30: s->x = hcs12Pull16(s); cyc = 3; break;                  // PULX
+      case 0x31: s->y = hcs12Pull16(s); cyc = 3; break;                  // PULY
+      case 0x32: s->a = pull8(s); cyc = 3; break;                        // PULA
+      case 0x33: s->b = pull8(s); cyc = 3; break;                        // PULB
+      case 0x34: hcs12Push16(s, s->x); cyc = 2; break;                   // PSHX
+      case 0x35: hcs12Push16(s, s->y); cyc = 2; break;                   // PSHY
+      case 0x36: push8(s, s->a); cyc = 2; break;                         // PSHA
+      case 0x37: push8(s, s->b); cyc = 2; break;                         // PSHB
+      case 0x38: setCCR(s, pull8(s)); cyc = 3; break;                    // PULC
+      case 0x39: push8(s, s->ccr); cyc = 2; break;                       // PSHC
+      case 0x3A: v16 = hcs12Pull16(s); s->a = v16 >> 8; s->b = (byte)v16; cyc = 3; break; // PULD
+      case 0x3B: hcs12Push16(s, D(s)); cyc = 2; break;                   // PSHD
+      case 0x3E:  // WAI
+         stackAll(s);
+         s->state = ST_WAIT;
+         cyc = 8;
+         break;
+      case 0x3F:  // SWI
+         if(s->dbug12)  // back to the monitor
+         {
+            s->state = ST_HALT;
+            cyc = 9;
+            break;
+         }
+         sp = s->sp;
+         stackAll(s);
+         s->ccr |= CC_I;
+         s->pc = vectorAddr(s, VEC_SWI);
+         s->cycles += 9;
+         enter(s, sp, FR_IRQ);
+         s->frames[s->depth-1].start -= 9;
+         return;
+      case 0x49:  // LSRD
+         v16 = D(s);
+         s->ccr &= ~(CC_N|CC_Z|CC_V|CC_C);
+         if(v16 & 1) s->ccr |= CC_C | CC_V;
+         v16 >>= 1;
+         if(!v16) s->ccr |= CC_Z;
+         s->a = v16 >> 8;
+         s->b = (byte)v16;
+         break;
+      case 0x59:  // ASLD
+         v16 = D(s);
+         s->ccr &= ~(CC_V|CC_C);
+         if(v16 & 0x8000) s->ccr |= CC_C;
+         v16 <<= 1;
+         nz16(s, v16);
+         if(!!(s->ccr & CC_N) != !!(s->ccr & CC_C)) s->ccr |= CC_V;
+         s->a = v16 >> 8;
+         s->b = (byte)v16;
+         break;
+      default:  // $01 MEM and anything not decoded
+         fprintf(stderr, "hcs12sim: opcode %02X not simulated at %04X\n", op, s->lastPC);
+         s->state = ST_HALT;
+         break;
+   }
+   s->cycles += cyc;
+}
+
+/*----------------------------------------------------
+Function: hcs12Run
+Description: Runs until the cycle count reaches end or
+             the CPU halts.  Peripheral events and
+             interrupts are handled between instructions,
+             idle loops are skipped after a backward jump.
+------------------------------------------------------*/
+void hcs12Run(struct hcs12 *s, unsigned long long end)
+{
+   word vec;
+
+   while(s->cycles < end && s->state <= ST_WAIT)
+   {
+      unsigned long long c0 = s->cycles;
+      if(s->cycles >= s->nextEvent) periphEvents(s);
+      if(s->irq && !(s->ccr & CC_I) && (vec = periphVector(s)) != 0)
+      {
+         if(s->state == ST_WAIT)  // registers already stacked by WAI
+         {
+            word sp = s->sp + 9;
+            s->state = ST_RUN;
+            s->ccr |= CC_I;
+            s->pc = vectorAddr(s, vec);
+            s->cycles += 5;
+            enter(s, sp, FR_IRQ);
+            s->frames[s->depth-1].start -= 5;
+            if(s->irqs) irqEnter(s, vec);
+         }
+         else interrupt(s, vec);
+      }
+      if(s->state == ST_WAIT)
+      {
+         // nothing to do until the next peripheral event
+         s->cycles = s->nextEvent < end ? s->nextEvent : end;
+         continue;
+      }
+      if(s->irqs) irqTrace(s);
+      if(s->pcCycles)  // interrupt entry goes to the first instruction of the ISR
+      {
+         unsigned long at = hcs12Linear(s, s->pc);
+         hcs12Step(s);
+         s->pcCycles[at] += s->cycles - c0;
+         if(s->loop.n < LOOP_INSTS)
+         {
+            s->loop.at[s->loop.n] = at;
+            s->loop.cyc[s->loop.n] = (unsigned)(s->cycles - c0);
+         }
+         s->loop.n++;
+      }
+      else hcs12Step(s);
+      if(s->pc < s->lastPC && s->skipIdle && s->lastPC - s->pc <= LOOP_BODY) idleLoop(s, end);
+   }
+}
@@ -0,0 +1,355 @@
+/*------------------------------------------------
+ * File: dbug12.c
+ * Description: DBug12 monitor routines used by the Lab 1
+ *              and Lab 2 programs (printf, getchar,
+ *              putchar, writeEEByte ...).
+ *
+ *              The user callable table at $EE80 points to
+ *              stubs at $EF00 made of a TRAP instruction;
+ *              the TRAP is recognized by address and the
+ *              routine is done by the simulator, which then
+ *              returns (RTS, or RTC after a CALL).
+ *
+ *              Cost of a routine: the characters sent wait
+ *              for the transmitter (10 bits at the SCI0 baud
+ *              rate, 160 x SBR bus cycles each), getchar
+ *              waits for the next input character, and a
+ *              fixed overhead per call and per formatted
+ *              character is charged for the monitor code.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "hcs12.h"
+
+#define TABLE    0xEE80
+#define STUBS    0xEF00
+#define RAMVECS  0x3E00   // user vector table in RAM ($FF80-$FFFF)
+#define R_SC0BDH 0x0C8
+#define R_SC0BDL 0x0C9
+
+// Overheads (bus cycles) of the monitor code
+#define CALL_CYCLES 40
+#define FMT_CYCLES  30    // per character of a printf format
+#define EE_PROG_US  46
+#define EE_ERASE_US 20000
+
+enum { F_MAIN, F_GETCHAR, F_PUTCHAR, F_PRINTF, F_GETCMDLINE, F_SSCANHEX,
+       F_ISXDIGIT, F_TOUPPER, F_ISALPHA, F_STRLEN, F_STRCPY, F_OUT2HEX,
+       F_OUT4HEX, F_SETUSERVECTOR, F_WRITEEEBYTE, F_ERASEEE, F_READMEM,
+       F_WRITEMEM };
+
+static const struct
+{
+   word addr;
+   byte far;     // entry of a far routine (called with CALL, page in the table)
+   const char *name;
+} routines[] =
+{
+   { 0xEE80, 1, "main" },
+   { 0xEE84, 0, "getchar" },
+   { 0xEE86, 0, "putchar" },
+   { 0xEE88, 0, "printf" },
+   { 0xEE8A, 1, "GetCmdLine" },
+   { 0xEE8E, 1, "sscanhex" },
+   { 0xEE92, 0, "isxdigit" },
+   { 0xEE94, 0, "toupper" },
+   { 0xEE96, 0, "isalpha" },
+   { 0xEE98, 0, "strlen" },
+   { 0xEE9A, 0, "strcpy" },
+   { 0xEE9C, 1, "out2hex" },
+   { 0xEEA0, 1, "out4hex" },
+   { 0xEEA4, 0, "SetUserVector" },
+   { 0xEEA6, 1, "WriteEEByte" },
+   { 0xEEAA, 1, "EraseEE" },
+   { 0xEEAE, 1, "ReadMem" },
+   { 0xEEB2, 1, "WriteMem" },
+};
+#define NUMROUTINES (int)(sizeof(routines) / sizeof(routines[0]))
+
+/*----------------------------------------------------
+Function: dbug12Install
+Description: Writes the table and the TRAP stubs into
+             the image.
+------------------------------------------------------*/
+void dbug12Install(struct image *img)
+{
+   byte *page = img->flash[0x0F];
+   int i;
+
+   for(i = 0; i < NUMROUTINES; i++)
+   {
+      word stub = STUBS + 2*i;
+      word t = routines[i].addr - WIN_END;
+      page[t] = stub >> 8;
+      page[t + 1] = (byte)stub;
+      if(routines[i].far) page[t + 2] = 0x3F;
+      page[stub - WIN_END] = 0x18;      // TRAP $FF
+      page[stub - WIN_END + 1] = 0xFF;
+   }
+}
+
+/*----------------------------------------------------
+Function: dbug12Symbols
+Description: Names of the stubs for the profile, so the
+             time spent in the monitor (waiting for the
+             terminal) shows as its routines.
+------------------------------------------------------*/
+void dbug12Symbols(struct profile *p)
+{
+   char name[32];
+   int i;
+
+   for(i = 0; i < NUMROUTINES; i++)
+   {
+      snprintf(name, sizeof(name), "DBug12.%s", routines[i].name);
+      profileAddSymbol(p, name, STUBS + 2*i, 0);
+   }
+}
+
+/*----------------------------------------------------
+Function: dbug12Input
+Description: Characters typed at the terminal, one every
+             gapMs milli-sec once the previous one is read.
+------------------------------------------------------*/
+void dbug12Input(struct hcs12 *s, const char *in, double gapMs)
+{
+   s->in = in;
+   s->inGap = (unsigned long long)(gapMs * 1000.0 * s->busMHz);
+   s->inDue = s->cycles + s->inGap;
+}
+
+/*----------------------------------------------------
+Function: dbug12Vector
+Description: Interrupt vectors under DBug12 are taken
+             from the user vector table in RAM.
+------------------------------------------------------*/
+word dbug12Vector(struct hcs12 *s, word vec)
+{
+   return(hcs12Read16(s, RAMVECS + (vec - 0xFF80)));
+}
+
+// Sends one character (waits for the transmitter)
+static void sendChar(struct hcs12 *s, char c)
+{
+   unsigned sbr = (s->regs[R_SC0BDH] & 0x1F) << 8 | s->regs[R_SC0BDL];
+
+   if(s->txHeld >= 0)  // a byte written by the program still waits
+   {
+      if(s->cycles < s->txFree) s->cycles = s->txFree;
+      sciSync(s);
+   }
+   if(s->cycles < s->txFree) s->cycles = s->txFree;
+   s->txFree = s->cycles + 160ULL * (sbr ? sbr : 1);
+   putchar(c);
+}
+
+static void sendString(struct hcs12 *s, const char *str)
+{
+   while(*str) sendChar(s, *str++);
+}
+
+static void setD(struct hcs12 *s, word v)
+{
+   s->a = v >> 8;
+   s->b = (byte)v;
+}
+
+/*----------------------------------------------------
+Function: doPrintf
+Description: printf with the format in D and the
+             arguments on the stack (int: 2 bytes, long: 4
+             bytes).  Returns the number of characters.
+------------------------------------------------------*/
+static int doPrintf(struct hcs12 *s, word args)
+{
+   word fmt = (word)(s->a << 8 | s->b);
+   char spec[16], out[64], str[256];
+   int n = 0, k;
+   char c;
+
+   while((c = (char)hcs12Read8(s, fmt++)) != '\0')
+   {
+      s->cycles += FMT_CYCLES;
+      if(c != '%')
+      {
+         sendChar(s, c);
+         n++;
+         continue;
+      }
+      // %[flags][width][.prec][l|h]conv
+      k = 0;
+      spec[k++] = '%';
+      while((c = (char)hcs12Read8(s, fmt++)) != '\0' && k < 12 && strchr("-+ #0123456789.", c))
+         spec[k++] = c;
+      if(c == 'l' || c == 'h')
+      {
+         int isLong = (c == 'l');
+         c = (char)hcs12Read8(s, fmt++);
+         if(isLong)
+         {
+            unsigned long v = (unsigned long)hcs12Read16(s, args) << 16 | hcs12Read16(s, args + 2);
+            args += 4;
+            spec[k++] = 'l';
+            spec[k++] = c;
+            spec[k] = '\0';
+            if(c == 'd' || c == 'i') snprintf(out, sizeof(out), spec, (long)(int)(unsigned)v);
+            else snprintf(out, sizeof(out), spec, v);
+            sendString(s, out);
+            n += strlen(out);
+            continue;
+         }
+      }
+      spec[k++] = c;
+      spec[k] = '\0';
+      switch(c)
+      {
+         case 'd': case 'i':
+            snprintf(out, sizeof(out), spec, (short)hcs12Read16(s, args));
+            args += 2;
+            break;
+         case 'u': case 'x': case 'X': case 'o':
+            snprintf(out, sizeof(out), spec, hcs12Read16(s, args));
+            args += 2;
+            break;
+         case 'c':
+            snprintf(out, sizeof(out), spec, hcs12Read8(s, args + 1));
+            args += 2;
+            break;
+         case 's':
+         {
+            word p = hcs12Read16(s, args);
+            int i;
+            args += 2;
+            for(i = 0; i < (int)sizeof(str) - 1 && (str[i] = (char)hcs12Read8(s, p + i)) != '\0'; i++) ;
+            str[i] = '\0';
+            snprintf(out, sizeof(out), spec, str);
+            break;
+         }
+         case '%':
+            strcpy(out, "%");
+            break;
+         default:
+            if(c == '\0') fmt--;
+            out[0] = '\0';
+            break;
+      }
+      sendString(s, out);
+      n += strlen(out);
+   }
+   return(n);
+}
+
+/*----------------------------------------------------
+Function: writeEE
+Description: WriteEEByte: programs one byte of EEPROM
+             (sector modify when bits go from 0 to 1).
+             Returns non-zero when the byte was written.
+------------------------------------------------------*/
+static int writeEE(struct hcs12 *s, word addr, byte v)
+{
+   byte *p;
+
+   if(addr < EE_START || addr >= RAM_START) return(0);
+   p = &s->eeprom[addr - EE_START];
+   if((*p & v) != v)
+   {
+      s->cycles += (unsigned long long)(EE_ERASE_US * s->busMHz);
+      s->ee.erases[(addr - EE_START) / EE_SECTOR]++;
+   }
+   s->cycles += (unsigned long long)(EE_PROG_US * s->busMHz);
+   *p = v;
+   if(s->snap) snapMark(s, addr);
+   return(1);
+}
+
+/*----------------------------------------------------
+Function: dbug12Trap
+Description: Called for a TRAP; returns 0 if it is not
+             one of the monitor stubs.
+------------------------------------------------------*/
+int dbug12Trap(struct hcs12 *s)
+{
+   int i;
+   word args;   // first stacked argument
+   word d = (word)(s->a << 8 | s->b);
+   char buf[8];
+
+   if(s->lastPC < STUBS || s->lastPC >= STUBS + 2*NUMROUTINES || (s->lastPC & 1)) return(0);
+   i = (s->lastPC - STUBS) / 2;
+   args = s->sp + (s->farCall ? 3 : 2);
+   s->cycles += CALL_CYCLES;
+
+   switch(i)
+   {
+      case F_GETCHAR:
+         if(s->in == NULL || *s->in == '\0')
+         {
+            s->state = ST_DONE;  // end of the input
+            s->pc = s->lastPC;
+            return(1);
+         }
+         if(s->cycles < s->inDue) s->cycles = s->inDue;
+         setD(s, (byte)*s->in++);
+         s->inDue = s->cycles + s->inGap;
+         break;
+      case F_PUTCHAR:
+         sendChar(s, (char)s->b);
+         break;
+      case F_PRINTF:
+         setD(s, (word)doPrintf(s, args));
+         break;
+      case F_ISXDIGIT:
+         setD(s, isxdigit(s->b) != 0);
+         break;
+      case F_TOUPPER:
+         setD(s, (word)toupper(s->b));
+         break;
+      case F_ISALPHA:
+         setD(s, isalpha(s->b) != 0);
+         break;
+      case F_STRLEN:
+      {
+         word n = 0;
+         while(hcs12Read8(s, d + n) != 0) n++;
+         s->cycles += 6 * n;
+         setD(s, n);
+         break;
+      }
+      case F_STRCPY:  // strcpy(dest in D, src on the stack)
+      {
+         word src = hcs12Read16(s, args), n = 0;
+         byte c;
+         do
+         {
+            c = hcs12Read8(s, src + n);
+            hcs12Write8(s, d + n, c);
+            n++;
+         } while(c != 0);
+         s->cycles += 8 * n;
+         break;
+      }
+      case F_OUT2HEX:
+         snprintf(buf, sizeof(buf), "%02X", s->b);
+         sendString(s, buf);
+         break;
+      case F_OUT4HEX:
+         snprintf(buf, sizeof(buf), "%04X", d);
+         sendString(s, buf);
+         break;
+      case F_SETUSERVECTOR:  // SetUserVector(vector number in D, handler on the stack)
+         hcs12Write16(s, RAMVECS + 2*(d & 0x3F), hcs12Read16(s, args));
+         setD(s, 0);
+         break;
+      case F_WRITEEEBYTE:
+         setD(s, (word)writeEE(s, d, hcs12Read8(s, args + 1)));
+         break;
+      default:
+         fprintf(stderr, "hcs12sim: DBug12 %s not simulated\n", routines[i].name);
+         s->state = ST_HALT;
+         s->pc = s->lastPC;
+         return(1);
+   }
+   hcs12Return(s);
+   return(1);
+}
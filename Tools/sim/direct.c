@@ -0,0 +1,147 @@
+/*------------------------------------------------
+ * File: direct.c
+ * Description: Direct page estimate (hcs12sim -H): what
+ *              moving some data to the direct page ($00-$FF,
+ *              __SHORT_SEG) would save, measured on an image
+ *              that reaches it with extended addressing.
+ *
+ *              Every executed instruction that reaches the
+ *              data with extended addressing and has a direct
+ *              form is counted, with the cycles the direct
+ *              form saves: 1 for the stores (STAA ... STS)
+ *              and BRSET/BRCLR, none for the loads, the ALU
+ *              operands and BSET/BCLR.  Each instruction site
+ *              is one byte shorter.  INC, DEC, TST, CLR, MOVB
+ *              and MOVW have no direct form and stay as they
+ *              are.  The counts go to the interrupt handler
+ *              running (the innermost interrupt frame), or to
+ *              the main line.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define DIRECT_ROUTINES 32
+#define DIRECT_SITES 1024
+
+struct directRoutine
+{
+   unsigned long func;          // handler (frame 0: the main line)
+   int irq;                     // an interrupt handler
+   unsigned long long insts;    // instructions counted
+   unsigned long long cycles;   // cycles direct addressing saves
+   int sites;                   // their instruction sites
+};
+
+struct direct
+{
+   byte in[0x10000 / 8];        // the data, a bit per address
+   struct directRoutine r[DIRECT_ROUTINES];
+   int n;
+   unsigned long sites[DIRECT_SITES];  // linear addresses of the sites seen
+   int numSites;
+};
+
+/*----------------------------------------------------
+Function: directNew
+Description: Estimate for the data at the given ranges
+             (hex lo-hi,lo-hi...).  NULL if a range is
+             not valid.
+------------------------------------------------------*/
+struct direct *directNew(const char *ranges)
+{
+   struct direct *d = calloc(1, sizeof(*d));
+   const char *p = ranges;
+   unsigned long lo, hi, a;
+   char *end;
+
+   if(d == NULL) return(NULL);
+   while(*p)
+   {
+      lo = strtoul(p, &end, 16);
+      hi = lo;
+      if(*end == '-') hi = strtoul(end + 1, &end, 16);
+      if(end == p || hi < lo || hi > 0xFFFF || (*end != ',' && *end != '\0'))
+      {
+         free(d);
+         return(NULL);
+      }
+      for(a = lo; a <= hi; a++) d->in[a >> 3] |= 1 << (a & 7);
+      p = (*end == ',') ? end + 1 : end;
+   }
+   return(d);
+}
+
+/*----------------------------------------------------
+Function: directAccess
+Description: An instruction with a direct form reached
+             address ea with extended addressing; direct
+             addressing would save cycles.
+------------------------------------------------------*/
+void directAccess(struct hcs12 *s, word ea, int cycles)
+{
+   struct direct *d = s->direct;
+   struct directRoutine *r;
+   unsigned long site;
+   int i;
+
+   if(!(d->in[ea >> 3] & (1 << (ea & 7)))) return;
+   for(i = s->depth - 1; i > 0 && s->frames[i].kind != FR_IRQ; i--) ;
+   for(r = d->r; r < d->r + d->n && r->func != s->frames[i].func; r++) ;
+   if(r == d->r + d->n)
+   {
+      if(d->n == DIRECT_ROUTINES) return;
+      d->n++;
+      r->func = s->frames[i].func;
+      r->irq = (i > 0);
+   }
+   r->insts++;
+   r->cycles += cycles;
+
+   site = hcs12Linear(s, s->lastPC);
+   for(i = 0; i < d->numSites && d->sites[i] != site; i++) ;
+   if(i == d->numSites && d->numSites < DIRECT_SITES)
+   {
+      d->sites[d->numSites++] = site;
+      r->sites++;
+   }
+}
+
+/*----------------------------------------------------
+Function: directReport
+Description: For each handler: its entries and cycles
+             per entry (from the profile, interrupts taken
+             inside excluded) as they are and with the data
+             in the direct page; the main line in total.
+------------------------------------------------------*/
+void directReport(struct hcs12 *s, struct profile *prof, FILE *out)
+{
+   struct direct *d = s->direct;
+   struct directRoutine *r;
+   unsigned long calls;
+   unsigned long long net;
+   char name[72];
+   int bytes = 0;
+
+   for(r = d->r; r < d->r + d->n; r++) bytes += r->sites;
+   fprintf(out, "direct page estimate: %d instruction sites, %d bytes of code saved\n",
+           bytes, bytes);
+   fprintf(out, "%-24s %6s %10s %10s %12s %12s\n", "routine", "sites", "entries",
+           "accesses", "cycles/entry", "with direct");
+   for(r = d->r; r < d->r + d->n; r++)
+   {
+      profileName(prof, r->func, name, sizeof(name));
+      if(!r->irq)
+      {
+         fprintf(out, "%-24s %6d %10s %10llu %12s %12s  (%llu cycles saved)\n", "main line",
+                 r->sites, "-", r->insts, "-", "-", r->cycles);
+         continue;
+      }
+      profileStats(prof, r->func, &calls, &net);
+      if(calls == 0) calls = 1;
+      fprintf(out, "%-24s %6d %10lu %10.2f %12.1f %12.1f\n", name, r->sites, calls,
+              (double)r->insts / calls, (double)net / calls,
+              (double)(net - r->cycles) / calls);
+   }
+}
@@ -0,0 +1,402 @@
+/*------------------------------------------------
+ * File: eeprom.c
+ * Description: EEPROM controller (EETS4K) of the
+ *              MC9S12DG256, $0400-$0FFF.
+ *
+ *              A command is an aligned word write to the
+ *              array (latches address and data), a write of
+ *              ECMD and a write of 1 to CBEIF in ESTAT.  Out
+ *              of sequence accesses set ACCERR, commands on
+ *              the protected area (EPROT) set PVIOL, and no
+ *              command is launched while either is set.  One
+ *              command can wait in the buffer while another
+ *              runs (CBEIF = 0 while it waits, CCIF = 1 when
+ *              both are done).  The array changes when a
+ *              command completes; programming can only clear
+ *              bits.
+ *
+ *              Times are those of the device user guide with
+ *              fNVMOP = 8 MHz / (PRDIV8 ? 8 : 1) / (EDIV + 1):
+ *                word program   9 fNVMOP + 25 bus cycles
+ *                sector erase   4000 fNVMOP (4 bytes)
+ *                mass erase     20000 fNVMOP
+ *                erase verify   1 bus cycle per word
+ *                sector modify  erase + program
+ *              ECLKDIV is write once; the monitor on the
+ *              board has loaded it for 200 kHz before the
+ *              program starts.
+ *
+ *              The erases of each sector are counted, and
+ *              eepromLoad/eepromSave keep the array and the
+ *              counts in a file between runs: the 3K bytes
+ *              of $0400-$0FFF, then the count of each sector
+ *              (4 bytes, most significant first).
+--------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "hcs12.h"
+
+// Registers
+#define R_ECLKDIV 0x110
+#define R_ECNFG   0x113
+#define R_EPROT   0x114
+#define R_ESTAT   0x115
+#define R_ECMD    0x116
+#define R_EADDRHI 0x118
+#define R_EDATALO 0x11B
+
+// Register bits
+#define EDIVLD 0x80
+#define PRDIV8 0x40
+#define CBEIF  0x80
+#define CCIF   0x40
+#define PVIOL  0x20
+#define ACCERR 0x10
+#define BLANK  0x04
+#define EPOPEN 0x80
+#define EPDIS  0x08
+
+// Commands
+#define ERASE_VERIFY  0x05
+#define PROG          0x20
+#define SECTOR_ERASE  0x40
+#define MASS_ERASE    0x41
+#define SECTOR_MODIFY 0x60
+
+#define OSC_HZ 8e6
+#define MONITOR_ECLKDIV (EDIVLD | PRDIV8 | 4)   // 8 MHz / 8 / 5 = 200 kHz
+#define MAXREPORTED 20
+
+#define EE_SIZE (RAM_START - EE_START)
+#define SECTOR(a) (((a) - EE_START) / EE_SECTOR)
+
+static void error(struct hcs12 *s, byte flag, const char *why)
+{
+   struct eectl *e = &s->ee;
+
+   s->regs[R_ESTAT] |= flag;
+   if(flag == ACCERR) e->accerr++;
+   else e->pviol++;
+   if(e->accerr + e->pviol <= MAXREPORTED && !s->quiet)
+      printf("EEPROM: %s at %.3f ms (PC %04X): %s\n", flag == ACCERR ? "ACCERR" : "PVIOL",
+             simTimeUs(s) / 1000.0, s->lastPC, why);
+}
+
+/*----------------------------------------------------
+Function: eepromReset
+Description: Controller reset (the array keeps its
+             contents).
+------------------------------------------------------*/
+void eepromReset(struct hcs12 *s)
+{
+   struct eectl *e = &s->ee;
+
+   e->state = EE_IDLE;
+   e->running = e->waiting = 0;
+   s->regs[R_ECLKDIV] = MONITOR_ECLKDIV;
+   s->regs[R_EPROT] = 0xFF;  // not protected
+   s->regs[R_ESTAT] = CBEIF | CCIF;
+}
+
+// fNVMOP cycles in bus cycles
+static unsigned long long nvmCycles(struct hcs12 *s, unsigned long n)
+{
+   byte div = s->regs[R_ECLKDIV];
+   double hz = OSC_HZ / ((div & PRDIV8) ? 8 : 1) / ((div & 0x3F) + 1);
+
+   return((unsigned long long)(n * s->busMHz * 1e6 / hz + 0.5));
+}
+
+static int isProtected(struct hcs12 *s, word a)
+{
+   byte p = s->regs[R_EPROT];
+
+   if(!(p & EPOPEN)) return(1);
+   if(p & EPDIS) return(0);
+   return(a >= RAM_START - 64 * ((p & 0x07) + 1));  // top 64 to 512 bytes
+}
+
+static unsigned long long duration(struct hcs12 *s, const struct eecmd *c)
+{
+   switch(c->cmd)
+   {
+      case ERASE_VERIFY: return(EE_SIZE / 2);
+      case PROG: return(nvmCycles(s, 9) + 25);
+      case SECTOR_ERASE: return(nvmCycles(s, 4000));
+      case MASS_ERASE: return(nvmCycles(s, 20000));
+      default: return(nvmCycles(s, 4009) + 25);  // sector modify
+   }
+}
+
+// Starts the command c at cycle at
+static void start(struct hcs12 *s, const struct eecmd *c, unsigned long long at)
+{
+   struct eectl *e = &s->ee;
+
+   e->active = *c;
+   e->running = 1;
+   e->doneAt = at + duration(s, c);
+   e->busyUs += (e->doneAt - at) / s->busMHz;
+   e->commands++;
+}
+
+static void program(struct hcs12 *s, word a, word v)
+{
+   byte *p = &s->eeprom[a - EE_START];
+
+   if((p[0] & (v >> 8)) != (v >> 8) || (p[1] & v) != (byte)v) s->ee.overwrites++;
+   p[0] &= v >> 8;
+   p[1] &= (byte)v;
+   if(s->snap) snapMark(s, a);
+   s->ee.programs++;
+}
+
+static void eraseSector(struct hcs12 *s, word a)
+{
+   a &= ~(EE_SECTOR - 1);
+   memset(&s->eeprom[a - EE_START], 0xFF, EE_SECTOR);
+   if(s->snap) snapMark(s, a);
+   s->ee.erases[SECTOR(a)]++;
+}
+
+// Result of the active command
+static void complete(struct hcs12 *s)
+{
+   struct eecmd *c = &s->ee.active;
+   int i;
+
+   switch(c->cmd)
+   {
+      case ERASE_VERIFY:
+         s->regs[R_ESTAT] |= BLANK;
+         for(i = 0; i < EE_SIZE; i++)
+            if(s->eeprom[i] != 0xFF) s->regs[R_ESTAT] &= ~BLANK;
+         break;
+      case PROG:
+         program(s, c->addr, c->data);
+         break;
+      case SECTOR_ERASE:
+         eraseSector(s, c->addr);
+         break;
+      case MASS_ERASE:
+         for(i = EE_START; i < RAM_START; i += EE_SECTOR) eraseSector(s, (word)i);
+         break;
+      case SECTOR_MODIFY:
+         eraseSector(s, c->addr);
+         program(s, c->addr, c->data);
+         break;
+   }
+}
+
+/*----------------------------------------------------
+Function: eepromSync
+Description: Completes the commands whose time is over
+             and starts the one in the buffer.
+------------------------------------------------------*/
+static void eepromSync(struct hcs12 *s)
+{
+   struct eectl *e = &s->ee;
+
+   while(e->running && s->cycles >= e->doneAt)
+   {
+      unsigned long long at = e->doneAt;
+      complete(s);
+      e->running = 0;
+      if(e->waiting)
+      {
+         e->waiting = 0;
+         start(s, &e->next, at);
+         s->regs[R_ESTAT] |= CBEIF;
+      }
+   }
+   if(!e->running) s->regs[R_ESTAT] |= CCIF;
+}
+
+/*----------------------------------------------------
+Function: eepromWrite
+Description: CPU write to the array: step 1 of a command
+             (wide is 0 for a byte write).
+------------------------------------------------------*/
+void eepromWrite(struct hcs12 *s, word a, word v, int wide)
+{
+   struct eectl *e = &s->ee;
+
+   eepromSync(s);
+   if(s->regs[R_ESTAT] & (ACCERR | PVIOL)) return;
+   if(!wide || (a & 1)) error(s, ACCERR, "byte or misaligned word write to the array");
+   else if(e->state != EE_IDLE) error(s, ACCERR, "array written twice in a command");
+   else if(!(s->regs[R_ESTAT] & CBEIF)) error(s, ACCERR, "array written with the buffer full");
+   else
+   {
+      e->cmdBuf.addr = a;
+      e->cmdBuf.data = v;
+      e->state = EE_LATCHED;
+      return;
+   }
+   e->state = EE_IDLE;
+}
+
+/*----------------------------------------------------
+Function: eepromRegRead, eepromRegWrite
+Description: Registers $110-$11B.
+------------------------------------------------------*/
+byte eepromRegRead(struct hcs12 *s, word a)
+{
+   eepromSync(s);
+   return(s->regs[a]);
+}
+
+void eepromRegWrite(struct hcs12 *s, word a, byte v)
+{
+   struct eectl *e = &s->ee;
+   byte st;
+
+   eepromSync(s);
+   st = s->regs[R_ESTAT];
+   switch(a)
+   {
+      case R_ECLKDIV:
+         if(!(s->regs[a] & EDIVLD)) s->regs[a] = EDIVLD | (v & 0x7F);  // write once
+         return;
+      case R_EPROT:
+         // EPOPEN and EPDIS can only be cleared (more protection)
+         s->regs[a] = (s->regs[a] & (v | ~(EPOPEN | EPDIS)) & ~0x07) | (v & 0x07);
+         return;
+      case R_ECMD:
+         if(st & (ACCERR | PVIOL)) return;
+         if(e->state != EE_LATCHED) error(s, ACCERR, "ECMD written before the array");
+         else if(v != ERASE_VERIFY && v != PROG && v != SECTOR_ERASE && v != MASS_ERASE
+                 && v != SECTOR_MODIFY) error(s, ACCERR, "not a command");
+         else
+         {
+            e->cmdBuf.cmd = v;
+            e->state = EE_COMMAND;
+            s->regs[a] = v;
+            return;
+         }
+         e->state = EE_IDLE;
+         return;
+      case R_ESTAT:
+         s->regs[a] = st & ~(v & (ACCERR | PVIOL));  // write 1 to clear
+         if(st & (ACCERR | PVIOL)) return;  // no launch with an error pending
+         if(!(v & CBEIF))
+         {
+            if(e->state != EE_IDLE)
+            {
+               error(s, ACCERR, "command aborted (CBEIF written 0)");
+               e->state = EE_IDLE;
+            }
+            return;
+         }
+         if(!(st & CBEIF)) return;
+         if(e->state != EE_COMMAND)
+         {
+            if(e->state == EE_LATCHED) error(s, ACCERR, "launched without a command");
+            e->state = EE_IDLE;
+            return;
+         }
+         e->state = EE_IDLE;
+         if((e->cmdBuf.cmd == MASS_ERASE && (!(s->regs[R_EPROT] & EPDIS)
+                                            || !(s->regs[R_EPROT] & EPOPEN)))
+            || (e->cmdBuf.cmd != ERASE_VERIFY && isProtected(s, e->cmdBuf.addr)))
+         {
+            error(s, PVIOL, "protected area");
+            return;
+         }
+         s->regs[a] &= ~CCIF;
+         if(e->running)
+         {
+            e->next = e->cmdBuf;
+            e->waiting = 1;
+            s->regs[a] &= ~CBEIF;
+         }
+         else start(s, &e->cmdBuf, s->cycles);
+         return;
+      default:
+         if(e->state != EE_IDLE && a != R_ECNFG)
+         {
+            error(s, ACCERR, "register written during a command");
+            e->state = EE_IDLE;
+            return;
+         }
+         if(a >= R_EADDRHI && a <= R_EDATALO) return;  // read only in normal modes
+         s->regs[a] = v;
+         return;
+   }
+}
+
+/*----------------------------------------------------
+Function: eepromLoad, eepromSave
+Description: Array and erase counts kept in a file.
+             eepromLoad returns 0 if the file does not
+             exist (the image of the program is kept).
+------------------------------------------------------*/
+int eepromLoad(struct hcs12 *s, const char *path)
+{
+   FILE *f = fopen(path, "rb");
+   byte buf[4];
+   int i;
+
+   if(f == NULL) return(0);
+   if(fread(s->eeprom, 1, EE_SIZE, f) != EE_SIZE)
+   {
+      fprintf(stderr, "%s: not an EEPROM image\n", path);
+      fclose(f);
+      return(-1);
+   }
+   for(i = 0; i < EE_SECTORS && fread(buf, 1, 4, f) == 4; i++)
+      s->ee.erases[i] = (unsigned long)buf[0] << 24 | (unsigned long)buf[1] << 16
+                        | buf[2] << 8 | buf[3];
+   fclose(f);
+   return(0);
+}
+
+int eepromSave(struct hcs12 *s, const char *path)
+{
+   FILE *f = fopen(path, "wb");
+   byte buf[4];
+   int i;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   eepromSync(s);
+   fwrite(s->eeprom, 1, EE_SIZE, f);
+   for(i = 0; i < EE_SECTORS; i++)
+   {
+      unsigned long n = s->ee.erases[i];
+      buf[0] = (byte)(n >> 24);
+      buf[1] = (byte)(n >> 16);
+      buf[2] = (byte)(n >> 8);
+      buf[3] = (byte)n;
+      fwrite(buf, 1, 4, f);
+   }
+   return(fclose(f) == 0 ? 0 : -1);
+}
+
+/*----------------------------------------------------
+Function: eepromReport
+Description: Commands, time busy, errors and the most
+             erased sectors.
+------------------------------------------------------*/
+void eepromReport(struct hcs12 *s, FILE *out)
+{
+   struct eectl *e = &s->ee;
+   unsigned long total = 0;
+   int i, n = 0, most = 0;
+
+   for(i = 0; i < EE_SECTORS; i++)
+   {
+      total += e->erases[i];
+      if(e->erases[i]) n++;
+      if(e->erases[i] > e->erases[most]) most = i;
+   }
+   fprintf(out, "EEPROM: %lu commands, busy %.3f ms, %lu words programmed (%lu not erased),"
+           " %lu ACCERR, %lu PVIOL\n", e->commands, e->busyUs / 1000.0, e->programs,
+           e->overwrites, e->accerr, e->pviol);
+   if(total)
+      fprintf(out, "        %lu sector erases in all runs on %d sectors, most %lu at $%04X\n",
+              total, n, e->erases[most], EE_START + most * EE_SECTOR);
+}
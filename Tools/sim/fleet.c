@@ -0,0 +1,365 @@
+/*------------------------------------------------
+ * File: fleet.c
+ * Description: hcs12fleet - runs an .s19 image as many
+ *              independent panels, each with its own random
+ *              keypad and switch script, on a pool of
+ *              threads, and reports the simulated MIPS.
+ *
+ *              The image is loaded once and shared read only
+ *              (struct image).  Each thread resets its one
+ *              struct hcs12 for every panel it runs, so its
+ *              working set is a CPU with its RAM, EEPROM and
+ *              peripherals; a panel keeps only its result.
+ *              The panels are dealt out in blocks, one queue
+ *              per thread.  A thread takes from the back of
+ *              its own queue and, once it is empty, from the
+ *              front of another (work stealing), since the
+ *              scripts do not all cost the same.  A script
+ *              depends only on the seed and the panel, so the
+ *              results do not depend on the threads.
+ *
+ *   hcs12fleet [-e] [-l] [-s] [-j threads] [-n panels] [-t seconds]
+ *              [-r seed] file.s19
+ *
+ *      -e  executes every pass of the idle loops
+ *      -l  lists the result of each panel
+ *      -s  scaling: runs the fleet on 1, 2, 4 ... -j
+ *          threads and checks they give the same results
+ *      -j  threads (default one per processor)
+ *      -n  panels (default 1000)
+ *      -t  simulated time of each panel (default 2 s)
+ *      -r  seed of the scripts (default 1)
+--------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "hcs12.h"
+
+#define MAXTHREADS 256
+#define R_PTT 0x240
+#define SIREN 0x20           // PT5 (siren.c)
+#define CACHE_LINE 64
+
+// Script of a panel (ms)
+#define FIRST_KEY 500        // keys from 0.5 s
+#define KEY_HOLD 100
+#define DIGIT_GAP 300        // between the digits of a code
+#define MIN_GAP 150          // between the other inputs
+#define MAX_GAP 600
+
+struct result
+{
+   unsigned long long insts, cycles;
+   unsigned long edges;      // siren (PT5)
+   unsigned long violations; // LCD
+   unsigned long hash;       // RAM and EEPROM at the end
+   byte ptt;                 // Port T as last seen
+   int state;
+   int keys, switches;
+};
+
+struct worker
+{
+   pthread_t thread;
+   int id;
+   pthread_mutex_t lock;     // head and tail
+   int *tasks;               // panels tasks[head] to tasks[tail-1]
+   int head, tail;
+   struct hcs12 *cpu;
+   int ran, stolen;
+   unsigned long long insts;
+   double busy;              // seconds
+};
+
+static const struct image *fleetImage;
+static struct result *results;
+static struct worker workers[MAXTHREADS];
+static int numWorkers, skipIdle = 1;
+static unsigned long seed = 1;
+static double seconds = 2.0;
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: hcs12fleet [-e] [-l] [-s] [-j threads] [-n panels] [-t seconds]\n"
+                   "                  [-r seed] file.s19\n");
+   exit(1);
+}
+
+static double wallSeconds(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return(t.tv_sec + t.tv_nsec / 1e9);
+}
+
+// splitmix64
+static unsigned long long nextRandom(unsigned long long *r)
+{
+   unsigned long long z = (*r += 0x9E3779B97F4A7C15ULL);
+
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   return(z ^ (z >> 31));
+}
+
+/*----------------------------------------------------
+Function: makeScript
+Description: Adds the random inputs of the panel until
+             endMs: the menu key followed by a code (the
+             default 0000 half the time), single keys and
+             switch changes (one zone open, or all closed).
+------------------------------------------------------*/
+static void makeScript(struct hcs12 *s, int panel, double endMs, struct result *r)
+{
+   static const char keys[] = "0123456789abcd*#";
+   unsigned long long rnd = seed * 0x2545F4914F6CDD1DULL + (unsigned long long)panel;
+   double at = FIRST_KEY + nextRandom(&rnd) % MAX_GAP;
+   int pick, i, good;
+
+   while(at < endMs)
+   {
+      pick = (int)(nextRandom(&rnd) % 10);
+      if(pick < 3)
+      {
+         good = nextRandom(&rnd) & 1;
+         r->keys += keyPress(s, at, 'a', KEY_HOLD) == 0;
+         for(i = 0; i < 4; i++)
+         {
+            at += DIGIT_GAP;
+            r->keys += keyPress(s, at, good ? '0' : keys[nextRandom(&rnd) % 10], KEY_HOLD) == 0;
+         }
+      }
+      else if(pick < 5)
+      {
+         i = (int)(nextRandom(&rnd) % 9);
+         r->switches += switchSet(s, at, i < 8 ? (byte)(1 << i) : 0) == 0;
+      }
+      else r->keys += keyPress(s, at, keys[nextRandom(&rnd) % 16], KEY_HOLD) == 0;
+      at += MIN_GAP + nextRandom(&rnd) % (MAX_GAP - MIN_GAP);
+   }
+}
+
+// onOutput of the panels: counts the siren edges
+static void onOutput(struct hcs12 *s, int what)
+{
+   struct result *r = s->observer;
+
+   if(what != OUT_PTT) return;
+   if((s->regs[R_PTT] ^ r->ptt) & SIREN) r->edges++;
+   r->ptt = s->regs[R_PTT];
+}
+
+// FNV-1a of n bytes
+static unsigned long hashBytes(unsigned long h, const byte *b, size_t n)
+{
+   while(n-- > 0) h = ((h ^ *b++) * 16777619UL) & 0xFFFFFFFFUL;
+   return(h);
+}
+
+/*----------------------------------------------------
+Function: runPanel
+Description: Resets s, runs the panel's script for the
+             simulated time and keeps its result.
+------------------------------------------------------*/
+static void runPanel(struct hcs12 *s, int panel, struct result *r)
+{
+   double endUs = seconds * 1e6;
+   unsigned long long end;
+
+   memset(r, 0, sizeof(*r));
+   s->skipIdle = skipIdle;
+   s->quiet = 1;
+   s->observer = r;
+   s->onOutput = onOutput;
+   hcs12Reset(s, fleetImage);
+   makeScript(s, panel, endUs / 1000.0, r);
+   end = (unsigned long long)(endUs * s->busMHz);
+   while(s->state <= ST_WAIT && simTimeUs(s) < endUs)
+   {
+      hcs12Run(s, end);
+      end = s->cycles + (unsigned long long)((endUs - simTimeUs(s)) * s->busMHz);
+   }
+   r->insts = s->insts;
+   r->cycles = s->cycles;
+   r->violations = s->lcd.violations;
+   r->state = s->state;
+   r->hash = hashBytes(hashBytes(2166136261UL, s->ram, sizeof(s->ram)), s->eeprom, sizeof(s->eeprom));
+}
+
+/*----------------------------------------------------
+Function: takePanel
+Description: Next panel for worker w: the back of its
+             own queue, else the front of the first other
+             queue that has one.  -1 when all are empty.
+------------------------------------------------------*/
+static int takePanel(struct worker *w)
+{
+   struct worker *v;
+   int panel = -1, k;
+
+   pthread_mutex_lock(&w->lock);
+   if(w->head < w->tail) panel = w->tasks[--w->tail];
+   pthread_mutex_unlock(&w->lock);
+   for(k = 1; panel < 0 && k < numWorkers; k++)
+   {
+      v = &workers[(w->id + k) % numWorkers];
+      pthread_mutex_lock(&v->lock);
+      if(v->head < v->tail)
+      {
+         panel = v->tasks[v->head++];
+         w->stolen++;
+      }
+      pthread_mutex_unlock(&v->lock);
+   }
+   return(panel);
+}
+
+static void *workerMain(void *arg)
+{
+   struct worker *w = arg;
+   double t0 = wallSeconds();
+   int panel;
+
+   while((panel = takePanel(w)) >= 0)
+   {
+      runPanel(w->cpu, panel, &results[panel]);
+      w->insts += results[panel].insts;
+      w->ran++;
+   }
+   w->busy = wallSeconds() - t0;
+   return(NULL);
+}
+
+/*----------------------------------------------------
+Function: runFleet
+Description: Runs the panels on threads workers.  Returns
+             the wall time, -1 on an error.
+------------------------------------------------------*/
+static double runFleet(int panels, int threads)
+{
+   double t0;
+   int i, j;
+   void *mem;
+
+   numWorkers = threads;
+   for(i = 0; i < threads; i++)
+   {
+      struct worker *w = &workers[i];
+      if(w->cpu == NULL)
+      {
+         if(posix_memalign(&mem, CACHE_LINE, sizeof(struct hcs12)) != 0) return(-1.0);
+         w->cpu = mem;
+         memset(w->cpu, 0, sizeof(struct hcs12));
+         pthread_mutex_init(&w->lock, NULL);
+      }
+      free(w->tasks);
+      w->id = i;
+      w->head = 0;
+      w->tail = panels * (i + 1) / threads - panels * i / threads;
+      if((w->tasks = malloc((w->tail + 1) * sizeof(int))) == NULL) return(-1.0);
+      for(j = 0; j < w->tail; j++) w->tasks[j] = panels * i / threads + j;
+      w->ran = w->stolen = 0;
+      w->insts = 0;
+   }
+   t0 = wallSeconds();
+   for(i = 0; i < threads; i++)
+      if(pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) return(-1.0);
+   for(i = 0; i < threads; i++) pthread_join(workers[i].thread, NULL);
+   return(wallSeconds() - t0);
+}
+
+int main(int argc, char *argv[])
+{
+   static struct image img;
+   static const char *states[] = { "running", "waiting", "halted", "done" };
+   const char *file = NULL;
+   struct result *first = NULL;
+   unsigned long long insts = 0, cycles = 0;
+   unsigned long violations = 0;
+   int panels = 1000, threads = (int)sysconf(_SC_NPROCESSORS_ONLN), list = 0, scaling = 0;
+   int sirens = 0, halted = 0, keys = 0, switches = 0, differ = 0, i, t;
+   double wall, base = 0.0;
+
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-e") == 0) skipIdle = 0;
+      else if(strcmp(argv[i], "-l") == 0) list = 1;
+      else if(strcmp(argv[i], "-s") == 0) scaling = 1;
+      else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) panels = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) seed = strtoul(argv[++i], NULL, 0);
+      else if(argv[i][0] != '-' && file == NULL) file = argv[i];
+      else usage();
+   }
+   if(threads < 1) threads = 1;
+   if(file == NULL || threads > MAXTHREADS || panels < 1 || seconds <= 0.0) usage();
+   imageInit(&img);
+   if(loadS19(&img, file) != 0) return(1);
+   fleetImage = &img;
+   results = calloc(panels, sizeof(*results));
+   if(scaling) first = calloc(panels, sizeof(*first));
+   if(results == NULL || (scaling && first == NULL))
+   {
+      fprintf(stderr, "hcs12fleet: out of memory\n");
+      return(1);
+   }
+
+   printf("%d panels x %.3f s of %s, seed %lu\n", panels, seconds, file, seed);
+   if(scaling) printf("\n%8s %10s %10s %9s %11s\n", "threads", "wall s", "MIPS", "speedup", "efficiency");
+   for(t = scaling ? 1 : threads;; t = t * 2 < threads ? t * 2 : threads)
+   {
+      if((wall = runFleet(panels, t)) < 0)
+      {
+         fprintf(stderr, "hcs12fleet: cannot start the threads\n");
+         return(1);
+      }
+      for(i = 0, insts = 0; i < panels; i++) insts += results[i].insts;
+      if(scaling)
+      {
+         if(t == 1)
+         {
+            base = wall;
+            memcpy(first, results, panels * sizeof(*first));
+         }
+         else for(i = 0; i < panels; i++) differ += memcmp(&first[i], &results[i], sizeof(*first)) != 0;
+         printf("%8d %10.3f %10.1f %9.2f %10.1f%%\n", t, wall, insts / wall / 1e6, base / wall,
+                100.0 * base / wall / t);
+      }
+      if(t == threads) break;
+   }
+
+   for(i = 0; i < panels; i++)
+   {
+      struct result *r = &results[i];
+      if(list)
+         printf("panel %5d: %2d keys %2d switches  %12llu insts  siren edges %6lu  "
+                "LCD violations %3lu  %08lX  %s\n", i, r->keys, r->switches, r->insts, r->edges,
+                r->violations, r->hash, r->state <= ST_WAIT ? "ok" : states[r->state]);
+      cycles += r->cycles;
+      violations += r->violations;
+      keys += r->keys;
+      switches += r->switches;
+      sirens += r->edges > 0;
+      halted += r->state == ST_HALT;
+   }
+   printf("\n%d key presses, %d switch changes; %d panels sounded the siren, %d halted, "
+          "%lu LCD violations\n", keys, switches, sirens, halted, violations);
+   printf("%llu instructions, %llu cycles, %.1f simulated s\n", insts, cycles, panels * seconds);
+   printf("%d threads, wall %.3f s: %.1f MIPS, %.1f simulated s per s\n", threads, wall,
+          insts / wall / 1e6, panels * seconds / wall);
+   for(i = 0; i < threads; i++)
+      printf("   thread %3d: %5d panels (%d stolen), %.1f MIPS\n", i, workers[i].ran,
+             workers[i].stolen, workers[i].busy > 0 ? workers[i].insts / workers[i].busy / 1e6 : 0.0);
+   if(scaling)
+   {
+      if(differ) printf("%d panels gave other results than on 1 thread\n", differ);
+      else printf("same results on every run\n");
+   }
+   return(differ ? 2 : 0);
+}
@@ -0,0 +1,811 @@
+/*------------------------------------------------
+ * File: fuzz.c
+ * Description: hcs12fuzz - coverage guided fuzzing of the
+ *              code entry of Lab 4 (checkCode, enterMstCode,
+ *              configCodes, setcode) on the simulator.
+ *
+ *              The image is run until it waits for the first
+ *              key of a code: readKey called by enableAlarm
+ *              ('a' at the menu, target arm) or by
+ *              enterMstCode ('c', target config).  That state
+ *              is kept in a snapshot (snapshot.c), and each
+ *              run restores it and hands readKey the keys of
+ *              one sequence.  readKey, printLCDStr and delayms
+ *              return at once, and writeToEE records its
+ *              arguments and returns TRUE in place of the
+ *              EEPROM commands (ms each).  The run ends when
+ *              the program polls the keypad again (pollReadKey:
+ *              the menu, or the exit delay once armed) or asks
+ *              for a key after the last.
+ *
+ *              A sequence that takes a new branch edge of the
+ *              routines joins the corpus, and the next ones are
+ *              mutations of the corpus.  Every run is checked
+ *              against a model of the routines as their
+ *              comments describe them (which routine takes each
+ *              key, the codes written, arming) and against
+ *              invariants: the statics of checkCode between
+ *              calls (mult is 1000, 100, 10 or 1 and alarmCode
+ *              holds only the digits taken), writeToEE (index
+ *              0 to 4, 4 digits or 0xFFFF, the master code not
+ *              disabled, one write), the alarm codes left to
+ *              writeToEE, SP and runaway code.
+ *
+ *   hcs12fuzz -m file.map [-a|-c] [-v] [-n runs] [-t seconds] [-k keys]
+ *             [-r seed] file.s19
+ *
+ *      -m  linker map of the image (routines, statics)
+ *      -a  only the arm target, -c only config
+ *      -v  lists the corpus and the branches taken one way
+ *      -n  runs of each target (default 200000)
+ *      -t  wall time limit of each target
+ *      -k  longest sequence (default 24 keys)
+ *      -r  seed of the mutations (default 1)
+--------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hcs12.h"
+
+#define MAXKEYS 64
+#define MAXWRITES 8
+#define MAXCORPUS 4096
+#define LINESIZE 512
+#define BOOT_MS 1000         // menu key pressed
+#define KEY_HOLD 100
+#define WAIT_MS 3000         // readKey reached by then
+#define RUN_INSTS 20000      // instructions per key before a run is a runaway
+#define EDGE_BITS 16
+
+static const char keys[] = "0123456789abcd*#";   // keypad (getAscii)
+
+// Symbols of the map
+enum { S_READKEY, S_POLLREADKEY, S_PRINTLCDSTR, S_DELAYMS, S_WRITETOEE,
+       S_ENABLEALARM, S_CHECKCODE, S_ISCODEVALID, S_CONFIGCODES, S_ENTERMSTCODE,
+       S_SETCODE, S_ALARMCODES, S_MULT, S_ALARMCODE, NUMSYMS };
+
+static struct
+{
+   const char *name;         // a final '.' takes any static of that name
+   word addr, size;
+   int found;
+} syms[NUMSYMS] =
+{
+   { "readKey" }, { "pollReadKey" }, { "printLCDStr" }, { "delayms" }, { "writeToEE" },
+   { "enableAlarm" }, { "checkCode" }, { "isCodeValid" }, { "configCodes" },
+   { "enterMstCode" }, { "setcode" }, { "alarmCodes" }, { "mult." }, { "alarmCode." }
+};
+
+// Routines whose branches are covered (the others are stubbed or outside)
+static const int covered[] = { S_ENABLEALARM, S_CHECKCODE, S_ISCODEVALID, S_CONFIGCODES,
+                               S_ENTERMSTCODE, S_SETCODE };
+#define NUMCOVERED ((int)(sizeof(covered) / sizeof(covered[0])))
+
+// End of a run
+#define E_WAIT  0            // readKey called after the last key
+#define E_MENU  1            // back at the menu
+#define E_ARMED 2            // exit delay
+#define E_OTHER 3            // runaway or halted
+
+static const char *ends[] = { "waits for a key", "back at the menu", "armed", "stopped" };
+
+// Violations
+enum { V_MULT, V_PARTIAL, V_CHECK, V_ENTER, V_CONFIG, V_SETCODE, V_INDEX, V_MASTER,
+       V_DIGITS, V_WRITES, V_CODES, V_STACK, V_RUNAWAY, V_HALT, NUMKINDS };
+
+static const char *kinds[NUMKINDS] =
+{
+   "checkCode: mult is not 1000, 100, 10 or 1",
+   "checkCode: alarmCode holds more than the digits taken",
+   "checkCode: differs from the model",
+   "enterMstCode: differs from the model",
+   "configCodes: differs from the model",
+   "setcode: differs from the model",
+   "writeToEE: index above 4",
+   "writeToEE: master code disabled",
+   "writeToEE: code of more than 4 digits",
+   "writeToEE: more than one write",
+   "alarm codes written outside writeToEE",
+   "SP outside RAM",
+   "runaway (no key taken)",
+   "halted"
+};
+
+struct outcome
+{
+   int numKeys;
+   byte by[MAXKEYS];         // routine that took each key (S_...)
+   int numWrites;
+   word ix[MAXWRITES], code[MAXWRITES];
+   int end;
+   unsigned bad;             // violations (1 << V_...)
+};
+
+struct seq
+{
+   int n;
+   char k[MAXKEYS];
+};
+
+struct example
+{
+   unsigned long count;
+   struct seq seq;           // first sequence seen, shrunk at the end
+   struct outcome fw, model;
+};
+
+static struct image img;
+static struct hcs12 cpu;
+static struct snapshot *snap;
+static struct seq corpus[MAXCORPUS];
+static int numCorpus, maxKeys = 24, verbose;
+static struct example examples[NUMKINDS];
+static byte edges[1 << EDGE_BITS], reached[0x10000], branch[0x10000];
+static word taken[0x10000];
+static int numEdges;
+static word codes[5];        // alarmCodes at the snapshot
+static unsigned long long rnd = 1, insts;
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: hcs12fuzz -m file.map [-a|-c] [-v] [-n runs] [-t seconds] [-k keys]\n"
+                   "                 [-r seed] file.s19\n");
+   exit(1);
+}
+
+static double wallSeconds(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return(t.tv_sec + t.tv_nsec / 1e9);
+}
+
+// splitmix64
+static unsigned long long nextRandom(void)
+{
+   unsigned long long z = (rnd += 0x9E3779B97F4A7C15ULL);
+
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   return(z ^ (z >> 31));
+}
+
+/*----------------------------------------------------
+Function: loadSymbols
+Description: Reads the addresses and sizes of syms from
+             the OBJECT-ALLOCATION SECTION of a CodeWarrior
+             map ("name  addr  size  size  refs  section",
+             hex addr and size).  Returns the number missing,
+             -1 if the file cannot be read.
+------------------------------------------------------*/
+static int loadSymbols(const char *path)
+{
+   FILE *f = fopen(path, "r");
+   char line[LINESIZE], name[LINESIZE];
+   unsigned long addr, size;
+   size_t len;
+   int i, missing = 0;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), f))
+   {
+      if(sscanf(line, "%511s %lx %lx", name, &addr, &size) != 3 || addr > 0xFFFF) continue;
+      for(i = 0; i < NUMSYMS; i++)
+      {
+         len = strlen(syms[i].name);
+         if(syms[i].found || (syms[i].name[len-1] == '.' ? strncmp(name, syms[i].name, len)
+                                                           : strcmp(name, syms[i].name)) != 0)
+            continue;
+         syms[i].addr = (word)addr;
+         syms[i].size = (word)size;
+         syms[i].found = 1;
+      }
+   }
+   fclose(f);
+   for(i = 0; i < NUMSYMS; i++)
+      if(!syms[i].found)
+      {
+         fprintf(stderr, "%s: no %s\n", path, syms[i].name);
+         missing++;
+      }
+   return(missing);
+}
+
+// Covered routine holding address a, -1 if none
+static int routineAt(word a)
+{
+   int i;
+
+   for(i = 0; i < NUMCOVERED; i++)
+      if(a >= syms[covered[i]].addr && a < syms[covered[i]].addr + syms[covered[i]].size)
+         return(covered[i]);
+   return(-1);
+}
+
+// Return address of the routine just entered
+static word returnAddr(struct hcs12 *s)
+{
+   return(hcs12Read16(s, s->farCall ? s->sp + 1 : s->sp));
+}
+
+// Conditional branch at a: Bcc, LBcc, BRSET/BRCLR, DBEQ ... IBNE
+static int isBranch(struct hcs12 *s, word a)
+{
+   byte op = hcs12Read8(s, a);
+
+   if(op >= 0x22 && op <= 0x2F) return(1);
+   if(op == 0x18) op = hcs12Read8(s, a + 1);
+   else if(op == 0x0E || op == 0x0F || op == 0x04) return(1);
+   return(op >= 0x22 && op <= 0x2F);
+}
+
+/*----------------------------------------------------
+Function: boot
+Description: Runs the image from reset with key pressed
+             at the menu until readKey is called, then
+             takes the snapshot.  Returns 0 when done.
+------------------------------------------------------*/
+static int boot(char key)
+{
+   struct hcs12 *s = &cpu;
+   double endUs = WAIT_MS * 1000.0;
+   int i;
+
+   if(snap) snapFree(snap, s);
+   snap = NULL;
+   s->quiet = 1;
+   s->skipIdle = 1;
+   hcs12Reset(s, &img);
+   keyPress(s, BOOT_MS, key, KEY_HOLD);
+   while(s->state <= ST_WAIT && simTimeUs(s) < (BOOT_MS - 10) * 1000.0)
+      hcs12Run(s, s->cycles + (unsigned long long)(((BOOT_MS - 10) * 1000.0 - simTimeUs(s)) * s->busMHz) + 1);
+   s->skipIdle = 0;  // one instruction at a time from here
+   while(s->state <= ST_WAIT && simTimeUs(s) < endUs && s->pc != syms[S_READKEY].addr)
+      hcs12Run(s, s->cycles + 1);
+   if(s->pc != syms[S_READKEY].addr)
+   {
+      fprintf(stderr, "hcs12fuzz: readKey not called within %d ms of '%c'\n", WAIT_MS - BOOT_MS, key);
+      return(1);
+   }
+   for(i = 0; i < 5; i++) codes[i] = hcs12Read16(s, syms[S_ALARMCODES].addr + 2 * i);
+   if((snap = snapTake(s)) == NULL)
+   {
+      fprintf(stderr, "hcs12fuzz: out of memory\n");
+      return(1);
+   }
+   return(0);
+}
+
+// Records the edge into the covered instruction at a (from prev); 1 if new
+static int edge(word prev, word a)
+{
+   unsigned h = ((unsigned)prev * 40503u ^ a) & ((1 << EDGE_BITS) - 1);
+
+   reached[a] = 1;
+   if(edges[h]) return(0);
+   edges[h] = 1;
+   numEdges++;
+   return(1);
+}
+
+/*----------------------------------------------------
+Function: run
+Description: Restores the snapshot and runs the keys of
+             q.  Fills the firmware outcome o (with the
+             invariants broken) and returns the new edges.
+------------------------------------------------------*/
+static int run(const struct seq *q, struct outcome *o)
+{
+   struct hcs12 *s = &cpu;
+   word prev = 0, pc;
+   unsigned long long limit, i0;
+   int fresh = 0, k = 0, r, mult, code;
+
+   snapRestore(snap, s);
+   memset(o, 0, sizeof(*o));
+   o->end = E_OTHER;
+   i0 = s->insts;
+   limit = i0 + RUN_INSTS;
+   for(;;)
+   {
+      pc = s->pc;
+      if(pc == syms[S_READKEY].addr)
+      {
+         mult = (short)hcs12Read16(s, syms[S_MULT].addr);
+         code = (short)hcs12Read16(s, syms[S_ALARMCODE].addr);
+         if(mult != 1000 && mult != 100 && mult != 10 && mult != 1) o->bad |= 1 << V_MULT;
+         else if(code < 0 || code > 9999 || code % (mult * 10) != 0) o->bad |= 1 << V_PARTIAL;
+         if(k == q->n)
+         {
+            o->end = E_WAIT;
+            break;
+         }
+         r = routineAt(returnAddr(s));
+         o->by[o->numKeys++] = (byte)(r < 0 ? NUMSYMS : r);
+         s->a = 0;
+         s->b = (byte)q->k[k++];
+         hcs12Return(s);
+         limit = s->insts + RUN_INSTS;
+         continue;
+      }
+      if(pc == syms[S_POLLREADKEY].addr)
+      {
+         o->end = routineAt(returnAddr(s)) == S_ENABLEALARM ? E_ARMED : E_MENU;
+         break;
+      }
+      if(pc == syms[S_PRINTLCDSTR].addr || pc == syms[S_DELAYMS].addr)
+      {
+         hcs12Return(s);
+         continue;
+      }
+      if(pc == syms[S_WRITETOEE].addr)
+      {
+         if(o->numWrites < MAXWRITES)
+         {
+            o->code[o->numWrites] = (word)(s->a << 8 | s->b);  // last argument in D
+            o->ix[o->numWrites] = hcs12Read16(s, s->sp + 2);
+         }
+         o->numWrites++;
+         s->a = 0;
+         s->b = 1;
+         hcs12Return(s);
+         continue;
+      }
+      if(s->insts >= limit)
+      {
+         o->bad |= 1 << V_RUNAWAY;
+         break;
+      }
+      hcs12Run(s, s->cycles + 1);
+      if(s->state > ST_WAIT)
+      {
+         o->bad |= 1 << V_HALT;
+         break;
+      }
+      if(s->sp < RAM_START || s->sp > FLASH_START) o->bad |= 1 << V_STACK;
+      if(routineAt(s->lastPC) >= 0)
+      {
+         fresh += edge(prev, s->lastPC);
+         if(branch[s->lastPC] == 0) branch[s->lastPC] = isBranch(s, s->lastPC) ? 2 : 1;
+         if(branch[s->lastPC] == 2 && taken[s->lastPC] != s->pc)
+         {
+            if(taken[s->lastPC] == 0) taken[s->lastPC] = s->pc;
+            else branch[s->lastPC] = 3;  // both ways
+         }
+         prev = s->lastPC;
+      }
+   }
+   insts += s->insts - i0;
+   for(r = 0; r < 5; r++)
+      if(hcs12Read16(s, syms[S_ALARMCODES].addr + 2 * r) != codes[r]) o->bad |= 1 << V_CODES;
+   return(fresh);
+}
+
+// Model: takes the next key for routine by, 0 when there is none
+static int take(const struct seq *q, struct outcome *m, int by, char *c)
+{
+   if(m->numKeys == q->n || m->numKeys == MAXKEYS)
+   {
+      m->end = E_WAIT;
+      return(0);
+   }
+   *c = q->k[m->numKeys];
+   m->by[m->numKeys++] = (byte)by;
+   return(1);
+}
+
+static int isDigit(char c)
+{
+   return(c >= '0' && c <= '9');
+}
+
+/*----------------------------------------------------
+Function: modelArm
+Description: enableAlarm and checkCode as commented: a
+             code is 4 digits in a row (any other key
+             starts again) and arms when it is one of the
+             alarm codes.
+------------------------------------------------------*/
+static void modelArm(const struct seq *q, struct outcome *m)
+{
+   int code = 0, mult = 1000, i;
+   char c;
+
+   memset(m, 0, sizeof(*m));
+   while(take(q, m, S_ENABLEALARM, &c))
+   {
+      if(!isDigit(c))
+      {
+         code = 0;
+         mult = 1000;
+         continue;
+      }
+      code += (c - '0') * mult;
+      mult /= 10;
+      if(mult > 0) continue;
+      for(i = 0; i < 5; i++)
+         if(codes[i] == code)
+         {
+            m->end = E_ARMED;
+            return;
+         }
+      code = 0;
+      mult = 1000;
+   }
+}
+
+/*----------------------------------------------------
+Function: modelConfig
+Description: configCodes, enterMstCode and setcode as
+             commented: the master code (up to 4 keys, the
+             first other than a digit ends it), the choice
+             of code ('a' or '1' to '4', others again) and
+             the new code, 4 digits or 'd' to disable (not
+             the master code).  An error starts the new code
+             again from its first digit.
+------------------------------------------------------*/
+static void modelConfig(const struct seq *q, struct outcome *m)
+{
+   int code = 0, mult = 1000, i, ix;
+   char c;
+
+   memset(m, 0, sizeof(*m));
+   for(i = 0; i < 4; i++)
+   {
+      if(!take(q, m, S_ENTERMSTCODE, &c)) return;
+      if(!isDigit(c)) break;
+      code += (c - '0') * mult;
+      mult /= 10;
+   }
+   m->end = E_MENU;
+   if(i < 4 || code != codes[0]) return;
+   do
+   {
+      if(!take(q, m, S_CONFIGCODES, &c)) return;
+   } while(c != 'a' && (c < '1' || c > '4'));
+   ix = c == 'a' ? 0 : c - '0';
+   for(;;)
+   {
+      code = 0;
+      mult = 1000;
+      for(i = 0; i < 4; i++)
+      {
+         if(!take(q, m, S_SETCODE, &c)) return;
+         if(c == 'd' && ix != 0) code = 0xFFFF;
+         else if(isDigit(c))
+         {
+            code += (c - '0') * mult;
+            mult /= 10;
+            if(mult > 0) continue;
+         }
+         else break;
+         m->ix[0] = (word)ix;
+         m->code[0] = (word)code;
+         m->numWrites = 1;
+         m->end = E_MENU;
+         return;
+      }
+   }
+}
+
+/*----------------------------------------------------
+Function: check
+Description: Adds to o->bad the invariants of the writes
+             and the differences from the model m (by the
+             routine where they start).
+------------------------------------------------------*/
+static void check(struct outcome *o, const struct outcome *m)
+{
+   int i, n = o->numWrites < MAXWRITES ? o->numWrites : MAXWRITES, by;
+
+   for(i = 0; i < n; i++)
+   {
+      if(o->ix[i] > 4) o->bad |= 1 << V_INDEX;
+      else if(o->ix[i] == 0 && o->code[i] == 0xFFFF) o->bad |= 1 << V_MASTER;
+      if(o->code[i] > 9999 && o->code[i] != 0xFFFF) o->bad |= 1 << V_DIGITS;
+   }
+   if(o->numWrites > 1) o->bad |= 1 << V_WRITES;
+   if(o->bad & (1 << V_RUNAWAY | 1 << V_HALT)) return;
+
+   for(i = 0; i < o->numKeys && i < m->numKeys && o->by[i] == m->by[i]; i++)
+      ;
+   if(i < o->numKeys || i < m->numKeys) by = i < m->numKeys ? m->by[i] : o->by[i];
+   else if(o->numWrites != m->numWrites || (n > 0 && (o->ix[0] != m->ix[0] || o->code[0] != m->code[0])))
+      by = S_SETCODE;
+   else if(o->end != m->end) by = m->numKeys ? m->by[m->numKeys-1] : S_ENABLEALARM;
+   else return;
+   switch(by)
+   {
+      case S_ENTERMSTCODE: o->bad |= 1 << V_ENTER; break;
+      case S_CONFIGCODES: o->bad |= 1 << V_CONFIG; break;
+      case S_SETCODE: o->bad |= 1 << V_SETCODE; break;
+      default: o->bad |= 1 << V_CHECK; break;
+   }
+}
+
+/*----------------------------------------------------
+Function: mutate
+Description: A new sequence from the corpus: one to four
+             changes (key replaced, inserted or removed, an
+             alarm code or 4 random digits inserted, part
+             repeated, the end of another entry spliced on,
+             cut short).
+------------------------------------------------------*/
+static void mutate(struct seq *q)
+{
+   const struct seq *o;
+   int changes = 1 + (int)(nextRandom() % 4), p, i, n;
+   char c;
+
+   *q = corpus[nextRandom() % numCorpus];
+   while(changes-- > 0)
+   {
+      p = q->n ? (int)(nextRandom() % (q->n + 1)) : 0;
+      switch(nextRandom() % 8)
+      {
+         case 0:
+            if(p < q->n) q->k[p] = keys[nextRandom() % 16];
+            break;
+         case 1:
+         case 2:
+            if(q->n == maxKeys) break;
+            c = (nextRandom() & 1) ? keys[nextRandom() % 10] : keys[nextRandom() % 16];
+            memmove(&q->k[p+1], &q->k[p], q->n - p);
+            q->k[p] = c;
+            q->n++;
+            break;
+         case 3:
+            if(p < q->n)
+            {
+               memmove(&q->k[p], &q->k[p+1], q->n - p - 1);
+               q->n--;
+            }
+            break;
+         case 4:  // a code
+            if(q->n + 4 > maxKeys) break;
+            i = (int)(nextRandom() % 6);
+            n = i < 5 && codes[i] <= 9999 ? codes[i] : (int)(nextRandom() % 10000);
+            memmove(&q->k[p+4], &q->k[p], q->n - p);
+            for(i = 3; i >= 0; i--, n /= 10) q->k[p+i] = (char)('0' + n % 10);
+            q->n += 4;
+            break;
+         case 5:  // repeat a part
+            n = 1 + (int)(nextRandom() % 4);
+            if(p + n > q->n || q->n + n > maxKeys) break;
+            memmove(&q->k[p+n], &q->k[p], q->n - p);
+            q->n += n;
+            break;
+         case 6:
+            o = &corpus[nextRandom() % numCorpus];
+            i = o->n ? (int)(nextRandom() % o->n) : 0;
+            n = o->n - i;
+            if(p + n > maxKeys) n = maxKeys - p;
+            memcpy(&q->k[p], &o->k[i], n);
+            q->n = p + n;
+            break;
+         default:
+            q->n = p;
+            break;
+      }
+   }
+}
+
+/*----------------------------------------------------
+Function: attempt
+Description: Runs q on the firmware (o) and the model (m)
+             of the target and checks them.  Returns the new
+             edges.
+------------------------------------------------------*/
+static int attempt(char menuKey, const struct seq *q, struct outcome *o, struct outcome *m)
+{
+   int fresh = run(q, o);
+
+   if(menuKey == 'a') modelArm(q, m);
+   else modelConfig(q, m);
+   check(o, m);
+   return(fresh);
+}
+
+/*----------------------------------------------------
+Function: shrink
+Description: Removes the keys of the example of kind one
+             at a time while the violation stays.
+------------------------------------------------------*/
+static void shrink(char menuKey, int kind)
+{
+   struct example *e = &examples[kind];
+   struct seq q;
+   struct outcome o, m;
+   int i = 0;
+
+   while(i < e->seq.n)
+   {
+      q = e->seq;
+      memmove(&q.k[i], &q.k[i+1], q.n - i - 1);
+      q.n--;
+      attempt(menuKey, &q, &o, &m);
+      if(o.bad & (1u << kind))
+      {
+         e->seq = q;
+         e->fw = o;
+         e->model = m;
+      }
+      else i++;
+   }
+}
+
+static void printSeq(const struct seq *q)
+{
+   printf("\"%.*s\" (%d keys)", q->n, q->k, q->n);
+}
+
+static void printOutcome(const char *who, const struct outcome *o)
+{
+   int i;
+
+   printf("            %-8s %2d keys", who, o->numKeys);
+   for(i = 0; i < o->numWrites && i < MAXWRITES; i++)
+      if(o->code[i] == 0xFFFF) printf(", disables %u", o->ix[i]);
+      else printf(", writes %u to %u", o->code[i], o->ix[i]);
+   printf(", %s\n", ends[o->end]);
+}
+
+static void addCorpus(const struct seq *q)
+{
+   if(numCorpus < MAXCORPUS) corpus[numCorpus++] = *q;
+}
+
+/*----------------------------------------------------
+Function: fuzz
+Description: Fuzzes one target (arm: 'a' at the menu,
+             config: 'c') for runs or seconds.  Returns 1
+             on a violation, -1 on an error.
+------------------------------------------------------*/
+static int fuzz(char menuKey, unsigned long runs, double seconds)
+{
+   struct seq q;
+   struct outcome o, m;
+   double t0, wall;
+   unsigned long n, found = 0, restores, lines;
+   int i, j, seeds, total, both, branches, seedEdges = 0;
+
+   memset(edges, 0, sizeof(edges));
+   memset(reached, 0, sizeof(reached));
+   memset(branch, 0, sizeof(branch));
+   memset(taken, 0, sizeof(taken));
+   memset(examples, 0, sizeof(examples));
+   numEdges = numCorpus = 0;
+   insts = 0;
+   if(boot(menuKey) != 0) return(-1);
+   printf("\ntarget %s: '%c' at the menu, snapshot at %.3f s (readKey from %s), %u bytes\n",
+          menuKey == 'a' ? "arm" : "config", menuKey, simTimeUs(&cpu) / 1e6,
+          menuKey == 'a' ? "enableAlarm" : "enterMstCode", (unsigned)sizeof(struct hcs12));
+   if((short)hcs12Read16(&cpu, syms[S_MULT].addr) != 1000 || hcs12Read16(&cpu, syms[S_ALARMCODE].addr) != 0)
+      printf("   checkCode has digits left from before the prompt\n");
+
+   // seeds: nothing, and each alarm code
+   q.n = 0;
+   addCorpus(&q);
+   for(i = 0; i < 5; i++)
+      if(codes[i] <= 9999)
+      {
+         sprintf(q.k, "%04u", codes[i]);
+         q.n = 4;
+         addCorpus(&q);
+      }
+   seeds = numCorpus;
+
+   t0 = wallSeconds();
+   for(n = 0; n < runs; n++)
+   {
+      if(n < (unsigned long)seeds) q = corpus[n];
+      else mutate(&q);
+      j = attempt(menuKey, &q, &o, &m);
+      if(n < (unsigned long)seeds) seedEdges = numEdges;
+      else if(j > 0) addCorpus(&q);
+      for(i = 0; i < NUMKINDS; i++)
+      {
+         struct example *e = &examples[i];
+         if(!(o.bad & (1u << i))) continue;
+         if(e->count++ == 0)
+         {
+            e->seq = q;
+            e->fw = o;
+            e->model = m;
+         }
+         found++;
+      }
+      if((n & 1023) == 0 && seconds > 0 && wallSeconds() - t0 > seconds)
+      {
+         n++;
+         break;
+      }
+   }
+   wall = wallSeconds() - t0;
+   snapStats(snap, &restores, &lines);
+
+   printf("   %lu runs in %.2f s: %.0f runs/s, %.1f MIPS, %.1f lines (%d bytes) restored per run\n",
+          n, wall, n / wall, insts / wall / 1e6, (double)lines / restores, SNAP_LINE);
+   printf("   corpus %d sequences, %d branch edges (%d from the seeds)\n", numCorpus, numEdges,
+          seedEdges);
+   printf("   %-14s %12s %10s\n", "coverage", "instructions", "branches");
+   for(i = 0; i < NUMCOVERED; i++)
+   {
+      const int f = covered[i];
+      for(j = syms[f].addr, total = both = branches = 0; j < syms[f].addr + syms[f].size; j++)
+      {
+         total += reached[j];
+         branches += branch[j] >= 2;
+         both += branch[j] == 3;
+      }
+      if(total == 0) continue;  // the other target
+      printf("   %-14s %12d %5d/%-4d both ways\n", syms[f].name, total, both, branches);
+      if(verbose)
+         for(j = syms[f].addr; j < syms[f].addr + syms[f].size; j++)
+            if(branch[j] == 2) printf("      %04X only to %04X\n", j, taken[j]);
+   }
+   if(verbose)
+      for(i = 0; i < numCorpus; i++)
+      {
+         printf("   corpus %4d: ", i);
+         printSeq(&corpus[i]);
+         printf("\n");
+      }
+
+   if(found == 0)
+   {
+      printf("   no violations\n");
+      return(0);
+   }
+   printf("   violations:\n");
+   for(i = 0; i < NUMKINDS; i++)
+   {
+      struct example *e = &examples[i];
+      if(e->count == 0) continue;
+      shrink(menuKey, i);
+      printf("      %-54s %9lu runs, e.g. ", kinds[i], e->count);
+      printSeq(&e->seq);
+      printf("\n");
+      printOutcome("firmware", &e->fw);
+      if(i >= V_CHECK && i <= V_SETCODE) printOutcome("model", &e->model);
+   }
+   return(1);
+}
+
+int main(int argc, char *argv[])
+{
+   const char *file = NULL, *map = NULL;
+   unsigned long runs = 200000;
+   double seconds = 0.0;
+   int arm = 1, config = 1, bad = 0, r, i;
+
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-a") == 0) config = 0;
+      else if(strcmp(argv[i], "-c") == 0) arm = 0;
+      else if(strcmp(argv[i], "-v") == 0) verbose = 1;
+      else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) map = argv[++i];
+      else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) runs = strtoul(argv[++i], NULL, 0);
+      else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+      else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) maxKeys = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) rnd = strtoull(argv[++i], NULL, 0);
+      else if(argv[i][0] != '-' && file == NULL) file = argv[i];
+      else usage();
+   }
+   if(file == NULL || map == NULL || (!arm && !config) || maxKeys < 4 || maxKeys > MAXKEYS) usage();
+   if(loadSymbols(map) != 0) return(1);
+   imageInit(&img);
+   if(loadS19(&img, file) != 0) return(1);
+
+   printf("hcs12fuzz %s, %lu runs per target, up to %d keys, seed %llu\n", file, runs, maxKeys, rnd);
+   if(arm && (r = fuzz('a', runs, seconds)) != 0) bad = r < 0 ? -1 : 1;
+   if(config && bad >= 0 && (r = fuzz('c', runs, seconds)) != 0) bad = r < 0 ? -1 : 1;
+   return(bad < 0 ? 1 : bad ? 2 : 0);
+}
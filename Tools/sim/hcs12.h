@@ -0,0 +1,446 @@
+/*------------------------------------------------
+ * File: hcs12.h
+ * Description: HCS12 (MC9S12DG256) instruction set
+ *              simulator - CPU, memory and the
+ *              peripherals used by the labs.
+ *
+ *              Time is counted in bus cycles.  The cycle
+ *              count of every instruction is the HCS12
+ *              column of the CPU12 Reference Manual
+ *              (Appendix A).
+--------------------------------------------------*/
+#ifndef _HCS12_H
+#define _HCS12_H
+
+#include <stdio.h>
+
+typedef unsigned char byte;
+typedef unsigned short word;
+
+// Memory map
+#define REG_END     0x0400  // $0000-$03FF registers
+#define EE_START    0x0400  // $0400-$0FFF EEPROM
+#define RAM_START   0x1000  // $1000-$3FFF RAM
+#define FLASH_START 0x4000  // $4000-$7FFF page $3E
+#define WIN_START   0x8000  // $8000-$BFFF PPAGE window
+#define WIN_END     0xC000  // $C000-$FFFF page $3F
+#define PAGE_SIZE   0x4000
+#define NUMPAGES    16      // PPAGE $30-$3F
+#define FIRST_PAGE  0x30
+
+// CCR bits
+#define CC_S 0x80
+#define CC_X 0x40
+#define CC_H 0x20
+#define CC_I 0x10
+#define CC_N 0x08
+#define CC_Z 0x04
+#define CC_V 0x02
+#define CC_C 0x01
+
+// Vectors
+#define VEC_RESET  0xFFFE
+#define VEC_TRAP   0xFFF8
+#define VEC_SWI    0xFFF6
+#define VEC_TC0    0xFFEE
+#define VEC_TC7    0xFFE0
+#define VEC_SCI0   0xFFD6
+
+// Run states
+#define ST_RUN   0
+#define ST_WAIT  1  // WAI, waiting for an interrupt
+#define ST_HALT  2  // BGND, STOP, SWI under DBug12 or an error
+#define ST_DONE  3  // stopped by the driver (time, input exhausted)
+
+// Outputs reported to onOutput
+#define OUT_LCD 0   // instruction or data byte executed by the LCD
+#define OUT_PTT 1   // a Port T pin changed
+
+// Call frames (shadow of the stack, for measuring routines)
+#define FR_CALL 0   // JSR, BSR or CALL
+#define FR_IRQ  1   // interrupt
+#define MAXFRAMES 64
+
+#define MAXPRESSES 256 // key presses and switch changes (see keypad.c)
+#define MAXSWITCHES 256
+#define MAXTEMPS 256
+#define EE_SECTOR 4    // EEPROM sector (bytes, see eeprom.c)
+#define EE_SECTORS ((RAM_START - EE_START) / EE_SECTOR)
+#define LCD_SEEN 32    // LCD violations printed (see lcd.c)
+#define SNAP_LINE 64   // bytes of RAM and EEPROM restored together (see snapshot.c)
+#define SNAP_LINES ((FLASH_START - EE_START) / SNAP_LINE)
+
+// Interrupt latency (see irq.c)
+#define IRQ_VECTORS 64   // $FF80-$FFFE
+#define IRQ_BINS 24      // histogram bins, powers of 2 of bus cycles
+#define IRQ_RING 64      // last instructions kept for the worst case trace
+
+// Idle loops (see idle.c)
+#define LOOP_BODY 64   // longest loop body (bytes)
+#define LOOP_INSTS 32  // instructions of one pass kept for the profile
+
+/*------------------------------------------------
+ Program image, shared read only by the instances
+ that run it.
+--------------------------------------------------*/
+struct image
+{
+   byte flash[NUMPAGES][PAGE_SIZE];  // pages $30-$3F
+   byte low[FLASH_START];            // $0000-$3FFF as loaded (EEPROM, RAM)
+   int lowLoaded;                    // anything loaded below $4000
+   word entry;                       // S9 record address (0 if none)
+};
+
+#define LINEAR_SIZE (0x10000UL + NUMPAGES * PAGE_SIZE)  // see hcs12Linear
+
+struct frame
+{
+   unsigned long func;        // routine (linear address of the call target)
+   unsigned long site;        // linear address of the JSR/BSR/CALL
+   word sp;                   // SP before the call/interrupt
+   byte kind;
+   unsigned long long start;  // cycles at entry
+   unsigned long long irq;    // cycles spent in interrupts taken inside
+};
+
+/*------------------------------------------------
+ Enhanced capture timer (output compare only)
+--------------------------------------------------*/
+struct timer
+{
+   word tcnt;
+   unsigned frac;                 // bus cycles into the current tick
+   unsigned long long sync;       // cycle of the last update of tcnt
+   unsigned long long next;       // cycle of the next compare match
+   unsigned long long flagAt[8];  // cycle each flag was set (match)
+   unsigned long long enabledAt[8];  // cycle each interrupt was enabled (TIE)
+};
+
+/*------------------------------------------------
+ Interrupt latency and duration by vector (see
+ irq.c)
+--------------------------------------------------*/
+struct irqStep
+{
+   unsigned long at;              // instruction (hcs12Linear)
+   unsigned long long cycle;      // cycles when it started
+   byte ccr;
+};
+
+struct irqVector
+{
+   unsigned long count, ends;      // entries and returns
+   unsigned long long latMin, latMax, latSum, durMin, durMax, durSum;
+   double latSq;                  // for the standard deviation
+   unsigned long latHist[IRQ_BINS], durHist[IRQ_BINS];
+   unsigned long long worstAt;    // request of the worst latency (cycles)
+   double worstUs;
+   unsigned long handler;         // first handler instruction
+   struct irqStep worst[IRQ_RING];   // instructions between its request and entry
+   int numWorst;
+};
+
+struct irqs
+{
+   struct irqVector vec[IRQ_VECTORS];
+   struct irqStep ring[IRQ_RING]; // last instructions
+   unsigned head;
+   struct                         // handlers running (nested)
+   {
+      int v, depth;
+      unsigned long long start;
+   } active[MAXFRAMES];
+   int numActive;
+};
+
+/*------------------------------------------------
+ Loop being watched for idle skipping: the state at
+ the last visit of its head (target of a backward
+ branch) and what the pass since then did.
+--------------------------------------------------*/
+struct loop
+{
+   word head;
+   byte ppage;
+   byte a, b, ccr;
+   word x, y, sp;
+   byte taint;                    // memory written or register read
+   unsigned long long cycles;     // cycles and instructions at the head
+   unsigned long long insts;
+   int n;                         // instructions of the pass (in at, cyc)
+   unsigned long at[LOOP_INSTS];
+   unsigned cyc[LOOP_INSTS];
+};
+
+/*------------------------------------------------
+ HD44780 LCD controller on Port K (see lcd.c)
+--------------------------------------------------*/
+struct lcd
+{
+   byte pins;                     // RS, E, DB4-DB7 as last written
+   byte fourBit, half, first;     // 4-bit mode, first nibble received
+   byte twoLines, incr, shiftOn, displayOn, cursor;
+   byte cgMode, ac;               // address counter (DDRAM or CGRAM)
+   int shift;                     // display shift
+   int resets;                    // function sets of the reset sequence
+   byte ddram[0x80];
+   byte cgram[0x40];
+   double eRise, dataChange;      // times (micro-sec)
+   double last, busyUntil;        // last instruction and end of its execution
+   unsigned long instructions, transfers, violations;
+   const char *seen[LCD_SEEN];    // violations printed (kind and PC)
+   word seenPC[LCD_SEEN];
+   int numSeen;
+   int used;                      // port K written
+   int trace;                     // prints the instructions and data
+};
+
+/*------------------------------------------------
+ Keypad presses and switch changes (see keypad.c),
+ times in micro-sec
+--------------------------------------------------*/
+struct press
+{
+   double at, hold;
+   byte key;                      // row x 4 + column
+   double seen;                   // first read that saw it (-1 if none)
+};
+
+struct change
+{
+   double at;
+   byte value;                    // Port H, bit set = switch open
+};
+
+struct reading
+{
+   double at;
+   double value;                  // temperature (deg C, see atd.c)
+};
+
+struct inputs
+{
+   struct press presses[MAXPRESSES];   // in time order
+   int numPresses;
+   struct change switches[MAXSWITCHES];
+   int numSwitches;
+   byte switch0;                  // switches before the first change
+   double bounce;                 // contact bounce after each change
+   struct reading temps[MAXTEMPS];
+   int numTemps;
+};
+
+/*------------------------------------------------
+ EEPROM controller (see eeprom.c)
+--------------------------------------------------*/
+#define EE_IDLE    0    // command sequence: nothing written
+#define EE_LATCHED 1    // array word written
+#define EE_COMMAND 2    // ECMD written
+
+struct eecmd
+{
+   byte cmd;
+   word addr, data;
+};
+
+struct eectl
+{
+   int state;                     // command sequence
+   struct eecmd cmdBuf;           // command being written
+   struct eecmd active, next;     // running and waiting in the buffer
+   int running, waiting;
+   unsigned long long doneAt;     // cycle the running command ends
+   unsigned long erases[EE_SECTORS];
+   unsigned long commands, programs, overwrites, accerr, pviol;
+   double busyUs;
+};
+
+struct hcs12
+{
+   // CPU registers
+   byte a, b;
+   word x, y, sp, pc;
+   byte ccr;
+   byte ppage;
+   int state;
+   unsigned long long cycles;
+   unsigned long long insts;
+   word lastPC;                  // address of the instruction executing
+   byte farCall;                 // last subroutine entry was a CALL
+
+   // Memory (snapshot.c copies eeprom and ram apart from the rest)
+   const struct image *img;
+   byte regs[REG_END];
+   byte eeprom[RAM_START - EE_START];
+   byte ram[FLASH_START - RAM_START];
+
+   // Peripherals
+   struct timer tim;
+   unsigned long long nextEvent; // earliest peripheral event (cycles)
+   byte irq;                     // an interrupt source is pending
+   int dbug12;                   // DBug12 monitor traps and vectors
+   double busMHz;                // current bus clock
+   double usBase;                // time at cycBase (micro-sec)
+   unsigned long long cycBase;   // cycles at the last bus clock change
+
+   struct lcd lcd;
+   struct inputs inputs;
+   struct eectl ee;
+
+   // SCI0, the terminal (see sci.c)
+   const char *in;               // characters still to be typed
+   unsigned long long inDue;     // cycle the next character arrives
+   unsigned long long inGap;     // cycles between characters
+   unsigned long long txFree;    // cycle the transmitter is free
+   int txHeld;                   // byte waiting in SCI0DRL for the shifter, -1 if none
+
+   // Shadow call stack
+   struct frame frames[MAXFRAMES];
+   int depth;
+   void (*onLeave)(struct hcs12 *, struct frame *);
+   void *user;
+   void (*onOutput)(struct hcs12 *, int);  // LCD and pin changes (OUT_...)
+   void *observer;
+   unsigned long long *pcCycles; // cycles by instruction address (hcs12Linear), or NULL
+   struct irqs *irqs;            // interrupt latency (see irq.c), or NULL
+   struct timeline *timeline;    // trace file (see timeline.c), or NULL
+
+   int quiet;                    // no LCD and EEPROM messages during the run (fleet.c)
+   struct snapshot *snap;        // marks the RAM and EEPROM written (see snapshot.c), or NULL
+   struct direct *direct;        // direct page estimate (see direct.c), or NULL
+
+   // Idle loop skipping
+   int skipIdle;                 // enabled
+   struct loop loop;
+   unsigned long long skipped;   // cycles skipped
+};
+
+// cpu.c
+void hcs12Reset(struct hcs12 *, const struct image *);
+void hcs12Step(struct hcs12 *);
+void hcs12Run(struct hcs12 *, unsigned long long);
+byte hcs12Read8(struct hcs12 *, word);
+word hcs12Read16(struct hcs12 *, word);
+void hcs12Write8(struct hcs12 *, word, byte);
+void hcs12Write16(struct hcs12 *, word, word);
+void hcs12Push16(struct hcs12 *, word);
+word hcs12Pull16(struct hcs12 *);
+unsigned long hcs12Linear(struct hcs12 *, word);
+void hcs12Return(struct hcs12 *);
+
+// idle.c
+void idleLoop(struct hcs12 *, unsigned long long);
+
+// periph.c
+void periphReset(struct hcs12 *);
+byte ioRead(struct hcs12 *, word);
+void ioWrite(struct hcs12 *, word, byte);
+void periphEvents(struct hcs12 *);
+word periphVector(struct hcs12 *);
+void periphSchedule(struct hcs12 *);
+double simTimeUs(struct hcs12 *);
+unsigned long long periphRequestAt(struct hcs12 *, word);
+unsigned periphTcnt(struct hcs12 *);
+
+// sci.c
+void sciSync(struct hcs12 *);
+byte sciStatus(struct hcs12 *);
+byte sciReceive(struct hcs12 *);
+void sciSend(struct hcs12 *, byte);
+int sciPending(struct hcs12 *);
+unsigned long long sciNext(struct hcs12 *);
+
+// srec.c
+void imageInit(struct image *);
+int loadS19(struct image *, const char *);
+
+// lcd.c
+void lcdReset(struct hcs12 *);
+void lcdPort(struct hcs12 *, byte);
+void lcdShow(struct hcs12 *, FILE *);
+void lcdLine(struct hcs12 *, int, char *);
+
+// eeprom.c
+void eepromReset(struct hcs12 *);
+void eepromWrite(struct hcs12 *, word, word, int);
+byte eepromRegRead(struct hcs12 *, word);
+void eepromRegWrite(struct hcs12 *, word, byte);
+int eepromLoad(struct hcs12 *, const char *);
+int eepromSave(struct hcs12 *, const char *);
+void eepromReport(struct hcs12 *, FILE *);
+
+// keypad.c
+int keyPress(struct hcs12 *, double, char, double);
+int switchSet(struct hcs12 *, double, byte);
+byte keypadRead(struct hcs12 *);
+byte switchRead(struct hcs12 *);
+char keypadKey(byte);
+void keypadReport(struct hcs12 *, FILE *);
+
+// atd.c
+int tempSet(struct hcs12 *, double, double);
+void atdConvert(struct hcs12 *);
+
+// scenario.c
+struct scenario;
+struct scenario *scenarioLoad(const char *);
+int scenarioStart(struct scenario *, struct hcs12 *);
+void scenarioFinish(struct scenario *, struct hcs12 *);
+double scenarioEnd(struct scenario *);
+int scenarioMetrics(struct scenario *);
+const char *scenarioMetric(struct scenario *, int, double *, double *);
+int scenarioWrite(struct hcs12 *, const char *);
+
+// profile.c
+struct profile;
+struct profile *profileNew(void);
+void profileAddSymbol(struct profile *, const char *, unsigned long, int);
+int profileLoadMap(struct profile *, const char *);
+int profileLoadLst(struct profile *, const char *);
+void profileAttach(struct profile *, struct hcs12 *);
+void profileFinish(struct profile *);
+const char *profileName(struct profile *, unsigned long, char *, int);
+long profileLookup(struct profile *, const char *);
+void profileRoutine(struct profile *, unsigned long, FILE *);
+void profileRoutines(struct profile *, int, FILE *);
+void profileFlat(struct profile *, FILE *);
+void profileGraph(struct profile *, FILE *);
+int profileWrite(struct profile *, const char *);
+void profileStats(struct profile *, unsigned long, unsigned long *, unsigned long long *);
+
+// irq.c
+struct irqs *irqNew(void);
+void irqEnter(struct hcs12 *, word);
+void irqLeave(struct hcs12 *, int);
+void irqTrace(struct hcs12 *);
+void irqReport(struct hcs12 *, struct profile *, FILE *);
+
+// timeline.c
+struct timeline;
+struct timeline *timelineOpen(const char *, struct profile *, double);
+void timelineEnter(struct hcs12 *);
+void timelineLeave(struct hcs12 *, struct frame *);
+int timelineClose(struct hcs12 *);
+
+// snapshot.c
+struct snapshot;
+struct snapshot *snapTake(struct hcs12 *);
+void snapMark(struct hcs12 *, word);
+void snapRestore(struct snapshot *, struct hcs12 *);
+void snapStats(struct snapshot *, unsigned long *, unsigned long *);
+void snapFree(struct snapshot *, struct hcs12 *);
+
+// direct.c
+struct direct;
+struct direct *directNew(const char *);
+void directAccess(struct hcs12 *, word, int);
+void directReport(struct hcs12 *, struct profile *, FILE *);
+
+// dbug12.c
+void dbug12Install(struct image *);
+int dbug12Trap(struct hcs12 *);
+void dbug12Input(struct hcs12 *, const char *, double);
+word dbug12Vector(struct hcs12 *, word);
+void dbug12Symbols(struct profile *);
+
+#endif /* _HCS12_H */
@@ -0,0 +1,177 @@
+/*------------------------------------------------
+ * File: idle.c
+ * Description: Idle loop skipping.  The labs spend most
+ *              of their time in waiting loops: delayms on
+ *              timeCounter and readKey on keyCode wait for
+ *              an interrupt, pollDelay counts X down in a
+ *              loop of NOPs.
+ *
+ *              The head of a loop (target of a backward
+ *              branch) is watched.  When a pass from the
+ *              head back to it wrote nothing, read no
+ *              register and left the CPU registers as they
+ *              were, the next passes are the same until an
+ *              interrupt changes the memory, so whole passes
+ *              are added to the cycle count up to the next
+ *              peripheral event.  A loop of NOPs closed by
+ *              DEX/DEY + BNE or by DBNE/IBNE is skipped up
+ *              to its last pass.  Cycles, instruction count
+ *              and profile come out as if the passes ran.
+--------------------------------------------------*/
+#include "hcs12.h"
+
+#define NOP 0xA7
+
+// Register numbers of the DBNE post byte
+#define R_A 0
+#define R_B 1
+#define R_D 4
+#define R_X 5
+#define R_Y 6
+
+// Starts a pass at the head of the loop
+static void watch(struct hcs12 *s)
+{
+   struct loop *l = &s->loop;
+
+   l->head = s->pc;
+   l->ppage = s->ppage;
+   l->a = s->a;
+   l->b = s->b;
+   l->ccr = s->ccr;
+   l->x = s->x;
+   l->y = s->y;
+   l->sp = s->sp;
+   l->taint = 0;
+   l->cycles = s->cycles;
+   l->insts = s->insts;
+   l->n = 0;
+}
+
+// Registers as at the head, except the counter r (-1 for none)
+static int sameState(struct hcs12 *s, int r)
+{
+   struct loop *l = &s->loop;
+
+   return(s->ccr == l->ccr && s->sp == l->sp
+          && (s->a == l->a || r == R_A || r == R_D)
+          && (s->b == l->b || r == R_B || r == R_D)
+          && (s->x == l->x || r == R_X)
+          && (s->y == l->y || r == R_Y));
+}
+
+/*----------------------------------------------------
+Function: counter
+Description: Recognizes a loop of NOPs closed by DEX/DEY
+             + BNE or DBNE/IBNE.  Returns the counter
+             register (and in *up whether it counts up),
+             or -1.
+------------------------------------------------------*/
+static int counter(struct hcs12 *s, int *up)
+{
+   word br = s->lastPC, end, a;
+   byte op = hcs12Read8(s, br);
+   int r;
+
+   *up = 0;
+   if(op == 0x26 && br > s->pc)  // BNE after DEX or DEY
+   {
+      end = br - 1;
+      op = hcs12Read8(s, end);
+      if(op == 0x09) r = R_X;
+      else if(op == 0x03) r = R_Y;
+      else return(-1);
+   }
+   else if(op == 0x04)  // DBNE, IBNE
+   {
+      byte pb = hcs12Read8(s, br + 1);
+      end = br;
+      if((pb & 0xE0) == 0xA0) *up = 1;
+      else if((pb & 0xE0) != 0x20) return(-1);
+      r = pb & 0x07;
+      if(r != R_A && r != R_B && r != R_D && r != R_X && r != R_Y) return(-1);
+   }
+   else return(-1);
+   for(a = s->pc; a < end; a++)
+      if(hcs12Read8(s, a) != NOP) return(-1);
+   return(r);
+}
+
+static unsigned long getCount(struct hcs12 *s, int r)
+{
+   switch(r)
+   {
+      case R_A: return(s->a);
+      case R_B: return(s->b);
+      case R_D: return((unsigned long)s->a << 8 | s->b);
+      case R_X: return(s->x);
+      default: return(s->y);
+   }
+}
+
+static void setCount(struct hcs12 *s, int r, unsigned long v)
+{
+   switch(r)
+   {
+      case R_A: s->a = (byte)v; break;
+      case R_B: s->b = (byte)v; break;
+      case R_D: s->a = (byte)(v >> 8); s->b = (byte)v; break;
+      case R_X: s->x = (word)v; break;
+      default: s->y = (word)v; break;
+   }
+}
+
+// Adds k passes of the loop
+static void skip(struct hcs12 *s, unsigned long long k)
+{
+   struct loop *l = &s->loop;
+   unsigned long long dc = s->cycles - l->cycles;
+   int i;
+
+   s->cycles += k * dc;
+   s->insts += k * (s->insts - l->insts);
+   s->skipped += k * dc;
+   if(s->pcCycles)
+      for(i = 0; i < l->n; i++) s->pcCycles[l->at[i]] += k * l->cyc[i];
+}
+
+/*----------------------------------------------------
+Function: idleLoop
+Description: Called by the CPU loop after a backward
+             branch, jump or return (pc < lastPC).  Skips
+             the passes of the loop whose outcome is known
+             before end and the next peripheral event, then
+             watches the loop again.
+------------------------------------------------------*/
+void idleLoop(struct hcs12 *s, unsigned long long end)
+{
+   struct loop *l = &s->loop;
+   unsigned long long limit, dc, k;
+   int r, up;
+
+   if(s->pc == l->head && s->ppage == l->ppage && !l->taint
+      && (s->pcCycles == NULL || l->n <= LOOP_INSTS))
+   {
+      dc = s->cycles - l->cycles;
+      limit = s->nextEvent < end ? s->nextEvent : end;
+      k = (limit > s->cycles && dc > 0) ? (limit - s->cycles) / dc : 0;
+      if(sameState(s, -1))
+      {
+         // waiting for an interrupt (or for nothing)
+         if(k > 0) skip(s, k);
+      }
+      else if((r = counter(s, &up)) >= 0 && sameState(s, r))
+      {
+         unsigned long v = getCount(s, r);
+         unsigned long mod = (r == R_A || r == R_B) ? 0x100 : 0x10000;
+         unsigned long left = up ? mod - v : v;  // passes to the exit
+         if(k > left - 1) k = left - 1;
+         if(k > 0)
+         {
+            skip(s, k);
+            setCount(s, r, (up ? v + k : v - k) & (mod - 1));
+         }
+      }
+   }
+   watch(s);
+}
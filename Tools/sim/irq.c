@@ -0,0 +1,194 @@
+/*------------------------------------------------
+ * File: irq.c
+ * Description: Interrupt latency and duration by vector.
+ *
+ *              The latency of an interrupt is the time from
+ *              its request - the compare match that set the
+ *              flag, or the write of TIE that enabled it if
+ *              that came later - to the first instruction of
+ *              the handler, stacking included.  It grows
+ *              while the I bit is set and while a long
+ *              instruction (IDIV, EMACS...) finishes.  The
+ *              duration runs from that first instruction to
+ *              the RTI, interrupts taken inside included.
+ *
+ *              Both go into histograms with bins of powers
+ *              of 2 cycles.  The last IRQ_RING instructions
+ *              are kept, so the worst latency of each vector
+ *              comes with the instructions that ran between
+ *              its request and the handler.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "hcs12.h"
+
+#define BAR 30   // width of the histogram bars
+
+/*----------------------------------------------------
+Function: irqNew
+------------------------------------------------------*/
+struct irqs *irqNew(void)
+{
+   return(calloc(1, sizeof(struct irqs)));
+}
+
+// Histogram bin: 0, then 1, 2-3, 4-7...
+static int bin(unsigned long long v)
+{
+   int b = 0;
+
+   while(v && b < IRQ_BINS - 1)
+   {
+      v >>= 1;
+      b++;
+   }
+   return(b);
+}
+
+/*----------------------------------------------------
+Function: irqTrace
+Description: Called by the CPU loop before each
+             instruction.
+------------------------------------------------------*/
+void irqTrace(struct hcs12 *s)
+{
+   struct irqStep *st = &s->irqs->ring[s->irqs->head++ % IRQ_RING];
+
+   st->at = hcs12Linear(s, s->pc);
+   st->cycle = s->cycles;
+   st->ccr = s->ccr;
+}
+
+// Keeps the instructions from the one running at req
+static void keepWorst(struct irqs *q, struct irqVector *v, unsigned long long req)
+{
+   unsigned n = q->head < IRQ_RING ? q->head : IRQ_RING, i, first = 0;
+
+   for(i = 0; i < n; i++)
+      if(q->ring[(q->head - n + i) % IRQ_RING].cycle <= req) first = i;
+   v->numWorst = 0;
+   for(i = first; i < n; i++) v->worst[v->numWorst++] = q->ring[(q->head - n + i) % IRQ_RING];
+}
+
+/*----------------------------------------------------
+Function: irqEnter
+Description: Called when the CPU has stacked the
+             registers and is at the first instruction of
+             the handler of vec.
+------------------------------------------------------*/
+void irqEnter(struct hcs12 *s, word vec)
+{
+   struct irqs *q = s->irqs;
+   struct irqVector *v = &q->vec[(0xFFFE - vec) / 2 % IRQ_VECTORS];
+   unsigned long long req = periphRequestAt(s, vec);
+   unsigned long long lat = s->cycles > req ? s->cycles - req : 0;
+
+   if(v->count == 0 || lat < v->latMin) v->latMin = lat;
+   if(v->count == 0 || lat > v->latMax)
+   {
+      v->latMax = lat;
+      v->worstAt = req;
+      v->worstUs = simTimeUs(s) - lat / s->busMHz;
+      keepWorst(q, v, req);
+   }
+   v->count++;
+   v->latSum += lat;
+   v->latSq += (double)lat * lat;
+   v->latHist[bin(lat)]++;
+   v->handler = hcs12Linear(s, s->pc);
+   if(q->numActive < MAXFRAMES)
+   {
+      q->active[q->numActive].v = (0xFFFE - vec) / 2 % IRQ_VECTORS;
+      q->active[q->numActive].depth = s->depth - 1;
+      q->active[q->numActive++].start = s->cycles;
+   }
+}
+
+/*----------------------------------------------------
+Function: irqLeave
+Description: Called when the interrupt frame at depth is
+             left (RTI).
+------------------------------------------------------*/
+void irqLeave(struct hcs12 *s, int depth)
+{
+   struct irqs *q = s->irqs;
+   struct irqVector *v;
+   unsigned long long dur;
+
+   if(q->numActive == 0 || q->active[q->numActive-1].depth != depth) return;  // SWI, TRAP
+   q->numActive--;
+   v = &q->vec[q->active[q->numActive].v];
+   dur = s->cycles - q->active[q->numActive].start;
+   if(v->ends++ == 0 || dur < v->durMin) v->durMin = dur;
+   if(dur > v->durMax) v->durMax = dur;
+   v->durSum += dur;
+   v->durHist[bin(dur)]++;
+}
+
+// Prints "min avg max" in cycles and micro-sec
+static void line(struct hcs12 *s, FILE *out, const char *what, unsigned long long min,
+                 double avg, unsigned long long max)
+{
+   fprintf(out, "   %-8s min %6llu  avg %9.1f  max %6llu cycles  (%.3f / %.3f / %.3f us)\n",
+           what, min, avg, max, min / s->busMHz, avg / s->busMHz, max / s->busMHz);
+}
+
+/*----------------------------------------------------
+Function: irqReport
+Description: For each vector taken: latency, jitter and
+             duration, their histograms and the trace of
+             the worst latency.
+------------------------------------------------------*/
+void irqReport(struct hcs12 *s, struct profile *prof, FILE *out)
+{
+   struct irqs *q = s->irqs;
+   char name[64];
+   int i, b, lo, hi;
+
+   fprintf(out, "interrupt latency (request to first handler instruction) and duration\n");
+   for(i = 0; i < IRQ_VECTORS; i++)
+   {
+      struct irqVector *v = &q->vec[i];
+      unsigned long most = 1;
+      double avg, sd;
+      if(v->count == 0) continue;
+      for(b = 0; b < IRQ_BINS; b++)
+      {
+         if(v->latHist[b] > most) most = v->latHist[b];
+         if(v->durHist[b] > most) most = v->durHist[b];
+      }
+      avg = (double)v->latSum / v->count;
+      sd = v->latSq / v->count - avg * avg;
+      fprintf(out, "\nvector %04X %s: %lu interrupts\n", 0xFFFE - 2*i,
+              profileName(prof, v->handler, name, sizeof(name)), v->count);
+      line(s, out, "latency", v->latMin, avg, v->latMax);
+      fprintf(out, "   jitter   %llu cycles (max - min), sd %.1f\n", v->latMax - v->latMin,
+              sd > 0 ? sqrt(sd) : 0.0);
+      if(v->ends) line(s, out, "duration", v->durMin, (double)v->durSum / v->ends, v->durMax);
+
+      for(lo = 0; lo < IRQ_BINS && !v->latHist[lo] && !v->durHist[lo]; lo++) ;
+      for(hi = IRQ_BINS - 1; hi > lo && !v->latHist[hi] && !v->durHist[hi]; hi--) ;
+      fprintf(out, "   %-13s %9s %-*s %9s\n", "cycles", "latency", BAR, "", "duration");
+      for(b = lo; b <= hi; b++)
+      {
+         char range[24];
+         if(b == 0) snprintf(range, sizeof(range), "0");
+         else snprintf(range, sizeof(range), "%lu-%lu", 1UL << (b - 1), (1UL << b) - 1);
+         fprintf(out, "   %-13s %9lu %-*.*s %9lu %.*s\n", range, v->latHist[b], BAR,
+                 (int)(v->latHist[b] * BAR / most), "##############################",
+                 v->durHist[b], (int)(v->durHist[b] * BAR / most),
+                 "##############################");
+      }
+
+      fprintf(out, "   worst latency: requested at %.3f ms, then\n", v->worstUs / 1000.0);
+      if(v->numWorst == IRQ_RING) fprintf(out, "      (earlier instructions not kept)\n");
+      for(b = 0; b < v->numWorst; b++)
+      {
+         struct irqStep *st = &v->worst[b];
+         long long rel = (long long)st->cycle - (long long)v->worstAt;
+         fprintf(out, "      %+6lld  %05lX  %-28s %s\n", rel, st->at,
+                 profileName(prof, st->at, name, sizeof(name)), (st->ccr & CC_I) ? "I" : "");
+      }
+   }
+}
@@ -0,0 +1,180 @@
+/*------------------------------------------------
+ * File: keypad.c
+ * Description: Keypad and switches of the Dragon12-Plus.
+ *
+ *              The 4 x 4 keypad is on Port A: rows on
+ *              PA4-PA7 (outputs), columns on PA0-PA3 with
+ *              the pull-ups of PUCR.  A pressed key pulls its
+ *              column low when its row is driven low.  The 8
+ *              switches are on Port H (bit set = switch open,
+ *              door or window of the zone).
+ *
+ *              Key presses and switch changes are given in
+ *              advance with their times and the pins are
+ *              worked out from the time of each read, so no
+ *              event has to be scheduled.  Contacts bounce
+ *              for a set time after each change: they toggle
+ *              every 20 to 500 micro-sec, from a generator
+ *              seeded by the time of the change, so a run is
+ *              the same every time.
+--------------------------------------------------*/
+#include <stdio.h>
+#include "hcs12.h"
+
+#define R_PORTA 0x000
+#define R_DDRA  0x002
+#define R_PTH   0x260
+#define R_DDRH  0x262
+
+// Keys by row (PA4-PA7) and column (PA0-PA3), as in keyPad.c
+static const char keys[] = "123a456b789c*0#d";
+
+/*----------------------------------------------------
+Function: bouncing
+Description: State of a contact t micro-sec after a
+             change to state final at time edge, during
+             the bounce.
+------------------------------------------------------*/
+static int bouncing(struct hcs12 *s, double edge, double t, int final)
+{
+   unsigned r = (unsigned)edge * 2654435761u;
+   double at = edge;
+   int state = final;
+
+   for(;;)
+   {
+      r = r * 1103515245u + 12345u;
+      at += 20 + (r >> 16) % 481;
+      if(at > t || at >= edge + s->inputs.bounce) return(state);
+      state = !state;
+   }
+}
+
+// Contact of a key press at time t (micro-sec)
+static int contact(struct hcs12 *s, const struct press *p, double t)
+{
+   double up = p->at + p->hold;
+
+   if(t < p->at || t >= up + s->inputs.bounce) return(0);
+   if(t < p->at + s->inputs.bounce) return(bouncing(s, p->at, t, 1));
+   if(t < up) return(1);
+   return(bouncing(s, up, t, 0));
+}
+
+/*----------------------------------------------------
+Function: keyPress
+Description: Adds a key press at atMs held for holdMs.
+             Returns -1 if the key is not on the keypad
+             or the list is full.
+------------------------------------------------------*/
+int keyPress(struct hcs12 *s, double atMs, char key, double holdMs)
+{
+   struct inputs *in = &s->inputs;
+   int i, k;
+
+   for(k = 0; keys[k] != '\0' && keys[k] != key; k++) ;
+   if(keys[k] == '\0' || in->numPresses == MAXPRESSES) return(-1);
+   for(i = in->numPresses++; i > 0 && in->presses[i-1].at > atMs * 1000.0; i--)
+      in->presses[i] = in->presses[i-1];
+   in->presses[i].at = atMs * 1000.0;
+   in->presses[i].hold = holdMs * 1000.0;
+   in->presses[i].key = (byte)k;
+   in->presses[i].seen = -1.0;
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: switchSet
+Description: Port H switches become value (bit set =
+             open) at atMs.  Returns -1 if the list is
+             full.
+------------------------------------------------------*/
+int switchSet(struct hcs12 *s, double atMs, byte value)
+{
+   struct inputs *in = &s->inputs;
+   int i;
+
+   if(in->numSwitches == MAXSWITCHES) return(-1);
+   for(i = in->numSwitches++; i > 0 && in->switches[i-1].at > atMs * 1000.0; i--)
+      in->switches[i] = in->switches[i-1];
+   in->switches[i].at = atMs * 1000.0;
+   in->switches[i].value = value;
+   return(0);
+}
+
+// Key of a press (row x 4 + column)
+char keypadKey(byte k)
+{
+   return(keys[k & 0x0F]);
+}
+
+/*----------------------------------------------------
+Function: keypadRead
+Description: PORTA: the output latch for the rows and
+             the column pins.
+------------------------------------------------------*/
+byte keypadRead(struct hcs12 *s)
+{
+   struct inputs *in = &s->inputs;
+   byte ddr = s->regs[R_DDRA], out = s->regs[R_PORTA];
+   byte pins = 0xFF;  // pull-ups
+   double now = simTimeUs(s);
+   int i;
+
+   for(i = 0; i < in->numPresses && in->presses[i].at <= now; i++)
+   {
+      struct press *p = &in->presses[i];
+      byte row = 0x10 << (p->key / 4), col = 0x01 << (p->key % 4);
+      if(!(ddr & row) || (out & row) || !contact(s, p, now)) continue;
+      pins &= ~col;
+      if(p->seen < 0) p->seen = now;
+   }
+   return((out & ddr) | (pins & ~ddr));
+}
+
+/*----------------------------------------------------
+Function: switchRead
+Description: PTH: the switches as set at the time of the
+             read, bouncing after each change.
+------------------------------------------------------*/
+byte switchRead(struct hcs12 *s)
+{
+   struct inputs *in = &s->inputs;
+   byte ddr = s->regs[R_DDRH], v = in->switch0, before = v;
+   double now = simTimeUs(s);
+   int i, bit;
+
+   for(i = 0; i < in->numSwitches && in->switches[i].at <= now; i++)
+   {
+      before = v;
+      v = in->switches[i].value;
+   }
+   if(i > 0 && now < in->switches[i-1].at + in->bounce)
+      for(bit = 0; bit < 8; bit++)
+         if((v ^ before) & (1 << bit))
+         {
+            if(bouncing(s, in->switches[i-1].at, now, (v >> bit) & 1)) v |= 1 << bit;
+            else v &= ~(1 << bit);
+         }
+   return((s->regs[R_PTH] & ddr) | (v & ~ddr));
+}
+
+/*----------------------------------------------------
+Function: keypadReport
+Description: Key presses with the delay until the
+             keypad scan first saw them.
+------------------------------------------------------*/
+void keypadReport(struct hcs12 *s, FILE *out)
+{
+   struct inputs *in = &s->inputs;
+   int i;
+
+   for(i = 0; i < in->numPresses; i++)
+   {
+      struct press *p = &in->presses[i];
+      fprintf(out, "key %c at %10.3f ms, held %7.3f ms", keypadKey(p->key), p->at / 1000.0,
+              p->hold / 1000.0);
+      if(p->seen >= 0) fprintf(out, ", first seen after %.3f ms\n", (p->seen - p->at) / 1000.0);
+      else fprintf(out, ", not seen\n");
+   }
+}
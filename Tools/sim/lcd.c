@@ -0,0 +1,305 @@
+/*------------------------------------------------
+ * File: lcd.c
+ * Description: HD44780 LCD controller on Port K, as
+ *              wired on the Dragon12-Plus: RS on PK0, E on
+ *              PK1, DB4-DB7 on PK2-PK5, R/W tied low (the
+ *              busy flag cannot be read).
+ *
+ *              A transfer is latched on the falling edge of
+ *              E.  The controller starts in 8-bit mode (one
+ *              transfer per instruction, DB0-DB3 low) and
+ *              takes two transfers per byte after a function
+ *              set with DL = 0.  Each transfer is checked
+ *              against the HD44780U timing at 5 V:
+ *
+ *                E high (PWEH)             230 ns
+ *                E cycle (tcycE)           500 ns
+ *                data setup (tDSW)          80 ns
+ *                RS stable while E is high
+ *                execution (fosc 270 kHz)  37 us, data 41 us,
+ *                                          clear/home 1.52 ms
+ *                after power on             15 ms
+ *                reset sequence        4.1 ms after the 1st
+ *                function set, 100 us after the 2nd
+ *
+ *              RS and the data bits change in the same port
+ *              write as E rises in lcd.asm, which the board
+ *              relies on, so the address setup time is not
+ *              checked.  With 2 lines, DDRAM addresses 28-3F
+ *              show on line 2 as on the board (lcdDisp.c sets
+ *              line 2 at 40 decimal); 68-7F are violations.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define RS   0x01
+#define E    0x02
+#define DATA 0x3C   // DB4-DB7
+
+// Times in micro-sec
+#define PWEH      0.23
+#define TCYCE     0.5
+#define TDSW      0.08
+#define T_EXEC    37.0
+#define T_DATA    41.0    // 37 us + tADD
+#define T_HOME    1520.0
+#define T_POWERON 15000.0
+#define T_RESET1  4100.0
+#define T_RESET2  100.0
+
+/*----------------------------------------------------
+Function: violation
+Description: Counts a violation and prints the first one
+             of each kind at each PC.  need is 0 for the
+             violations that are not about time.
+------------------------------------------------------*/
+static void violation(struct hcs12 *s, const char *what, double need, double got)
+{
+   struct lcd *l = &s->lcd;
+   int i;
+
+   l->violations++;
+   if(s->quiet) return;
+   for(i = 0; i < l->numSeen; i++)
+      if(l->seen[i] == what && l->seenPC[i] == s->lastPC) return;
+   if(l->numSeen == LCD_SEEN) return;
+   l->seen[l->numSeen] = what;
+   l->seenPC[l->numSeen++] = s->lastPC;
+   printf("LCD: %s at %.3f ms (PC %04X)", what, simTimeUs(s) / 1000.0, s->lastPC);
+   if(need > 0) printf(": %.3f us, needs %.3f us", got, need);
+   printf("\n");
+}
+
+/*----------------------------------------------------
+Function: lcdReset
+Description: Power on: 8-bit mode, 1 line, display off,
+             DDRAM filled with spaces, busy for 15 ms.
+------------------------------------------------------*/
+void lcdReset(struct hcs12 *s)
+{
+   struct lcd *l = &s->lcd;
+   int trace = l->trace;
+
+   memset(l, 0, sizeof(*l));
+   memset(l->ddram, ' ', sizeof(l->ddram));
+   l->trace = trace;
+   l->incr = 1;
+   l->eRise = -1e9;
+   l->busyUntil = T_POWERON;
+}
+
+// Next address counter value (I/D, 1 or 2 lines)
+static byte step(struct lcd *l, byte ac, int incr)
+{
+   if(l->cgMode) return((ac + (incr ? 1 : -1)) & 0x3F);
+   if(l->twoLines)
+   {
+      if(incr) return(ac == 0x27 ? 0x40 : ac == 0x67 ? 0x00 : ac + 1);
+      return(ac == 0x00 ? 0x67 : ac == 0x40 ? 0x27 : ac - 1);
+   }
+   if(incr) return(ac >= 0x4F ? 0x00 : ac + 1);
+   return(ac == 0x00 ? 0x4F : ac - 1);
+}
+
+static void shiftDisplay(struct lcd *l, int right)
+{
+   int n = l->twoLines ? 40 : 80;
+   l->shift = (l->shift + (right ? n - 1 : 1)) % n;
+}
+
+/*----------------------------------------------------
+Function: execute
+Description: Runs an instruction (rs = 0) or writes a
+             data byte, and returns its execution time.
+------------------------------------------------------*/
+static double execute(struct hcs12 *s, byte v, int rs)
+{
+   struct lcd *l = &s->lcd;
+
+   if(l->trace) printf("LCD %10.3f ms  %s $%02X\n", simTimeUs(s) / 1000.0, rs ? "data " : "instr", v);
+   if(rs)
+   {
+      if(l->cgMode) l->cgram[l->ac & 0x3F] = v;
+      else l->ddram[l->ac & 0x7F] = v;
+      l->ac = step(l, l->ac, l->incr);
+      if(l->shiftOn && !l->cgMode) shiftDisplay(l, !l->incr);
+      return(T_DATA);
+   }
+   if(v & 0x80)  // set DDRAM address
+   {
+      byte a = v & 0x7F;
+      if(l->twoLines && a >= 0x28 && a < 0x40)
+         a = a - 0x28 + 0x40;  // line 2 on the board, which lcdDisp.c relies on (address 40)
+      else if(l->twoLines && a >= 0x68)
+      {
+         violation(s, "DDRAM address not on a 2 line display", 0, 0);
+         a = 0x40;
+      }
+      l->ac = a;
+      l->cgMode = 0;
+   }
+   else if(v & 0x40)  // set CGRAM address
+   {
+      l->ac = v & 0x3F;
+      l->cgMode = 1;
+   }
+   else if(v & 0x20)  // function set
+   {
+      if(!l->fourBit && !(v & 0x10)) l->half = 0;
+      l->fourBit = !(v & 0x10);
+      l->twoLines = (v & 0x08) != 0;
+   }
+   else if(v & 0x10)  // cursor or display shift
+   {
+      if(v & 0x08) shiftDisplay(l, (v & 0x04) != 0);
+      else l->ac = step(l, l->ac, (v & 0x04) != 0);
+   }
+   else if(v & 0x08)  // display on/off control
+   {
+      l->displayOn = (v & 0x04) != 0;
+      l->cursor = v & 0x03;
+   }
+   else if(v & 0x04)  // entry mode set
+   {
+      l->incr = (v & 0x02) != 0;
+      l->shiftOn = v & 0x01;
+   }
+   else if(v & 0x02)  // return home
+   {
+      l->ac = 0;
+      l->cgMode = 0;
+      l->shift = 0;
+      return(T_HOME);
+   }
+   else if(v & 0x01)  // clear display
+   {
+      memset(l->ddram, ' ', sizeof(l->ddram));
+      l->ac = 0;
+      l->cgMode = 0;
+      l->shift = 0;
+      l->incr = 1;
+      return(T_HOME);
+   }
+   return(T_EXEC);
+}
+
+/*----------------------------------------------------
+Function: latch
+Description: Falling edge of E: takes the nibble on
+             DB4-DB7 and runs the instruction or data
+             write once it is complete.
+------------------------------------------------------*/
+static void latch(struct hcs12 *s, double now)
+{
+   struct lcd *l = &s->lcd;
+   byte nibble = (byte)((l->pins & DATA) << 2);   // DB7-DB4 in the upper nibble
+   int rs = l->pins & RS;
+   double t;
+
+   l->transfers++;
+   if(now - l->eRise < PWEH) violation(s, "E pulse too short", PWEH, now - l->eRise);
+   if(now - l->dataChange < TDSW) violation(s, "data changed just before E fell", TDSW,
+                                             now - l->dataChange);
+   if(!(l->fourBit && l->half) && now < l->busyUntil)  // start of an instruction
+   {
+      if(l->instructions == 0) violation(s, "first transfer before the power on delay", T_POWERON, now);  // reset = power on
+      else violation(s, "transfer while busy", l->busyUntil - l->last, now - l->last);
+   }
+   if(l->fourBit && !l->half)  // first nibble
+   {
+      l->first = nibble;
+      l->half = 1;
+      return;
+   }
+   if(l->fourBit)
+   {
+      l->half = 0;
+      t = execute(s, l->first | nibble >> 4, rs);
+   }
+   else  // 8-bit mode: one transfer per instruction (DB0-DB3 low)
+   {
+      t = execute(s, nibble, rs);
+      if(!rs && (nibble & 0x30) == 0x30 && l->resets < 2)  // reset sequence
+         t = (l->resets++ == 0) ? T_RESET1 : T_RESET2;
+   }
+   l->instructions++;
+   l->last = now;
+   l->busyUntil = now + t;
+   if(s->onOutput) s->onOutput(s, OUT_LCD);
+}
+
+/*----------------------------------------------------
+Function: lcdPort
+Description: Called on a write of PORTK or DDRK with the
+             levels of the output pins.
+------------------------------------------------------*/
+void lcdPort(struct hcs12 *s, byte pins)
+{
+   struct lcd *l = &s->lcd;
+   double now = simTimeUs(s);
+   byte changed = (pins ^ l->pins) & (RS | E | DATA);
+
+   if(!changed) return;
+   l->used = 1;
+   if((l->pins & E) && (changed & RS))
+      violation(s, "RS changed while E is high", PWEH, now - l->eRise);
+   if(changed & (RS | DATA)) l->dataChange = now;
+   if(changed & E)
+   {
+      if(pins & E)
+      {
+         if(now - l->eRise < TCYCE) violation(s, "E cycle too short", TCYCE, now - l->eRise);
+         l->eRise = now;
+         l->pins = pins;
+         return;
+      }
+      l->pins = pins;
+      latch(s, now);
+      return;
+   }
+   l->pins = pins;
+}
+
+/*----------------------------------------------------
+Function: lcdLine
+Description: Line 0 or 1 of the 2 x 16 display as it
+             reads (16 characters and a '\0').
+------------------------------------------------------*/
+void lcdLine(struct hcs12 *s, int line, char *text)
+{
+   struct lcd *l = &s->lcd;
+   int i;
+
+   for(i = 0; i < 16; i++)
+   {
+      int a;
+      byte c;
+      if(l->twoLines) a = (line ? 0x40 : 0x00) + (l->shift + i) % 40;
+      else a = (line ? 40 : 0) + (l->shift + i) % 80;   // 1 line: second half not shown
+      c = l->ddram[a & 0x7F];
+      if(!l->displayOn || (!l->twoLines && line)) c = ' ';
+      text[i] = (c >= 0x20 && c < 0x7F) ? (char)c : (c < 0x08 ? '#' : '?');
+   }
+   text[16] = '\0';
+}
+
+/*----------------------------------------------------
+Function: lcdShow
+Description: Prints the 2 x 16 display as it reads.
+------------------------------------------------------*/
+void lcdShow(struct hcs12 *s, FILE *out)
+{
+   struct lcd *l = &s->lcd;
+   char text[17];
+   int line;
+
+   fprintf(out, "LCD +----------------+  %lu transfers, %lu violations\n", l->transfers,
+           l->violations);
+   for(line = 0; line < 2; line++)
+   {
+      lcdLine(s, line, text);
+      fprintf(out, "    |%s|\n", text);
+   }
+   fprintf(out, "    +----------------+\n");
+}
@@ -0,0 +1,392 @@
+/*------------------------------------------------
+ * File: periph.c
+ * Description: Peripherals of the simulator - clock
+ *              generator (PLL), PPAGE, HPRIO, the timer
+ *              output compare channels, SCI0 (sci.c),
+ *              the LCD on Port K (lcd.c), the keypad and
+ *              switches on Ports A and H (keypad.c), the
+ *              EEPROM controller (eeprom.c) and ATD0 (atd.c).
+ *              Other registers behave as RAM.
+ *
+ *              The timer is updated lazily: TCNT is brought
+ *              up to date from the cycle count when it is
+ *              read, when a timer register is written and at
+ *              the cycle of the next compare match
+ *              (nextEvent), so the CPU loop only compares
+ *              two counters between instructions.
+--------------------------------------------------*/
+#include <string.h>
+#include "hcs12.h"
+
+// Register addresses
+#define R_PORTA  0x000
+#define R_PPAGE  0x030
+#define R_PORTK  0x032
+#define R_DDRK   0x033
+#define R_HPRIO  0x01F
+#define R_SYNR   0x034
+#define R_REFDV  0x035
+#define R_CRGFLG 0x037
+#define R_CLKSEL 0x039
+#define R_PLLCTL 0x03A
+#define R_TIOS   0x040
+#define R_CFORC  0x041
+#define R_TCNT   0x044
+#define R_TSCR1  0x046
+#define R_TCTL1  0x048
+#define R_TCTL2  0x049
+#define R_TIE    0x04C
+#define R_TSCR2  0x04D
+#define R_TFLG1  0x04E
+#define R_TC0    0x050
+#define R_TC7END 0x060
+#define R_ATDCTL5  0x085
+#define R_ATDSTAT0 0x086
+#define R_EEREGS 0x110    // EEPROM controller $110-$11B
+#define R_EEEND  0x11C
+#define R_SC0BDH 0x0C8
+#define R_SC0BDL 0x0C9
+#define R_SC0CR2 0x0CB
+#define R_SC0SR1 0x0CC
+#define R_SC0DRL 0x0CF
+#define R_PTT    0x240
+#define R_PTH    0x260
+
+// Register bits
+#define LOCK   0x08
+#define PLLON  0x40
+#define PLLSEL 0x80
+#define TEN    0x80
+#define TFFCA  0x10
+
+#define OSC_MHZ 8.0     // Dragon12-Plus crystal
+#define NEVER (~0ULL)
+
+/*----------------------------------------------------
+Function: periphReset
+Description: Register reset values.  Under DBug12 the
+             monitor has already set the 24 MHz bus and
+             9600 baud.
+------------------------------------------------------*/
+void periphReset(struct hcs12 *s)
+{
+   memset(s->regs, 0, sizeof(s->regs));
+   memset(&s->tim, 0, sizeof(s->tim));
+   s->regs[R_HPRIO] = 0xF2;
+   s->regs[R_PLLCTL] = 0xF1 & ~PLLON;
+   s->regs[R_SC0BDL] = 0x04;
+   s->txHeld = -1;
+   s->busMHz = OSC_MHZ / 2;
+   s->usBase = 0.0;
+   s->cycBase = 0;
+   if(s->dbug12)
+   {
+      s->regs[R_SYNR] = 2;
+      s->regs[R_PLLCTL] |= PLLON;
+      s->regs[R_CLKSEL] = PLLSEL;
+      s->regs[R_CRGFLG] = LOCK;
+      s->regs[R_SC0BDL] = 156;  // 9600 baud
+      s->busMHz = 24.0;
+   }
+   s->regs[R_PPAGE] = s->ppage;
+   s->nextEvent = NEVER;
+   s->irq = 0;
+   lcdReset(s);
+   eepromReset(s);
+}
+
+/*----------------------------------------------------
+Function: simTimeUs
+Description: Simulated time (micro-sec) of the current
+             cycle count.
+------------------------------------------------------*/
+double simTimeUs(struct hcs12 *s)
+{
+   return(s->usBase + (s->cycles - s->cycBase) / s->busMHz);
+}
+
+// Bus clock from the CRG registers
+static void setClock(struct hcs12 *s)
+{
+   double mhz = OSC_MHZ / 2;
+
+   if((s->regs[R_CLKSEL] & PLLSEL) && (s->regs[R_PLLCTL] & PLLON))
+      mhz = OSC_MHZ * (s->regs[R_SYNR] + 1) / (s->regs[R_REFDV] + 1);
+   if(mhz != s->busMHz)
+   {
+      s->usBase = simTimeUs(s);
+      s->cycBase = s->cycles;
+      s->busMHz = mhz;
+   }
+}
+
+/*----------------------------------------------------
+Function: compareAction
+Description: Output action of channel ch on its pin of
+             Port T (TCTL1/TCTL2), on a match or a forced
+             compare.
+------------------------------------------------------*/
+static void compareAction(struct hcs12 *s, int ch)
+{
+   byte old = s->regs[R_PTT];
+   int action = (ch >= 4) ? s->regs[R_TCTL1] >> (2*(ch-4)) : s->regs[R_TCTL2] >> (2*ch);
+
+   switch(action & 3)
+   {
+      case 1: s->regs[R_PTT] ^= 1 << ch; break;
+      case 2: s->regs[R_PTT] &= ~(1 << ch); break;
+      case 3: s->regs[R_PTT] |= 1 << ch; break;
+   }
+   if(s->regs[R_PTT] != old && s->onOutput) s->onOutput(s, OUT_PTT);
+}
+
+/*----------------------------------------------------
+Function: timerSync
+Description: Brings TCNT up to the current cycle and sets
+             the flags (and output actions) of the channels
+             matched on the way.
+------------------------------------------------------*/
+static void timerSync(struct hcs12 *s)
+{
+   struct timer *t = &s->tim;
+   int pr = s->regs[R_TSCR2] & 0x07;
+   unsigned long long total;
+   unsigned long ticks;
+   word old;
+   int ch;
+
+   if(!(s->regs[R_TSCR1] & TEN))
+   {
+      t->sync = s->cycles;
+      return;
+   }
+   total = t->frac + (s->cycles - t->sync);
+   ticks = (unsigned long)(total >> pr);
+   if(ticks == 0)
+   {
+      t->sync = s->cycles;
+      t->frac = (unsigned)total;
+      return;
+   }
+   old = t->tcnt;
+   t->tcnt += (word)ticks;
+
+   for(ch = 0; ch < 8; ch++)
+   {
+      word tc;
+      unsigned long k;
+      if(!(s->regs[R_TIOS] & (1 << ch))) continue;
+      tc = (word)(s->regs[R_TC0 + 2*ch] << 8 | s->regs[R_TC0 + 2*ch + 1]);
+      if(ticks < 0x10000 && (word)(tc - old - 1) >= ticks) continue;  // not in (old, new]
+      k = (word)(tc - old);  // ticks to the match
+      if(k == 0) k = 0x10000;
+      if(!(s->regs[R_TFLG1] & (1 << ch)))
+         t->flagAt[ch] = t->sync + ((unsigned long long)k << pr) - t->frac;
+      s->regs[R_TFLG1] |= 1 << ch;
+      compareAction(s, ch);
+   }
+   t->sync = s->cycles;
+   t->frac = (unsigned)(total & ((1u << pr) - 1));
+}
+
+/*----------------------------------------------------
+Function: periphSchedule
+Description: Computes nextEvent (the next compare match or
+             SCI0 change) and the pending interrupt flag.
+------------------------------------------------------*/
+void periphSchedule(struct hcs12 *s)
+{
+   struct timer *t = &s->tim;
+   int pr = s->regs[R_TSCR2] & 0x07;
+   unsigned long long next = NEVER, c;
+   unsigned long d;
+   int ch;
+
+   if(s->regs[R_TSCR1] & TEN)
+   {
+      for(ch = 0; ch < 8; ch++)
+      {
+         word tc;
+         if(!(s->regs[R_TIOS] & (1 << ch))) continue;
+         tc = (word)(s->regs[R_TC0 + 2*ch] << 8 | s->regs[R_TC0 + 2*ch + 1]);
+         d = (word)(tc - t->tcnt);
+         if(d == 0) d = 0x10000;
+         c = t->sync + ((unsigned long long)d << pr) - t->frac;
+         if(c < next) next = c;
+      }
+   }
+   c = sciNext(s);
+   if(c < next) next = c;
+   s->nextEvent = next;
+   s->irq = (s->regs[R_TFLG1] & s->regs[R_TIE]) != 0 || sciPending(s);
+}
+
+/*----------------------------------------------------
+Function: periphEvents
+Description: Called by the CPU loop once nextEvent is
+             reached.
+------------------------------------------------------*/
+void periphEvents(struct hcs12 *s)
+{
+   timerSync(s);
+   sciSync(s);
+   periphSchedule(s);
+}
+
+/*----------------------------------------------------
+Function: periphVector
+Description: Highest priority pending interrupt (0 if
+             none).  The vector selected by HPRIO comes
+             first, then the higher vector addresses (the
+             timer channels before SCI0).
+------------------------------------------------------*/
+word periphVector(struct hcs12 *s)
+{
+   byte pend = s->regs[R_TFLG1] & s->regs[R_TIE];
+   int sci = sciPending(s);
+   word hp = 0xFF00 | s->regs[R_HPRIO];
+   int ch;
+
+   if(!pend && !sci) return(0);
+   if(sci && hp == VEC_SCI0) return(hp);
+   for(ch = 0; ch < 8; ch++)
+      if((pend & (1 << ch)) && VEC_TC0 - 2*ch == hp) return(hp);
+   for(ch = 0; ch < 8; ch++)
+      if(pend & (1 << ch)) return(VEC_TC0 - 2*ch);
+   return(VEC_SCI0);
+}
+
+/*----------------------------------------------------
+Function: periphRequestAt
+Description: Cycle an interrupt was requested: its flag
+             set with the interrupt enabled.  The current
+             cycle for the vectors without a flag.
+------------------------------------------------------*/
+unsigned long long periphRequestAt(struct hcs12 *s, word vec)
+{
+   int ch = (VEC_TC0 - vec) / 2;
+
+   if(vec > VEC_TC0 || vec < VEC_TC7) return(s->cycles);
+   return(s->tim.flagAt[ch] > s->tim.enabledAt[ch] ? s->tim.flagAt[ch] : s->tim.enabledAt[ch]);
+}
+
+// TCNT brought up to date (for the timeline)
+unsigned periphTcnt(struct hcs12 *s)
+{
+   timerSync(s);
+   return(s->tim.tcnt);
+}
+
+/*----------------------------------------------------
+Function: ioRead
+Description: Register reads.
+------------------------------------------------------*/
+byte ioRead(struct hcs12 *s, word a)
+{
+   byte v;
+
+   switch(a)
+   {
+      case R_PORTA:
+         return(keypadRead(s));
+      case R_PTH:
+         return(switchRead(s));
+      case R_PPAGE:
+         return(s->ppage);
+      case R_TCNT:
+      case R_TCNT + 1:
+         timerSync(s);
+         return(a == R_TCNT ? s->tim.tcnt >> 8 : (byte)s->tim.tcnt);
+      case R_CRGFLG:
+         if(s->regs[R_PLLCTL] & PLLON) s->regs[R_CRGFLG] |= LOCK;  // locks at once
+         else s->regs[R_CRGFLG] &= ~LOCK;
+         return(s->regs[R_CRGFLG]);
+      case R_SC0SR1:
+         return(sciStatus(s));
+      case R_SC0DRL:
+         v = sciReceive(s);
+         periphSchedule(s);
+         return(v);
+   }
+   if(a >= R_EEREGS && a < R_EEEND) return(eepromRegRead(s, a));
+   if(a >= R_TC0 && a < R_TC7END)
+   {
+      v = s->regs[a];
+      if(s->regs[R_TSCR1] & TFFCA)  // fast flag clear on access
+      {
+         s->regs[R_TFLG1] &= ~(1 << ((a - R_TC0) >> 1));
+         s->irq = (s->regs[R_TFLG1] & s->regs[R_TIE]) != 0;
+      }
+      return(v);
+   }
+   return(s->regs[a]);
+}
+
+/*----------------------------------------------------
+Function: ioWrite
+Description: Register writes.
+------------------------------------------------------*/
+void ioWrite(struct hcs12 *s, word a, byte v)
+{
+   byte old = s->regs[a];
+   int ch;
+
+   if((a >= R_TIOS && a <= R_TFLG1) || (a >= R_TC0 && a < R_TC7END))
+   {
+      timerSync(s);
+      switch(a)
+      {
+         case R_TCNT:
+         case R_TCNT + 1:
+            break;  // not writable in normal modes
+         case R_CFORC:  // forced compare: the output action, no flag
+            for(ch = 0; ch < 8; ch++)
+               if(v & s->regs[R_TIOS] & (1 << ch)) compareAction(s, ch);
+            break;
+         case R_TFLG1:
+            s->regs[a] &= ~v;  // write 1 to clear
+            break;
+         case R_TIE:
+            for(ch = 0; ch < 8; ch++)
+               if(v & ~old & (1 << ch)) s->tim.enabledAt[ch] = s->cycles;
+            s->regs[a] = v;
+            break;
+         default:
+            if(a >= R_TC0 && (s->regs[R_TSCR1] & TFFCA))
+               s->regs[R_TFLG1] &= ~(1 << ((a - R_TC0) >> 1));
+            s->regs[a] = v;
+            break;
+      }
+      periphSchedule(s);
+      return;
+   }
+   if(a >= R_EEREGS && a < R_EEEND)
+   {
+      eepromRegWrite(s, a, v);
+      return;
+   }
+   switch(a)
+   {
+      case R_PPAGE:
+         s->ppage = v;
+         break;
+      case R_CRGFLG:
+         v = s->regs[a] & ~(v & 0x94);  // RTIF, LOCKIF, SCMIF write 1 to clear
+         break;
+      case R_ATDSTAT0:
+         v = s->regs[a] & ~(v & 0x80);  // SCF write 1 to clear
+         break;
+      case R_SC0SR1:
+         return;
+      case R_SC0DRL:
+         sciSend(s, v);
+         periphSchedule(s);
+         return;
+   }
+   s->regs[a] = v;
+   if(a == R_PORTK || a == R_DDRK) lcdPort(s, s->regs[R_PORTK] & s->regs[R_DDRK]);
+   if(a == R_ATDCTL5) atdConvert(s);
+   if(a == R_PTT && v != old && s->onOutput) s->onOutput(s, OUT_PTT);
+   if(a == R_SYNR || a == R_REFDV || a == R_CLKSEL || a == R_PLLCTL) setClock(s);
+   if(a == R_SC0CR2 || a == R_SC0BDL) periphSchedule(s);
+}
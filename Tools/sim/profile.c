@@ -0,0 +1,539 @@
+/*------------------------------------------------
+ * File: profile.c
+ * Description: Symbols and profiles of a simulator run.
+ *
+ *              Symbols come from the CodeWarrior linker map
+ *              (PROCEDURES of the OBJECT-ALLOCATION SECTION,
+ *              Labs 3 and 4) or from an assembler listing
+ *              (labels named in the "; Subroutine:" headers,
+ *              Labs 1 and 2).  Labels of assembler modules
+ *              that nothing references (loop labels such as
+ *              next_char or prkLop) belong to the routine
+ *              before them unless they were called.
+ *
+ *              Every executed cycle is counted against the
+ *              address of its instruction (hcs12Run), so the
+ *              self cycles of a function are those of the
+ *              addresses up to the next function.  Calls and
+ *              the inclusive cycles come from the shadow call
+ *              stack (onLeave), by routine and by caller.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "hcs12.h"
+
+#define NAMESIZE 48
+#define LINESIZE 512
+#define MAXSYMS 2048
+#define EDGES 4096         // call graph hash table (power of 2)
+#define LST_SOURCE 39      // column of the source text in an ASM12 listing
+#define SPONTANEOUS (~0UL) // caller of an interrupt
+
+struct symbol
+{
+   char name[NAMESIZE];
+   unsigned long addr;   // linear address (hcs12Linear)
+   int local;            // unreferenced assembler label
+   int func;             // counted as a function in the reports
+   unsigned long long self;
+};
+
+struct stats
+{
+   unsigned long calls;
+   unsigned long long total;            // with interrupts taken inside
+   unsigned long long net;              // without
+   unsigned long long min, max;         // without
+};
+
+struct edge
+{
+   unsigned long caller;                // address of the call (SPONTANEOUS for interrupts)
+   unsigned long callee;                // routine
+   unsigned long calls;
+   unsigned long long cycles;           // inclusive
+};
+
+struct profile
+{
+   struct symbol syms[MAXSYMS];
+   int numSyms;
+   struct stats *stats;                 // by routine address (LINEAR_SIZE)
+   unsigned long long *pcCycles;        // by instruction address
+   struct edge edges[EDGES];
+   unsigned long long totalCycles;
+};
+
+/*----------------------------------------------------
+Function: profileNew
+------------------------------------------------------*/
+struct profile *profileNew(void)
+{
+   struct profile *p = calloc(1, sizeof(*p));
+
+   if(p == NULL) return(NULL);
+   p->stats = calloc(LINEAR_SIZE, sizeof(*p->stats));
+   p->pcCycles = calloc(LINEAR_SIZE, sizeof(*p->pcCycles));
+   if(p->stats == NULL || p->pcCycles == NULL) return(NULL);
+   return(p);
+}
+
+/*----------------------------------------------------
+Function: profileAddSymbol
+Description: Adds a routine (local: unreferenced label).
+------------------------------------------------------*/
+void profileAddSymbol(struct profile *p, const char *name, unsigned long addr, int local)
+{
+   struct symbol *sym;
+
+   if(p->numSyms == MAXSYMS) return;
+   sym = &p->syms[p->numSyms++];
+   snprintf(sym->name, NAMESIZE, "%s", name);
+   sym->addr = addr;
+   sym->local = local;
+}
+
+// Linear address of a map address (banked ones are ppaaaa)
+static unsigned long mapLinear(unsigned long a)
+{
+   unsigned page = a >> 16;
+   word off = a & 0xFFFF;
+
+   if(page >= FIRST_PAGE && page < FIRST_PAGE + NUMPAGES && off >= WIN_START && off < WIN_END)
+      return(0x10000UL + (page - FIRST_PAGE) * PAGE_SIZE + (off - WIN_START));
+   if(off >= WIN_START && off < WIN_END)  // non-banked window, page $3D
+      return(0x10000UL + 0x0D * PAGE_SIZE + (off - WIN_START));
+   return(off);
+}
+
+/*----------------------------------------------------
+Function: profileLoadMap
+Description: Procedures of a CodeWarrior linker map.
+             Returns the number of symbols read.
+------------------------------------------------------*/
+int profileLoadMap(struct profile *p, const char *path)
+{
+   FILE *f = fopen(path, "r");
+   char line[LINESIZE], name[NAMESIZE];
+   int inObjects = 0, inProcs = 0, asmModule = 0, n0 = p->numSyms;
+   unsigned long addr;
+   unsigned size, dsize, ref;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), f) != NULL)
+   {
+      if(strstr(line, "OBJECT-ALLOCATION SECTION")) inObjects = 1;
+      else if(!inObjects) continue;
+      else if(strstr(line, "MODULE STATISTIC") || strstr(line, "SECTION USE IN")) break;
+      else if(strncmp(line, "MODULE:", 7) == 0)
+      {
+         asmModule = strstr(line, ".asm.o") != NULL;
+         inProcs = 0;
+      }
+      else if(strncmp(line, "- PROCEDURES:", 13) == 0) inProcs = 1;
+      else if(strncmp(line, "- ", 2) == 0) inProcs = 0;
+      else if(inProcs && sscanf(line, "%47s %lx %x %u %u", name, &addr, &size, &dsize, &ref) == 5)
+         profileAddSymbol(p, name, mapLinear(addr), asmModule && ref == 0);
+   }
+   fclose(f);
+   return(p->numSyms - n0);
+}
+
+// Case insensitive compare of an identifier with a label
+static int sameName(const char *a, int len, const char *label)
+{
+   return((int)strlen(label) == len && strncasecmp(a, label, len) == 0);
+}
+
+/*----------------------------------------------------
+Function: profileLoadLst
+Description: Routines of an ASM12 listing: the labels
+             named in "; Subroutine" (or "; ISR") header
+             comments, and "main" for the code after the
+             "; Main routine" header.
+------------------------------------------------------*/
+int profileLoadLst(struct profile *p, const char *path)
+{
+   FILE *f = fopen(path, "r");
+   char line[LINESIZE];
+   static struct { char name[NAMESIZE]; word addr; } labels[MAXSYMS];
+   int numLabels = 0, n0 = p->numSyms, mainNext = 0, i;
+   unsigned a;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   // Code labels: "  nn:     aaaa bb bb      label: ..."
+   while(fgets(line, sizeof(line), f) != NULL)
+   {
+      char *src = line + LST_SOURCE;
+      int len = 0;
+      if(strlen(line) <= LST_SOURCE || sscanf(line + 11, "%4x", &a) != 1 || line[16] == '+'
+         || line[16] == '=') continue;
+      while(isalnum((byte)src[len]) || src[len] == '_') len++;
+      if(len == 0 || len >= NAMESIZE || isdigit((byte)src[0]) || numLabels == MAXSYMS) continue;
+      memcpy(labels[numLabels].name, src, len);
+      labels[numLabels].name[len] = '\0';
+      labels[numLabels++].addr = (word)a;
+   }
+   rewind(f);
+   while(fgets(line, sizeof(line), f) != NULL)
+   {
+      char *c = strchr(line, ';');
+      char *k;
+      if(mainNext && strlen(line) > 16 && sscanf(line + 11, "%4x", &a) == 1 && isxdigit((byte)line[16]))
+      {
+         profileAddSymbol(p, "main", a, 0);
+         mainNext = 0;
+      }
+      if(c == NULL || (strlen(line) > LST_SOURCE && c > line + LST_SOURCE)) continue;
+      if(strstr(c, "Main routine")) mainNext = 1;
+      if((k = strstr(c, "Subroutine")) == NULL && (k = strstr(c, "ISR")) == NULL) continue;
+      // first identifier after the keyword that is a code label
+      for(k = strpbrk(k, " :;-\t"); k && *k; )
+      {
+         int len = 0;
+         while(*k && !isalpha((byte)*k) && *k != '_') k++;
+         while(isalnum((byte)k[len]) || k[len] == '_') len++;
+         if(len == 0) break;
+         for(i = 0; i < numLabels && !sameName(k, len, labels[i].name); i++) ;
+         if(i < numLabels)
+         {
+            profileAddSymbol(p, labels[i].name, labels[i].addr, 0);
+            break;
+         }
+         k += len;
+      }
+   }
+   fclose(f);
+   return(p->numSyms - n0);
+}
+
+static int byAddr(const void *a, const void *b)
+{
+   const struct symbol *x = a, *y = b;
+   if(x->addr != y->addr) return(x->addr < y->addr ? -1 : 1);
+   return(x->local - y->local);  // referenced symbol first
+}
+
+/*----------------------------------------------------
+Function: profileLeave
+Description: onLeave callback: statistics of the routine
+             and of the caller/callee pair.
+------------------------------------------------------*/
+static void profileLeave(struct hcs12 *s, struct frame *f)
+{
+   struct profile *p = s->user;
+   struct stats *st = &p->stats[f->func];
+   unsigned long long total = s->cycles - f->start;
+   unsigned long long net = total - f->irq;
+   unsigned long caller = SPONTANEOUS;
+   unsigned h, n;
+   struct edge *e;
+
+   if(f->kind != FR_IRQ) caller = f->site;
+   if(st->calls == 0 || net < st->min) st->min = net;
+   if(net > st->max) st->max = net;
+   st->calls++;
+   st->total += total;
+   st->net += net;
+
+   h = (unsigned)((caller * 31 + f->func) & (EDGES - 1));
+   for(n = 0, e = &p->edges[h]; e->calls && (e->caller != caller || e->callee != f->func);
+       e = &p->edges[h = (h + 1) & (EDGES - 1)])
+      if(++n == EDGES) return;  // table full
+   e->caller = caller;
+   e->callee = f->func;
+   e->calls++;
+   e->cycles += total;
+}
+
+/*----------------------------------------------------
+Function: profileAttach
+Description: Profiles the runs of the CPU (after its
+             reset).
+------------------------------------------------------*/
+void profileAttach(struct profile *p, struct hcs12 *s)
+{
+   int i;
+
+   s->user = p;
+   s->onLeave = profileLeave;
+   s->pcCycles = p->pcCycles;
+   qsort(p->syms, p->numSyms, sizeof(p->syms[0]), byAddr);
+   for(i = 0; i < p->numSyms; i++) p->syms[i].func = !p->syms[i].local;  // until profileFinish
+}
+
+// Index of the function that holds a linear address (-1 if none)
+static int funcOf(struct profile *p, unsigned long a)
+{
+   int lo = 0, hi = p->numSyms - 1, mid, best = -1;
+
+   while(lo <= hi)
+   {
+      mid = (lo + hi) / 2;
+      if(p->syms[mid].addr <= a)
+      {
+         best = mid;
+         lo = mid + 1;
+      }
+      else hi = mid - 1;
+   }
+   while(best >= 0 && !p->syms[best].func) best--;
+   return(best);
+}
+
+/*----------------------------------------------------
+Function: profileFinish
+Description: Decides the functions (unreferenced labels
+             that were called count as functions) and
+             adds up the self cycles.
+------------------------------------------------------*/
+void profileFinish(struct profile *p)
+{
+   unsigned long a;
+   int i, j;
+
+   for(i = 0; i < p->numSyms; i++)
+   {
+      struct symbol *sym = &p->syms[i];
+      sym->func = !sym->local || p->stats[sym->addr].calls != 0;
+      for(j = 0; j < i; j++)  // one function per address
+         if(p->syms[j].func && p->syms[j].addr == sym->addr) sym->func = 0;
+      sym->self = 0;
+   }
+   p->totalCycles = 0;
+   for(a = 0; a < LINEAR_SIZE; a++)
+   {
+      if(p->pcCycles[a] == 0) continue;
+      p->totalCycles += p->pcCycles[a];
+      if((i = funcOf(p, a)) >= 0) p->syms[i].self += p->pcCycles[a];
+   }
+}
+
+/*----------------------------------------------------
+Function: profileName
+Description: Name of a routine address (function name,
+             name+offset or the hex address).
+------------------------------------------------------*/
+const char *profileName(struct profile *p, unsigned long a, char *buf, int size)
+{
+   int i = funcOf(p, a);
+
+   if(a == SPONTANEOUS) snprintf(buf, size, "<interrupt>");
+   else if(i < 0) snprintf(buf, size, a >= 0x10000 ? "%06lX" : "%04lX", a);
+   else if(p->syms[i].addr == a) snprintf(buf, size, "%s", p->syms[i].name);
+   else snprintf(buf, size, "%s+%lX", p->syms[i].name, a - p->syms[i].addr);
+   return(buf);
+}
+
+/*----------------------------------------------------
+Function: profileLookup
+Description: Address of a function (or a hex address);
+             -1 if unknown.
+------------------------------------------------------*/
+long profileLookup(struct profile *p, const char *name)
+{
+   char *end;
+   unsigned long a;
+   int i;
+
+   for(i = 0; i < p->numSyms; i++)
+      if(strcmp(p->syms[i].name, name) == 0) return((long)p->syms[i].addr);
+   a = strtoul(name, &end, 16);
+   if(*end != '\0' || a >= LINEAR_SIZE) return(-1);
+   return((long)a);
+}
+
+/*----------------------------------------------------
+Function: profileRoutine
+Description: One line of the routine table.
+------------------------------------------------------*/
+void profileRoutine(struct profile *p, unsigned long a, FILE *out)
+{
+   struct stats *st = &p->stats[a];
+   char name[NAMESIZE + 8];
+
+   fprintf(out, "%-24s %8lu %10llu %10llu %10llu %12llu\n", profileName(p, a, name, sizeof(name)),
+           st->calls, st->min, st->calls ? st->net / st->calls : 0, st->max, st->total);
+}
+
+/*----------------------------------------------------
+Function: profileStats
+Description: Calls of the routine at a and their cycles,
+             interrupts taken inside excluded.
+------------------------------------------------------*/
+void profileStats(struct profile *p, unsigned long a, unsigned long *calls,
+                  unsigned long long *net)
+{
+   *calls = p->stats[a].calls;
+   *net = p->stats[a].net;
+}
+
+// Routines by total cycles, largest first
+static struct profile *sortProfile;
+static int byTotal(const void *a, const void *b)
+{
+   unsigned long long ta = sortProfile->stats[*(const unsigned long *)a].total;
+   unsigned long long tb = sortProfile->stats[*(const unsigned long *)b].total;
+   return(ta < tb ? 1 : ta > tb ? -1 : 0);
+}
+
+/*----------------------------------------------------
+Function: profileRoutines
+Description: Routine table (calls, min/avg/max cycles
+             without interrupts, total with them) of the
+             max routines with the most cycles.
+------------------------------------------------------*/
+void profileRoutines(struct profile *p, int max, FILE *out)
+{
+   unsigned long *all = malloc(LINEAR_SIZE * sizeof(*all));
+   unsigned long a;
+   int n = 0, i;
+
+   for(a = 0; a < LINEAR_SIZE; a++)
+      if(p->stats[a].calls) all[n++] = a;
+   sortProfile = p;
+   qsort(all, n, sizeof(*all), byTotal);
+   for(i = 0; i < n && i < max; i++) profileRoutine(p, all[i], out);
+   free(all);
+}
+
+static int bySelf(const void *a, const void *b)
+{
+   const struct symbol *x = *(struct symbol * const *)a, *y = *(struct symbol * const *)b;
+   return(x->self < y->self ? 1 : x->self > y->self ? -1 : 0);
+}
+
+/*----------------------------------------------------
+Function: profileFlat
+Description: Flat profile: self cycles of each function
+             (share of all the cycles run), calls and
+             cycles per call with the callees and
+             interrupts.
+------------------------------------------------------*/
+void profileFlat(struct profile *p, FILE *out)
+{
+   struct symbol *order[MAXSYMS];
+   unsigned long long other = p->totalCycles;
+   int n = 0, i;
+
+   for(i = 0; i < p->numSyms; i++)
+      if(p->syms[i].func && (p->syms[i].self || p->stats[p->syms[i].addr].calls))
+         order[n++] = &p->syms[i];
+   qsort(order, n, sizeof(order[0]), bySelf);
+   fprintf(out, "  %%time   self cycles      calls   self/call  total/call  name\n");
+   for(i = 0; i < n; i++)
+   {
+      struct stats *st = &p->stats[order[i]->addr];
+      other -= order[i]->self;
+      fprintf(out, "%7.2f %13llu %10lu %11llu %11llu  %s\n",
+              p->totalCycles ? 100.0 * order[i]->self / p->totalCycles : 0.0, order[i]->self,
+              st->calls, st->calls ? order[i]->self / st->calls : 0,
+              st->calls ? st->total / st->calls : 0, order[i]->name);
+   }
+   if(other) fprintf(out, "%7.2f %13llu %10s %11s %11s  <no symbol>\n",
+                     100.0 * other / p->totalCycles, other, "", "", "");
+}
+
+/*----------------------------------------------------
+Function: profileGraph
+Description: Call graph: for each function called, its
+             callers and its callees with the calls and
+             the cycles (callees and interrupts included)
+             of each pair.
+------------------------------------------------------*/
+void profileGraph(struct profile *p, FILE *out)
+{
+   char n1[NAMESIZE + 8], n2[NAMESIZE + 8];
+   static char used[EDGES];
+   int i, j, k, m;
+
+   fprintf(out, "%-28s %10s %14s\n", "", "calls", "cycles");
+   for(i = 0; i < p->numSyms; i++)
+   {
+      struct symbol *sym = &p->syms[i];
+      struct stats *st = &p->stats[sym->addr];
+      if(!sym->func || st->calls == 0) continue;
+      // callers, by function of the call
+      for(j = 0; j < EDGES; j++) used[j] = 0;
+      for(j = 0; j < EDGES; j++)
+      {
+         struct edge *e = &p->edges[j];
+         unsigned long calls = 0;
+         unsigned long long cycles = 0;
+         if(!e->calls || e->callee != sym->addr || used[j]) continue;
+         k = (e->caller == SPONTANEOUS) ? -2 : funcOf(p, e->caller);
+         for(m = j; m < EDGES; m++)
+         {
+            struct edge *e2 = &p->edges[m];
+            if(!e2->calls || e2->callee != sym->addr || used[m]) continue;
+            if(((e2->caller == SPONTANEOUS) ? -2 : funcOf(p, e2->caller)) != k) continue;
+            used[m] = 1;
+            calls += e2->calls;
+            cycles += e2->cycles;
+         }
+         fprintf(out, "    %-24s %10lu %14llu\n", k >= 0 ? p->syms[k].name :
+                 profileName(p, e->caller, n1, sizeof(n1)), calls, cycles);
+      }
+      fprintf(out, "%-28s %10lu %14llu  (%.2f%%)\n", sym->name, st->calls, st->total,
+              p->totalCycles ? 100.0 * st->total / p->totalCycles : 0.0);
+      // callees, all the calls of the function to each routine
+      for(j = 0; j < EDGES; j++) used[j] = 0;
+      for(j = 0; j < EDGES; j++)
+      {
+         struct edge *e = &p->edges[j];
+         unsigned long calls = 0;
+         unsigned long long cycles = 0;
+         if(!e->calls || e->caller == SPONTANEOUS || used[j] || funcOf(p, e->caller) != i) continue;
+         for(m = j; m < EDGES; m++)
+         {
+            struct edge *e2 = &p->edges[m];
+            if(!e2->calls || e2->callee != e->callee || e2->caller == SPONTANEOUS || used[m]
+               || funcOf(p, e2->caller) != i) continue;
+            used[m] = 1;
+            calls += e2->calls;
+            cycles += e2->cycles;
+         }
+         fprintf(out, "    -> %-21s %10lu %14llu\n", profileName(p, e->callee, n2, sizeof(n2)),
+                 calls, cycles);
+      }
+      fprintf(out, "\n");
+   }
+}
+
+/*----------------------------------------------------
+Function: profileWrite
+Description: Writes "name calls cycles" (self cycles)
+             for each function, the profile format of the
+             placement tool.
+------------------------------------------------------*/
+int profileWrite(struct profile *p, const char *path)
+{
+   FILE *f = fopen(path, "w");
+   int i;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   fprintf(f, "# name calls cycles\n");
+   for(i = 0; i < p->numSyms; i++)
+   {
+      struct symbol *sym = &p->syms[i];
+      if(sym->func && (sym->self || p->stats[sym->addr].calls))
+         fprintf(f, "%s %lu %llu\n", sym->name, p->stats[sym->addr].calls, sym->self);
+   }
+   fclose(f);
+   return(0);
+}
@@ -0,0 +1,138 @@
+/*------------------------------------------------
+ * File: run.c
+ * Description: hcs12run - plays a scenario (see
+ *              scenario.c) on one or two builds and
+ *              prints the latency of each response, so two
+ *              builds are compared in one command.
+ *
+ *   hcs12run [-e] [-x percent] scenario file.s19 [file2.s19]
+ *
+ *      -e  executes every pass of the idle loops
+ *      -x  exit status 2 when a metric of the second
+ *          build is slower than the first by more than
+ *          percent (also when a response is missing)
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define MAXBUILDS 2
+#define MAXMETRICS 256
+
+struct result
+{
+   const char *file;
+   double latency[MAXMETRICS];   // ms, -1 if no response
+   char lcd[2][17];
+   unsigned long violations;
+   unsigned long long insts, cycles;
+};
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: hcs12run [-e] [-x percent] scenario file.s19 [file2.s19]\n");
+   exit(1);
+}
+
+/*----------------------------------------------------
+Function: play
+Description: Runs the scenario on the image in file and
+             keeps the metrics in r.  Returns -1 on an
+             error.
+------------------------------------------------------*/
+static int play(struct scenario *sc, const char *file, int skipIdle, struct result *r)
+{
+   static struct image img;
+   static struct hcs12 cpu;
+   struct hcs12 *s = &cpu;
+   double endUs = scenarioEnd(sc) * 1000.0, at;
+   unsigned long long end;
+   int m;
+
+   imageInit(&img);
+   if(loadS19(&img, file) != 0) return(-1);
+   cpu.skipIdle = skipIdle;
+   hcs12Reset(s, &img);
+   if(scenarioStart(sc, s) != 0) return(-1);
+   end = (unsigned long long)(endUs * s->busMHz);
+   while(s->state <= ST_WAIT && simTimeUs(s) < endUs)
+   {
+      hcs12Run(s, end);
+      end = s->cycles + (unsigned long long)((endUs - simTimeUs(s)) * s->busMHz);
+   }
+   scenarioFinish(sc, s);
+
+   r->file = file;
+   for(m = 0; m < scenarioMetrics(sc) && m < MAXMETRICS; m++)
+      scenarioMetric(sc, m, &at, &r->latency[m]);
+   lcdLine(s, 0, r->lcd[0]);
+   lcdLine(s, 1, r->lcd[1]);
+   r->violations = s->lcd.violations;
+   r->insts = s->insts;
+   r->cycles = s->cycles;
+   return(0);
+}
+
+int main(int argc, char *argv[])
+{
+   static struct result res[MAXBUILDS];
+   const char *path = NULL, *files[MAXBUILDS];
+   struct scenario *sc;
+   double percent = -1.0, at, lat;
+   int skipIdle = 1, builds = 0, slower = 0, missing = 0;
+   int i, m, n;
+
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-e") == 0) skipIdle = 0;
+      else if(strcmp(argv[i], "-x") == 0 && i + 1 < argc) percent = atof(argv[++i]);
+      else if(argv[i][0] == '-') usage();
+      else if(path == NULL) path = argv[i];
+      else if(builds < MAXBUILDS) files[builds++] = argv[i];
+      else usage();
+   }
+   if(builds == 0) usage();
+   if((sc = scenarioLoad(path)) == NULL) return(1);
+   n = scenarioMetrics(sc);
+   if(n > MAXMETRICS) n = MAXMETRICS;
+
+   printf("scenario %s: %d metrics, %.3f s\n\n", path, n, scenarioEnd(sc) / 1000.0);
+   for(i = 0; i < builds; i++)
+   {
+      if(play(sc, files[i], skipIdle, &res[i]) != 0) return(1);
+      printf("%c  %s\n   %llu instructions, %llu cycles\n", 'A' + i, files[i], res[i].insts,
+             res[i].cycles);
+      printf("   LCD |%s|%s|  %lu violations\n", res[i].lcd[0], res[i].lcd[1], res[i].violations);
+   }
+
+   printf("\n%-24s %10s %12s", "metric", "at ms", "A ms");
+   if(builds > 1) printf(" %12s %9s", "B ms", "change");
+   printf("\n");
+   for(m = 0; m < n; m++)
+   {
+      const char *name = scenarioMetric(sc, m, &at, &lat);
+      printf("%-24s %10.3f", name, at);
+      for(i = 0; i < builds; i++)
+      {
+         if(res[i].latency[m] < 0)
+         {
+            printf(" %12s", "none");
+            missing++;
+         }
+         else printf(" %12.3f", res[i].latency[m]);
+      }
+      if(builds > 1 && res[0].latency[m] > 0 && res[1].latency[m] >= 0)
+      {
+         double change = 100.0 * (res[1].latency[m] - res[0].latency[m]) / res[0].latency[m];
+         int worse = percent >= 0 && change > percent;
+         printf(" %+8.1f%%%s", change, worse ? " *" : "");
+         slower += worse;
+      }
+      printf("\n");
+   }
+   if(percent >= 0 && builds > 1)
+      printf("\n%d metrics slower by more than %.1f%%, %d responses missing\n", slower, percent,
+             missing);
+   return((percent >= 0 && (slower || missing)) ? 2 : 0);
+}
@@ -0,0 +1,440 @@
+/*------------------------------------------------
+ * File: scenario.c
+ * Description: Scenarios - a session at the board as
+ *              timed key presses, switch changes and
+ *              temperatures, with the responses to time.
+ *              One event per line:
+ *
+ *                <time> key <k> [hold]
+ *                <time> code <keys> [gap]
+ *                <time> switches <hex>
+ *                <time> open <n>
+ *                <time> close <n>
+ *                <time> temp <deg C>
+ *                <time> end
+ *                bounce <ms>
+ *
+ *              Times are in milli-sec from the reset or,
+ *              with a '+', from the previous event (the last
+ *              key of a code).  A key is held 100 ms by
+ *              default and the keys of a code are 300 ms
+ *              apart.  open and close change one switch
+ *              (zone) of Port H.  A line starting with '#'
+ *              is a comment.
+ *
+ *              An event can be followed by the response to
+ *              time and the name of the metric:
+ *
+ *                -> lcd           next byte the LCD executes
+ *                -> lcd "text"    an LCD write leaves text on
+ *                                 the display
+ *                -> siren on      first edge of the siren (PT5)
+ *                -> siren off     last edge before 10 ms of
+ *                                 silence, the siren having
+ *                                 sounded after the input
+ *
+ *              e.g.  +500 code 1234 -> siren off code-to-disarm
+ *
+ *              The responses are seen through onOutput, so
+ *              they are timed to the bus cycle and a run is
+ *              the same every time.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define SC_EVENTS 256
+#define SC_TEXT 32
+#define LINESIZE 256
+#define MAXTOKENS 12
+
+#define R_PTT 0x240
+#define SIREN 0x20           // PT5, TC5 output compare (siren.c)
+#define QUIET 10000.0        // siren off after 10 ms without an edge (micro-sec)
+#define TAIL 5000.0          // run after the last event when there is no end (ms)
+
+// Events
+#define EV_KEY      0
+#define EV_CODE     1
+#define EV_SWITCHES 2
+#define EV_OPEN     3
+#define EV_CLOSE    4
+#define EV_TEMP     5
+#define EV_END      6
+
+// Responses
+#define RS_NONE      0
+#define RS_LCD       1
+#define RS_TEXT      2
+#define RS_SIREN_ON  3
+#define RS_SIREN_OFF 4
+
+static const char *verbs[] = { "key", "code", "switches", "open", "close", "temp", "end" };
+
+struct event
+{
+   double at;                 // milli-sec
+   int kind;
+   char keys[SC_TEXT];        // key or code
+   double value;              // switches, zone or temperature
+   double hold, gap;          // milli-sec
+   int resp;
+   char text[17];             // for RS_TEXT
+   char name[SC_TEXT];        // metric
+   double from, done;         // micro-sec: last input and response (-1 if none)
+};
+
+struct scenario
+{
+   struct event ev[SC_EVENTS];
+   int n;
+   double end;                // milli-sec
+   double bounce;
+   byte siren;                // level of the siren pin
+   double lastEdge;           // micro-sec
+};
+
+// Splits a line into words and "quoted text"
+static int tokens(char *line, char *tok[])
+{
+   int n = 0;
+   char *p = line;
+
+   for(;;)
+   {
+      while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+      if(*p == '\0' || n == MAXTOKENS) return(n);
+      if(*p == '"')
+      {
+         tok[n++] = p++;   // the word keeps its opening quote
+         while(*p && *p != '"') p++;
+         if(*p) *p++ = '\0';
+         continue;
+      }
+      else
+      {
+         tok[n++] = p;
+         while(*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+      }
+      if(*p) *p++ = '\0';
+   }
+}
+
+/*----------------------------------------------------
+Function: parseEvent
+Description: Fills e from the words of a line.  last is
+             the time of the previous event (ms).  Returns
+             an error message or NULL.
+------------------------------------------------------*/
+static const char *parseEvent(struct event *e, char *tok[], int n, double last)
+{
+   char *end;
+   int i = 2, k;
+
+   e->at = strtod(tok[0], &end) + (tok[0][0] == '+' ? last : 0.0);
+   if(*end != '\0' || e->at < last) return("bad time (or before the previous event)");
+   for(k = 0; k <= EV_END && strcmp(tok[1], verbs[k]) != 0; k++) ;
+   if(k > EV_END) return("unknown event");
+   e->kind = k;
+   e->hold = 100.0;
+   e->gap = 300.0;
+   e->resp = RS_NONE;
+   if(k != EV_END)
+   {
+      if(n < 3) return("missing value");
+      i = 3;
+      switch(k)
+      {
+         case EV_KEY:
+         case EV_CODE:
+            if(strlen(tok[2]) >= SC_TEXT || (k == EV_KEY && tok[2][1] != '\0')) return("bad key");
+            strcpy(e->keys, tok[2]);
+            if(i < n && strcmp(tok[i], "->") != 0)
+            {
+               if(k == EV_KEY) e->hold = atof(tok[i++]);
+               else e->gap = atof(tok[i++]);
+            }
+            break;
+         case EV_SWITCHES:
+            e->value = (double)strtoul(tok[2], NULL, 16);
+            break;
+         case EV_OPEN:
+         case EV_CLOSE:
+            e->value = atoi(tok[2]);
+            if(e->value < 0 || e->value > 7) return("zone not 0-7");
+            break;
+         case EV_TEMP:
+            e->value = atof(tok[2]);
+            break;
+      }
+   }
+   if(i == n) return(NULL);
+   if(strcmp(tok[i], "->") != 0 || i + 1 == n) return("expected -> and a response");
+   i++;
+   if(strcmp(tok[i], "lcd") == 0)
+   {
+      e->resp = RS_LCD;
+      if(++i < n && tok[i][0] == '"')
+      {
+         e->resp = RS_TEXT;
+         strncpy(e->text, tok[i++] + 1, 16);
+         e->text[16] = '\0';
+      }
+   }
+   else if(strcmp(tok[i], "siren") == 0 && i + 1 < n && strcmp(tok[i+1], "on") == 0)
+   {
+      e->resp = RS_SIREN_ON;
+      i += 2;
+   }
+   else if(strcmp(tok[i], "siren") == 0 && i + 1 < n && strcmp(tok[i+1], "off") == 0)
+   {
+      e->resp = RS_SIREN_OFF;
+      i += 2;
+   }
+   else return("unknown response");
+   if(i < n) strncpy(e->name, tok[i++], SC_TEXT - 1);
+   else snprintf(e->name, SC_TEXT, "%s-to-%s", verbs[k],
+                 e->resp == RS_SIREN_ON ? "siren" : e->resp == RS_SIREN_OFF ? "silence" : "lcd");
+   if(i < n) return("extra words");
+   return(NULL);
+}
+
+/*----------------------------------------------------
+Function: scenarioLoad
+Description: Reads a scenario file.  Returns NULL (after
+             a message) on an error.
+------------------------------------------------------*/
+struct scenario *scenarioLoad(const char *path)
+{
+   FILE *f = fopen(path, "r");
+   struct scenario *sc;
+   char line[LINESIZE], *tok[MAXTOKENS];
+   double last = 0.0;
+   int lineNum = 0, n;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(NULL);
+   }
+   sc = calloc(1, sizeof(*sc));
+   sc->end = -1.0;
+   while(sc && fgets(line, sizeof(line), f) != NULL)
+   {
+      struct event *e = &sc->ev[sc->n];
+      const char *err = NULL;
+      lineNum++;
+      n = tokens(line, tok);
+      if(n == 0 || tok[0][0] == '#') continue;
+      if(strcmp(tok[0], "bounce") == 0 && n == 2) sc->bounce = atof(tok[1]);
+      else if(n < 2) err = "missing event";
+      else if(sc->n == SC_EVENTS) err = "too many events";
+      else if((err = parseEvent(e, tok, n, last)) == NULL)
+      {
+         last = e->at;
+         if(e->kind == EV_CODE) last += (strlen(e->keys) - 1) * e->gap;
+         if(e->kind == EV_END) sc->end = e->at;
+         sc->n++;
+      }
+      if(err)
+      {
+         fprintf(stderr, "%s:%d: %s\n", path, lineNum, err);
+         free(sc);
+         sc = NULL;
+      }
+   }
+   fclose(f);
+   if(sc && sc->end < 0) sc->end = last + TAIL;
+   return(sc);
+}
+
+/*----------------------------------------------------
+Function: observe
+Description: onOutput of a run: completes the metrics
+             waiting for an LCD write or a siren edge.
+------------------------------------------------------*/
+static void observe(struct hcs12 *s, int what)
+{
+   struct scenario *sc = s->observer;
+   double now = simTimeUs(s), quiet;
+   char text[2][17];
+   byte level;
+   int i;
+
+   if(what == OUT_LCD)
+   {
+      lcdLine(s, 0, text[0]);
+      lcdLine(s, 1, text[1]);
+      for(i = 0; i < sc->n; i++)
+      {
+         struct event *e = &sc->ev[i];
+         if(e->done >= 0 || e->from > now) continue;
+         if(e->resp == RS_LCD
+            || (e->resp == RS_TEXT && (strstr(text[0], e->text) || strstr(text[1], e->text))))
+            e->done = now;
+      }
+      return;
+   }
+   level = s->regs[R_PTT] & SIREN;
+   if(level == sc->siren) return;
+   sc->siren = level;
+   for(i = 0; i < sc->n; i++)
+   {
+      struct event *e = &sc->ev[i];
+      if(e->done >= 0 || e->from > now) continue;
+      quiet = sc->lastEdge;  // siren off: sounding after the input, then quiet
+      if(e->resp == RS_SIREN_ON) e->done = now;
+      else if(e->resp == RS_SIREN_OFF && quiet >= e->from && now - quiet >= QUIET) e->done = quiet;
+   }
+   sc->lastEdge = now;
+}
+
+/*----------------------------------------------------
+Function: scenarioStart
+Description: Gives the inputs of the scenario to a reset
+             simulator and watches its outputs.  Returns
+             -1 if the input lists are full.
+------------------------------------------------------*/
+int scenarioStart(struct scenario *sc, struct hcs12 *s)
+{
+   byte zones = s->inputs.switch0;
+   int i, j, err = 0;
+
+   s->inputs.bounce = sc->bounce * 1000.0;
+   for(i = 0; i < sc->n; i++)
+   {
+      struct event *e = &sc->ev[i];
+      e->from = e->at * 1000.0;
+      e->done = -1.0;
+      switch(e->kind)
+      {
+         case EV_KEY:
+            err |= keyPress(s, e->at, e->keys[0], e->hold);
+            break;
+         case EV_CODE:
+            for(j = 0; e->keys[j] != '\0'; j++)
+               err |= keyPress(s, e->at + j * e->gap, e->keys[j], e->hold);
+            e->from = (e->at + (j - 1) * e->gap) * 1000.0;
+            break;
+         case EV_SWITCHES:
+         case EV_OPEN:
+         case EV_CLOSE:
+            if(e->kind == EV_SWITCHES) zones = (byte)e->value;
+            else if(e->kind == EV_OPEN) zones |= 1 << (int)e->value;
+            else zones &= ~(1 << (int)e->value);
+            err |= switchSet(s, e->at, zones);
+            break;
+         case EV_TEMP:
+            err |= tempSet(s, e->at, e->value);
+            break;
+      }
+   }
+   sc->siren = s->regs[R_PTT] & SIREN;
+   sc->lastEdge = 0.0;
+   s->observer = sc;
+   s->onOutput = observe;
+   if(err) fprintf(stderr, "scenario: a key is not on the keypad or too many inputs\n");
+   return(err ? -1 : 0);
+}
+
+/*----------------------------------------------------
+Function: scenarioFinish
+Description: End of the run: a siren quiet since the last
+             edge is off, if that edge came after the input.
+------------------------------------------------------*/
+void scenarioFinish(struct scenario *sc, struct hcs12 *s)
+{
+   double now = simTimeUs(s), quiet = sc->lastEdge;
+   int i;
+
+   for(i = 0; i < sc->n; i++)
+   {
+      struct event *e = &sc->ev[i];
+      if(e->resp == RS_SIREN_OFF && e->done < 0 && quiet >= e->from && now - quiet >= QUIET)
+         e->done = quiet;
+   }
+   s->onOutput = NULL;
+}
+
+// Time to run the scenario (ms)
+double scenarioEnd(struct scenario *sc)
+{
+   return(sc->end);
+}
+
+// Number of metrics (events with a response)
+int scenarioMetrics(struct scenario *sc)
+{
+   int i, n = 0;
+
+   for(i = 0; i < sc->n; i++)
+      if(sc->ev[i].resp != RS_NONE) n++;
+   return(n);
+}
+
+/*----------------------------------------------------
+Function: scenarioMetric
+Description: Name of metric m, with the time of its input
+             and the latency of the response (ms, -1 if
+             there was none).
+------------------------------------------------------*/
+const char *scenarioMetric(struct scenario *sc, int m, double *at, double *latency)
+{
+   int i;
+
+   for(i = 0; i < sc->n; i++)
+   {
+      struct event *e = &sc->ev[i];
+      if(e->resp == RS_NONE || m-- > 0) continue;
+      *at = e->from / 1000.0;
+      *latency = e->done < 0 ? -1.0 : (e->done - e->from) / 1000.0;
+      return(e->name);
+   }
+   return(NULL);
+}
+
+/*----------------------------------------------------
+Function: scenarioWrite
+Description: Records the key presses, switch changes and
+             temperatures given to a run as a scenario
+             ending at the current time.
+------------------------------------------------------*/
+int scenarioWrite(struct hcs12 *s, const char *path)
+{
+   struct inputs *in = &s->inputs;
+   FILE *f = fopen(path, "w");
+   int k = 0, w = 0, t = 0;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   fprintf(f, "# recorded by hcs12sim\n");
+   if(in->bounce > 0) fprintf(f, "bounce %g\n", in->bounce / 1000.0);
+   for(;;)
+   {
+      double kt = k < in->numPresses ? in->presses[k].at : 1e300;
+      double wt = w < in->numSwitches ? in->switches[w].at : 1e300;
+      double tt = t < in->numTemps ? in->temps[t].at : 1e300;
+      if(kt == 1e300 && wt == 1e300 && tt == 1e300) break;
+      if(kt <= wt && kt <= tt)
+      {
+         fprintf(f, "%.3f key %c %g\n", kt / 1000.0, keypadKey(in->presses[k].key),
+                 in->presses[k].hold / 1000.0);
+         k++;
+      }
+      else if(wt <= tt)
+      {
+         fprintf(f, "%.3f switches %02X\n", wt / 1000.0, in->switches[w++].value);
+      }
+      else
+      {
+         fprintf(f, "%.3f temp %g\n", tt / 1000.0, in->temps[t++].value);
+      }
+   }
+   fprintf(f, "%.3f end\n", simTimeUs(s) / 1000.0);
+   fclose(f);
+   return(0);
+}
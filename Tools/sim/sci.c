@@ -0,0 +1,136 @@
+/*------------------------------------------------
+ * File: sci.c
+ * Description: SCI0 of the simulator - the terminal.
+ *
+ *              The transmitter has the data register and
+ *              the shift register of the HCS12: a byte
+ *              written while the shifter is busy waits in
+ *              the data register (TDRE clear) and moves to
+ *              the shifter when the previous one is out,
+ *              10 bits at the baud rate (160 x SBR bus
+ *              cycles).  A byte is printed when it starts
+ *              shifting.  The receiver takes the characters
+ *              typed at the terminal (dbug12Input), one
+ *              every inGap cycles once the previous one is
+ *              read.
+ *
+ *              TDRE, TC and RDRF request the SCI0 interrupt
+ *              when TIE, TCIE and RIE are set in SCI0CR2.
+--------------------------------------------------*/
+#include "hcs12.h"
+
+#define R_SC0BDH 0x0C8
+#define R_SC0BDL 0x0C9
+#define R_SC0CR2 0x0CB
+
+// SCI0CR2 bits
+#define TIE  0x80
+#define TCIE 0x40
+#define RIE  0x20
+
+// SCI0SR1 bits
+#define TDRE 0x80
+#define TC   0x40
+#define RDRF 0x20
+
+#define NEVER (~0ULL)
+
+// Bus cycles of one character (start, 8 data and stop bits)
+static unsigned long long charCycles(struct hcs12 *s)
+{
+   unsigned sbr = (s->regs[R_SC0BDH] & 0x1F) << 8 | s->regs[R_SC0BDL];
+
+   return(160ULL * (sbr ? sbr : 1));
+}
+
+/*----------------------------------------------------
+Function: sciSync
+Description: Moves the byte waiting in the data register
+             to the shifter once it is free.
+------------------------------------------------------*/
+void sciSync(struct hcs12 *s)
+{
+   if(s->txHeld < 0 || s->cycles < s->txFree) return;
+   putchar(s->txHeld);
+   s->txFree += charCycles(s);
+   s->txHeld = -1;
+}
+
+/*----------------------------------------------------
+Function: sciStatus
+Description: SCI0SR1.
+------------------------------------------------------*/
+byte sciStatus(struct hcs12 *s)
+{
+   byte v = 0;
+
+   sciSync(s);
+   if(s->txHeld < 0)
+   {
+      v |= TDRE;
+      if(s->cycles >= s->txFree) v |= TC;
+   }
+   if(s->in && *s->in && s->cycles >= s->inDue) v |= RDRF;
+   return(v);
+}
+
+/*----------------------------------------------------
+Function: sciReceive
+Description: Read of SCI0DRL: the character received,
+             the next one arrives inGap later.
+------------------------------------------------------*/
+byte sciReceive(struct hcs12 *s)
+{
+   if(s->in && *s->in && s->cycles >= s->inDue)
+   {
+      s->inDue = s->cycles + s->inGap;
+      return((byte)*s->in++);
+   }
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: sciSend
+Description: Write of SCI0DRL.  Overwrites a byte still
+             waiting, like the hardware.
+------------------------------------------------------*/
+void sciSend(struct hcs12 *s, byte v)
+{
+   sciSync(s);
+   if(s->cycles >= s->txFree)
+   {
+      putchar(v);
+      s->txFree = s->cycles + charCycles(s);
+   }
+   else s->txHeld = v;
+}
+
+/*----------------------------------------------------
+Function: sciPending
+Description: Non-zero when SCI0 requests its interrupt.
+------------------------------------------------------*/
+int sciPending(struct hcs12 *s)
+{
+   byte cr2 = s->regs[R_SC0CR2], sr1;
+
+   if(!(cr2 & (TIE | TCIE | RIE))) return(0);
+   sr1 = sciStatus(s);
+   return(((cr2 & TIE) && (sr1 & TDRE)) || ((cr2 & TCIE) && (sr1 & TC)) ||
+          ((cr2 & RIE) && (sr1 & RDRF)));
+}
+
+/*----------------------------------------------------
+Function: sciNext
+Description: Cycle of the next change of SCI0SR1 that
+             can request the interrupt (NEVER if none).
+------------------------------------------------------*/
+unsigned long long sciNext(struct hcs12 *s)
+{
+   byte cr2 = s->regs[R_SC0CR2];
+   unsigned long long next = NEVER;
+
+   if(s->txHeld >= 0 || ((cr2 & TCIE) && s->cycles < s->txFree)) next = s->txFree;
+   if((cr2 & RIE) && s->in && *s->in && s->inDue > s->cycles && s->inDue < next)
+      next = s->inDue;
+   return(next);
+}
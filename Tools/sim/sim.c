@@ -0,0 +1,268 @@
+/*------------------------------------------------
+ * File: sim.c
+ * Description: hcs12sim - runs an .s19 image on the
+ *              simulated HCS12 and reports the cycles
+ *              spent in each routine.
+ *
+ *   hcs12sim [-d] [-e] [-l] [-I] [-H lo-hi,...] [-g addr] [-i input]
+ *            [-p ms] [-t seconds] [-n cycles] [-k ms:key[:hold],...] [-s ms:hex,...] [-b ms]
+ *            [-E eeprom] [-w scenario] [-T trace [-U us]] [-m map|lst] [-c]
+ *            [-o profile] [-r routine,...] file.s19
+ *
+ *      -d  DBug12 monitor routines and RAM vectors
+ *          (Labs 1 and 2, started with -g like the
+ *          monitor G command)
+ *      -e  executes every pass of the idle loops (see
+ *          idle.c) instead of skipping them
+ *      -l  prints the instructions and data sent to the
+ *          LCD (see lcd.c)
+ *      -I  interrupt latency and duration histograms by
+ *          vector (see irq.c)
+ *      -H  what moving the data at the given hex
+ *          ranges to the direct page would save, by
+ *          interrupt handler (see direct.c)
+ *      -i  characters typed at the terminal (\r \n \\
+ *          escapes), one every -p milli-sec (default 100)
+ *      -t  simulated time limit (default 60 s)
+ *      -n  cycle limit
+ *      -k  key presses: time, key (0-9 a-d * #) and time
+ *          held (default 100 ms)
+ *      -s  switches (Port H, hex, bit set = open) from
+ *          the given times
+ *      -b  contact bounce of the keys and switches
+ *      -E  EEPROM image file, read at the start (if it
+ *          exists) and written at the end (see eeprom.c)
+ *      -w  records the key presses and switch changes
+ *          as a scenario for hcs12run (see scenario.c)
+ *      -T  writes the timeline of the run for
+ *          chrome://tracing or Perfetto, leaving out the
+ *          spans shorter than -U micro-sec (see timeline.c)
+ *      -m  symbols from the linker map (Labs 3, 4) or the
+ *          assembler listing (.lst, Labs 1, 2); adds the
+ *          flat profile to the report
+ *      -c  call graph
+ *      -o  writes the "name calls cycles" profile used by
+ *          the placement tool
+ *      -r  routines to report (names or hex addresses);
+ *          the routines with the most cycles by default
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hcs12.h"
+
+#define MAXREPORT 32
+#define DBUG12_SP 0x3C00   // user stack set by DBug12
+
+// Copies the argument of -i with the escapes replaced
+static char *unescape(const char *arg)
+{
+   char *out = malloc(strlen(arg) + 1), *p = out;
+
+   while(*arg)
+   {
+      if(*arg == '\\' && arg[1] != '\0')
+      {
+         arg++;
+         *p++ = (*arg == 'r') ? '\r' : (*arg == 'n') ? '\n' : *arg;
+         arg++;
+      }
+      else *p++ = *arg++;
+   }
+   *p = '\0';
+   return(out);
+}
+
+/*----------------------------------------------------
+Function: inputEvents
+Description: Adds the key presses of -k or the switch
+             changes of -s.  Returns -1 on a bad entry.
+------------------------------------------------------*/
+static int inputEvents(struct hcs12 *s, char *list, int isKey)
+{
+   char *p, *e;
+
+   for(p = strtok(list, ","); p; p = strtok(NULL, ","))
+   {
+      double at = strtod(p, &e), hold = 100.0;
+      if(*e++ != ':' || *e == '\0')
+      {
+         fprintf(stderr, "hcs12sim: bad input event %s\n", p);
+         return(-1);
+      }
+      if(isKey)
+      {
+         if(e[1] == ':') hold = atof(e + 2);
+         if(keyPress(s, at, *e, hold) != 0)
+         {
+            fprintf(stderr, "hcs12sim: bad key %s\n", p);
+            return(-1);
+         }
+      }
+      else if(switchSet(s, at, (byte)strtoul(e, NULL, 16)) != 0)
+      {
+         fprintf(stderr, "hcs12sim: too many switch changes\n");
+         return(-1);
+      }
+   }
+   return(0);
+}
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: hcs12sim [-d] [-e] [-l] [-I] [-H lo-hi,...] [-g addr] [-i input]\n"
+                   "                [-p ms] [-t seconds] [-n cycles] [-k ms:key[:hold],...] [-s ms:hex,...] [-b ms]\n"
+                   "                [-E eeprom] [-w scenario] [-T trace [-U us]] [-m map|lst] [-c]\n"
+                   "                [-o profile] [-r routine,...] file.s19\n");
+   exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+   static struct image img;
+   static struct hcs12 cpu;
+   struct hcs12 *s = &cpu;
+   struct profile *prof = profileNew();
+   const char *file = NULL, *input = NULL, *symbols = NULL, *profOut = NULL, *eeFile = NULL;
+   const char *record = NULL, *traceFile = NULL;
+   double minUs = 0.0;
+   char *routines = NULL, *keys = NULL, *switches = NULL;
+   double bounceMs = 0.0;
+   int graph = 0;
+   long start = -1;
+   double seconds = 60.0, gapMs = 100.0, t0, t1;
+   unsigned long long limit = 0, end;
+   static const char *stopped[] = { "running", "waiting", "halted", "done" };
+   char *p;
+   int i;
+
+   cpu.skipIdle = 1;
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-d") == 0) cpu.dbug12 = 1;
+      else if(strcmp(argv[i], "-e") == 0) cpu.skipIdle = 0;
+      else if(strcmp(argv[i], "-l") == 0) cpu.lcd.trace = 1;
+      else if(strcmp(argv[i], "-I") == 0) cpu.irqs = irqNew();
+      else if(strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+      {
+         if((cpu.direct = directNew(argv[++i])) == NULL) usage();
+      }
+      else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc) start = strtol(argv[++i], NULL, 16);
+      else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) input = unescape(argv[++i]);
+      else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) gapMs = atof(argv[++i]);
+      else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+      else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) limit = strtoull(argv[++i], NULL, 0);
+      else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) keys = argv[++i];
+      else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) switches = argv[++i];
+      else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc) bounceMs = atof(argv[++i]);
+      else if(strcmp(argv[i], "-E") == 0 && i + 1 < argc) eeFile = argv[++i];
+      else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc) record = argv[++i];
+      else if(strcmp(argv[i], "-T") == 0 && i + 1 < argc) traceFile = argv[++i];
+      else if(strcmp(argv[i], "-U") == 0 && i + 1 < argc) minUs = atof(argv[++i]);
+      else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) symbols = argv[++i];
+      else if(strcmp(argv[i], "-c") == 0) graph = 1;
+      else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) profOut = argv[++i];
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) routines = argv[++i];
+      else if(argv[i][0] != '-' && file == NULL) file = argv[i];
+      else usage();
+   }
+   if(file == NULL || prof == NULL) usage();
+
+   imageInit(&img);
+   if(loadS19(&img, file) != 0) return(1);
+   if(cpu.dbug12) dbug12Install(&img);
+   if(symbols)
+   {
+      int n = strstr(symbols, ".lst") ? profileLoadLst(prof, symbols) : profileLoadMap(prof, symbols);
+      if(n < 0) return(1);
+      if(n == 0) fprintf(stderr, "%s: no routines found\n", symbols);
+      if(cpu.dbug12) dbug12Symbols(prof);
+   }
+
+   profileAttach(prof, s);
+   if(traceFile && (cpu.timeline = timelineOpen(traceFile, prof, minUs)) == NULL) return(1);
+   hcs12Reset(s, &img);
+   if(start < 0 && cpu.dbug12 && img.entry != 0) start = img.entry;
+   if(start >= 0)
+   {
+      s->pc = (word)start;
+      s->frames[0].func = hcs12Linear(s, s->pc);
+   }
+   if(cpu.dbug12) s->sp = DBUG12_SP;
+   if(input) dbug12Input(s, input, gapMs);
+   if(eeFile && eepromLoad(s, eeFile) != 0) return(1);
+   s->inputs.bounce = bounceMs * 1000.0;
+   if(keys && inputEvents(s, keys, 1) != 0) return(1);
+   if(switches && inputEvents(s, switches, 0) != 0) return(1);
+
+   end = (unsigned long long)(seconds * 1e6 * s->busMHz);
+   if(limit) end = limit;
+   t0 = (double)clock() / CLOCKS_PER_SEC;
+   while(s->state <= ST_WAIT && s->cycles < end)
+   {
+      hcs12Run(s, end);
+      if(!limit) end = s->cycles + (unsigned long long)((seconds * 1e6 - simTimeUs(s)) * s->busMHz);
+   }
+   t1 = (double)clock() / CLOCKS_PER_SEC;
+   if(s->timeline && timelineClose(s) != 0) return(1);
+   fflush(stdout);
+
+   printf("\n%s at %04X after %llu instructions, %llu cycles (%.3f ms simulated)\n",
+          s->state <= ST_WAIT ? "time limit" : stopped[s->state], s->lastPC,
+          s->insts, s->cycles, simTimeUs(s) / 1000.0);
+   if(s->skipped) printf("idle loops skipped: %llu cycles (%.1f%%)\n", s->skipped,
+                         100.0 * s->skipped / s->cycles);
+   if(t1 > t0) printf("host %.3f s, %.1f MIPS\n", t1 - t0, s->insts / (t1 - t0) / 1e6);
+
+   if(s->lcd.used)
+   {
+      printf("\n");
+      lcdShow(s, stdout);
+   }
+   if(s->inputs.numPresses)
+   {
+      printf("\n");
+      keypadReport(s, stdout);
+   }
+   if(s->ee.commands || s->ee.accerr || s->ee.pviol || eeFile)
+   {
+      printf("\n");
+      eepromReport(s, stdout);
+   }
+   if(eeFile && eepromSave(s, eeFile) != 0) return(1);
+   if(record && scenarioWrite(s, record) != 0) return(1);
+
+   profileFinish(prof);
+   printf("\n%-24s %8s %10s %10s %10s %12s\n", "routine", "calls", "min", "avg", "max",
+          "total+irq");
+   if(routines == NULL) profileRoutines(prof, MAXREPORT, stdout);
+   for(p = routines ? strtok(routines, ",") : NULL; p; p = strtok(NULL, ","))
+   {
+      long a = profileLookup(prof, p);
+      if(a < 0) fprintf(stderr, "%s: unknown routine\n", p);
+      else profileRoutine(prof, (unsigned long)a, stdout);
+   }
+   if(symbols)
+   {
+      printf("\n");
+      profileFlat(prof, stdout);
+   }
+   if(graph)
+   {
+      printf("\n");
+      profileGraph(prof, stdout);
+   }
+   if(s->irqs)
+   {
+      printf("\n");
+      irqReport(s, prof, stdout);
+   }
+   if(s->direct)
+   {
+      printf("\n");
+      directReport(s, prof, stdout);
+   }
+   if(profOut && profileWrite(prof, profOut) != 0) return(1);
+   return(0);
+}
@@ -0,0 +1,125 @@
+/*------------------------------------------------
+ * File: snapshot.c
+ * Description: Snapshots of the whole state of a
+ *              simulator instance (CPU, registers, RAM,
+ *              EEPROM and peripherals), restored many times
+ *              over (hcs12fuzz).
+ *
+ *              A snapshot is a copy of the struct hcs12.
+ *              From then on the instance marks each line
+ *              (SNAP_LINE bytes) of RAM and EEPROM it writes
+ *              (hcs12Write8, the EEPROM commands and the
+ *              DBug12 WriteEEByte), and a restore copies back
+ *              the marked lines only, with the rest of the
+ *              struct: about 27 KB in place of the 43 KB of
+ *              the whole state, whatever the lines of the
+ *              image left untouched.  The struct holds no
+ *              pointer to itself, so the copy needs no fixing.
+ *
+ *              The marks belong to the snapshot: it serves
+ *              the one instance it was taken from.  After a
+ *              hcs12Reset of that instance (nothing marked
+ *              since) the next restore copies everything.
+--------------------------------------------------*/
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "hcs12.h"
+
+// EEPROM and RAM follow each other in struct hcs12
+typedef char memoryContiguous[offsetof(struct hcs12, ram) ==
+                              offsetof(struct hcs12, eeprom) + (RAM_START - EE_START) ? 1 : -1];
+
+struct snapshot
+{
+   struct hcs12 cpu;              // state when taken
+   byte marked[SNAP_LINES];       // lines written since the last restore
+   word lines[SNAP_LINES];        // their numbers
+   int numLines;
+   unsigned long restores, restored;  // restores and lines they copied
+};
+
+/*----------------------------------------------------
+Function: snapTake
+Description: Takes a snapshot of s, which from then on
+             marks the lines it writes.  Returns NULL when
+             out of memory.
+------------------------------------------------------*/
+struct snapshot *snapTake(struct hcs12 *s)
+{
+   struct snapshot *p = calloc(1, sizeof(*p));
+
+   if(p == NULL) return(NULL);
+   s->snap = p;
+   p->cpu = *s;
+   return(p);
+}
+
+/*----------------------------------------------------
+Function: snapMark
+Description: Marks the line of a RAM or EEPROM address
+             written by s (s->snap is not NULL).
+------------------------------------------------------*/
+void snapMark(struct hcs12 *s, word a)
+{
+   struct snapshot *p = s->snap;
+   int line = (a - EE_START) / SNAP_LINE;
+
+   if(a < EE_START || a >= FLASH_START || p->marked[line]) return;
+   p->marked[line] = 1;
+   p->lines[p->numLines++] = (word)line;
+}
+
+/*----------------------------------------------------
+Function: snapRestore
+Description: Returns s to the state of snapshot p.
+------------------------------------------------------*/
+void snapRestore(struct snapshot *p, struct hcs12 *s)
+{
+   size_t tail = offsetof(struct hcs12, tim);
+   byte *to = s->eeprom;
+   const byte *from = p->cpu.eeprom;
+   int i, line;
+
+   p->restores++;
+   if(s->snap != p)  // reset since: nothing was marked
+   {
+      *s = p->cpu;
+      p->restored += SNAP_LINES;
+   }
+   else
+   {
+      memcpy(s, &p->cpu, offsetof(struct hcs12, eeprom));
+      memcpy((byte *)s + tail, (const byte *)&p->cpu + tail, sizeof(*s) - tail);
+      for(i = 0; i < p->numLines; i++)
+      {
+         line = p->lines[i];
+         memcpy(to + line * SNAP_LINE, from + line * SNAP_LINE, SNAP_LINE);
+      }
+      p->restored += p->numLines;
+   }
+   for(i = 0; i < p->numLines; i++) p->marked[p->lines[i]] = 0;
+   p->numLines = 0;
+}
+
+/*----------------------------------------------------
+Function: snapStats
+Description: Restores so far and the RAM and EEPROM lines
+             they copied.
+------------------------------------------------------*/
+void snapStats(struct snapshot *p, unsigned long *restores, unsigned long *lines)
+{
+   *restores = p->restores;
+   *lines = p->restored;
+}
+
+/*----------------------------------------------------
+Function: snapFree
+Description: Frees p; s (taken from, or NULL) no longer
+             marks its writes.
+------------------------------------------------------*/
+void snapFree(struct snapshot *p, struct hcs12 *s)
+{
+   if(s && s->snap == p) s->snap = NULL;
+   free(p);
+}
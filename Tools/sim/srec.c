@@ -0,0 +1,143 @@
+/*------------------------------------------------
+ * File: srec.c
+ * Description: Loads Motorola S-record files (.s19)
+ *              into a program image.
+ *
+ *              S1 records use the 64K CPU addresses
+ *              ($8000-$BFFF goes to page $3D).  S2 records
+ *              use either banked addresses (ppaaaa with
+ *              aaaa in $8000-$BFFF) or linear addresses
+ *              from $C0000 (page $30).
+--------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define MAXLINE 600
+
+static int hexByte(const char *p)
+{
+   int v;
+   if(sscanf(p, "%2x", &v) != 1) return(-1);
+   return(v);
+}
+
+// Stores one byte at a 64K CPU address in the default pages
+static void store16(struct image *img, unsigned a, byte v)
+{
+   if(a >= WIN_END) img->flash[0x0F][a - WIN_END] = v;
+   else if(a >= WIN_START) img->flash[0x0D][a - WIN_START] = v;
+   else if(a >= FLASH_START) img->flash[0x0E][a - FLASH_START] = v;
+   else
+   {
+      img->low[a] = v;
+      img->lowLoaded = 1;
+   }
+}
+
+static int store(struct image *img, unsigned long a, int len, byte v)
+{
+   unsigned page;
+
+   if(len == 2 || a < 0x10000)
+   {
+      store16(img, (unsigned)a, v);
+      return(0);
+   }
+   page = a >> 16;
+   if(page >= FIRST_PAGE && page < FIRST_PAGE + NUMPAGES
+      && (a & 0xFFFF) >= WIN_START && (a & 0xFFFF) < WIN_END)
+   {
+      img->flash[page - FIRST_PAGE][(a & 0xFFFF) - WIN_START] = v;
+      return(0);
+   }
+   if(a >= 0xC0000 && a < 0x100000)
+   {
+      a -= 0xC0000;
+      img->flash[a / PAGE_SIZE][a % PAGE_SIZE] = v;
+      return(0);
+   }
+   return(-1);
+}
+
+/*----------------------------------------------------
+Function: imageInit
+Description: Empty image: erased flash and EEPROM, zero
+             RAM.
+------------------------------------------------------*/
+void imageInit(struct image *img)
+{
+   memset(img->flash, 0xFF, sizeof(img->flash));
+   memset(img->low, 0, sizeof(img->low));
+   memset(&img->low[EE_START], 0xFF, RAM_START - EE_START);
+   img->lowLoaded = 0;
+   img->entry = 0;
+}
+
+/*----------------------------------------------------
+Function: loadS19
+Description: Adds the records of the file to the image.
+             Returns 0 or -1 with a message on stderr.
+------------------------------------------------------*/
+int loadS19(struct image *img, const char *path)
+{
+   FILE *f = fopen(path, "r");
+   char line[MAXLINE];
+   int lineNum = 0;
+
+   if(f == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), f) != NULL)
+   {
+      int count, alen, i, sum, v;
+      unsigned long addr = 0;
+
+      lineNum++;
+      if(line[0] != 'S') continue;
+      switch(line[1])
+      {
+         case '1': case '9': alen = 2; break;
+         case '2': case '8': alen = 3; break;
+         case '3': case '7': alen = 4; break;
+         default: continue;  // S0 header, S5 count
+      }
+      count = hexByte(&line[2]);
+      if(count < alen + 1 || (int)strlen(line) < 4 + 2*count)
+      {
+         fprintf(stderr, "%s:%d: bad record\n", path, lineNum);
+         fclose(f);
+         return(-1);
+      }
+      sum = count;
+      for(i = 0; i < count; i++)
+      {
+         v = hexByte(&line[4 + 2*i]);
+         if(v < 0)
+         {
+            fprintf(stderr, "%s:%d: bad hex\n", path, lineNum);
+            fclose(f);
+            return(-1);
+         }
+         sum += v;
+         if(i < alen) addr = addr << 8 | v;
+         else if(i < count - 1 && line[1] <= '3')
+         {
+            if(store(img, addr + i - alen, alen, (byte)v) != 0)
+            {
+               fprintf(stderr, "%s:%d: address %05lX outside the flash\n", path, lineNum,
+                       addr + i - alen);
+               fclose(f);
+               return(-1);
+            }
+         }
+      }
+      if((sum & 0xFF) != 0xFF)
+         fprintf(stderr, "%s:%d: checksum error\n", path, lineNum);
+      if(line[1] >= '7') img->entry = (word)addr;
+   }
+   fclose(f);
+   return(0);
+}
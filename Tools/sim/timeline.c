@@ -0,0 +1,170 @@
+/*------------------------------------------------
+ * File: timeline.c
+ * Description: Timeline of a run in the Chrome trace
+ *              event format (chrome://tracing, Perfetto).
+ *
+ *              Every routine call and interrupt of the
+ *              shadow call stack becomes a complete span
+ *              ("X" event), named from the map or listing,
+ *              on the track of main-line code or on the
+ *              track of its interrupt vector.  The spans are
+ *              written as they end, shorter ones than the
+ *              given minimum are left out.  TCNT and the
+ *              stack (bytes below the highest SP seen, and
+ *              frames) are counter tracks sampled every
+ *              SAMPLE_US, the stack as its peak since the
+ *              last sample.
+ *
+ *              The events go straight to the file, so the
+ *              memory used is the same for any length of
+ *              run.
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "hcs12.h"
+
+#define MAXTRACKS 32
+#define SAMPLE_US 100.0
+#define PID 1
+
+struct timeline
+{
+   FILE *out;
+   struct profile *prof;
+   double minUs;                  // shortest span written
+   int tid[MAXFRAMES];            // track of each frame
+   double start[MAXFRAMES];       // micro-sec
+   unsigned long handlers[MAXTRACKS];  // interrupt handler of each track (1 and up)
+   int numTracks;
+   double lastSample;
+   word top, peak;                // highest SP, deepest stack since the last sample
+   int peakFrames;
+   unsigned long long events;
+};
+
+// Starts an event (the separator after the previous one)
+static FILE *event(struct timeline *t)
+{
+   if(t->events++) fprintf(t->out, ",\n");
+   return(t->out);
+}
+
+static void trackName(struct timeline *t, int tid, const char *name)
+{
+   fprintf(event(t), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}}", PID, tid, name);
+}
+
+/*----------------------------------------------------
+Function: timelineOpen
+Description: Starts the trace file.  Returns NULL (after
+             a message) if it cannot be written.
+------------------------------------------------------*/
+struct timeline *timelineOpen(const char *path, struct profile *prof, double minUs)
+{
+   struct timeline *t = calloc(1, sizeof(*t));
+
+   if(t == NULL) return(NULL);
+   if((t->out = fopen(path, "w")) == NULL)
+   {
+      perror(path);
+      free(t);
+      return(NULL);
+   }
+   setvbuf(t->out, NULL, _IOFBF, 1 << 20);
+   t->prof = prof;
+   t->minUs = minUs;
+   t->lastSample = -SAMPLE_US;
+   fprintf(t->out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+   trackName(t, 0, "main");
+   return(t);
+}
+
+// Counter samples: TCNT and the stack
+static void sample(struct hcs12 *s, struct timeline *t)
+{
+   double now = simTimeUs(s);
+
+   if(s->sp > t->top) t->top = s->sp;
+   if((word)(t->top - s->sp) > t->peak) t->peak = t->top - s->sp;
+   if(s->depth > t->peakFrames) t->peakFrames = s->depth;
+   if(now - t->lastSample < SAMPLE_US) return;
+   fprintf(event(t), "{\"name\":\"TCNT\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,"
+                     "\"args\":{\"TCNT\":%u}}", PID, now, periphTcnt(s));
+   fprintf(event(t), "{\"name\":\"stack\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,"
+                     "\"args\":{\"bytes\":%u,\"frames\":%d}}", PID, now, t->peak, t->peakFrames);
+   t->lastSample = now;
+   t->peak = t->top - s->sp;
+   t->peakFrames = s->depth;
+}
+
+/*----------------------------------------------------
+Function: timelineEnter
+Description: Called when a frame is entered (s->depth - 1).
+------------------------------------------------------*/
+void timelineEnter(struct hcs12 *s)
+{
+   struct timeline *t = s->timeline;
+   struct frame *f = &s->frames[s->depth-1];
+   int d = s->depth - 1, i;
+   char name[64], track[80];
+
+   t->start[d] = simTimeUs(s);
+   t->tid[d] = d > 0 ? t->tid[d-1] : 0;
+   if(f->kind == FR_IRQ)
+   {
+      for(i = 0; i < t->numTracks && t->handlers[i] != f->func; i++) ;
+      if(i == t->numTracks && i < MAXTRACKS)
+      {
+         t->handlers[t->numTracks++] = f->func;
+         snprintf(track, sizeof(track), "irq %s", profileName(t->prof, f->func, name, sizeof(name)));
+         trackName(t, i + 1, track);
+      }
+      t->tid[d] = i < MAXTRACKS ? i + 1 : MAXTRACKS;
+   }
+   sample(s, t);
+}
+
+// Span of frame d ending now
+static void span(struct hcs12 *s, struct timeline *t, struct frame *f, int d)
+{
+   double now = simTimeUs(s);
+   char name[64];
+
+   if(now - t->start[d] < t->minUs) return;
+   fprintf(event(t), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+                     "\"dur\":%.3f}", profileName(t->prof, f->func, name, sizeof(name)), PID,
+           t->tid[d], t->start[d], now - t->start[d]);
+}
+
+/*----------------------------------------------------
+Function: timelineLeave
+Description: Called when frame f (at s->depth) is left.
+------------------------------------------------------*/
+void timelineLeave(struct hcs12 *s, struct frame *f)
+{
+   struct timeline *t = s->timeline;
+
+   span(s, t, f, s->depth);
+   sample(s, t);
+}
+
+/*----------------------------------------------------
+Function: timelineClose
+Description: Ends the spans still open and the file.
+             Returns -1 on a write error.
+------------------------------------------------------*/
+int timelineClose(struct hcs12 *s)
+{
+   struct timeline *t = s->timeline;
+   int d, err;
+
+   for(d = s->depth - 1; d >= 0; d--) span(s, t, &s->frames[d], d);
+   fprintf(t->out, "\n]}\n");
+   err = ferror(t->out);
+   if(fclose(t->out) != 0) err = 1;
+   if(err) fprintf(stderr, "timeline: write error\n");
+   s->timeline = NULL;
+   free(t);
+   return(err ? -1 : 0);
+}
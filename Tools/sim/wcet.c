@@ -0,0 +1,1119 @@
+/*------------------------------------------------
+ * File: wcet.c
+ * Description: hcs12wcet - static worst case execution
+ *              time and stack depth of the interrupt
+ *              handlers (or of any routine) of an .s19
+ *              image.
+ *
+ *   hcs12wcet [-d] [-f MHz] [-m map|lst]... [-r routine,...]
+ *             [-l addr:count,...] [-p name:period_us[:percent],...]
+ *             [-M routine] [-P file.prm | -S bytes] file.s19
+ *
+ *      -d  a Lab 1 or Lab 2 program (DBug12 vectors are
+ *          set at run time: name the handlers with -r)
+ *      -f  bus clock for the micro-sec (24 MHz)
+ *      -m  symbols, as for hcs12sim (several allowed)
+ *      -r  routines to analyse instead of the vectors
+ *      -l  loop bounds: the most times the instruction
+ *          at addr (name+hex or hex, the loop head) runs
+ *          each time the loop is entered
+ *      -p  period of a handler and its budget (percent
+ *          of the period, 10 if not given); the exit
+ *          status is 2 when a handler is over its budget
+ *          or has no bound
+ *      -M  start of the main-line code for the stack (the
+ *          reset vector if not given)
+ *      -P  the stack size from STACKSIZE of the linker
+ *          file; -S gives it in bytes.  The exit status
+ *          is 2 when the worst depth does not fit.
+ *
+ *              The control flow graph of each routine is
+ *              built from the image, following every branch,
+ *              loop primitive and BRSET/BRCLR; calls are
+ *              analysed the same way, each routine once.
+ *              The cycles of an instruction (for each way
+ *              out of it) are those of the simulator - one
+ *              step of a scratch CPU - so they are the CPU12
+ *              Reference Manual figures used by hcs12sim.
+ *              The switch helpers of the C runtime
+ *              (_CASE_CHECKED_BYTE...), which jump through a
+ *              table after the JSR, are run for every value
+ *              of B to find the cases.
+ *
+ *              The bound of a routine is the longest path
+ *              from its entry to a return.  Loops must be
+ *              natural (one head) and have a bound (-l);
+ *              each adds (count - 1) times its longest pass.
+ *              Indirect jumps and calls, WAI, SWI and TRAP
+ *              leave a routine without a bound.
+ *
+ *              The stack depth of a routine is the most bytes
+ *              below SP at its entry it uses: the SP change
+ *              of each instruction is taken from the same
+ *              step (PSHx, LEAS -xx_VARSIZE,SP of the asm
+ *              frames, the JSR and the routine it calls...)
+ *              and must be the same on every path to an
+ *              instruction.  A load of SP (LDS in _Startup)
+ *              starts a new stack.  The worst depth is that
+ *              of the main-line code, plus the deepest
+ *              handler with its 9 bytes of registers, plus
+ *              every handler that clears the I bit (it can
+ *              be interrupted in turn).
+--------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hcs12.h"
+
+#define MAXFUNCS 256
+#define MAXSUCC 260      // ways out of an instruction (a switch helper has many)
+#define MAXNODES 4096    // instructions of a routine
+#define MAXLOOPS 64
+#define MAXBOUNDS 64
+#define MAXROOTS 64
+#define ENTRY_CYCLES 9   // interrupt entry: stacking and vector fetch
+#define VARIANTS 48      // CCR and register values tried on a branch
+#define HELPER_STEPS 64  // longest run of a switch helper
+#define UNBOUNDED -1LL
+#define NO_STACK -1      // stack depth not known
+#define SCRATCH_SP (RAM_START + 0x800)
+
+#define EXIT -1          // edge leaving the routine (RTS, RTC, RTI)
+
+// Ways out of an instruction
+#define W_NEXT 0   // to pc in the same routine
+#define W_CALL 1   // call of pc, back at ret
+#define W_EXIT 2   // return
+#define W_STOP 3   // no bound (why)
+
+struct way
+{
+   int kind;
+   word pc, ret;
+   byte page;
+   unsigned long cycles;
+   int push;                  // bytes it pushes (pulls if negative)
+   int peak;                  // deepest below SP before it, while it runs
+   int newStack;              // loads SP
+   int stackUnknown;          // W_STOP: goes where the stack is not known
+};
+
+struct edge
+{
+   int from, to;              // node, or EXIT
+   unsigned long long cost;   // cycles of the instruction (and of the routine it calls)
+   int back;                  // to the head of a loop
+   int push, peak, newStack;  // see struct way; peak includes the routine called
+};
+
+struct cfg
+{
+   word pc[MAXNODES];
+   int numNodes;
+   int *index;                // node of each address, -1 if none
+   struct edge *edges;
+   int numEdges, maxEdges;
+   int order[MAXNODES], rpo[MAXNODES], idom[MAXNODES];
+   long long extra[MAXNODES];  // cycles of the passes of a loop (at its head)
+};
+
+struct func
+{
+   unsigned long at;          // hcs12Linear
+   word pc;
+   byte page;
+   int done;                  // 0 not yet, 1 in progress, 2 done
+   long long wcet;            // cycles, UNBOUNDED if none
+   int loops;
+   char why[96];
+   int stack;                 // bytes, NO_STACK if not known
+   int nests;                 // clears the I bit (itself or a routine it calls)
+   int rti;                   // returns with RTI
+   char stackWhy[96];
+};
+
+struct bound
+{
+   unsigned long at;
+   unsigned long count;
+};
+
+static struct hcs12 cpu;       // scratch CPU that times the instructions
+static struct profile *prof;
+static struct func funcs[MAXFUNCS];
+static int numFuncs;
+static struct bound bounds[MAXBOUNDS];
+static int numBounds;
+static word scratchSP = SCRATCH_SP;
+static int pushed;             // bytes pushed by the last step
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: hcs12wcet [-d] [-f MHz] [-m map|lst]... [-r routine,...]\n"
+                   "                 [-l addr:count,...] [-p name:period_us[:percent],...]\n"
+                   "                 [-M routine] [-P file.prm | -S bytes] file.s19\n");
+   exit(1);
+}
+
+static unsigned long linear(word pc, byte page)
+{
+   cpu.ppage = page;
+   return(hcs12Linear(&cpu, pc));
+}
+
+static const char *nameOf(unsigned long a, char *buf, int size)
+{
+   return(profileName(prof, a, buf, size));
+}
+
+// Address of a name, name+hex or hex; -1 if unknown
+static long lookup(const char *text)
+{
+   char name[64], *plus;
+   long a;
+
+   snprintf(name, sizeof(name), "%s", text);
+   if((plus = strchr(name, '+')) == NULL) return(profileLookup(prof, name));
+   *plus = '\0';
+   if((a = profileLookup(prof, name)) < 0) return(-1);
+   return(a + strtol(plus + 1, NULL, 16));
+}
+
+/*----------------------------------------------------
+Function: step
+Description: Runs the instruction at pc on the scratch
+             CPU with the given CCR and register values.
+             Returns its cycles, the next pc in *next and
+             the bytes it pushed in pushed.
+------------------------------------------------------*/
+static unsigned long step(word pc, byte page, byte ccr, word reg, word *next)
+{
+   cpu.pc = pc;
+   cpu.ppage = page;
+   cpu.ccr = ccr;
+   cpu.a = cpu.b = (byte)reg;
+   cpu.x = cpu.y = reg;
+   cpu.sp = scratchSP;
+   cpu.cycles = 0;
+   cpu.state = ST_RUN;
+   cpu.depth = 1;
+   hcs12Step(&cpu);
+   *next = cpu.pc;
+   pushed = (short)(word)(scratchSP - cpu.sp);
+   return((unsigned long)cpu.cycles);
+}
+
+// Bytes of an indexed post byte and its offset
+static int idxLen(byte pb)
+{
+   if(!(pb & 0x20) || (pb & 0xC0) != 0xC0) return(1);  // 5-bit offset, auto inc/dec
+   if(pb & 0x04) return(1);                             // accumulator offset, [D,r]
+   return((pb & 0x02) ? 3 : 2);                         // 16-bit, [n16,r]; 9-bit
+}
+
+static int addWay(struct way *w, int n, int kind, word pc, byte page, unsigned long cycles)
+{
+   if(n == MAXSUCC) return(n);
+   w[n].kind = kind;
+   w[n].pc = pc;
+   w[n].page = page;
+   w[n].ret = 0;
+   w[n].cycles = cycles;
+   w[n].push = w[n].peak = w[n].newStack = w[n].stackUnknown = 0;
+   return(n + 1);
+}
+
+/*----------------------------------------------------
+Function: timeWays
+Description: Cycles of each way out of a branch, from
+             the variants of CCR and registers that take
+             it (the longest seen for one that none
+             takes, as BRSET on a register).
+------------------------------------------------------*/
+static void timeWays(word pc, byte page, struct way *w, int n)
+{
+   static const word regs[] = { 0x0000, 0x0001, 0xFFFF };
+   unsigned long c, most = 0, seen[MAXSUCC] = { 0 };
+   word next;
+   int v, i;
+
+   for(v = 0; v < VARIANTS; v++)
+   {
+      c = step(pc, page, (byte)(CC_S | CC_X | CC_I | (v & 0x0F)), regs[v / 16 % 3], &next);
+      if(c > most) most = c;
+      for(i = 0; i < n; i++)
+         if(w[i].pc == next && c > seen[i]) seen[i] = c;
+   }
+   for(i = 0; i < n; i++) w[i].cycles = seen[i] ? seen[i] : most;
+}
+
+// The name of the routine at a (without an offset) starts with prefix
+static int named(unsigned long a, const char *prefix)
+{
+   char name[64];
+   nameOf(a, name, sizeof(name));
+   return(strncmp(name, prefix, strlen(prefix)) == 0 && strchr(name, '+') == NULL);
+}
+
+/*----------------------------------------------------
+Function: caseWays
+Description: A JSR to a switch helper: runs it for each
+             value of B (D 0-255 for the word helpers)
+             until it jumps back out, and takes the
+             places it lands on as the ways out of the
+             JSR, with the cycles and the stack of the JSR
+             and helper.
+------------------------------------------------------*/
+static int caseWays(word pc, byte page, unsigned long helper, struct way *w)
+{
+   char hname[64], name[64];
+   unsigned long c;
+   word next, low;
+   int v, i, k, n = 0;
+
+   nameOf(helper, hname, sizeof(hname));
+   for(v = 0; v < 256; v++)
+   {
+      c = step(pc, page, CC_S | CC_X | CC_I, 0, &next);
+      cpu.a = 0;
+      cpu.b = (byte)v;
+      low = cpu.sp;
+      for(k = 0; k < HELPER_STEPS && cpu.state == ST_RUN; k++)
+      {
+         nameOf(linear(cpu.pc, cpu.ppage), name, sizeof(name));
+         if(strncmp(name, hname, strlen(hname)) != 0 ||
+            (name[strlen(hname)] != '\0' && name[strlen(hname)] != '+')) break;
+         hcs12Step(&cpu);
+         if(cpu.sp < low) low = cpu.sp;
+      }
+      if(k == HELPER_STEPS || cpu.state != ST_RUN) return(0);
+      c = (unsigned long)cpu.cycles;
+      for(i = 0; i < n && w[i].pc != cpu.pc; i++) ;
+      if(i == n) n = addWay(w, n, W_NEXT, cpu.pc, page, c);
+      else if(c > w[i].cycles) w[i].cycles = c;
+      w[i].push = (short)(word)(scratchSP - cpu.sp);
+      if(scratchSP - low > w[i].peak) w[i].peak = scratchSP - low;
+   }
+   return(n);
+}
+
+/*----------------------------------------------------
+Function: decode
+Description: The ways out of the instruction at pc.
+             Returns their number; why is set for W_STOP.
+------------------------------------------------------*/
+static int decode(word pc, byte page, struct way *w, char *why, int whySize)
+{
+   byte op, pb;
+   word next, t;
+   int n = 0, len, p;
+   unsigned long c;
+
+   cpu.ppage = page;
+   op = hcs12Read8(&cpu, pc);
+   switch(op)
+   {
+      case 0x00:
+         snprintf(why, whySize, "BGND");
+         return(addWay(w, 0, W_STOP, pc, page, 0));
+      case 0x3E:  // the registers it stacks are those of the interrupt that ends it
+         snprintf(why, whySize, "WAI");
+         n = addWay(w, 0, W_STOP, pc, page, 0);
+         return(addWay(w, n, W_NEXT, pc + 1, page, 0));
+      case 0x3F:
+         snprintf(why, whySize, "SWI");
+         n = addWay(w, 0, W_STOP, pc, page, 0);
+         w[0].stackUnknown = 1;
+         return(n);
+      case 0x0A: case 0x0B: case 0x3D:  // RTC RTI RTS
+         n = addWay(w, 0, W_EXIT, pc, page, step(pc, page, CC_S | CC_X | CC_I, 0, &next));
+         w[0].push = pushed;
+         return(n);
+      case 0x04:  // DBEQ DBNE TBEQ TBNE IBEQ IBNE
+         pb = hcs12Read8(&cpu, pc + 1);
+         t = pc + 3 + hcs12Read8(&cpu, pc + 2) - ((pb & 0x10) ? 0x100 : 0);
+         n = addWay(w, n, W_NEXT, pc + 3, page, 0);
+         n = addWay(w, n, W_NEXT, t, page, 0);
+         break;
+      case 0x06:  // JMP ext
+         return(addWay(w, 0, W_NEXT, hcs12Read16(&cpu, pc + 1), page,
+                       step(pc, page, CC_S | CC_X | CC_I, 0, &next)));
+      case 0x07:  // BSR
+         n = addWay(w, 0, W_CALL, pc + 2 + (signed char)hcs12Read8(&cpu, pc + 1), page,
+                    step(pc, page, CC_S | CC_X | CC_I, 0, &next));
+         w[0].ret = pc + 2;
+         w[0].peak = pushed;
+         return(n);
+      case 0x16: case 0x17:  // JSR ext, dir
+         len = op == 0x16 ? 3 : 2;
+         t = op == 0x16 ? hcs12Read16(&cpu, pc + 1) : hcs12Read8(&cpu, pc + 1);
+         if(named(linear(t, page), "_CASE_")) return(caseWays(pc, page, linear(t, page), w));
+         n = addWay(w, 0, W_CALL, t, page, step(pc, page, CC_S | CC_X | CC_I, 0, &next));
+         w[0].ret = pc + len;
+         w[0].peak = pushed;
+         return(n);
+      case 0x4A:  // CALL ext
+         n = addWay(w, 0, W_CALL, hcs12Read16(&cpu, pc + 1), hcs12Read8(&cpu, pc + 3),
+                    step(pc, page, CC_S | CC_X | CC_I, 0, &next));
+         w[0].ret = pc + 4;
+         w[0].peak = pushed;
+         return(n);
+      case 0x05: case 0x15:  // JMP JSR indexed: [n16,PC] through a constant
+         pb = hcs12Read8(&cpu, pc + 1);
+         if(pb == 0xFB)
+         {
+            t = hcs12Read16(&cpu, pc + 4 + hcs12Read16(&cpu, pc + 2));
+            c = step(pc, page, CC_S | CC_X | CC_I, 0, &next);
+            n = addWay(w, 0, op == 0x05 ? W_NEXT : W_CALL, t, page, c);
+            w[0].ret = pc + 4;
+            w[0].peak = pushed;
+            return(n);
+         }
+         snprintf(why, whySize, "indirect %s", op == 0x05 ? "jump" : "call");
+         n = addWay(w, 0, W_STOP, pc, page, 0);
+         w[0].stackUnknown = 1;
+         return(n);
+      case 0x4B:  // CALL indexed: [n16,PC] through a constant (DBug12 routines)
+         if(hcs12Read8(&cpu, pc + 1) == 0xFB)
+         {
+            word at = pc + 4 + hcs12Read16(&cpu, pc + 2);
+            c = step(pc, page, CC_S | CC_X | CC_I, 0, &next);
+            cpu.ppage = page;
+            n = addWay(w, 0, W_CALL, hcs12Read16(&cpu, at), hcs12Read8(&cpu, at + 2), c);
+            w[0].ret = pc + 4;
+            w[0].peak = pushed;
+            return(n);
+         }
+         snprintf(why, whySize, "indirect call");
+         n = addWay(w, 0, W_STOP, pc, page, 0);
+         w[0].stackUnknown = 1;
+         return(n);
+      case 0x0E: case 0x0F: case 0x1E: case 0x1F: case 0x4E: case 0x4F:  // BRSET BRCLR
+         len = op == 0x4E || op == 0x4F ? 4 : op == 0x1E || op == 0x1F ? 5
+             : 3 + idxLen(hcs12Read8(&cpu, pc + 1));
+         n = addWay(w, n, W_NEXT, pc + len, page, 0);
+         n = addWay(w, n, W_NEXT, pc + len + (signed char)hcs12Read8(&cpu, pc + len - 1), page, 0);
+         break;
+      case 0x18:
+         op = hcs12Read8(&cpu, pc + 1);
+         if(op >= 0x20 && op <= 0x2F)  // long branches
+         {
+            if(op != 0x21) n = addWay(w, n, W_NEXT, pc + 4 + hcs12Read16(&cpu, pc + 2), page, 0);
+            if(op != 0x20) n = addWay(w, n, W_NEXT, pc + 4, page, 0);
+            break;
+         }
+         if(op == 0x3E || (op >= 0x30 && op <= 0x39) || op >= 0x40)
+         {
+            snprintf(why, whySize, op == 0x3E ? "STOP" : "TRAP");
+            n = addWay(w, 0, W_STOP, pc, page, 0);
+            w[0].stackUnknown = op != 0x3E && !cpu.dbug12;  // DBug12 routines: not counted
+            return(n);
+         }
+         // other page 2 instructions run straight on
+      default:
+         if(op >= 0x20 && op <= 0x2F && hcs12Read8(&cpu, pc) != 0x18)  // short branches
+         {
+            t = pc + 2 + (signed char)hcs12Read8(&cpu, pc + 1);
+            if(op != 0x21) n = addWay(w, n, W_NEXT, t, page, 0);
+            if(op != 0x20 && t != pc + 2) n = addWay(w, n, W_NEXT, pc + 2, page, 0);
+            break;
+         }
+         scratchSP = SCRATCH_SP - 0x100;  // an SP that depends on it is loaded
+         step(pc, page, CC_S | CC_X | CC_I, 0, &next);
+         p = pushed;
+         scratchSP = SCRATCH_SP;
+         c = step(pc, page, CC_S | CC_X | CC_I, 0, &next);
+         if(cpu.state != ST_RUN)
+         {
+            snprintf(why, whySize, "instruction not simulated");
+            n = addWay(w, 0, W_STOP, pc, page, 0);
+            w[0].stackUnknown = 1;
+            return(n);
+         }
+         n = addWay(w, 0, W_NEXT, next, page, c);
+         w[0].newStack = p != pushed;
+         w[0].push = w[0].newStack ? 0 : pushed;
+         w[0].peak = w[0].push > 0 ? w[0].push : 0;
+         return(n);
+   }
+   timeWays(pc, page, w, n);
+   return(n);
+}
+
+static struct func *analyse(word pc, byte page);
+
+static int nodeOf(struct cfg *g, word pc)
+{
+   if(g->index[pc] < 0 && g->numNodes < MAXNODES)
+   {
+      g->index[pc] = g->numNodes;
+      g->pc[g->numNodes++] = pc;
+   }
+   return(g->index[pc]);
+}
+
+static void addEdge(struct cfg *g, int from, int to, unsigned long long cost, const struct way *w,
+                    int peak)
+{
+   if(g->numEdges == g->maxEdges)
+   {
+      g->maxEdges = g->maxEdges ? 2 * g->maxEdges : 256;
+      g->edges = realloc(g->edges, g->maxEdges * sizeof(*g->edges));
+   }
+   g->edges[g->numEdges].from = from;
+   g->edges[g->numEdges].to = to;
+   g->edges[g->numEdges].cost = cost;
+   g->edges[g->numEdges].push = w->kind == W_CALL ? 0 : w->push;
+   g->edges[g->numEdges].peak = peak;
+   g->edges[g->numEdges].newStack = w->newStack;
+   g->edges[g->numEdges++].back = 0;
+}
+
+// Sets f->why once (the first reason it has no bound)
+static void noBound(struct func *f, const char *why, word pc)
+{
+   char name[64];
+   if(f->wcet == UNBOUNDED) return;
+   f->wcet = UNBOUNDED;
+   snprintf(f->why, sizeof(f->why), "%s at %s", why, nameOf(linear(pc, f->page), name, sizeof(name)));
+}
+
+// Sets f->stackWhy once
+static void noStack(struct func *f, const char *why, word pc)
+{
+   char name[64];
+   if(f->stack == NO_STACK) return;
+   f->stack = NO_STACK;
+   snprintf(f->stackWhy, sizeof(f->stackWhy), "%s at %s", why,
+            nameOf(linear(pc, f->page), name, sizeof(name)));
+}
+
+/*----------------------------------------------------
+Function: build
+Description: Control flow graph of the routine f: every
+             instruction reachable from its entry, the
+             routines it calls analysed on the way.
+------------------------------------------------------*/
+static void build(struct cfg *g, struct func *f)
+{
+   struct way ways[MAXSUCC];    // not static: analyse() comes back here
+   char why[64], name[64];
+   int work[MAXNODES], numWork = 0, v, i, n, to, peak;
+   struct func *callee;
+   byte op;
+
+   work[numWork++] = nodeOf(g, f->pc);
+   while(numWork > 0)
+   {
+      v = work[--numWork];
+      op = hcs12Read8(&cpu, g->pc[v]);
+      if(op == 0x10 && !(hcs12Read8(&cpu, g->pc[v] + 1) & CC_I)) f->nests = 1;  // CLI
+      n = decode(g->pc[v], f->page, ways, why, sizeof(why));
+      if(n == 0)
+      {
+         noBound(f, "switch helper not understood", g->pc[v]);
+         noStack(f, "switch helper not understood", g->pc[v]);
+      }
+      for(i = 0; i < n; i++)
+      {
+         struct way *wy = &ways[i];
+         unsigned long long cost = wy->cycles;
+         word target = wy->pc;
+
+         peak = wy->peak;
+         if(wy->kind == W_STOP)
+         {
+            noBound(f, why, g->pc[v]);
+            if(wy->stackUnknown) noStack(f, why, g->pc[v]);
+            continue;
+         }
+         if(wy->kind == W_EXIT)
+         {
+            f->rti |= op == 0x0B;
+            addEdge(g, v, EXIT, cost, wy, peak);
+            continue;
+         }
+         if(wy->kind == W_CALL)
+         {
+            callee = analyse(wy->pc, wy->page);
+            snprintf(why, sizeof(why), "call of %s",
+                     nameOf(linear(wy->pc, wy->page), name, sizeof(name)));
+            if(callee->wcet == UNBOUNDED) noBound(f, why, g->pc[v]);
+            else cost += callee->wcet;
+            if(callee->stack == NO_STACK) noStack(f, why, g->pc[v]);
+            else peak += callee->stack;
+            f->nests |= callee->nests;
+            target = wy->ret;
+         }
+         if(g->index[target] < 0)
+         {
+            if((to = nodeOf(g, target)) < 0)
+            {
+               noBound(f, "routine too long", target);
+               noStack(f, "routine too long", target);
+               continue;
+            }
+            work[numWork++] = to;
+         }
+         addEdge(g, v, g->index[target], cost, wy, peak);
+      }
+   }
+}
+
+// Reverse post order from node v
+static void number(struct cfg *g, int v, int *seen, int *next)
+{
+   int e;
+
+   seen[v] = 1;
+   for(e = 0; e < g->numEdges; e++)
+      if(g->edges[e].from == v && g->edges[e].to != EXIT && !seen[g->edges[e].to])
+         number(g, g->edges[e].to, seen, next);
+   g->rpo[v] = --*next;
+   g->order[*next] = v;
+}
+
+/*----------------------------------------------------
+Function: dominators
+Description: Immediate dominators (Cooper, Harvey and
+             Kennedy), node 0 being the entry.
+------------------------------------------------------*/
+static void dominators(struct cfg *g)
+{
+   int changed = 1, i, e, v, a, b, best;
+
+   for(v = 0; v < g->numNodes; v++) g->idom[v] = -1;
+   g->idom[0] = 0;
+   while(changed)
+   {
+      changed = 0;
+      for(i = 1; i < g->numNodes; i++)
+      {
+         v = g->order[i];
+         best = -1;
+         for(e = 0; e < g->numEdges; e++)
+         {
+            if(g->edges[e].to != v || g->idom[g->edges[e].from] < 0) continue;
+            a = g->edges[e].from;
+            if(best < 0)
+            {
+               best = a;
+               continue;
+            }
+            b = best;
+            while(a != b)
+            {
+               while(g->rpo[a] > g->rpo[b]) a = g->idom[a];
+               while(g->rpo[b] > g->rpo[a]) b = g->idom[b];
+            }
+            best = a;
+         }
+         if(best != g->idom[v])
+         {
+            g->idom[v] = best;
+            changed = 1;
+         }
+      }
+   }
+}
+
+static int dominates(struct cfg *g, int h, int v)
+{
+   while(v != h && v != 0) v = g->idom[v];
+   return(v == h);
+}
+
+// Longest paths from node from over the edges that are not back edges,
+// within the nodes of in (all if NULL), adding the loop passes
+static void longest(struct cfg *g, int from, const char *in, long long *dist)
+{
+   int i, e, v, w;
+
+   for(v = 0; v < g->numNodes; v++) dist[v] = UNBOUNDED;
+   dist[from] = from == 0 ? g->extra[0] : 0;
+   for(i = g->rpo[from]; i < g->numNodes; i++)
+   {
+      v = g->order[i];
+      if(dist[v] == UNBOUNDED || (in && !in[v])) continue;
+      for(e = 0; e < g->numEdges; e++)
+      {
+         w = g->edges[e].to;
+         if(g->edges[e].from != v || w == EXIT || g->edges[e].back || (in && !in[w])) continue;
+         if(dist[v] + (long long)g->edges[e].cost + g->extra[w] > dist[w])
+            dist[w] = dist[v] + g->edges[e].cost + g->extra[w];
+      }
+   }
+}
+
+/*----------------------------------------------------
+Function: bound
+Description: The longest path of the graph of f from its
+             entry to a return, each loop head adding
+             (count - 1) passes of its loop.  The loops
+             are done from the innermost out.
+------------------------------------------------------*/
+static long long bound(struct cfg *g, struct func *f)
+{
+   static char body[MAXLOOPS][MAXNODES];
+   int heads[MAXLOOPS], size[MAXLOOPS], numLoops = 0, *seen, next = g->numNodes;
+   int e, i, j, k, v, h, changed;
+   long long *dist, best = UNBOUNDED;
+   unsigned long at;
+
+   seen = calloc(g->numNodes, sizeof(*seen));
+   dist = malloc(g->numNodes * sizeof(*dist));
+   number(g, 0, seen, &next);
+   dominators(g);
+
+   // Back edges and the bodies of their loops
+   for(e = 0; e < g->numEdges && f->wcet != UNBOUNDED; e++)
+   {
+      struct edge *ed = &g->edges[e];
+      if(ed->to == EXIT || g->rpo[ed->to] > g->rpo[ed->from]) continue;
+      if(!dominates(g, ed->to, ed->from))
+      {
+         noBound(f, "loop with two entries", g->pc[ed->to]);
+         break;
+      }
+      ed->back = 1;
+      for(i = 0; i < numLoops && heads[i] != ed->to; i++) ;
+      if(i == numLoops)
+      {
+         if(numLoops == MAXLOOPS)
+         {
+            noBound(f, "too many loops", g->pc[ed->to]);
+            break;
+         }
+         heads[numLoops] = ed->to;
+         memset(body[numLoops], 0, g->numNodes);
+         body[numLoops][ed->to] = 1;
+         numLoops++;
+      }
+      body[i][ed->from] = 1;
+   }
+   for(i = 0; i < numLoops; i++)  // everything that reaches a latch without the head
+   {
+      changed = 1;
+      while(changed)
+      {
+         changed = 0;
+         for(e = 0; e < g->numEdges; e++)
+         {
+            struct edge *ed = &g->edges[e];
+            if(ed->to != EXIT && body[i][ed->to] && ed->to != heads[i] && !body[i][ed->from])
+               changed = body[i][ed->from] = 1;
+         }
+      }
+      for(size[i] = 0, v = 0; v < g->numNodes; v++) size[i] += body[i][v];
+   }
+
+   for(v = 0; v < g->numNodes; v++) g->extra[v] = 0;
+   for(k = 0; k < numLoops && f->wcet != UNBOUNDED; k++)
+   {
+      long long pass = 0;
+      for(i = -1, j = 0; j < numLoops; j++)  // innermost (smallest) not done yet
+         if(size[j] > 0 && (i < 0 || size[j] < size[i])) i = j;
+      h = heads[i];
+      size[i] = 0;
+      at = linear(g->pc[h], f->page);
+      for(j = 0; j < numBounds && bounds[j].at != at; j++) ;
+      if(j == numBounds)
+      {
+         noBound(f, "loop without a bound (-l)", g->pc[h]);
+         break;
+      }
+      longest(g, h, body[i], dist);
+      for(e = 0; e < g->numEdges; e++)
+         if(g->edges[e].back && g->edges[e].to == h && dist[g->edges[e].from] != UNBOUNDED &&
+            dist[g->edges[e].from] + (long long)g->edges[e].cost > pass)
+            pass = dist[g->edges[e].from] + g->edges[e].cost;
+      g->extra[h] = bounds[j].count > 1 ? (long long)(bounds[j].count - 1) * pass : 0;
+      f->loops++;
+   }
+
+   if(f->wcet != UNBOUNDED)
+   {
+      longest(g, 0, NULL, dist);
+      for(e = 0; e < g->numEdges; e++)
+         if(g->edges[e].to == EXIT && dist[g->edges[e].from] != UNBOUNDED &&
+            dist[g->edges[e].from] + (long long)g->edges[e].cost > best)
+            best = dist[g->edges[e].from] + g->edges[e].cost;
+      if(best == UNBOUNDED) noBound(f, "no return", f->pc);
+   }
+   free(seen);
+   free(dist);
+   return(f->wcet == UNBOUNDED ? UNBOUNDED : best);
+}
+
+/*----------------------------------------------------
+Function: stackDepth
+Description: The most bytes below SP at the entry of f
+             that it uses, the bytes pushed at each
+             instruction being the same on every path to
+             it and none left at a return.
+------------------------------------------------------*/
+static int stackDepth(struct cfg *g, struct func *f)
+{
+   int *depth = malloc(g->numNodes * sizeof(int)), *work = malloc(g->numNodes * sizeof(int));
+   int numWork = 0, most = 0, e, v, d;
+
+   for(v = 0; v < g->numNodes; v++) depth[v] = NO_STACK;
+   depth[0] = 0;
+   work[numWork++] = 0;
+   while(numWork > 0 && f->stack != NO_STACK)
+   {
+      v = work[--numWork];
+      for(e = 0; e < g->numEdges; e++)
+      {
+         struct edge *ed = &g->edges[e];
+         if(ed->from != v) continue;
+         if(depth[v] + ed->peak > most) most = depth[v] + ed->peak;
+         if(ed->to == EXIT)
+         {
+            if(depth[v] != 0) noStack(f, "stack not balanced at the return", g->pc[v]);
+            continue;
+         }
+         d = ed->newStack ? 0 : depth[v] + ed->push;
+         if(d < 0) noStack(f, "pulls more than it pushed", g->pc[v]);
+         else if(depth[ed->to] == NO_STACK)
+         {
+            depth[ed->to] = d;
+            work[numWork++] = ed->to;
+         }
+         else if(depth[ed->to] != d && !ed->newStack)
+            noStack(f, "stack not the same on every path", g->pc[ed->to]);
+      }
+   }
+   free(depth);
+   free(work);
+   return(f->stack == NO_STACK ? NO_STACK : most);
+}
+
+/*----------------------------------------------------
+Function: analyse
+Description: Analyses the routine at pc, once: the
+             bound of its cycles from its first
+             instruction to its return included
+             (UNBOUNDED if it has none) and its stack
+             depth (NO_STACK if not known).
+------------------------------------------------------*/
+static struct func *analyse(word pc, byte page)
+{
+   unsigned long at = linear(pc, page);
+   struct func *f;
+   struct cfg *g;
+   int i;
+
+   for(i = 0; i < numFuncs && funcs[i].at != at; i++) ;
+   if(i < numFuncs)
+   {
+      if(funcs[i].done == 1)
+      {
+         noBound(&funcs[i], "recursion", pc);
+         noStack(&funcs[i], "recursion", pc);
+      }
+      return(&funcs[i]);
+   }
+   if(numFuncs == MAXFUNCS)
+   {
+      fprintf(stderr, "hcs12wcet: more than %d routines\n", MAXFUNCS);
+      exit(1);
+   }
+   f = &funcs[numFuncs++];
+   f->at = at;
+   f->pc = pc;
+   f->page = page;
+   f->done = 1;
+
+   g = calloc(1, sizeof(*g));
+   g->index = malloc(0x10000 * sizeof(int));
+   for(i = 0; i < 0x10000; i++) g->index[i] = -1;
+   build(g, f);
+   if(f->stack != NO_STACK) f->stack = stackDepth(g, f);
+   if(f->wcet != UNBOUNDED) f->wcet = bound(g, f);
+   free(g->index);
+   free(g->edges);
+   free(g);
+   f->done = 2;
+   return(f);
+}
+
+static struct func *funcAt(unsigned long at)
+{
+   int i;
+   for(i = 0; i < numFuncs; i++)
+      if(funcs[i].at == at) return(&funcs[i]);
+   return(NULL);
+}
+
+// STACKSIZE of a linker parameter file, -1 if none
+static long prmStack(const char *path)
+{
+   FILE *in = fopen(path, "r");
+   char line[256];
+   long size = -1;
+
+   if(in == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), in))
+      if(strncmp(line, "STACKSIZE", 9) == 0) size = strtol(line + 9, NULL, 0);
+   fclose(in);
+   if(size < 0) fprintf(stderr, "hcs12wcet: no STACKSIZE in %s\n", path);
+   return(size);
+}
+
+// Splits a linear address into pc and page
+static word pcOf(unsigned long a, byte *page)
+{
+   *page = a >= 0x10000 ? FIRST_PAGE + (a - 0x10000) / PAGE_SIZE : 0x3D;
+   return(a >= 0x10000 ? WIN_START + (a - 0x10000) % PAGE_SIZE : (word)a);
+}
+
+struct root
+{
+   unsigned long at;
+   word pc, vector;             // vector 0: a routine named with -r
+   byte page;
+   double periodUs, percent;   // no check if periodUs is 0
+};
+
+int main(int argc, char *argv[])
+{
+   static struct image img;
+   static struct root roots[MAXROOTS];
+   const char *file = NULL, *routines = NULL, *periods = NULL, *loops = NULL;
+   const char *mainLine = NULL, *prm = NULL;
+   double mhz = 24.0;
+   long stackSize = -1;
+   int numRoots = 0, over = 0, i, j;
+   char buf[256], name[64], *p;
+   struct func *top = NULL;
+
+   prof = profileNew();
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-d") == 0) cpu.dbug12 = 1;
+      else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) mhz = atof(argv[++i]);
+      else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+      {
+         const char *sym = argv[++i];
+         if((strstr(sym, ".lst") ? profileLoadLst(prof, sym) : profileLoadMap(prof, sym)) < 0)
+            return(1);
+      }
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) routines = argv[++i];
+      else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) loops = argv[++i];
+      else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) periods = argv[++i];
+      else if(strcmp(argv[i], "-M") == 0 && i + 1 < argc) mainLine = argv[++i];
+      else if(strcmp(argv[i], "-P") == 0 && i + 1 < argc) prm = argv[++i];
+      else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc) stackSize = strtol(argv[++i], NULL, 0);
+      else if(argv[i][0] == '-' || file) usage();
+      else file = argv[i];
+   }
+   if(file == NULL || mhz <= 0) usage();
+   if(prm && (stackSize = prmStack(prm)) < 0) return(1);
+   if(cpu.dbug12 && routines == NULL)
+   {
+      fprintf(stderr, "hcs12wcet: the DBug12 vectors are set at run time, name the handlers with -r\n");
+      return(1);
+   }
+
+   imageInit(&img);
+   if(loadS19(&img, file) != 0) return(1);
+   if(cpu.dbug12)
+   {
+      dbug12Install(&img);
+      dbug12Symbols(prof);
+   }
+   hcs12Reset(&cpu, &img);
+   profileAttach(prof, &cpu);
+   cpu.onLeave = NULL;          // the scratch CPU keeps no profile
+   cpu.pcCycles = NULL;
+   cpu.ee.accerr = 1UL << 30;    // nor reports the EEPROM commands it breaks
+
+   if(loops)
+   {
+      snprintf(buf, sizeof(buf), "%s", loops);
+      for(p = strtok(buf, ","); p && numBounds < MAXBOUNDS; p = strtok(NULL, ","))
+      {
+         char *colon = strchr(p, ':');
+         long a;
+         if(colon == NULL) usage();
+         *colon = '\0';
+         if((a = lookup(p)) < 0)
+         {
+            fprintf(stderr, "hcs12wcet: unknown loop %s\n", p);
+            return(1);
+         }
+         bounds[numBounds].at = (unsigned long)a;
+         bounds[numBounds++].count = strtoul(colon + 1, NULL, 0);
+      }
+   }
+
+   // Roots: the named routines, or the handlers in the vector table
+   if(routines)
+   {
+      snprintf(buf, sizeof(buf), "%s", routines);
+      for(p = strtok(buf, ","); p && numRoots < MAXROOTS; p = strtok(NULL, ","))
+      {
+         long a = lookup(p);
+         if(a < 0)
+         {
+            fprintf(stderr, "hcs12wcet: unknown routine %s\n", p);
+            return(1);
+         }
+         roots[numRoots].at = (unsigned long)a;
+         roots[numRoots].pc = pcOf((unsigned long)a, &roots[numRoots].page);
+         numRoots++;
+      }
+   }
+   else
+   {
+      word v, h;
+      for(v = 0xFF80; v < VEC_RESET; v += 2)
+      {
+         h = hcs12Read16(&cpu, v);
+         if(h == 0xFFFF || h == 0x0000 || h == hcs12Read16(&cpu, VEC_RESET)) continue;
+         for(j = 0; j < numRoots && roots[j].pc != h; j++) ;
+         if(j < numRoots || numRoots == MAXROOTS) continue;  // shared by several vectors
+         roots[numRoots].at = linear(h, 0x3D);
+         roots[numRoots].page = 0x3D;
+         roots[numRoots].vector = v;
+         roots[numRoots++].pc = h;
+      }
+   }
+
+   if(periods)
+   {
+      snprintf(buf, sizeof(buf), "%s", periods);
+      for(p = strtok(buf, ","); p; p = strtok(NULL, ","))
+      {
+         char *f1 = strchr(p, ':'), *f2;
+         long a;
+         if(f1 == NULL) usage();
+         *f1++ = '\0';
+         if((f2 = strchr(f1, ':')) != NULL) *f2++ = '\0';
+         a = lookup(p);
+         for(j = 0; j < numRoots && (long)roots[j].at != a; j++) ;
+         if(j == numRoots)
+         {
+            fprintf(stderr, "hcs12wcet: %s is not a handler analysed\n", p);
+            return(1);
+         }
+         roots[j].periodUs = atof(f1);
+         roots[j].percent = f2 ? atof(f2) : 10.0;
+      }
+   }
+
+   for(i = 0; i < numRoots; i++) analyse(roots[i].pc, roots[i].page);
+   if(mainLine || !cpu.dbug12)
+   {
+      long a = mainLine ? lookup(mainLine) : hcs12Read16(&cpu, VEC_RESET);
+      byte page = 0x3D;
+      if(a < 0)
+      {
+         fprintf(stderr, "hcs12wcet: unknown routine %s\n", mainLine);
+         return(1);
+      }
+      top = analyse(pcOf((unsigned long)a, &page), page);
+   }
+
+   printf("worst case execution time of %s, %.1f MHz bus\n"
+          "(from the first instruction to the return; the interrupt entry adds %d cycles)\n\n",
+          file, mhz, ENTRY_CYCLES);
+   printf("%-6s %-24s %8s %9s %10s %7s %7s\n", "vector", "handler", "cycles", "us", "period us",
+          "budget", "use");
+   for(i = 0; i < numRoots; i++)
+   {
+      struct root *r = &roots[i];
+      struct func *f = funcAt(r->at);
+      long long c = f->wcet == UNBOUNDED ? UNBOUNDED : f->wcet + (r->vector ? ENTRY_CYCLES : 0);
+
+      if(r->vector) printf("%04X   ", r->vector);
+      else printf("%-6s ", "-");
+      printf("%-24s ", nameOf(r->at, name, sizeof(name)));
+      if(c == UNBOUNDED) printf("%8s %9s", "none", "");
+      else printf("%8lld %9.3f", c, c / mhz);
+      if(r->periodUs > 0)
+      {
+         double use = c == UNBOUNDED ? 0 : 100.0 * c / mhz / r->periodUs;
+         int bad = c == UNBOUNDED || use > r->percent;
+         printf(" %10.1f %6.1f%% ", r->periodUs, r->percent);
+         if(c == UNBOUNDED) printf("%7s", "");
+         else printf("%6.1f%%", use);
+         printf("%s", bad ? "  OVER" : "  ok");
+         over += bad;
+      }
+      printf("\n");
+   }
+
+   printf("\n%-24s %8s %9s %6s\n", "routine", "cycles", "us", "stack");
+   for(i = 0; i < numFuncs; i++)
+   {
+      struct func *f = &funcs[i];
+      printf("%-24s ", nameOf(f->at, name, sizeof(name)));
+      if(f->wcet == UNBOUNDED) printf("%8s %9s", "none", "");
+      else printf("%8lld %9.3f", f->wcet, f->wcet / mhz);
+      if(f->stack == NO_STACK) printf(" %6s", "?");
+      else printf(" %6d", f->stack);
+      if(f->wcet == UNBOUNDED) printf("  %s", f->why);
+      else if(f->loops) printf("  %d loop%s", f->loops, f->loops > 1 ? "s" : "");
+      if(f->stack == NO_STACK && strcmp(f->why, f->stackWhy) != 0)
+         printf("%s%s", f->wcet == UNBOUNDED ? "; " : "  ", f->stackWhy);
+      printf("\n");
+   }
+   if(periods) printf("\n%d handler%s over budget\n", over, over == 1 ? "" : "s");
+
+   // Worst stack: main-line, the deepest handler, and those that let others in
+   {
+      int nested = 0, deepest = 0, known = 1, total;
+      struct func *worst = NULL;
+
+      printf("\nstack depth in bytes (return addresses and interrupt registers included%s)\n",
+             cpu.dbug12 ? ",\nnot the stack of the DBug12 routines" : "");
+      if(top && top->stack == NO_STACK)
+         printf("   %-22s %6s  %s: %s\n", "main-line", "?", nameOf(top->at, name, sizeof(name)),
+                top->stackWhy);
+      else if(top)
+         printf("   %-22s %6d  %s\n", "main-line", top->stack, nameOf(top->at, name, sizeof(name)));
+      for(i = 0; i < numRoots; i++)
+      {
+         struct func *f = funcAt(roots[i].at);
+         if(!roots[i].vector && !f->rti) continue;
+         if(f->stack == NO_STACK)
+         {
+            known = 0;
+            continue;
+         }
+         if(f->nests) nested += ENTRY_CYCLES + f->stack;
+         else if(ENTRY_CYCLES + f->stack > deepest)
+         {
+            deepest = ENTRY_CYCLES + f->stack;
+            worst = f;
+         }
+      }
+      if(worst) printf("   %-22s %6d  %s (9 + %d)\n", "deepest handler", deepest,
+                       nameOf(worst->at, name, sizeof(name)), worst->stack);
+      if(nested) printf("   %-22s %6d\n", "handlers that clear I", nested);
+      if(top == NULL || top->stack == NO_STACK || !known)
+      {
+         printf("   worst not known\n");
+         if(stackSize >= 0) over++;
+      }
+      else
+      {
+         total = top->stack + deepest + nested;
+         printf("   %-22s %6d", "worst", total);
+         if(stackSize >= 0)
+         {
+            printf(" of %ld, %ld %s", stackSize, labs(stackSize - total),
+                   total > stackSize ? "OVER" : "free");
+            over += total > stackSize;
+         }
+         printf("\n");
+      }
+   }
+   return(over ? 2 : 0);
+}
@@ -0,0 +1,630 @@
+/*-------------------------------------------------------------
+ * File:  station.c
+ * Description: Monitoring station.  Receives the telemetry
+ *              frames (Lab 4/Sources/telem.h) of many panels,
+ *              one stream per panel on a Unix domain socket or
+ *              a pseudo-terminal, and keeps the state of each
+ *              panel.  Each worker thread waits on its own epoll
+ *              set; the listening socket is in all of them
+ *              (EPOLLEXCLUSIVE), so a panel belongs to the worker
+ *              that accepted it and its state is never shared.
+ *              A read goes into the worker's buffer and the
+ *              frames are decoded in place (telem/telemproto.c).
+ *
+ *  Usage: station serve [-w workers] [-y ptys] [-q] socket
+ *         station bench [-w workers] [-c clients] [-p panels]
+ *                       [-t seconds] [-r rate]
+ *
+ *      serve  prints the state changes of the panels (-q: the
+ *             alarms only) and the summary of a panel when it
+ *             hangs up, until interrupted.  -y also opens that
+ *             many pseudo-terminals and prints their names (for
+ *             alarmhost run -o).
+ *      bench  runs the station and -p panels (default 1000) on
+ *             -c client threads (default as many as workers) in
+ *             one process for -t seconds (default 5).  A panel
+ *             sends its script of frames as fast as it can, or
+ *             -r frames per second.  The alarm frames carry their
+ *             send time (a third value) and the station measures
+ *             the time to handling them.
+-----------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../telem/telemproto.h"
+
+#define MAXWORKERS 64
+#define MAXEVENTS 256
+#define READSIZE 65536
+#define LAT_BUCKETS 100000  // 10 us each, up to 1 s
+#define LAT_STEP 10
+#define BURST 64            // frames per write in bench
+
+struct worker;
+
+struct panel
+{
+   struct tm_parser parser;  // carry of a split frame, counts
+   struct worker *w;
+   int id;
+   int pty;                 // a pseudo-terminal: never hangs up
+   int state;               // TS_IDLE ..., -1 before the first
+   int zone;
+   unsigned long ms;        // time of the last frame
+   unsigned long load, stack;
+   unsigned long long alarms, keys;
+};
+
+struct worker
+{
+   pthread_t thread;
+   int epfd;
+   unsigned char buf[READSIZE];
+   unsigned long long frames, bytes, alarms, crcErrors, lost, bad;
+   unsigned long *latency;  // LAT_BUCKETS + 1 (over 1 s)
+};
+
+static struct worker workers[MAXWORKERS];
+static struct panel **panels;   // by fd
+static int maxFds;
+static int listenFd = -1;
+static int nWorkers = 1;
+static int quiet, bench;
+static volatile sig_atomic_t stopping;
+static int nextId, closed;      // __atomic
+static struct timespec epoch;
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: station serve [-w workers] [-y ptys] [-q] socket\n"
+                   "       station bench [-w workers] [-c clients] [-p panels] [-t seconds] [-r rate]\n");
+   exit(1);
+}
+
+// Micro-seconds since epoch (the start)
+static unsigned long long nowUs(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return((t.tv_sec - epoch.tv_sec) * 1000000ULL + t.tv_nsec / 1000 - epoch.tv_nsec / 1000);
+}
+
+static const char *stateName(int state)
+{
+   return(state < 0 ? "none" : tmStateName(state));
+}
+
+/*----------------------------------------------------
+Function: onFrame
+Description: tm_handler of the panels: updates the state
+             of the panel.  The alarm frames of bench carry
+             their send time: the latency goes into the
+             worker's histogram.
+------------------------------------------------------*/
+static void onFrame(void *ctx, const struct tm_frame *f)
+{
+   struct panel *p = ctx;
+   struct worker *w = p->w;
+   unsigned long v[TM_MAX_VALUES], lat;
+   int n = tmValues(f, v, TM_MAX_VALUES);
+
+   if(n < 2)
+   {
+      w->bad++;
+      return;
+   }
+   w->frames++;
+   p->ms = v[0];
+   switch(f->type)
+   {
+      case TM_BOOT:
+         p->state = -1;
+         if(!quiet && !bench) printf("panel %d %10.3f s  boot, version %lu\n", p->id, v[0] / 1000.0, v[1]);
+         break;
+      case TM_STATE:
+         if((int)v[1] == p->state) break;
+         if(v[1] == TS_ALARM)
+         {
+            p->alarms++;
+            w->alarms++;
+            if(bench && n >= 3)
+            {
+               lat = (unsigned long)((nowUs() - v[2]) & 0xFFFFFFFFUL) / LAT_STEP;
+               w->latency[lat < LAT_BUCKETS ? lat : LAT_BUCKETS]++;
+            }
+         }
+         if(!bench && (!quiet || v[1] == TS_ALARM))
+            printf("panel %d %10.3f s  %s -> %s\n", p->id, v[0] / 1000.0, stateName(p->state),
+                   tmStateName(v[1]));
+         p->state = (int)v[1];
+         break;
+      case TM_ZONE:
+         p->zone = (int)v[1];
+         break;
+      case TM_KEY:
+         p->keys++;
+         break;
+      case TM_COUNTERS:
+         if(n >= 4)
+         {
+            p->stack = v[1];
+            p->load = v[3];
+         }
+         break;
+   }
+}
+
+static void addPanel(struct worker *w, int fd, int pty)
+{
+   struct epoll_event ev;
+   struct panel *p;
+
+   if(fd >= maxFds || (p = calloc(1, sizeof(*p))) == NULL)
+   {
+      close(fd);
+      return;
+   }
+   tmInit(&p->parser);
+   p->w = w;
+   p->id = __atomic_fetch_add(&nextId, 1, __ATOMIC_RELAXED);
+   p->pty = pty;
+   p->state = -1;
+   panels[fd] = p;
+   ev.events = EPOLLIN;
+   ev.data.fd = fd;
+   if(epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) != 0)
+   {
+      perror("epoll_ctl");
+      panels[fd] = NULL;
+      free(p);
+      close(fd);
+   }
+}
+
+// Adds the counts of the panel to its worker
+static void countPanel(struct panel *p)
+{
+   p->w->bytes += p->parser.bytes;
+   p->w->crcErrors += p->parser.crcErrors;
+   p->w->lost += p->parser.lost;
+}
+
+static void printPanel(const struct panel *p, const char *how)
+{
+   printf("panel %d %s: %llu frames, %s, switches %02X, %llu keys, %llu alarms, "
+          "%llu CRC errors, %llu lost\n", p->id, how, p->parser.frames, stateName(p->state),
+          p->zone, p->keys, p->alarms, p->parser.crcErrors, p->parser.lost);
+}
+
+static void closePanel(struct worker *w, int fd)
+{
+   struct panel *p = panels[fd];
+
+   // Free the slot before the fd, which another worker may reuse
+   epoll_ctl(w->epfd, EPOLL_CTL_DEL, fd, NULL);
+   panels[fd] = NULL;
+   close(fd);
+   countPanel(p);
+   if(!bench) printPanel(p, "hung up");
+   free(p);
+   __atomic_fetch_add(&closed, 1, __ATOMIC_RELEASE);
+}
+
+/*----------------------------------------------------
+Function: workerMain
+Description: Accepts panels and reads their streams until
+             stopping.  Each ready panel gets one read (the
+             sets are level triggered), so a busy panel does
+             not hold up the others.
+------------------------------------------------------*/
+static void *workerMain(void *arg)
+{
+   struct worker *w = arg;
+   struct epoll_event ev[MAXEVENTS];
+   struct panel *p;
+   ssize_t r;
+   int n, i, fd;
+
+   while(!stopping)
+   {
+      n = epoll_wait(w->epfd, ev, MAXEVENTS, 100);
+      for(i = 0; i < n; i++)
+      {
+         fd = ev[i].data.fd;
+         if(fd == listenFd)
+         {
+            while((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+               addPanel(w, fd, 0);
+            continue;
+         }
+         if((p = panels[fd]) == NULL) continue;
+         r = read(fd, w->buf, READSIZE);
+         if(r > 0) tmParse(&p->parser, w->buf, (size_t)r, onFrame, p);
+         else if(r == 0 || (errno != EAGAIN && errno != EINTR)) closePanel(w, fd);
+      }
+   }
+   return(NULL);
+}
+
+static int openListener(const char *path)
+{
+   struct sockaddr_un addr;
+
+   if(strlen(path) >= sizeof(addr.sun_path))
+   {
+      fprintf(stderr, "%s: path too long\n", path);
+      return(-1);
+   }
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, path);
+   unlink(path);
+   if((listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+      bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 4096) != 0)
+   {
+      perror(path);
+      return(-1);
+   }
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: openPty
+Description: Opens a pseudo-terminal in raw mode for the
+             panel of worker w and prints the name of its
+             terminal side.  The station keeps that side
+             open too, so the panel can come and go.
+------------------------------------------------------*/
+static int openPty(struct worker *w)
+{
+   struct termios tio;
+   int master, slave;
+   const char *name;
+
+   if((master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)) < 0 || grantpt(master) != 0 ||
+      unlockpt(master) != 0 || (name = ptsname(master)) == NULL ||
+      (slave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC)) < 0)
+   {
+      perror("pseudo-terminal");
+      return(-1);
+   }
+   tcgetattr(slave, &tio);
+   cfmakeraw(&tio);
+   tcsetattr(slave, TCSANOW, &tio);
+   printf("panel %d on %s\n", __atomic_load_n(&nextId, __ATOMIC_RELAXED), name);
+   addPanel(w, master, 1);
+   return(0);
+}
+
+static int startWorkers(void)
+{
+   struct epoll_event ev;
+   struct tm_parser dummy;
+   struct rlimit lim;
+   int i;
+
+   tmInit(&dummy);   // makes the CRC table before the threads
+   if(getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max)
+   {
+      lim.rlim_cur = lim.rlim_max;
+      setrlimit(RLIMIT_NOFILE, &lim);
+   }
+   maxFds = getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur != RLIM_INFINITY ? (int)lim.rlim_cur : 65536;
+   panels = calloc(maxFds, sizeof(*panels));
+   for(i = 0; i < nWorkers; i++)
+   {
+      workers[i].latency = calloc(LAT_BUCKETS + 1, sizeof(unsigned long));
+      if(panels == NULL || workers[i].latency == NULL || (workers[i].epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+      {
+         perror("station");
+         return(-1);
+      }
+      ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+      ev.data.fd = listenFd;
+      if(epoll_ctl(workers[i].epfd, EPOLL_CTL_ADD, listenFd, &ev) != 0)
+      {
+         perror("epoll_ctl");
+         return(-1);
+      }
+   }
+   return(0);
+}
+
+static void runWorkers(void)
+{
+   int i;
+
+   for(i = 0; i < nWorkers; i++) pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]);
+}
+
+// Stops the workers and adds the counts of the panels still open
+static void stopWorkers(void)
+{
+   int i, fd;
+
+   stopping = 1;
+   for(i = 0; i < nWorkers; i++) pthread_join(workers[i].thread, NULL);
+   for(fd = 0; fd < maxFds; fd++)
+   {
+      if(panels[fd] == NULL) continue;
+      countPanel(panels[fd]);
+      if(!bench) printPanel(panels[fd], "open");
+   }
+}
+
+static void onSignal(int sig)
+{
+   (void)sig;
+   stopping = 1;
+}
+
+static int serve(const char *path, int ptys)
+{
+   int i;
+
+   if(openListener(path) != 0 || startWorkers() != 0) return(1);
+   for(i = 0; i < ptys; i++)
+      if(openPty(&workers[i % nWorkers]) != 0) return(1);
+   signal(SIGINT, onSignal);
+   signal(SIGTERM, onSignal);
+   printf("listening on %s, %d workers\n", path, nWorkers);
+   fflush(stdout);
+   runWorkers();
+   while(!stopping) pause();
+   stopWorkers();
+   unlink(path);
+   return(0);
+}
+
+//----------------------------------------------------
+// bench
+
+struct client
+{
+   pthread_t thread;
+   int count;               // panels
+   int *fds;
+   int *seqs;
+   double rate;             // frames per second per panel, 0 = no limit
+   unsigned long long start, end;  // us
+   unsigned long long frames;
+};
+
+// The script of a panel: disarmed, code entered, armed, a zone
+// opens, alarm, reset
+static const int script[][2] =
+{
+   { TM_STATE, TS_IDLE }, { TM_KEY, 'a' }, { TM_KEY, 'x' }, { TM_KEY, 'x' }, { TM_KEY, 'x' },
+   { TM_KEY, 'x' }, { TM_STATE, TS_ARMING }, { TM_STATE, TS_ARMED }, { TM_ZONE, 0x02 },
+   { TM_STATE, TS_ALARM }, { TM_ZONE, 0x00 }
+};
+#define SCRIPT_LEN (int)(sizeof(script) / sizeof(script[0]))
+
+// Writes all of n bytes
+static int writeAll(int fd, const unsigned char *b, int n)
+{
+   ssize_t r;
+
+   while(n > 0)
+   {
+      if((r = write(fd, b, n)) < 0)
+      {
+         if(errno == EINTR) continue;
+         return(-1);
+      }
+      b += r;
+      n -= (int)r;
+   }
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: clientMain
+Description: Sends the frames of the panels of the client
+             round robin, BURST frames per write (one with
+             a rate), until the time is up, then hangs up.
+------------------------------------------------------*/
+static void *clientMain(void *arg)
+{
+   struct client *c = arg;
+   unsigned char out[BURST * TM_FRAME_MAX];
+   unsigned long v[3];
+   unsigned long long due, round = 0;
+   int burst = c->rate > 0 ? 1 : BURST, i, k, n, len, step;
+   struct timespec ts;
+
+   while(nowUs() < c->end)
+   {
+      if(c->rate > 0)
+      {
+         due = c->start + (unsigned long long)(round * 1e6 / c->rate);
+         if(due > c->end) break;
+         ts.tv_sec = epoch.tv_sec + (time_t)(due / 1000000);
+         ts.tv_nsec = epoch.tv_nsec + (long)(due % 1000000) * 1000;
+         if(ts.tv_nsec >= 1000000000L)
+         {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+         }
+         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+      }
+      for(i = 0; i < c->count; i++)
+      {
+         len = 0;
+         for(k = 0; k < burst; k++)
+         {
+            step = c->seqs[i] % SCRIPT_LEN;
+            v[0] = (unsigned long)(nowUs() / 1000);
+            v[1] = (unsigned long)script[step][1];
+            v[2] = (unsigned long)(nowUs() & 0xFFFFFFFFUL);
+            n = script[step][0] == TM_STATE && script[step][1] == TS_ALARM ? 3 : 2;
+            len += tmFrame(out + len, script[step][0], c->seqs[i] & 0xFF, v, n);
+            c->seqs[i]++;
+         }
+         if(writeAll(c->fds[i], out, len) != 0)
+         {
+            perror("panel write");
+            return(NULL);
+         }
+         c->frames += burst;
+      }
+      round++;
+   }
+   for(i = 0; i < c->count; i++) close(c->fds[i]);
+   return(NULL);
+}
+
+static int connectPanel(const char *path)
+{
+   struct sockaddr_un addr;
+   int fd;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, path);
+   if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0 ||
+      connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+   {
+      perror("panel connect");
+      if(fd >= 0) close(fd);
+      return(-1);
+   }
+   return(fd);
+}
+
+// Latency (us) at fraction q of the alarms
+static unsigned long percentile(const unsigned long *hist, unsigned long long total, double q)
+{
+   unsigned long long sum = 0;
+   int i;
+
+   for(i = 0; i <= LAT_BUCKETS; i++)
+   {
+      sum += hist[i];
+      if(sum > 0 && sum >= q * total) return((unsigned long)(i + 1) * LAT_STEP);
+   }
+   return(0);
+}
+
+static int runBench(int nClients, int nPanels, double seconds, double rate)
+{
+   static struct client clients[MAXWORKERS];
+   char path[64];
+   unsigned long *hist = calloc(LAT_BUCKETS + 1, sizeof(unsigned long));
+   unsigned long long frames = 0, sent = 0, bytes = 0, alarms = 0, crcErrors = 0, lost = 0, bad = 0;
+   unsigned long long t, start, maxLat = 0;
+   double secs;
+   int i, j, panel;
+
+   snprintf(path, sizeof(path), "/tmp/station.%d", (int)getpid());
+   if(hist == NULL || openListener(path) != 0 || startWorkers() != 0) return(1);
+   if(2 * nPanels + 64 > maxFds)
+   {
+      fprintf(stderr, "%d panels need %d files, the limit is %d\n", nPanels, 2 * nPanels + 64, maxFds);
+      unlink(path);
+      return(1);
+   }
+   runWorkers();
+   for(i = 0, panel = 0; i < nClients; i++)
+   {
+      clients[i].count = nPanels / nClients + (i < nPanels % nClients);
+      clients[i].fds = calloc(clients[i].count, sizeof(int));
+      clients[i].seqs = calloc(clients[i].count, sizeof(int));
+      clients[i].rate = rate;
+      if(clients[i].fds == NULL || clients[i].seqs == NULL) return(1);
+      for(j = 0; j < clients[i].count; j++)
+      {
+         if((clients[i].fds[j] = connectPanel(path)) < 0) return(1);
+         clients[i].seqs[j] = (panel + j) * 7;   // not all in step
+      }
+      panel += clients[i].count;
+   }
+   // All connected: the clock starts now
+   while(__atomic_load_n(&nextId, __ATOMIC_ACQUIRE) < nPanels) usleep(1000);
+   start = nowUs();
+   for(i = 0; i < nClients; i++)
+   {
+      clients[i].start = start;
+      clients[i].end = start + (unsigned long long)(seconds * 1e6);
+      pthread_create(&clients[i].thread, NULL, clientMain, &clients[i]);
+   }
+   for(i = 0; i < nClients; i++)
+   {
+      pthread_join(clients[i].thread, NULL);
+      sent += clients[i].frames;
+   }
+   while(__atomic_load_n(&closed, __ATOMIC_ACQUIRE) < nPanels) usleep(1000);
+   secs = (nowUs() - start) / 1e6;
+   stopWorkers();
+   unlink(path);
+
+   for(i = 0; i < nWorkers; i++)
+   {
+      frames += workers[i].frames;
+      bytes += workers[i].bytes;
+      alarms += workers[i].alarms;
+      crcErrors += workers[i].crcErrors;
+      lost += workers[i].lost;
+      bad += workers[i].bad;
+      for(j = 0; j <= LAT_BUCKETS; j++)
+      {
+         hist[j] += workers[i].latency[j];
+         if(workers[i].latency[j] && (t = (unsigned long long)(j + 1) * LAT_STEP) > maxLat) maxLat = t;
+      }
+   }
+   printf("%d panels, %d workers, %d clients, %.3f s%s\n", nPanels, nWorkers, nClients, secs,
+          rate > 0 ? "" : ", no rate limit");
+   printf("frames %llu of %llu sent, %.0f frames/s, %.1f MB/s\n", frames, sent, frames / secs,
+          bytes / secs / 1e6);
+   printf("CRC errors %llu, lost %llu, bad payloads %llu\n", crcErrors, lost, bad);
+   printf("alarms %llu, latency us: p50 %lu  p99 %lu  p99.9 %lu  max %s%llu\n", alarms,
+          percentile(hist, alarms, 0.50), percentile(hist, alarms, 0.99),
+          percentile(hist, alarms, 0.999), hist[LAT_BUCKETS] ? ">" : "",
+          hist[LAT_BUCKETS] ? (unsigned long long)LAT_BUCKETS * LAT_STEP : maxLat);
+   for(i = 0; i < nWorkers && nWorkers > 1; i++)
+      printf("   worker %d: %llu frames\n", i, workers[i].frames);
+   return(frames == sent && crcErrors == 0 && lost == 0 ? 0 : 1);
+}
+
+int main(int argc, char *argv[])
+{
+   const char *path = NULL;
+   int ptys = 0, nClients = 0, nPanels = 1000, i;
+   double seconds = 5.0, rate = 0.0;
+
+   if(argc < 2) usage();
+   if(strcmp(argv[1], "bench") == 0) bench = 1;
+   else if(strcmp(argv[1], "serve") != 0) usage();
+   for(i = 2; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-w") == 0 && i + 1 < argc) nWorkers = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-q") == 0 && !bench) quiet = 1;
+      else if(strcmp(argv[i], "-y") == 0 && i + 1 < argc && !bench) ptys = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc && bench) nClients = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc && bench) nPanels = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc && bench) seconds = atof(argv[++i]);
+      else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc && bench) rate = atof(argv[++i]);
+      else if(argv[i][0] == '-' || bench || path != NULL) usage();
+      else path = argv[i];
+   }
+   if(nClients == 0) nClients = nWorkers;
+   if(nWorkers < 1 || nWorkers > MAXWORKERS || nClients < 1 || nClients > MAXWORKERS ||
+      nPanels < nClients || seconds <= 0.0 || rate < 0.0 || ptys < 0) usage();
+   clock_gettime(CLOCK_MONOTONIC, &epoch);
+   if(bench) return(runBench(nClients, nPanels, seconds, rate));
+   if(path == NULL) usage();
+   return(serve(path, ptys));
+}
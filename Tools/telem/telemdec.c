@@ -0,0 +1,192 @@
+/*-------------------------------------------------------------
+ * File:  telemdec.c
+ * Description: Telemetry decoder.  Reads streams of the frames
+ *              of Lab 4/Sources/telem.h (from SCI1, or written
+ *              by alarmhost run -o), checks them and prints the
+ *              frames (-l) and, for each stream, the frames of
+ *              each type, the CRC errors, the bytes skipped to
+ *              find a frame and the frames lost (SEQ gaps).
+ *
+ *  Usage: telemdec [-l] [-c size] [-b n] stream...
+ *
+ *      -c  bytes given to the parser at a time (default 4096),
+ *          like the reads from a serial port
+ *      -b  decodes the streams n more times in memory and prints
+ *          the frames and bytes per second
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "telemproto.h"
+
+#define DIAG_ISRS 4       // as in diag.h
+#define CHUNK 4096
+
+struct stream
+{
+   const char *name;
+   int list;
+   unsigned long long types[TM_TYPES];
+};
+
+static const char *const isrNames[DIAG_ISRS] = { "tco", "disp", "key", "siren" };
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: telemdec [-l] [-c size] [-b n] stream...\n");
+   exit(1);
+}
+
+/*----------------------------------------------------
+Function: printFrame
+Description: Prints the time, SEQ, type and values of a
+             frame.
+------------------------------------------------------*/
+static void printFrame(const struct tm_frame *f, const unsigned long *v, int n)
+{
+   printf("%10.3f s  %3d  %-8s", v[0] / 1000.0, f->seq, tmTypeName(f->type));
+   switch(f->type)
+   {
+      case TM_BOOT:
+         if(n >= 2) printf(" version %lu", v[1]);
+         break;
+      case TM_STATE:
+         if(n >= 2) printf(" %s", tmStateName(v[1]));
+         break;
+      case TM_ZONE:
+         if(n >= 2) printf(" switches %02lX", v[1]);
+         break;
+      case TM_KEY:
+         if(n >= 2) printf(v[1] == 'x' ? " digit" : " '%c'", (int)v[1]);
+         break;
+      case TM_COUNTERS:
+         if(n >= 4) printf(" stack %lu/%lu load %lu%%", v[1], v[2], v[3]);
+         break;
+      case TM_ISR:
+         if(n >= 5) printf(" %-6s count %lu cycles %lu max %lu",
+                           v[1] < DIAG_ISRS ? isrNames[v[1]] : "?", v[2], v[3], v[4]);
+         break;
+   }
+   printf("\n");
+}
+
+// tm_handler of the streams
+static void onFrame(void *ctx, const struct tm_frame *f)
+{
+   struct stream *s = ctx;
+   unsigned long v[TM_MAX_VALUES];
+   int n = tmValues(f, v, TM_MAX_VALUES);
+
+   s->types[f->type < TM_TYPES ? f->type : 0]++;
+   if(s->list && n > 0) printFrame(f, v, n);
+   else if(s->list) printf("%12s %3d  %-8s bad payload\n", "", f->seq, tmTypeName(f->type));
+}
+
+/*----------------------------------------------------
+Function: readStream
+Description: Reads the whole file.  Returns the bytes
+             (malloc'd), NULL on an error.
+------------------------------------------------------*/
+static unsigned char *readStream(const char *path, size_t *size)
+{
+   FILE *in = fopen(path, "rb");
+   unsigned char *buf = NULL, *more;
+   size_t n = 0, cap = 0, m;
+
+   if(in == NULL)
+   {
+      perror(path);
+      return(NULL);
+   }
+   do
+   {
+      if(n == cap)
+      {
+         cap = cap ? 2 * cap : 65536;
+         if((more = realloc(buf, cap)) == NULL)
+         {
+            fprintf(stderr, "%s: out of memory\n", path);
+            free(buf);
+            fclose(in);
+            return(NULL);
+         }
+         buf = more;
+      }
+      m = fread(buf + n, 1, cap - n, in);
+      n += m;
+   } while(m > 0);
+   if(ferror(in))
+   {
+      perror(path);
+      free(buf);
+      fclose(in);
+      return(NULL);
+   }
+   fclose(in);
+   *size = n;
+   return(buf);
+}
+
+static void parse(struct tm_parser *p, struct stream *s, const unsigned char *b, size_t n,
+                  size_t chunk)
+{
+   size_t i, m;
+
+   tmInit(p);
+   for(i = 0; i < n; i += m)
+   {
+      m = n - i < chunk ? n - i : chunk;
+      tmParse(p, b + i, m, onFrame, s);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   struct tm_parser p;
+   struct stream s;
+   unsigned char *buf;
+   size_t size, chunk = CHUNK;
+   double t0, secs;
+   int list = 0, bench = 0, i, j, t, status = 0;
+
+   for(i = 1; i < argc && argv[i][0] == '-'; i++)
+   {
+      if(strcmp(argv[i], "-l") == 0) list = 1;
+      else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) chunk = strtoul(argv[++i], NULL, 0);
+      else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc) bench = atoi(argv[++i]);
+      else usage();
+   }
+   if(i >= argc || chunk == 0 || bench < 0) usage();
+   for(; i < argc; i++)
+   {
+      if((buf = readStream(argv[i], &size)) == NULL)
+      {
+         status = 1;
+         continue;
+      }
+      memset(&s, 0, sizeof(s));
+      s.name = argv[i];
+      s.list = list;
+      if(list) printf("%s:\n", argv[i]);
+      parse(&p, &s, buf, size, chunk);
+      printf("%s: %llu bytes, %llu frames, %llu CRC errors, %llu bytes skipped, %llu lost%s\n",
+             argv[i], p.bytes, p.frames, p.crcErrors, p.skipped, p.lost,
+             p.carryLen ? ", cut short" : "");
+      for(t = 1; t < TM_TYPES; t++)
+         if(s.types[t]) printf("   %-10s %llu\n", tmTypeName(t), s.types[t]);
+      if(s.types[0]) printf("   %-10s %llu\n", "unknown", s.types[0]);
+
+      if(bench > 0)
+      {
+         s.list = 0;
+         t0 = (double)clock() / CLOCKS_PER_SEC;
+         for(j = 0; j < bench; j++) parse(&p, &s, buf, size, chunk);
+         secs = (double)clock() / CLOCKS_PER_SEC - t0;
+         printf("   decoded %d times in %.3f s: %.0f frames/s, %.1f MB/s\n", bench, secs,
+                secs > 0 ? p.frames * bench / secs : 0.0, secs > 0 ? p.bytes * bench / secs / 1e6 : 0.0);
+      }
+      free(buf);
+   }
+   return(status);
+}
@@ -0,0 +1,212 @@
+/*------------------------------------------------
+ * File: telemproto.c
+ * Description: Telemetry frame parser.  tmParse takes the
+ *              stream in buffers of any size, finds the frames
+ *              (resynchronising on TM_SOF after a bad length or
+ *              CRC) and passes each good one to the handler.
+ *              The payload is not copied: it points into the
+ *              caller's buffer, or into the parser for the one
+ *              frame that straddles two buffers, and is only
+ *              valid during the call.  tmFrame builds frames
+ *              (test streams).  The CRC table is made by the
+ *              first tmInit or tmFrame: make that call before
+ *              starting threads that use the others.
+--------------------------------------------------*/
+#include <string.h>
+#include "telemproto.h"
+
+static unsigned short crcTable[256];
+
+static void crcInit(void)
+{
+   unsigned crc;
+   int i, bit;
+
+   if(crcTable[1] != 0) return;
+   for(i = 0; i < 256; i++)
+   {
+      crc = i << 8;
+      for(bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      crcTable[i] = (unsigned short)crc;
+   }
+}
+
+// CRC-16/CCITT of n bytes from 0xFFFF
+static unsigned crc16(const unsigned char *b, int n)
+{
+   unsigned crc = 0xFFFF;
+
+   while(n-- > 0) crc = ((crc << 8) ^ crcTable[(crc >> 8) ^ *b++]) & 0xFFFF;
+   return(crc);
+}
+
+/*----------------------------------------------------
+Function: tmInit
+Description: Empties the parser and clears its counts.
+------------------------------------------------------*/
+void tmInit(struct tm_parser *p)
+{
+   crcInit();
+   memset(p, 0, sizeof(*p));
+   p->lastSeq = -1;
+}
+
+/*----------------------------------------------------
+Function: scan
+Description: Passes the frames that start before stop in
+             the n bytes of b to fn.  Returns where it
+             stopped: stop, or the start of a frame that
+             is not all in b.
+------------------------------------------------------*/
+static size_t scan(struct tm_parser *p, const unsigned char *b, size_t n, size_t stop,
+                   tm_handler fn, void *ctx)
+{
+   struct tm_frame f;
+   size_t pos = 0, total;
+   int len;
+
+   while(pos < stop)
+   {
+      if(b[pos] != TM_SOF)
+      {
+         p->skipped++;
+         pos++;
+         continue;
+      }
+      if(n - pos < 2) break;
+      len = b[pos+1];
+      if(len > TM_MAX_PAYLOAD)
+      {
+         p->skipped++;
+         pos++;
+         continue;
+      }
+      total = TM_HEADER + len + TM_CRC;
+      if(n - pos < total) break;
+      if(crc16(b + pos + 1, TM_HEADER - 1 + len) !=
+         (unsigned)(b[pos+total-2] << 8 | b[pos+total-1]))
+      {
+         p->crcErrors++;   // a damaged frame, or a TM_SOF inside one
+         p->skipped++;
+         pos++;
+         continue;
+      }
+      f.type = b[pos+2];
+      f.seq = b[pos+3];
+      f.payload = b + pos + TM_HEADER;
+      f.len = len;
+      if(p->lastSeq >= 0 && f.type != TM_BOOT) p->lost += (f.seq - p->lastSeq - 1) & 0xFF;
+      p->lastSeq = f.seq;
+      p->frames++;
+      fn(ctx, &f);
+      pos += total;
+   }
+   return(pos);
+}
+
+/*----------------------------------------------------
+Function: tmParse
+Description: Parses the next n bytes of the stream.  The
+             start of a frame left at the end is kept and
+             completed by the next call.
+------------------------------------------------------*/
+void tmParse(struct tm_parser *p, const unsigned char *b, size_t n, tm_handler fn, void *ctx)
+{
+   unsigned char joined[2 * TM_FRAME_MAX];
+   size_t m, pos, off = 0;
+
+   p->bytes += n;
+   if(p->carryLen > 0)
+   {
+      // The kept bytes and enough of b to end the frame they start
+      m = n < TM_FRAME_MAX ? n : TM_FRAME_MAX;
+      memcpy(joined, p->carry, p->carryLen);
+      memcpy(joined + p->carryLen, b, m);
+      pos = scan(p, joined, p->carryLen + m, p->carryLen, fn, ctx);
+      if(pos < (size_t)p->carryLen)
+      {
+         p->carryLen = (int)(p->carryLen + m - pos);
+         memmove(p->carry, joined + pos, p->carryLen);
+         return;
+      }
+      off = pos - p->carryLen;
+      p->carryLen = 0;
+   }
+   if(off >= n) return;
+   pos = off + scan(p, b + off, n - off, n - off, fn, ctx);
+   p->carryLen = (int)(n - pos);
+   memcpy(p->carry, b + pos, p->carryLen);
+}
+
+/*----------------------------------------------------
+Function: tmFrame
+Description: Builds the frame of the n values (the ms
+             first) in out, TM_FRAME_MAX bytes.  Returns
+             its length, 0 if the values do not fit.
+------------------------------------------------------*/
+int tmFrame(unsigned char *out, int type, int seq, const unsigned long *v, int n)
+{
+   int len = TM_HEADER, i;
+   unsigned long x;
+   unsigned crc;
+
+   crcInit();
+   for(i = 0; i < n; i++)
+   {
+      x = v[i] & 0xFFFFFFFFUL;
+      do
+      {
+         if(len == TM_HEADER + TM_MAX_PAYLOAD) return(0);
+         out[len++] = (unsigned char)((x & 0x7F) | (x > 0x7F ? 0x80 : 0));
+         x >>= 7;
+      } while(x != 0);
+   }
+   out[0] = TM_SOF;
+   out[1] = (unsigned char)(len - TM_HEADER);
+   out[2] = (unsigned char)type;
+   out[3] = (unsigned char)seq;
+   crc = crc16(out + 1, len - 1);
+   out[len++] = (unsigned char)(crc >> 8);
+   out[len++] = (unsigned char)crc;
+   return(len);
+}
+
+/*----------------------------------------------------
+Function: tmValues
+Description: Decodes the varints of the payload into
+             v (at most max).  Returns their number, -1
+             if the last is cut short or too long.
+------------------------------------------------------*/
+int tmValues(const struct tm_frame *f, unsigned long *v, int max)
+{
+   int i = 0, count = 0, shift;
+   unsigned long x;
+
+   while(i < f->len && count < max)
+   {
+      x = 0;
+      for(shift = 0;; shift += 7)
+      {
+         if(i >= f->len || shift > 28) return(-1);
+         x |= (unsigned long)(f->payload[i] & 0x7F) << shift;
+         if(!(f->payload[i++] & 0x80)) break;
+      }
+      v[count++] = x;
+   }
+   return(count);
+}
+
+const char *tmTypeName(int type)
+{
+   static const char *const names[TM_TYPES] =
+      { "?", "boot", "state", "zone", "key", "counters", "isr" };
+
+   return(type > 0 && type < TM_TYPES ? names[type] : "?");
+}
+
+const char *tmStateName(unsigned long state)
+{
+   static const char *const names[] = { "idle", "config", "arming", "armed", "entry", "alarm" };
+
+   return(state <= TS_ALARM ? names[state] : "?");
+}
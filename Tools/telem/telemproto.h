@@ -0,0 +1,62 @@
+/*------------------------------------------------
+ * File: telemproto.h
+ * Description: Host side of the telemetry frames of
+ *              Lab 4 (see Lab 4/Sources/telem.h for the
+ *              format): an incremental frame parser, the
+ *              varint decoder and a frame encoder.
+--------------------------------------------------*/
+#ifndef _TELEMPROTO_H
+#define _TELEMPROTO_H
+
+#include <stddef.h>
+
+// As in telem.h
+#define TM_SOF 0x7E
+#define TM_MAX_PAYLOAD 24
+#define TM_HEADER 4       // SOF, LEN, TYPE, SEQ
+#define TM_CRC 2
+#define TM_FRAME_MAX (TM_HEADER + TM_MAX_PAYLOAD + TM_CRC)
+#define TM_MAX_VALUES TM_MAX_PAYLOAD
+
+#define TM_BOOT     1
+#define TM_STATE    2
+#define TM_ZONE     3
+#define TM_KEY      4
+#define TM_COUNTERS 5
+#define TM_ISR      6
+#define TM_TYPES    7
+
+#define TS_IDLE    0
+#define TS_CONFIG  1
+#define TS_ARMING  2
+#define TS_ARMED   3
+#define TS_ENTRY   4
+#define TS_ALARM   5
+
+struct tm_frame
+{
+   int type;
+   int seq;
+   const unsigned char *payload;  // in the caller's buffer when the frame is whole there
+   int len;
+};
+
+// Called for each frame with a good CRC
+typedef void (*tm_handler)(void *, const struct tm_frame *);
+
+struct tm_parser
+{
+   unsigned char carry[TM_FRAME_MAX];  // start of a frame split between two buffers
+   int carryLen;
+   int lastSeq;             // -1 before the first frame
+   unsigned long long bytes, frames, crcErrors, skipped, lost;
+};
+
+void tmInit(struct tm_parser *);
+void tmParse(struct tm_parser *, const unsigned char *, size_t, tm_handler, void *);
+int tmFrame(unsigned char *, int, int, const unsigned long *, int);
+int tmValues(const struct tm_frame *, unsigned long *, int);
+const char *tmTypeName(int);
+const char *tmStateName(unsigned long);
+
+#endif /* _TELEMPROTO_H */
@@ -0,0 +1,249 @@
+/*-------------------------------------------------------------
+ * File:  tracedec.c
+ * Description: Trace decoder.  Reads a hex dump of traceBuf
+ *              (see Lab 4/Sources/trace.h) and the trace point
+ *              names from trace.h, puts the (id, TCNT) records
+ *              of the ring in order from the oldest, extends
+ *              TCNT past its wraps and pairs each begin with
+ *              the next end of the same id.  Prints the
+ *              records (-l) and the count, shortest, mean and
+ *              longest span of each trace point, and writes the
+ *              spans as a timeline (Chrome trace event format,
+ *              one track per trace point) with -o.
+ *
+ *  Usage: tracedec [-l] [-u us] [-a addr] [-o timeline.json] trace.h dump
+ *
+ *      -u  micro-sec per timer tick (default 1.3333, the
+ *          full speed clock profile; 2 at low power)
+ *      -a  address of traceBuf in the dump (hex); the
+ *          lowest address of the dump by default
+ *
+ *  Dump format: lines of a hex address and up to 16 hex bytes,
+ *  like the DBug12 MD command or alarmhost run -r; whatever
+ *  follows the bytes (ASCII column) is ignored.
+ *
+ *  A gap of more than one TCNT wrap between two records (87 ms
+ *  at full speed) cannot be seen and is shortened.
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAXIDS 128
+#define NAMESIZE 32
+#define LINESIZE 256
+#define MEMSIZE 0x10000
+#define END_BIT 0x80      // TRACE_END_BIT
+#define REC_SIZE 3        // id, TCNT high, TCNT low
+#define LINEBYTES 16
+
+struct point
+{
+   char name[NAMESIZE];
+   int named;             // defined in trace.h
+   int open;              // a begin without its end yet
+   double start;          // micro-sec
+   unsigned long count;
+   double min, max, sum;
+};
+
+struct point points[MAXIDS];
+int ringSize = 0;
+unsigned char mem[MEMSIZE];
+unsigned char dumped[MEMSIZE];
+
+static void usage(void)
+{
+   fprintf(stderr, "usage: tracedec [-l] [-u us] [-a addr] [-o timeline.json] trace.h dump\n");
+   exit(1);
+}
+
+/*----------------------------------------------------
+Function: readHeader
+Description: Takes TRACE_SIZE and the TR_ ids from the
+             #define lines of trace.h.  Returns -1 if it
+             cannot be read or has no TRACE_SIZE.
+------------------------------------------------------*/
+int readHeader(const char *path)
+{
+   FILE *in = fopen(path, "r");
+   char line[LINESIZE], name[NAMESIZE];
+   int value, i;
+
+   if(in == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   for(i = 0; i < MAXIDS; i++) sprintf(points[i].name, "id%d", i);
+   while(fgets(line, sizeof(line), in) != NULL)
+   {
+      if(sscanf(line, " #define %31s %i", name, &value) != 2) continue;
+      if(strcmp(name, "TRACE_SIZE") == 0) ringSize = value;
+      else if(strncmp(name, "TR_", 3) == 0 && value > 0 && value < MAXIDS)
+      {
+         for(i = 0; name[i+3] != '\0'; i++) points[value].name[i] = tolower((unsigned char)name[i+3]);
+         points[value].name[i] = '\0';
+         points[value].named = 1;
+      }
+   }
+   fclose(in);
+   if(ringSize <= 0 || ringSize > 256)
+   {
+      fprintf(stderr, "%s: no TRACE_SIZE (1 to 256)\n", path);
+      return(-1);
+   }
+   return(0);
+}
+
+/*----------------------------------------------------
+Function: readDump
+Description: Reads the bytes of the dump into mem.
+             Returns the lowest address, -1 on an error.
+------------------------------------------------------*/
+long readDump(const char *path)
+{
+   FILE *in = fopen(path, "r");
+   char line[LINESIZE], *p, *end;
+   unsigned long addr, byte;
+   long lowest = -1;
+   int n;
+
+   if(in == NULL)
+   {
+      perror(path);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), in) != NULL)
+   {
+      addr = strtoul(line, &end, 16);
+      if(end == line || addr >= MEMSIZE) continue;
+      p = end + (*end == ':');
+      for(n = 0; n < LINEBYTES; n++)
+      {
+         while(*p == ' ' || *p == '\t') p++;
+         if(!isxdigit((unsigned char)p[0]) || !isxdigit((unsigned char)p[1]) ||
+            (p[2] != '\0' && !isspace((unsigned char)p[2]))) break;
+         byte = strtoul(p, &end, 16);
+         p = end;
+         if(addr >= MEMSIZE) break;
+         mem[addr] = (unsigned char)byte;
+         dumped[addr] = 1;
+         if(lowest < 0 || (long)addr < lowest) lowest = addr;
+         addr++;
+      }
+   }
+   fclose(in);
+   if(lowest < 0) fprintf(stderr, "%s: no bytes\n", path);
+   return(lowest);
+}
+
+int main(int argc, char *argv[])
+{
+   const char *header = NULL, *dump = NULL, *json = NULL;
+   double usPerTick = 4.0 / 3.0, t = 0.0, span;
+   long base = -1, addr;
+   int list = 0, head, i, n, slot, id, first = 1, unmatched = 0, records = 0;
+   unsigned tcnt, last = 0;
+   FILE *out = NULL;
+   struct point *p;
+
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-l") == 0) list = 1;
+      else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc) usPerTick = atof(argv[++i]);
+      else if(strcmp(argv[i], "-a") == 0 && i + 1 < argc) base = strtol(argv[++i], NULL, 16);
+      else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) json = argv[++i];
+      else if(argv[i][0] == '-') usage();
+      else if(header == NULL) header = argv[i];
+      else if(dump == NULL) dump = argv[i];
+      else usage();
+   }
+   if(dump == NULL || usPerTick <= 0.0) usage();
+   if(readHeader(header) != 0) return(1);
+   if((addr = readDump(dump)) < 0) return(1);
+   if(base < 0) base = addr;
+   for(i = 0; i < 1 + REC_SIZE * ringSize; i++)
+   {
+      if(base + i >= MEMSIZE || !dumped[base + i])
+      {
+         fprintf(stderr, "%s: traceBuf (%d bytes from %04lX) not all dumped\n", dump,
+                 1 + REC_SIZE * ringSize, base);
+         return(1);
+      }
+   }
+   if(json != NULL)
+   {
+      if((out = fopen(json, "w")) == NULL)
+      {
+         perror(json);
+         return(1);
+      }
+      fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+      for(i = 1; i < MAXIDS; i++)
+         if(points[i].named)
+            fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                         "\"args\":{\"name\":\"%s\"}},\n", i, points[i].name);
+   }
+
+   // The oldest record is the one the next is written over (id 0
+   // until the ring has wrapped)
+   head = mem[base];
+   for(n = 0; n < ringSize; n++)
+   {
+      slot = (head + n) % ringSize;
+      addr = base + 1 + REC_SIZE * slot;
+      id = mem[addr];
+      tcnt = (mem[addr+1] << 8) | mem[addr+2];
+      if(id == 0) continue;
+      if(!first) t += ((tcnt - last) & 0xFFFF) * usPerTick;
+      first = 0;
+      last = tcnt;
+      records++;
+      if(list) printf("%12.3f us  %04X  %-16s %s\n", t, tcnt, points[id & ~END_BIT].name,
+                      (id & END_BIT) ? "end" : "begin");
+      p = &points[id & ~END_BIT];
+      if(!(id & END_BIT))
+      {
+         if(p->open) unmatched++;   // its end was lost
+         p->open = 1;
+         p->start = t;
+         continue;
+      }
+      if(!p->open)
+      {
+         unmatched++;   // begin before the oldest record, or lost
+         continue;
+      }
+      p->open = 0;
+      span = t - p->start;
+      if(p->count == 0 || span < p->min) p->min = span;
+      if(span > p->max) p->max = span;
+      p->sum += span;
+      p->count++;
+      if(out != NULL)
+         fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                      "\"dur\":%.3f},\n", p->name, id & ~END_BIT, p->start, span);
+   }
+
+   printf("%d records over %.3f ms (%d in the ring, head %d), %d unmatched\n\n", records,
+          t / 1000.0, ringSize, head, unmatched);
+   printf("%-16s %8s %12s %12s %12s\n", "trace point", "spans", "min us", "mean us", "max us");
+   for(i = 1; i < MAXIDS; i++)
+   {
+      if(points[i].count == 0) continue;
+      printf("%-16s %8lu %12.3f %12.3f %12.3f\n", points[i].name, points[i].count, points[i].min,
+             points[i].sum / points[i].count, points[i].max);
+   }
+   if(out != NULL)
+   {
+      fprintf(out, "{\"name\":\"end\",\"ph\":\"i\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"s\":\"g\"}\n]}\n", t);
+      if(fclose(out) != 0)
+      {
+         perror(json);
+         return(1);
+      }
+   }
+   return(0);
+}